@@ -0,0 +1,67 @@
+// Fuzzer de CredentialsParser::parse con libFuzzer:
+//
+//   clang++ -std=c++17 -g -O1 -fsanitize=fuzzer,address,undefined -I src \
+//       fuzz/fuzz_credentials_parser.cpp src/credentials_parser.cpp -o fuzz_credentials
+//   ./fuzz_credentials -max_len=512 fuzz/corpus_credentials
+//
+// Ademas de los fallos de memoria que detectan los sanitizers, aborta si un
+// buffer queda sin terminar o si se acepta algo que el firmware rechazaria.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#include "credentials_parser.h"
+
+namespace
+{
+void check(bool condition)
+{
+  if (!condition)
+  {
+    abort();
+  }
+}
+
+size_t terminatedLength(const char *text, size_t capacity)
+{
+  const void *end = memchr(text, '\0', capacity);
+  check(end != nullptr);
+  return static_cast<const char *>(end) - text;
+}
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  using namespace CredentialsParser;
+
+  CredentialsPayload out;
+  const Error error = parse(std::string_view(reinterpret_cast<const char *>(data), size), out);
+  check(errorName(error)[0] != '?');
+
+  const size_t ssid = terminatedLength(out.ssid, sizeof(out.ssid));
+  terminatedLength(out.password, sizeof(out.password));
+  terminatedLength(out.userId, sizeof(out.userId));
+  const size_t deviceId = terminatedLength(out.deviceId, sizeof(out.deviceId));
+  terminatedLength(out.endpoint, sizeof(out.endpoint));
+  terminatedLength(out.region, sizeof(out.region));
+  terminatedLength(out.environment, sizeof(out.environment));
+  terminatedLength(out.thingName, sizeof(out.thingName));
+  terminatedLength(out.provisionToken, sizeof(out.provisionToken));
+
+  if (error == Error::NONE)
+  {
+    check(ssid > 0);
+    check(deviceId <= 32);
+    check(out.awsPort >= 0 && out.awsPort < 65536);
+    for (size_t i = 0; i < deviceId; ++i)
+    {
+      const char c = out.deviceId[i];
+      check((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+            c == '-' || c == '_');
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+// Subconjunto minimo de Arduino para compilar modulos de src/ en host.
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+
+// String de Arduino sobre std::string; solo lo que usan los modulos de src/.
+class String
+{
+public:
+  String() = default;
+  String(const char *text) : value_(text ? text : "") {}
+  String(const char *text, size_t length) : value_(text, length) {}
+
+  const char *c_str() const { return value_.c_str(); }
+  size_t length() const { return value_.size(); }
+  bool isEmpty() const { return value_.empty(); }
+  void reserve(size_t size) { value_.reserve(size); }
+  bool concat(const char *text, size_t length)
+  {
+    value_.append(text, length);
+    return true;
+  }
+
+  String &operator+=(const char *text)
+  {
+    value_ += text;
+    return *this;
+  }
+  bool operator==(const char *text) const { return value_ == text; }
+  bool operator==(const String &other) const { return value_ == other.value_; }
+  bool operator!=(const String &other) const { return value_ != other.value_; }
+
+private:
+  std::string value_;
+};
+
+class HardwareSerial
+{
+public:
+  void begin(unsigned long) {}
+
+  int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)))
+  {
+    va_list args;
+    va_start(args, fmt);
+    const int written = vprintf(fmt, args);
+    va_end(args);
+    return written;
+  }
+
+  size_t print(const char *text) { return static_cast<size_t>(::printf("%s", text)); }
+  size_t println(const char *text) { return static_cast<size_t>(::printf("%s\n", text)); }
+  size_t println() { return static_cast<size_t>(::printf("\n")); }
+};
+
+extern HardwareSerial Serial;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
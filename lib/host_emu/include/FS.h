@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <memory>
+
+// API fs::FS/fs::File de arduino-esp32 sobre ficheros del host. El montaje
+// y los contadores se controlan con spiffs_host.h.
+namespace fs
+{
+struct FileImpl;
+
+class File
+{
+public:
+  File() = default;
+  explicit File(std::shared_ptr<FileImpl> impl) : impl_(std::move(impl)) {}
+
+  explicit operator bool() const;
+  size_t size() const;
+  int available();
+  int read();
+  size_t read(uint8_t *buffer, size_t length);
+  size_t write(const uint8_t *buffer, size_t length);
+  size_t write(uint8_t value) { return write(&value, 1); }
+  String readString();
+  void close();
+
+private:
+  std::shared_ptr<FileImpl> impl_;
+};
+
+class FS
+{
+public:
+  virtual ~FS() = default;
+
+  // mode: "r", "w" (trunca) o "a".
+  File open(const char *path, const char *mode = "r");
+  bool exists(const char *path);
+  bool remove(const char *path);
+  bool rename(const char *from, const char *to);
+};
+} // namespace fs
+
+using fs::File;
+using fs::FS;
@@ -0,0 +1,70 @@
+#pragma once
+
+// U8g2 emulado para host: solo el SSD1306 128x64 por I2C y las primitivas
+// que usa oled_display.cpp. El framebuffer es real (mismo formato por tiles
+// que U8g2) y las transferencias se copian a la RAM del panel emulado; ver
+// u8g2_host.h para el panel y los contadores de I2C.
+
+#include <Arduino.h>
+
+#define U8G2_R0 0
+#define U8X8_PIN_NONE 255
+
+class U8G2
+{
+public:
+  static constexpr uint8_t kTileWidth = 16;
+  static constexpr uint8_t kTileHeight = 8;
+
+  explicit U8G2(uint8_t tileBufHeight) : tileBufHeight_(tileBufHeight) {}
+
+  void begin();
+  void setContrast(uint8_t) {}
+  void setBusClock(uint32_t) {}
+
+  void clearDisplay();
+  void clearBuffer();
+  void sendBuffer();
+  void updateDisplay();
+  void updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th);
+  void setBufferCurrTileRow(uint8_t row) { currTileRow_ = row; }
+
+  void drawPixel(int x, int y);
+  void drawHLine(int x, int y, int w);
+  void drawVLine(int x, int y, int h);
+  void drawFrame(int x, int y, int w, int h);
+  void drawCircle(int x0, int y0, int r);
+  void drawDisc(int x0, int y0, int r);
+
+  uint8_t *getBufferPtr() { return buffer_; }
+  uint8_t getBufferTileWidth() const { return kTileWidth; }
+  uint8_t getBufferTileHeight() const { return tileBufHeight_; }
+  uint8_t getBufferCurrTileRow() const { return currTileRow_; }
+
+private:
+  uint8_t tileBufHeight_;
+  uint8_t currTileRow_ = 0;
+  uint8_t buffer_[kTileWidth * 8 * kTileHeight] = {};
+};
+
+// Buffer completo de 1 KB.
+class U8G2_SSD1306_128X64_NONAME_F_HW_I2C : public U8G2
+{
+public:
+  U8G2_SSD1306_128X64_NONAME_F_HW_I2C(int, int = U8X8_PIN_NONE, int = U8X8_PIN_NONE,
+                                      int = U8X8_PIN_NONE)
+      : U8G2(kTileHeight)
+  {
+  }
+};
+
+// Buffer de una pagina (128 bytes).
+class U8G2_SSD1306_128X64_NONAME_1_HW_I2C : public U8G2
+{
+public:
+  U8G2_SSD1306_128X64_NONAME_1_HW_I2C(int, int = U8X8_PIN_NONE, int = U8X8_PIN_NONE,
+                                      int = U8X8_PIN_NONE)
+      : U8G2(1)
+  {
+  }
+};
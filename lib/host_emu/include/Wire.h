@@ -0,0 +1,18 @@
+#pragma once
+
+// Wire emulado: no hay dispositivos en el bus (endTransmission devuelve
+// NACK de direccion); wire_host.h expone la configuracion aplicada.
+
+#include <Arduino.h>
+
+class TwoWire
+{
+public:
+  bool begin(int sdaPin = -1, int sclPin = -1, uint32_t frequency = 0);
+  bool end();
+  bool setClock(uint32_t frequency);
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool sendStop = true);
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <esp_core_dump.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Particion coredump emulada.
+namespace CoreDumpHost
+{
+constexpr uint32_t kPartitionAddress = 0x3F0000;
+constexpr uint32_t kPartitionBytes = 64 * 1024;
+
+// Deja una imagen valida en la particion, como tras un panic.
+void setImage(const uint8_t *data, size_t length, const esp_core_dump_summary_t &summary);
+// Particion vacia.
+void clear();
+// Cuantas veces se llamo a esp_core_dump_image_erase().
+size_t eraseCount();
+// Falla la siguiente lectura de la particion.
+void failNextRead();
+} // namespace CoreDumpHost
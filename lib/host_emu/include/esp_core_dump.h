@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+// Layout de IDF 4.4 para RISC-V.
+typedef struct
+{
+  uint32_t stackdump[256 / 4];
+  uint32_t dump_size;
+} esp_core_dump_bt_info_t;
+
+typedef struct
+{
+  uint32_t mstatus;
+  uint32_t mtvec;
+  uint32_t mcause;
+  uint32_t mtval;
+  uint32_t ra;
+  uint32_t sp;
+  uint32_t exc_a[8];
+} esp_core_dump_summary_extra_info_t;
+
+typedef struct
+{
+  uint32_t exc_tcb;
+  char exc_task[16];
+  uint32_t exc_pc;
+  esp_core_dump_bt_info_t exc_bt_info;
+  uint32_t core_dump_version;
+  uint8_t app_elf_sha256[17];
+  esp_core_dump_summary_extra_info_t ex_info;
+} esp_core_dump_summary_t;
+
+esp_err_t esp_core_dump_image_get(size_t *out_addr, size_t *out_size);
+esp_err_t esp_core_dump_image_erase(void);
+esp_err_t esp_core_dump_get_summary(esp_core_dump_summary_t *summary);
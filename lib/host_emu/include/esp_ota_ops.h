@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstddef>
+
+// En host no hay ELF de aplicacion: el hash es fijo.
+int esp_ota_get_app_elf_sha256(char *dst, size_t size);
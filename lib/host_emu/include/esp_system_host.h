@@ -0,0 +1,10 @@
+#pragma once
+
+#include "esp_system.h"
+
+// Control del sistema emulado.
+namespace EspSystemHost
+{
+// Motivo que devuelve esp_reset_reason() a partir de ahora.
+void setResetReason(esp_reset_reason_t reason);
+} // namespace EspSystemHost
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+
+// Control del heap emulado.
+namespace HeapCapsHost
+{
+constexpr size_t kHeapBytes = 200 * 1024;
+
+// Fija libre y bloque mayor (p. ej. para simular fragmentacion); el minimo
+// historico se actualiza igual que en el dispositivo.
+void setFree(size_t freeBytes, size_t largestFreeBlock);
+// Vuelve a medir con mallinfo2() y olvida el minimo.
+void reset();
+} // namespace HeapCapsHost
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "nvs.h"
+
+esp_err_t nvs_flash_init();
+esp_err_t nvs_flash_deinit();
+esp_err_t nvs_flash_erase();
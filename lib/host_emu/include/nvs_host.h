@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Control de la NVS emulada: fichero de respaldo, contadores y cortes de
+// alimentacion simulados. Cada nvs_set_*/nvs_erase_* llega al fichero en
+// el momento, como en el NVS real; nvs_commit solo se cuenta.
+namespace NvsHost
+{
+struct Stats
+{
+  uint32_t opens = 0;
+  uint32_t commits = 0;
+  uint32_t reads = 0;
+  uint32_t writes = 0; // nvs_set_* y nvs_erase_* aplicados
+  uint64_t bytesWritten = 0;
+  // Modelo de flash: entradas de 32 bytes (1 para enteros, cabecera + datos
+  // para str/blob) en paginas de 4 KB con 126 entradas; cada pagina llena
+  // acaba en un borrado al reciclarla.
+  uint32_t entriesWritten = 0;
+  uint32_t eraseCycles = 0;
+};
+
+// Empieza con una particion vacia respaldada por path.
+void reset(const char *path);
+// Descarta el estado en RAM y recarga el fichero, como tras un reinicio.
+void reboot();
+// Tras n escrituras mas, toda escritura falla sin llegar al fichero.
+void cutPowerAfterWrites(uint32_t n);
+bool powerCut();
+
+Stats stats();
+void resetStats();
+} // namespace NvsHost
@@ -0,0 +1,6 @@
+#pragma once
+
+// Lo que el firmware consulta del sdkconfig de arduino-esp32 para el C3.
+#define CONFIG_IDF_TARGET_ARCH_RISCV 1
+#define CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH 1
+#define CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF 1
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Control del SPIFFS emulado: cada fichero de la particion es un fichero
+// bajo el directorio de respaldo. Las escrituras llegan al disco al cerrar.
+namespace SpiffsHost
+{
+struct Stats
+{
+  uint32_t opens = 0;
+  uint32_t lookups = 0; // exists() y aperturas fallidas
+  uint64_t bytesRead = 0;
+  uint64_t bytesWritten = 0;
+  // Modelo de flash: paginas logicas de 256 bytes (datos + una de indice por
+  // fichero escrito) en bloques de 4 KB; cada bloque lleno acaba en un
+  // borrado al recolectarlo.
+  uint32_t pagesWritten = 0;
+  uint32_t eraseCycles = 0;
+};
+
+// Empieza con una particion vacia y formateada respaldada por dir.
+void reset(const char *dir);
+// La particion existe pero no esta formateada: begin(false) falla.
+void unformat();
+// Crea un fichero sin contarlo en las estadisticas (carga previa de datos).
+bool putFile(const char *path, const char *data, size_t length);
+
+Stats stats();
+void resetStats();
+} // namespace SpiffsHost
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+#include "freertos/task.h"
+
+// Tareas que ve uxTaskGetSystemState() en el host.
+namespace TaskHost
+{
+// Crea la tarea o cambia su minimo de pila libre (bytes).
+TaskHandle_t setTask(const char *name, uint32_t stackHighWaterBytes);
+void removeTask(const char *name);
+void clear();
+} // namespace TaskHost
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Control del SSD1306 emulado. Los bytes de I2C siguen lo que emite
+// u8x8_cad_ssd13xx_fast_i2c: por cada tramo de tiles de una fila, direccion
+// + byte de control + 3 comandos de posicion, y los datos en transacciones
+// de hasta 24 bytes con su direccion y byte de control.
+namespace U8g2Host
+{
+constexpr size_t kPanelBytes = 128 * 8;
+
+struct Stats
+{
+  uint32_t fullSends = 0;   // sendBuffer()/updateDisplay()
+  uint32_t areaUpdates = 0; // updateDisplayArea()
+  uint32_t tilesSent = 0;
+  uint64_t i2cBytes = 0;
+};
+
+// Panel en negro y contadores a cero.
+void reset();
+// RAM del panel: 8 filas de 128 bytes, mismo formato que el framebuffer.
+const uint8_t *panel();
+
+Stats stats();
+void resetStats();
+} // namespace U8g2Host
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+// Estado del controlador I2C emulado.
+namespace WireHost
+{
+struct Stats
+{
+  uint32_t begins = 0; // begin() con el driver parado
+  uint32_t ends = 0;
+  uint32_t transmissions = 0;
+};
+
+struct Config
+{
+  bool started = false;
+  int sdaPin = -1;
+  int sclPin = -1;
+  uint32_t clockHz = 0;
+};
+
+void reset();
+Config config();
+Stats stats();
+} // namespace WireHost
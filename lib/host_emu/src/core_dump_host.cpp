@@ -0,0 +1,110 @@
+#include "core_dump_host.h"
+
+#include <esp_partition.h>
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+const esp_partition_t kPartition = {ESP_PARTITION_TYPE_DATA,
+                                    ESP_PARTITION_SUBTYPE_DATA_COREDUMP,
+                                    CoreDumpHost::kPartitionAddress,
+                                    CoreDumpHost::kPartitionBytes,
+                                    "coredump",
+                                    false};
+
+// La imagen va tras una cabecera ficticia, como en flash no empieza en 0.
+constexpr size_t kImageOffset = 32;
+
+std::vector<uint8_t> g_image;
+esp_core_dump_summary_t g_summary;
+size_t g_eraseCount = 0;
+bool g_failNextRead = false;
+} // namespace
+
+namespace CoreDumpHost
+{
+void setImage(const uint8_t *data, size_t length, const esp_core_dump_summary_t &summary)
+{
+  g_image.assign(data, data + length);
+  g_summary = summary;
+}
+
+void clear()
+{
+  g_image.clear();
+  g_eraseCount = 0;
+  g_failNextRead = false;
+}
+
+size_t eraseCount() { return g_eraseCount; }
+
+void failNextRead() { g_failNextRead = true; }
+} // namespace CoreDumpHost
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char *)
+{
+  return type == kPartition.type && subtype == kPartition.subtype ? &kPartition : nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t srcOffset, void *dst, size_t size)
+{
+  if (partition != &kPartition || !dst || srcOffset + size > kPartition.size)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (g_failNextRead)
+  {
+    g_failNextRead = false;
+    return ESP_FAIL;
+  }
+  std::memset(dst, 0xFF, size);
+  for (size_t i = 0; i < size; ++i)
+  {
+    const size_t at = srcOffset + i;
+    if (at >= kImageOffset && at - kImageOffset < g_image.size())
+    {
+      static_cast<uint8_t *>(dst)[i] = g_image[at - kImageOffset];
+    }
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_core_dump_image_get(size_t *out_addr, size_t *out_size)
+{
+  if (!out_addr || !out_size)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (g_image.empty())
+  {
+    return ESP_ERR_NOT_FOUND;
+  }
+  *out_addr = kPartition.address + kImageOffset;
+  *out_size = g_image.size();
+  return ESP_OK;
+}
+
+esp_err_t esp_core_dump_image_erase(void)
+{
+  g_image.clear();
+  g_eraseCount++;
+  return ESP_OK;
+}
+
+esp_err_t esp_core_dump_get_summary(esp_core_dump_summary_t *summary)
+{
+  if (!summary)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (g_image.empty())
+  {
+    return ESP_ERR_NOT_FOUND;
+  }
+  *summary = g_summary;
+  return ESP_OK;
+}
@@ -0,0 +1,45 @@
+#include "esp_system_host.h"
+
+#include <esp_ota_ops.h>
+#include <esp_system.h>
+
+#include <vector>
+
+namespace
+{
+std::vector<shutdown_handler_t> g_shutdownHandlers;
+esp_reset_reason_t g_resetReason = ESP_RST_POWERON;
+}
+
+namespace EspSystemHost
+{
+void setResetReason(esp_reset_reason_t reason) { g_resetReason = reason; }
+} // namespace EspSystemHost
+
+esp_reset_reason_t esp_reset_reason(void) { return g_resetReason; }
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler)
+{
+  if (!handler)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+  g_shutdownHandlers.push_back(handler);
+  return ESP_OK;
+}
+
+int esp_ota_get_app_elf_sha256(char *dst, size_t size)
+{
+  static const char kHostSha[] = "0000000000000000000000000000000000000000000000000000000000000000";
+  if (!dst || size == 0)
+  {
+    return 0;
+  }
+  size_t n = 0;
+  for (; n + 1 < size && kHostSha[n]; ++n)
+  {
+    dst[n] = kHostSha[n];
+  }
+  dst[n] = '\0';
+  return static_cast<int>(n);
+}
@@ -0,0 +1,243 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "task_host.h"
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Las notificaciones se consultan cada ms: basta para tests y evita un
+// destructor en el thread_local que se usa desde los hooks de malloc.
+struct HostTask
+{
+  std::atomic<uint32_t> notifications{0};
+};
+
+struct HostSemaphore
+{
+  std::mutex lock;
+  std::condition_variable released;
+  bool taken = false;
+};
+
+namespace
+{
+std::recursive_mutex g_critical;
+thread_local HostTask t_task;
+thread_local HostTask *t_created = nullptr;
+
+struct ListedTask
+{
+  std::string name;
+  HostTask *handle;
+  uint32_t stackHighWaterBytes;
+};
+
+std::mutex g_listedLock;
+std::vector<ListedTask> g_listed;
+}
+
+void vPortEnterCritical(portMUX_TYPE *)
+{
+  g_critical.lock();
+}
+
+void vPortExitCritical(portMUX_TYPE *)
+{
+  g_critical.unlock();
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+  return new HostSemaphore();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+  std::unique_lock<std::mutex> guard(semaphore->lock);
+  const auto isFree = [semaphore] { return !semaphore->taken; };
+  if (ticks == portMAX_DELAY)
+  {
+    semaphore->released.wait(guard, isFree);
+  }
+  else if (!semaphore->released.wait_for(guard, std::chrono::milliseconds(ticks), isFree))
+  {
+    return pdFALSE;
+  }
+  semaphore->taken = true;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+  {
+    std::lock_guard<std::mutex> guard(semaphore->lock);
+    if (!semaphore->taken)
+    {
+      return pdFALSE;
+    }
+    semaphore->taken = false;
+  }
+  semaphore->released.notify_one();
+  return pdTRUE;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount()
+{
+  return millis();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+  return t_created ? t_created : &t_task;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *, uint32_t, void *arg, UBaseType_t,
+                       TaskHandle_t *handle)
+{
+  // Las tareas no terminan, como en el firmware: el hilo se suelta.
+  HostTask *task = new HostTask();
+  if (handle)
+  {
+    *handle = task;
+  }
+  std::thread([fn, arg, task] {
+    t_created = task;
+    fn(arg);
+  }).detach();
+  return pdTRUE;
+}
+
+void xTaskNotifyGive(TaskHandle_t task)
+{
+  if (task)
+  {
+    task->notifications.fetch_add(1);
+  }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks)
+{
+  HostTask *task = xTaskGetCurrentTaskHandle();
+  const uint32_t start = millis();
+  for (;;)
+  {
+    const uint32_t pending = task->notifications.load();
+    if (pending > 0)
+    {
+      if (clearOnExit)
+      {
+        task->notifications.store(0);
+      }
+      else
+      {
+        task->notifications.fetch_sub(1);
+      }
+      return pending;
+    }
+    if (ticks != portMAX_DELAY && millis() - start >= ticks)
+    {
+      return 0;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+UBaseType_t uxTaskGetNumberOfTasks()
+{
+  std::lock_guard<std::mutex> guard(g_listedLock);
+  return static_cast<UBaseType_t>(g_listed.size());
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *tasks, UBaseType_t size, uint32_t *totalRunTime)
+{
+  std::lock_guard<std::mutex> guard(g_listedLock);
+  if (totalRunTime)
+  {
+    *totalRunTime = 0;
+  }
+  // Como FreeRTOS: si no caben todas, no rellena nada.
+  if (size < g_listed.size())
+  {
+    return 0;
+  }
+  for (size_t i = 0; i < g_listed.size(); ++i)
+  {
+    TaskStatus_t status = {};
+    status.xHandle = g_listed[i].handle;
+    status.pcTaskName = g_listed[i].name.c_str();
+    status.xTaskNumber = static_cast<UBaseType_t>(i + 1);
+    status.eCurrentState = eBlocked;
+    status.usStackHighWaterMark = g_listed[i].stackHighWaterBytes;
+    tasks[i] = status;
+  }
+  return static_cast<UBaseType_t>(g_listed.size());
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+  std::lock_guard<std::mutex> guard(g_listedLock);
+  const HostTask *target = task ? task : xTaskGetCurrentTaskHandle();
+  for (const ListedTask &listed : g_listed)
+  {
+    if (listed.handle == target)
+    {
+      return listed.stackHighWaterBytes;
+    }
+  }
+  return 0;
+}
+
+namespace TaskHost
+{
+TaskHandle_t setTask(const char *name, uint32_t stackHighWaterBytes)
+{
+  std::lock_guard<std::mutex> guard(g_listedLock);
+  for (ListedTask &listed : g_listed)
+  {
+    if (listed.name == name)
+    {
+      listed.stackHighWaterBytes = stackHighWaterBytes;
+      return listed.handle;
+    }
+  }
+  g_listed.push_back({name, new HostTask(), stackHighWaterBytes});
+  return g_listed.back().handle;
+}
+
+void removeTask(const char *name)
+{
+  std::lock_guard<std::mutex> guard(g_listedLock);
+  for (size_t i = 0; i < g_listed.size(); ++i)
+  {
+    if (g_listed[i].name == name)
+    {
+      delete g_listed[i].handle;
+      g_listed.erase(g_listed.begin() + static_cast<std::ptrdiff_t>(i));
+      return;
+    }
+  }
+}
+
+void clear()
+{
+  std::lock_guard<std::mutex> guard(g_listedLock);
+  for (ListedTask &listed : g_listed)
+  {
+    delete listed.handle;
+  }
+  g_listed.clear();
+}
+} // namespace TaskHost
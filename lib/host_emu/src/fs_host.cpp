@@ -0,0 +1,276 @@
+#include "spiffs_host.h"
+
+#include <SPIFFS.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+fs::SPIFFSFS SPIFFS;
+
+namespace fs
+{
+struct FileImpl
+{
+  std::string hostPath;
+  std::string data;
+  size_t position = 0;
+  bool writable = false;
+  bool dirty = false;
+  bool open = true;
+};
+} // namespace fs
+
+namespace
+{
+namespace stdfs = std::filesystem;
+
+constexpr uint32_t kPageSize = 256;
+constexpr uint32_t kPagesPerBlock = 16;
+
+std::string g_dir = "spiffs_host";
+bool g_formatted = true;
+bool g_mounted = false;
+SpiffsHost::Stats g_stats;
+uint32_t g_blockPagesUsed = 0;
+
+// "/certs/device.pem" -> <dir>/certs/device.pem
+std::string hostPath(const char *path)
+{
+  std::string relative = path ? path : "";
+  while (!relative.empty() && relative[0] == '/')
+  {
+    relative.erase(0, 1);
+  }
+  return g_dir + "/" + relative;
+}
+
+bool readHostFile(const std::string &path, std::string &out)
+{
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+  {
+    return false;
+  }
+  out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  return true;
+}
+
+bool writeHostFile(const std::string &path, const std::string &data)
+{
+  std::error_code ec;
+  stdfs::create_directories(stdfs::path(path).parent_path(), ec);
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(data.data(), static_cast<std::streamsize>(data.size()));
+  return static_cast<bool>(out);
+}
+
+void accountPages(size_t bytes)
+{
+  // Paginas de datos mas la de indice del fichero.
+  const uint32_t pages = static_cast<uint32_t>((bytes + kPageSize - 1) / kPageSize) + 1;
+  g_stats.pagesWritten += pages;
+  g_blockPagesUsed += pages;
+  while (g_blockPagesUsed >= kPagesPerBlock)
+  {
+    g_blockPagesUsed -= kPagesPerBlock;
+    g_stats.eraseCycles++;
+  }
+}
+
+void flushFile(fs::FileImpl &file)
+{
+  if (!file.dirty)
+  {
+    return;
+  }
+  writeHostFile(file.hostPath, file.data);
+  g_stats.bytesWritten += file.data.size();
+  accountPages(file.data.size());
+  file.dirty = false;
+}
+} // namespace
+
+namespace fs
+{
+File::operator bool() const { return impl_ && impl_->open; }
+
+size_t File::size() const { return *this ? impl_->data.size() : 0; }
+
+int File::available()
+{
+  return *this ? static_cast<int>(impl_->data.size() - impl_->position) : 0;
+}
+
+int File::read()
+{
+  uint8_t value = 0;
+  return read(&value, 1) == 1 ? value : -1;
+}
+
+size_t File::read(uint8_t *buffer, size_t length)
+{
+  if (!*this || !buffer)
+  {
+    return 0;
+  }
+  const size_t left = impl_->data.size() - impl_->position;
+  const size_t count = length < left ? length : left;
+  memcpy(buffer, impl_->data.data() + impl_->position, count);
+  impl_->position += count;
+  g_stats.bytesRead += count;
+  return count;
+}
+
+size_t File::write(const uint8_t *buffer, size_t length)
+{
+  if (!*this || !impl_->writable || !buffer)
+  {
+    return 0;
+  }
+  impl_->data.replace(impl_->position, length, reinterpret_cast<const char *>(buffer), length);
+  impl_->position += length;
+  impl_->dirty = true;
+  return length;
+}
+
+String File::readString()
+{
+  if (!*this)
+  {
+    return String();
+  }
+  const size_t count = impl_->data.size() - impl_->position;
+  String out(impl_->data.data() + impl_->position, count);
+  impl_->position += count;
+  g_stats.bytesRead += count;
+  return out;
+}
+
+void File::close()
+{
+  if (!*this)
+  {
+    return;
+  }
+  flushFile(*impl_);
+  impl_->open = false;
+}
+
+File FS::open(const char *path, const char *mode)
+{
+  if (!g_mounted || !path || !mode)
+  {
+    return File();
+  }
+  auto impl = std::make_shared<FileImpl>();
+  impl->hostPath = hostPath(path);
+  const bool exists = readHostFile(impl->hostPath, impl->data);
+  if (mode[0] == 'r' && !exists)
+  {
+    g_stats.lookups++;
+    return File();
+  }
+  if (mode[0] == 'w')
+  {
+    impl->data.clear();
+    impl->dirty = true;
+  }
+  impl->writable = mode[0] != 'r';
+  impl->position = mode[0] == 'a' ? impl->data.size() : 0;
+  g_stats.opens++;
+  return File(impl);
+}
+
+bool FS::exists(const char *path)
+{
+  g_stats.lookups++;
+  std::error_code ec;
+  return g_mounted && path && stdfs::is_regular_file(hostPath(path), ec);
+}
+
+bool FS::remove(const char *path)
+{
+  std::error_code ec;
+  return g_mounted && path && stdfs::remove(hostPath(path), ec);
+}
+
+bool FS::rename(const char *from, const char *to)
+{
+  if (!g_mounted || !from || !to)
+  {
+    return false;
+  }
+  std::error_code ec;
+  stdfs::rename(hostPath(from), hostPath(to), ec);
+  return !ec;
+}
+
+bool SPIFFSFS::begin(bool formatOnFail, const char *, uint8_t, const char *)
+{
+  if (!g_formatted && !(formatOnFail && format()))
+  {
+    return false;
+  }
+  g_mounted = true;
+  return true;
+}
+
+bool SPIFFSFS::format()
+{
+  std::error_code ec;
+  stdfs::remove_all(g_dir, ec);
+  stdfs::create_directories(g_dir, ec);
+  g_formatted = !ec;
+  return g_formatted;
+}
+
+size_t SPIFFSFS::totalBytes() { return 1024 * 1024; }
+
+size_t SPIFFSFS::usedBytes()
+{
+  size_t used = 0;
+  std::error_code ec;
+  for (const auto &entry : stdfs::recursive_directory_iterator(g_dir, ec))
+  {
+    if (entry.is_regular_file(ec))
+    {
+      used += static_cast<size_t>(entry.file_size(ec));
+    }
+  }
+  return used;
+}
+
+void SPIFFSFS::end() { g_mounted = false; }
+} // namespace fs
+
+namespace SpiffsHost
+{
+void reset(const char *dir)
+{
+  g_dir = dir ? dir : "spiffs_host";
+  g_mounted = false;
+  SPIFFS.format();
+  resetStats();
+}
+
+void unformat()
+{
+  g_mounted = false;
+  g_formatted = false;
+}
+
+bool putFile(const char *path, const char *data, size_t length)
+{
+  return data && writeHostFile(hostPath(path), std::string(data, length));
+}
+
+Stats stats() { return g_stats; }
+
+void resetStats()
+{
+  g_stats = Stats();
+  g_blockPagesUsed = 0;
+}
+} // namespace SpiffsHost
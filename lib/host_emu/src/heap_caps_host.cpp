@@ -0,0 +1,68 @@
+#include "heap_caps_host.h"
+
+#include <esp_heap_caps.h>
+
+#include <malloc.h>
+
+namespace
+{
+bool g_fixed = false;
+size_t g_free = 0;
+size_t g_largest = 0;
+size_t g_minimum = HeapCapsHost::kHeapBytes;
+
+void measure(size_t &freeBytes, size_t &largest)
+{
+  if (g_fixed)
+  {
+    freeBytes = g_free;
+    largest = g_largest;
+    return;
+  }
+  const struct mallinfo2 info = mallinfo2();
+  const size_t used = info.uordblks < HeapCapsHost::kHeapBytes ? info.uordblks : HeapCapsHost::kHeapBytes;
+  freeBytes = HeapCapsHost::kHeapBytes - used;
+  // glibc no da el bloque libre mayor: los huecos dentro de su arena cuentan
+  // como fragmentacion.
+  largest = info.fordblks < freeBytes ? freeBytes - info.fordblks : 0;
+}
+} // namespace
+
+namespace HeapCapsHost
+{
+void setFree(size_t freeBytes, size_t largestFreeBlock)
+{
+  g_fixed = true;
+  g_free = freeBytes;
+  g_largest = largestFreeBlock;
+}
+
+void reset()
+{
+  g_fixed = false;
+  g_minimum = kHeapBytes;
+}
+} // namespace HeapCapsHost
+
+void heap_caps_get_info(multi_heap_info_t *info, uint32_t)
+{
+  size_t freeBytes = 0;
+  size_t largest = 0;
+  measure(freeBytes, largest);
+  if (freeBytes < g_minimum)
+  {
+    g_minimum = freeBytes;
+  }
+  *info = multi_heap_info_t();
+  info->total_free_bytes = freeBytes;
+  info->total_allocated_bytes = HeapCapsHost::kHeapBytes - freeBytes;
+  info->largest_free_block = largest;
+  info->minimum_free_bytes = g_minimum;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, caps);
+  return info.total_free_bytes;
+}
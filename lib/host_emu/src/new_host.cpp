@@ -0,0 +1,26 @@
+#include <cstdlib>
+#include <new>
+
+// Como en el dispositivo, new/delete acaban en malloc/free y pasan por los
+// wrappers de --wrap (heap_monitor.cpp); el new de libstdc++.so no lo haria.
+// Un test que defina su propio operator new sustituye a este.
+
+void *operator new(size_t size)
+{
+  void *ptr = std::malloc(size ? size : 1);
+  if (!ptr)
+  {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
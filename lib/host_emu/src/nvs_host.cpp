@@ -0,0 +1,533 @@
+#include "nvs_host.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "nvs_flash.h"
+
+namespace
+{
+struct Item
+{
+  nvs_type_t type;
+  std::string data;
+};
+
+struct Handle
+{
+  std::string ns;
+  bool readOnly;
+};
+
+// ns -> clave -> item. El NVS real indexa por (clave, tipo) pero no permite
+// dos tipos para la misma clave: un set de otro tipo borra el anterior.
+std::map<std::string, std::map<std::string, Item>> g_store;
+std::map<nvs_handle_t, Handle> g_handles;
+std::string g_path = "nvs_host.bin";
+nvs_handle_t g_nextHandle = 1;
+bool g_initialized = false;
+bool g_loaded = false;
+bool g_powerCutArmed = false;
+bool g_powerCut = false;
+uint32_t g_writesUntilCut = 0;
+NvsHost::Stats g_stats;
+uint32_t g_pageEntriesUsed = 0;
+
+constexpr uint32_t kEntrySize = 32;
+constexpr uint32_t kEntriesPerPage = 126;
+
+void accountEntries(nvs_type_t type, size_t dataSize)
+{
+  uint32_t entries = 1;
+  if (type == NVS_TYPE_STR || type == NVS_TYPE_BLOB)
+  {
+    const size_t stored = dataSize + (type == NVS_TYPE_STR ? 1 : 0);
+    entries += static_cast<uint32_t>((stored + kEntrySize - 1) / kEntrySize);
+  }
+  g_stats.entriesWritten += entries;
+  g_pageEntriesUsed += entries;
+  while (g_pageEntriesUsed >= kEntriesPerPage)
+  {
+    g_pageEntriesUsed -= kEntriesPerPage;
+    g_stats.eraseCycles++;
+  }
+}
+
+void appendU32(std::string &out, uint32_t value)
+{
+  for (int i = 0; i < 4; ++i)
+  {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+uint32_t readU32(const std::string &in, size_t pos)
+{
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i)
+  {
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(in[pos + i])) << (8 * i);
+  }
+  return value;
+}
+
+// Formato: por item ns\0 clave\0 tipo(u8) longitud(u32) datos. Un
+// namespace vacio se guarda con clave vacia para que sobreviva al reinicio.
+void save()
+{
+  std::string out;
+  for (const auto &ns : g_store)
+  {
+    if (ns.second.empty())
+    {
+      out.append(ns.first).push_back('\0');
+      out.push_back('\0');
+      out.push_back(static_cast<char>(NVS_TYPE_ANY));
+      appendU32(out, 0);
+      continue;
+    }
+    for (const auto &entry : ns.second)
+    {
+      out.append(ns.first).push_back('\0');
+      out.append(entry.first).push_back('\0');
+      out.push_back(static_cast<char>(entry.second.type));
+      appendU32(out, static_cast<uint32_t>(entry.second.data.size()));
+      out.append(entry.second.data);
+    }
+  }
+
+  FILE *file = fopen(g_path.c_str(), "wb");
+  if (!file)
+  {
+    return;
+  }
+  fwrite(out.data(), 1, out.size(), file);
+  fclose(file);
+}
+
+void load()
+{
+  g_store.clear();
+  FILE *file = fopen(g_path.c_str(), "rb");
+  if (!file)
+  {
+    return;
+  }
+  std::string in;
+  char buffer[512];
+  size_t read = 0;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+  {
+    in.append(buffer, read);
+  }
+  fclose(file);
+
+  size_t pos = 0;
+  while (pos < in.size())
+  {
+    const size_t nsEnd = in.find('\0', pos);
+    const size_t keyEnd = nsEnd == std::string::npos ? nsEnd : in.find('\0', nsEnd + 1);
+    if (keyEnd == std::string::npos || keyEnd + 5 > in.size())
+    {
+      break;
+    }
+    const std::string ns = in.substr(pos, nsEnd - pos);
+    const std::string key = in.substr(nsEnd + 1, keyEnd - nsEnd - 1);
+    const nvs_type_t type = static_cast<nvs_type_t>(static_cast<uint8_t>(in[keyEnd + 1]));
+    const uint32_t length = readU32(in, keyEnd + 2);
+    pos = keyEnd + 6;
+    if (pos + length > in.size())
+    {
+      break;
+    }
+    auto &items = g_store[ns];
+    if (!key.empty())
+    {
+      items[key] = Item{type, in.substr(pos, length)};
+    }
+    pos += length;
+  }
+}
+
+const Handle *findHandle(nvs_handle_t handle)
+{
+  const auto it = g_handles.find(handle);
+  return it == g_handles.end() ? nullptr : &it->second;
+}
+
+// Comprobaciones comunes de una escritura; consume presupuesto del corte.
+esp_err_t beginWrite(nvs_handle_t handle, const char *key, const Handle **out)
+{
+  const Handle *h = findHandle(handle);
+  if (!h)
+  {
+    return ESP_ERR_NVS_INVALID_HANDLE;
+  }
+  if (h->readOnly)
+  {
+    return ESP_ERR_NVS_READ_ONLY;
+  }
+  if (!key || strlen(key) >= NVS_KEY_NAME_MAX_SIZE)
+  {
+    return ESP_ERR_NVS_KEY_TOO_LONG;
+  }
+  if (g_powerCut)
+  {
+    return ESP_FAIL;
+  }
+  if (g_powerCutArmed)
+  {
+    if (g_writesUntilCut == 0)
+    {
+      g_powerCut = true;
+      return ESP_FAIL;
+    }
+    --g_writesUntilCut;
+  }
+  *out = h;
+  return ESP_OK;
+}
+
+esp_err_t setItem(nvs_handle_t handle, const char *key, nvs_type_t type, const std::string &data)
+{
+  const Handle *h = nullptr;
+  const esp_err_t err = beginWrite(handle, key, &h);
+  if (err != ESP_OK)
+  {
+    return err;
+  }
+  g_store[h->ns][key] = Item{type, data};
+  g_stats.writes++;
+  g_stats.bytesWritten += strlen(key) + data.size();
+  accountEntries(type, data.size());
+  save();
+  return ESP_OK;
+}
+
+esp_err_t getItem(nvs_handle_t handle, const char *key, nvs_type_t type, const Item **out)
+{
+  const Handle *h = findHandle(handle);
+  if (!h)
+  {
+    return ESP_ERR_NVS_INVALID_HANDLE;
+  }
+  g_stats.reads++;
+  const auto ns = g_store.find(h->ns);
+  if (ns == g_store.end())
+  {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  const auto it = ns->second.find(key ? key : "");
+  // Igual que ESP-IDF: otro tipo con la misma clave se ve como inexistente.
+  if (it == ns->second.end() || it->second.type != type)
+  {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  *out = &it->second;
+  return ESP_OK;
+}
+} // namespace
+
+struct nvs_opaque_iterator_t
+{
+  std::vector<nvs_entry_info_t> entries;
+  size_t index = 0;
+};
+
+namespace NvsHost
+{
+void reset(const char *path)
+{
+  g_path = path ? path : "nvs_host.bin";
+  remove(g_path.c_str());
+  g_store.clear();
+  g_handles.clear();
+  g_initialized = false;
+  g_loaded = true;
+  g_powerCutArmed = false;
+  g_powerCut = false;
+  resetStats();
+}
+
+void reboot()
+{
+  g_handles.clear();
+  g_initialized = false;
+  g_powerCutArmed = false;
+  g_powerCut = false;
+  load();
+  g_loaded = true;
+}
+
+void cutPowerAfterWrites(uint32_t n)
+{
+  g_powerCutArmed = true;
+  g_powerCut = false;
+  g_writesUntilCut = n;
+}
+
+bool powerCut() { return g_powerCut; }
+
+Stats stats() { return g_stats; }
+
+void resetStats()
+{
+  g_stats = Stats();
+  g_pageEntriesUsed = 0;
+}
+} // namespace NvsHost
+
+esp_err_t nvs_flash_init()
+{
+  if (!g_loaded)
+  {
+    load();
+    g_loaded = true;
+  }
+  g_initialized = true;
+  return ESP_OK;
+}
+
+esp_err_t nvs_flash_deinit()
+{
+  g_handles.clear();
+  g_initialized = false;
+  return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase()
+{
+  g_store.clear();
+  g_handles.clear();
+  save();
+  return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+  if (!g_initialized)
+  {
+    return ESP_ERR_NVS_NOT_INITIALIZED;
+  }
+  if (!name || !out_handle || strlen(name) >= NVS_NS_NAME_MAX_SIZE)
+  {
+    return ESP_ERR_NVS_INVALID_NAME;
+  }
+  if (g_store.find(name) == g_store.end())
+  {
+    if (open_mode == NVS_READONLY)
+    {
+      return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (g_powerCut)
+    {
+      return ESP_FAIL;
+    }
+    g_store[name];
+    save();
+  }
+  g_stats.opens++;
+  *out_handle = g_nextHandle++;
+  g_handles[*out_handle] = Handle{name, open_mode == NVS_READONLY};
+  return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) { g_handles.erase(handle); }
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+  const Handle *h = findHandle(handle);
+  if (!h)
+  {
+    return ESP_ERR_NVS_INVALID_HANDLE;
+  }
+  if (g_powerCut)
+  {
+    return ESP_FAIL;
+  }
+  g_stats.commits++;
+  return ESP_OK;
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char *key, int32_t value)
+{
+  std::string data;
+  appendU32(data, static_cast<uint32_t>(value));
+  return setItem(handle, key, NVS_TYPE_I32, data);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
+{
+  if (!value)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+  return setItem(handle, key, NVS_TYPE_STR, std::string(value));
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+  if (!value && length > 0)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+  return setItem(handle, key, NVS_TYPE_BLOB, std::string(static_cast<const char *>(value), length));
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char *key, int32_t *out_value)
+{
+  const Item *item = nullptr;
+  const esp_err_t err = getItem(handle, key, NVS_TYPE_I32, &item);
+  if (err != ESP_OK)
+  {
+    return err;
+  }
+  if (out_value)
+  {
+    *out_value = static_cast<int32_t>(readU32(item->data, 0));
+  }
+  return ESP_OK;
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length)
+{
+  const Item *item = nullptr;
+  const esp_err_t err = getItem(handle, key, NVS_TYPE_STR, &item);
+  if (err != ESP_OK)
+  {
+    return err;
+  }
+  const size_t required = item->data.size() + 1;
+  if (!out_value)
+  {
+    *length = required;
+    return ESP_OK;
+  }
+  if (*length < required)
+  {
+    return ESP_ERR_NVS_INVALID_LENGTH;
+  }
+  memcpy(out_value, item->data.c_str(), required);
+  *length = required;
+  return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+  const Item *item = nullptr;
+  const esp_err_t err = getItem(handle, key, NVS_TYPE_BLOB, &item);
+  if (err != ESP_OK)
+  {
+    return err;
+  }
+  if (!out_value)
+  {
+    *length = item->data.size();
+    return ESP_OK;
+  }
+  if (*length < item->data.size())
+  {
+    return ESP_ERR_NVS_INVALID_LENGTH;
+  }
+  memcpy(out_value, item->data.data(), item->data.size());
+  *length = item->data.size();
+  return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+  const Handle *h = findHandle(handle);
+  if (!h)
+  {
+    return ESP_ERR_NVS_INVALID_HANDLE;
+  }
+  auto &items = g_store[h->ns];
+  if (items.find(key ? key : "") == items.end())
+  {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  const esp_err_t err = beginWrite(handle, key, &h);
+  if (err != ESP_OK)
+  {
+    return err;
+  }
+  items.erase(key);
+  g_stats.writes++;
+  save();
+  return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+  const Handle *h = findHandle(handle);
+  if (!h)
+  {
+    return ESP_ERR_NVS_INVALID_HANDLE;
+  }
+  if (h->readOnly)
+  {
+    return ESP_ERR_NVS_READ_ONLY;
+  }
+  if (g_powerCut)
+  {
+    return ESP_FAIL;
+  }
+  g_store[h->ns].clear();
+  g_stats.writes++;
+  save();
+  return ESP_OK;
+}
+
+nvs_iterator_t nvs_entry_find(const char *, const char *namespace_name, nvs_type_t type)
+{
+  nvs_opaque_iterator_t *it = new nvs_opaque_iterator_t();
+  for (const auto &ns : g_store)
+  {
+    if (namespace_name && ns.first != namespace_name)
+    {
+      continue;
+    }
+    for (const auto &entry : ns.second)
+    {
+      if (type != NVS_TYPE_ANY && entry.second.type != type)
+      {
+        continue;
+      }
+      nvs_entry_info_t info = {};
+      strncpy(info.namespace_name, ns.first.c_str(), sizeof(info.namespace_name) - 1);
+      strncpy(info.key, entry.first.c_str(), sizeof(info.key) - 1);
+      info.type = entry.second.type;
+      it->entries.push_back(info);
+    }
+  }
+  if (it->entries.empty())
+  {
+    delete it;
+    return nullptr;
+  }
+  return it;
+}
+
+// Avanza en el sitio; al llegar al final devuelve nullptr sin liberar, para
+// que nvs_release_iterator() sobre el primer puntero sea siempre valido.
+nvs_iterator_t nvs_entry_next(nvs_iterator_t iterator)
+{
+  if (!iterator || ++iterator->index >= iterator->entries.size())
+  {
+    return nullptr;
+  }
+  return iterator;
+}
+
+void nvs_entry_info(nvs_iterator_t iterator, nvs_entry_info_t *out_info)
+{
+  if (iterator && out_info && iterator->index < iterator->entries.size())
+  {
+    *out_info = iterator->entries[iterator->index];
+  }
+}
+
+void nvs_release_iterator(nvs_iterator_t iterator) { delete iterator; }
@@ -0,0 +1,198 @@
+#include "u8g2_host.h"
+
+#include <U8g2lib.h>
+
+#include <cstring>
+
+namespace
+{
+constexpr int kWidth = U8G2::kTileWidth * 8;
+constexpr int kHeight = U8G2::kTileHeight * 8;
+constexpr uint32_t kRunOverhead = 5;
+constexpr uint32_t kChunkBytes = 24;
+constexpr uint32_t kChunkOverhead = 2;
+
+uint8_t g_panel[U8g2Host::kPanelBytes] = {};
+U8g2Host::Stats g_stats;
+
+// Un tramo de tiles consecutivos de una fila, como u8x8_DrawTile.
+void drawTiles(uint8_t tx, uint8_t ty, uint8_t count, const uint8_t *data)
+{
+  const uint32_t bytes = static_cast<uint32_t>(count) * 8;
+  std::memcpy(g_panel + ty * kWidth + tx * 8, data, bytes);
+  g_stats.tilesSent += count;
+  g_stats.i2cBytes += kRunOverhead + bytes + (bytes + kChunkBytes - 1) / kChunkBytes * kChunkOverhead;
+}
+} // namespace
+
+namespace U8g2Host
+{
+void reset()
+{
+  std::memset(g_panel, 0, sizeof(g_panel));
+  g_stats = Stats();
+}
+
+const uint8_t *panel() { return g_panel; }
+
+Stats stats() { return g_stats; }
+
+void resetStats() { g_stats = Stats(); }
+} // namespace U8g2Host
+
+void U8G2::begin()
+{
+  clearDisplay();
+}
+
+void U8G2::clearDisplay()
+{
+  const uint8_t zeros[kWidth] = {};
+  for (uint8_t row = 0; row < kTileHeight; ++row)
+  {
+    drawTiles(0, row, kTileWidth, zeros);
+  }
+  clearBuffer();
+}
+
+void U8G2::clearBuffer()
+{
+  std::memset(buffer_, 0, static_cast<size_t>(tileBufHeight_) * kWidth);
+}
+
+void U8G2::sendBuffer()
+{
+  g_stats.fullSends++;
+  for (uint8_t row = 0; row < tileBufHeight_ && currTileRow_ + row < kTileHeight; ++row)
+  {
+    drawTiles(0, currTileRow_ + row, kTileWidth, buffer_ + row * kWidth);
+  }
+}
+
+void U8G2::updateDisplay()
+{
+  sendBuffer();
+}
+
+void U8G2::updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th)
+{
+  // Igual que U8g2: solo hace algo con el buffer completo.
+  if (tileBufHeight_ != kTileHeight || tx >= kTileWidth || ty >= kTileHeight)
+  {
+    return;
+  }
+  if (tx + tw > kTileWidth)
+  {
+    tw = kTileWidth - tx;
+  }
+  if (ty + th > kTileHeight)
+  {
+    th = kTileHeight - ty;
+  }
+  g_stats.areaUpdates++;
+  for (uint8_t row = ty; row < ty + th; ++row)
+  {
+    drawTiles(tx, row, tw, buffer_ + row * kWidth + tx * 8);
+  }
+}
+
+void U8G2::drawPixel(int x, int y)
+{
+  if (x < 0 || x >= kWidth || y < 0 || y >= kHeight)
+  {
+    return;
+  }
+  const int row = y / 8 - currTileRow_;
+  if (row < 0 || row >= tileBufHeight_)
+  {
+    return;
+  }
+  buffer_[row * kWidth + x] |= static_cast<uint8_t>(1u << (y & 7));
+}
+
+void U8G2::drawHLine(int x, int y, int w)
+{
+  for (int i = 0; i < w; ++i)
+  {
+    drawPixel(x + i, y);
+  }
+}
+
+void U8G2::drawVLine(int x, int y, int h)
+{
+  for (int i = 0; i < h; ++i)
+  {
+    drawPixel(x, y + i);
+  }
+}
+
+void U8G2::drawFrame(int x, int y, int w, int h)
+{
+  drawHLine(x, y, w);
+  drawHLine(x, y + h - 1, w);
+  drawVLine(x, y, h);
+  drawVLine(x + w - 1, y, h);
+}
+
+// Mismo recorrido de punto medio que u8g2_draw_circle/u8g2_draw_disc.
+void U8G2::drawCircle(int x0, int y0, int r)
+{
+  int f = 1 - r;
+  int ddFx = 1;
+  int ddFy = -2 * r;
+  int x = 0;
+  int y = r;
+  for (;;)
+  {
+    drawPixel(x0 + x, y0 + y);
+    drawPixel(x0 - x, y0 + y);
+    drawPixel(x0 + x, y0 - y);
+    drawPixel(x0 - x, y0 - y);
+    drawPixel(x0 + y, y0 + x);
+    drawPixel(x0 - y, y0 + x);
+    drawPixel(x0 + y, y0 - x);
+    drawPixel(x0 - y, y0 - x);
+    if (x >= y)
+    {
+      break;
+    }
+    if (f >= 0)
+    {
+      --y;
+      ddFy += 2;
+      f += ddFy;
+    }
+    ++x;
+    ddFx += 2;
+    f += ddFx;
+  }
+}
+
+void U8G2::drawDisc(int x0, int y0, int r)
+{
+  int f = 1 - r;
+  int ddFx = 1;
+  int ddFy = -2 * r;
+  int x = 0;
+  int y = r;
+  for (;;)
+  {
+    drawVLine(x0 + x, y0 - y, 2 * y + 1);
+    drawVLine(x0 - x, y0 - y, 2 * y + 1);
+    drawVLine(x0 + y, y0 - x, 2 * x + 1);
+    drawVLine(x0 - y, y0 - x, 2 * x + 1);
+    if (x >= y)
+    {
+      break;
+    }
+    if (f >= 0)
+    {
+      --y;
+      ddFy += 2;
+      f += ddFy;
+    }
+    ++x;
+    ddFx += 2;
+    f += ddFx;
+  }
+}
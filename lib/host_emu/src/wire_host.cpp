@@ -0,0 +1,67 @@
+#include "wire_host.h"
+
+#include <Wire.h>
+
+TwoWire Wire;
+
+namespace
+{
+constexpr uint32_t kDefaultClockHz = 100000;
+constexpr uint8_t kAddressNack = 2;
+
+WireHost::Config g_config;
+WireHost::Stats g_stats;
+} // namespace
+
+namespace WireHost
+{
+void reset()
+{
+  g_config = Config();
+  g_stats = Stats();
+}
+
+Config config() { return g_config; }
+
+Stats stats() { return g_stats; }
+} // namespace WireHost
+
+// Como arduino-esp32 2.x: con el driver ya iniciado, begin() no cambia nada.
+bool TwoWire::begin(int sdaPin, int sclPin, uint32_t frequency)
+{
+  if (g_config.started)
+  {
+    return true;
+  }
+  g_config.started = true;
+  g_config.sdaPin = sdaPin;
+  g_config.sclPin = sclPin;
+  g_config.clockHz = frequency ? frequency : kDefaultClockHz;
+  g_stats.begins++;
+  return true;
+}
+
+bool TwoWire::end()
+{
+  if (!g_config.started)
+  {
+    return false;
+  }
+  g_config.started = false;
+  g_stats.ends++;
+  return true;
+}
+
+bool TwoWire::setClock(uint32_t frequency)
+{
+  g_config.clockHz = frequency;
+  return true;
+}
+
+void TwoWire::beginTransmission(uint8_t) {}
+
+uint8_t TwoWire::endTransmission(bool)
+{
+  g_stats.transmissions++;
+  return kAddressNack;
+}
@@ -1,88 +1,125 @@
 #include "Config.hpp"
 
 #include <Arduino.h>
-#include <algorithm>
 #include <cstring>
 #include <nvs.h>
 #include <nvs_flash.h>
 #include <string>
-#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "heap_monitor.h"
+#include "log.h"
 
 namespace Config
 {
   namespace
   {
     bool g_initialized = false;
-    std::vector<std::string> g_loggedMissingKeys;
-
-    constexpr const char *kNamespaces[] = {"aws", "wifi", "device", "certs", "diag"};
+    std::unordered_set<std::string> g_loggedMissingKeys;
+    bool g_loggedMissingSchema[kKeyCount] = {};
 
-    struct LengthLimit
+    // Cache read-through de NVS. Las claves del schema van en un array
+    // indexado por Key; las demas en un mapa por "ns/key". Solo se usa desde
+    // la tarea de loop(), igual que el resto de Config; los set actualizan la
+    // entrada.
+    struct CacheEntry
     {
-      const char *ns;
-      const char *key;
-      size_t maxLen;
+      enum class Kind : uint8_t
+      {
+        MISSING,
+        STRING,
+        INT,
+      };
+
+      bool loaded = false;
+      Kind kind = Kind::MISSING;
+      std::string text;
+      int32_t number = 0;
     };
 
-    constexpr size_t kDefaultMaxLen = 512;
-    constexpr LengthLimit kLengthLimits[] = {
-        {"wifi", "ssid", 128},
-        {"wifi", "password", 128},
-        {"device", "device_id", 128},
-        {"device", "env", 64},
-        {"aws", "endpoint", 256},
-        {"aws", "thing", 128},
-        {"certs", "root_ca", 256},
-        {"certs", "device_cert", 256},
-        {"certs", "private_key", 256},
-    };
+    CacheEntry g_schemaCache[kKeyCount];
+    std::unordered_map<std::string, CacheEntry> g_cache;
+    CacheStats g_cacheStats;
+
+    // Tambien es el orden en que Transaction::commit() escribe los namespaces.
+    constexpr const char *kNamespaces[] = {"aws", "wifi", "device", "certs", "diag", "meta"};
+    constexpr int kNotInSchema = -1;
+    constexpr const char kMetaNamespace[] = "meta";
+    constexpr const char kJournalKey[] = "journal";
+
+    void recoverJournal();
 
-    bool hasLogged(const char *ns, const char *key)
+    std::string cacheKey(const char *ns, const char *key)
     {
-      const std::string token = std::string(ns ? ns : "") + "/" + (key ? key : "");
-      if (std::find(g_loggedMissingKeys.begin(), g_loggedMissingKeys.end(), token) !=
-          g_loggedMissingKeys.end())
+      return std::string(ns ? ns : "") + "/" + (key ? key : "");
+    }
+
+    // Solo para la API por ns/key; el codigo nuevo usa Key directamente.
+    int findKey(const char *ns, const char *key)
+    {
+      if (!ns || !key)
       {
-        return true;
+        return kNotInSchema;
       }
-      g_loggedMissingKeys.push_back(token);
-      return false;
+      for (size_t i = 0; i < kKeyCount; ++i)
+      {
+        if (strcmp(kSchema[i].key, key) == 0 && strcmp(kSchema[i].ns, ns) == 0)
+        {
+          return static_cast<int>(i);
+        }
+      }
+      return kNotInSchema;
     }
 
     void logMissing(const char *ns, const char *key)
     {
-      if (hasLogged(ns, key))
+      const int index = findKey(ns, key);
+      if (index != kNotInSchema)
+      {
+        if (g_loggedMissingSchema[index])
+        {
+          return;
+        }
+        g_loggedMissingSchema[index] = true;
+      }
+      else if (!g_loggedMissingKeys.insert(cacheKey(ns, key)).second)
       {
         return;
       }
-      Serial.printf("[CONFIG] Clave faltante %s/%s\n", ns, key);
+      LOG_WARN(CONFIG, "Clave faltante %s/%s\n", ns, key);
     }
 
-    size_t maxAllowedLength(const char *ns, const char *key)
+    void logMissing(Key key)
     {
-      if (!ns || !key)
+      const size_t index = static_cast<size_t>(key);
+      if (g_loggedMissingSchema[index])
       {
-        return kDefaultMaxLen;
+        return;
       }
-      for (const LengthLimit &entry : kLengthLimits)
+      g_loggedMissingSchema[index] = true;
+      LOG_WARN(CONFIG, "Clave faltante %s/%s\n", kSchema[index].ns, kSchema[index].key);
+    }
+
+    bool checkType(Key key, Type expected)
+    {
+      const KeySpec &entry = spec(key);
+      if (entry.type == expected)
       {
-        if (strcmp(entry.ns, ns) == 0 && strcmp(entry.key, key) == 0)
-        {
-          return entry.maxLen;
-        }
+        return true;
       }
-      return kDefaultMaxLen;
+      LOG_WARN(CONFIG, "Tipo incorrecto para %s/%s\n", entry.ns, entry.key);
+      return false;
     }
 
-    bool validateLength(const char *ns, const char *key, const std::string &value)
+    bool validateLength(const char *ns, const char *key, const std::string &value, size_t maxLen)
     {
-      const size_t maxLen = maxAllowedLength(ns, key);
       if (value.length() > maxLen)
       {
-        Serial.printf("[CONFIG] Valor demasiado largo %s/%s (max %u)\n",
-                      ns,
-                      key,
-                      static_cast<unsigned>(maxLen));
+        LOG_WARN(CONFIG, "Valor demasiado largo %s/%s (max %u)\n",
+                 ns,
+                 key,
+                 static_cast<unsigned>(maxLen));
         return false;
       }
       return true;
@@ -118,189 +155,722 @@ namespace Config
       if (err == ESP_OK)
       {
         g_initialized = true;
+        recoverJournal();
       }
       else
       {
-        Serial.printf("[CONFIG] Error inicializando NVS (%d)\n", static_cast<int>(err));
+        LOG_ERROR(CONFIG, "Error inicializando NVS (%d)\n", static_cast<int>(err));
       }
       return err;
     }
-  } // namespace
 
-  void init() { ensureInit(); }
+    // Lee ns/key de NVS como string o int32. Devuelve false ante errores que
+    // no conviene cachear (NVS sin inicializar, fallo de lectura).
+    bool loadEntry(const char *ns, const char *key, CacheEntry &entry)
+    {
+      HeapMonitor::Scope heapScope(HeapMonitor::Tag::CONFIG);
+      entry = CacheEntry();
+      if (ensureInit() != ESP_OK)
+      {
+        return false;
+      }
 
-  esp_err_t setString(const char *ns, const char *key, const std::string &value)
-  {
-    esp_err_t err = ensureInit();
-    if (err != ESP_OK)
+      nvs_handle_t handle;
+      esp_err_t err = nvs_open(ns, NVS_READONLY, &handle);
+      if (err == ESP_ERR_NVS_NOT_FOUND)
+      {
+        entry.loaded = true;
+        return true;
+      }
+      if (err != ESP_OK)
+      {
+        return false;
+      }
+
+      size_t length = 0;
+      err = nvs_get_str(handle, key, nullptr, &length);
+      if (err == ESP_OK)
+      {
+        entry.kind = CacheEntry::Kind::STRING;
+        if (length > 0)
+        {
+          entry.text.resize(length);
+          err = nvs_get_str(handle, key, &entry.text[0], &length);
+          if (!entry.text.empty() && entry.text.back() == '\0')
+          {
+            entry.text.pop_back();
+          }
+        }
+      }
+      else if (err == ESP_ERR_NVS_NOT_FOUND || err == ESP_ERR_NVS_TYPE_MISMATCH)
+      {
+        // NVS busca por (clave, tipo): un int32 da NOT_FOUND al leerlo como
+        // string, no TYPE_MISMATCH.
+        err = nvs_get_i32(handle, key, &entry.number);
+        if (err == ESP_OK)
+        {
+          entry.kind = CacheEntry::Kind::INT;
+        }
+        else if (err == ESP_ERR_NVS_TYPE_MISMATCH)
+        {
+          // Otro tipo (blob, u8...): para Config equivale a inexistente.
+          err = ESP_OK;
+        }
+      }
+      nvs_close(handle);
+
+      if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND)
+      {
+        entry = CacheEntry();
+        return false;
+      }
+      entry.loaded = true;
+      return true;
+    }
+
+    const CacheEntry *resolve(CacheEntry &entry, const char *ns, const char *key)
     {
-      return err;
+      if (entry.loaded)
+      {
+        g_cacheStats.hits++;
+        return &entry;
+      }
+      g_cacheStats.misses++;
+      return loadEntry(ns, key, entry) ? &entry : nullptr;
     }
 
-    if (!validateLength(ns, key, value))
+    const CacheEntry *lookup(Key key)
     {
-      return ESP_ERR_INVALID_SIZE;
+      const size_t index = static_cast<size_t>(key);
+      return resolve(g_schemaCache[index], kSchema[index].ns, kSchema[index].key);
     }
 
-    nvs_handle_t handle;
-    err = nvs_open(ns, NVS_READWRITE, &handle);
-    if (err != ESP_OK)
+    const CacheEntry *lookup(const char *ns, const char *key)
     {
-      Serial.printf("[CONFIG] No se pudo abrir namespace %s (%d)\n", ns, static_cast<int>(err));
-      return err;
+      if (!ns || !key)
+      {
+        return nullptr;
+      }
+      const int index = findKey(ns, key);
+      if (index != kNotInSchema)
+      {
+        return lookup(static_cast<Key>(index));
+      }
+      return resolve(g_cache[cacheKey(ns, key)], ns, key);
     }
 
-    err = nvs_set_str(handle, key, value.c_str());
-    if (err == ESP_OK)
+    CacheEntry *slotFor(const char *ns, const char *key)
     {
-      err = nvs_commit(handle);
+      HeapMonitor::Scope heapScope(HeapMonitor::Tag::CONFIG);
+      const int index = findKey(ns, key);
+      if (index != kNotInSchema)
+      {
+        return &g_schemaCache[index];
+      }
+      return &g_cache[cacheKey(ns, key)];
     }
-    nvs_close(handle);
 
-    if (err != ESP_OK)
+    void store(CacheEntry &slot, esp_err_t err, CacheEntry::Kind kind, const std::string &text, int32_t number)
     {
-      Serial.printf("[CONFIG] Error al guardar %s/%s (%d)\n", ns, key, static_cast<int>(err));
+      slot = CacheEntry();
+      if (err != ESP_OK)
+      {
+        // No se sabe que quedo en flash: la proxima lectura va a NVS.
+        return;
+      }
+      slot.loaded = true;
+      slot.kind = kind;
+      slot.text = text;
+      slot.number = number;
     }
-    return err;
-  }
 
-  esp_err_t setInt(const char *ns, const char *key, int32_t value)
-  {
-    esp_err_t err = ensureInit();
-    if (err != ESP_OK)
+    esp_err_t writeString(const char *ns, const char *key, const std::string &value, size_t maxLen)
     {
+      HeapMonitor::Scope heapScope(HeapMonitor::Tag::CONFIG);
+      esp_err_t err = ensureInit();
+      if (err != ESP_OK)
+      {
+        return err;
+      }
+
+      if (!validateLength(ns, key, value, maxLen))
+      {
+        return ESP_ERR_INVALID_SIZE;
+      }
+
+      nvs_handle_t handle;
+      err = nvs_open(ns, NVS_READWRITE, &handle);
+      if (err != ESP_OK)
+      {
+        LOG_ERROR(CONFIG, "No se pudo abrir namespace %s (%d)\n", ns, static_cast<int>(err));
+        return err;
+      }
+
+      err = nvs_set_str(handle, key, value.c_str());
+      if (err == ESP_OK)
+      {
+        err = nvs_commit(handle);
+      }
+      nvs_close(handle);
+
+      if (err != ESP_OK)
+      {
+        LOG_ERROR(CONFIG, "Error al guardar %s/%s (%d)\n", ns, key, static_cast<int>(err));
+      }
       return err;
     }
 
-    nvs_handle_t handle;
-    err = nvs_open(ns, NVS_READWRITE, &handle);
-    if (err != ESP_OK)
+    esp_err_t writeInt(const char *ns, const char *key, int32_t value)
     {
-      Serial.printf("[CONFIG] No se pudo abrir namespace %s (%d)\n", ns, static_cast<int>(err));
+      esp_err_t err = ensureInit();
+      if (err != ESP_OK)
+      {
+        return err;
+      }
+
+      nvs_handle_t handle;
+      err = nvs_open(ns, NVS_READWRITE, &handle);
+      if (err != ESP_OK)
+      {
+        LOG_ERROR(CONFIG, "No se pudo abrir namespace %s (%d)\n", ns, static_cast<int>(err));
+        return err;
+      }
+
+      err = nvs_set_i32(handle, key, value);
+      if (err == ESP_OK)
+      {
+        err = nvs_commit(handle);
+      }
+      nvs_close(handle);
+
+      if (err != ESP_OK)
+      {
+        LOG_ERROR(CONFIG, "Error al guardar %s/%s (%d)\n", ns, key, static_cast<int>(err));
+      }
       return err;
     }
 
-    err = nvs_set_i32(handle, key, value);
-    if (err == ESP_OK)
+    std::string readString(const CacheEntry *entry, const std::string &def)
+    {
+      HeapMonitor::Scope heapScope(HeapMonitor::Tag::CONFIG);
+      if (!entry || entry->kind != CacheEntry::Kind::STRING)
+      {
+        return def;
+      }
+      return entry->text;
+    }
+
+    int32_t readInt(const CacheEntry *entry, int32_t def)
     {
-      err = nvs_commit(handle);
+      if (!entry || entry->kind != CacheEntry::Kind::INT)
+      {
+        return def;
+      }
+      return entry->number;
     }
-    nvs_close(handle);
 
-    if (err != ESP_OK)
+    // Cambia si cambia cualquier campo del schema, aunque FW_VERSION no se toque.
+    uint32_t schemaHash()
+    {
+      uint32_t hash = 2166136261u;
+      auto mix = [&hash](const void *data, size_t length) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < length; ++i)
+        {
+          hash = (hash ^ bytes[i]) * 16777619u;
+        }
+      };
+      for (const KeySpec &entry : kSchema)
+      {
+        mix(entry.ns, strlen(entry.ns) + 1);
+        mix(entry.key, strlen(entry.key) + 1);
+        mix(entry.defaultString, strlen(entry.defaultString) + 1);
+        mix(&entry.type, sizeof(entry.type));
+        mix(&entry.defaultInt, sizeof(entry.defaultInt));
+        mix(&entry.seeded, sizeof(entry.seeded));
+      }
+      return hash;
+    }
+    // Journal: u32 generacion, y por escritura u8 tipo, ns\0, clave\0 y el
+    // valor (i32 little endian, o u16 longitud + bytes). Guarda ns/clave en
+    // texto para seguir siendo legible si el schema cambia entre versiones.
+    void appendU32(std::string &out, uint32_t value)
     {
-      Serial.printf("[CONFIG] Error al guardar %s/%s (%d)\n", ns, key, static_cast<int>(err));
+      for (int i = 0; i < 4; ++i)
+      {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+      }
     }
+
+    bool readU32(const std::string &in, size_t &pos, uint32_t &value)
+    {
+      if (pos + 4 > in.size())
+      {
+        return false;
+      }
+      value = 0;
+      for (int i = 0; i < 4; ++i)
+      {
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(in[pos + i])) << (8 * i);
+      }
+      pos += 4;
+      return true;
+    }
+
+    bool readCString(const std::string &in, size_t &pos, std::string &value)
+    {
+      const size_t end = in.find('\0', pos);
+      if (end == std::string::npos)
+      {
+        return false;
+      }
+      value.assign(in, pos, end - pos);
+      pos = end + 1;
+      return true;
+    }
+
+    esp_err_t writeMeta(const std::string *journal, const int32_t *generationValue)
+    {
+      HeapMonitor::Scope heapScope(HeapMonitor::Tag::CONFIG);
+      nvs_handle_t handle;
+      esp_err_t err = nvs_open(kMetaNamespace, NVS_READWRITE, &handle);
+      if (err != ESP_OK)
+      {
+        return err;
+      }
+      if (journal)
+      {
+        err = nvs_set_blob(handle, kJournalKey, journal->data(), journal->size());
+      }
+      if (err == ESP_OK && generationValue)
+      {
+        err = nvs_set_i32(handle, spec(Key::CONFIG_GENERATION).key, *generationValue);
+        if (err == ESP_OK)
+        {
+          err = nvs_erase_key(handle, kJournalKey);
+          err = err == ESP_ERR_NVS_NOT_FOUND ? ESP_OK : err;
+        }
+      }
+      if (err == ESP_OK)
+      {
+        err = nvs_commit(handle);
+      }
+      nvs_close(handle);
+
+      if (generationValue)
+      {
+        store(g_schemaCache[static_cast<size_t>(Key::CONFIG_GENERATION)],
+              err,
+              CacheEntry::Kind::INT,
+              std::string(),
+              *generationValue);
+      }
+      return err;
+    }
+
+    bool readJournal(std::string &journal)
+    {
+      nvs_handle_t handle;
+      if (nvs_open(kMetaNamespace, NVS_READONLY, &handle) != ESP_OK)
+      {
+        return false;
+      }
+      size_t length = 0;
+      esp_err_t err = nvs_get_blob(handle, kJournalKey, nullptr, &length);
+      if (err == ESP_OK && length > 0)
+      {
+        journal.resize(length);
+        err = nvs_get_blob(handle, kJournalKey, &journal[0], &length);
+      }
+      nvs_close(handle);
+      return err == ESP_OK && length > 0;
+    }
+
+    void recoverJournal()
+    {
+      HeapMonitor::Scope heapScope(HeapMonitor::Tag::CONFIG);
+      std::string journal;
+      if (!readJournal(journal))
+      {
+        return;
+      }
+
+      size_t pos = 0;
+      uint32_t journalGeneration = 0;
+      const uint32_t current = static_cast<uint32_t>(getInt(Key::CONFIG_GENERATION));
+      bool valid = readU32(journal, pos, journalGeneration);
+      if (valid && journalGeneration > current)
+      {
+        LOG_WARN(CONFIG, "Completando transaccion interrumpida (gen %lu)\n",
+                 static_cast<unsigned long>(journalGeneration));
+        while (valid && pos < journal.size())
+        {
+          const Type type = static_cast<Type>(journal[pos++]);
+          std::string ns;
+          std::string key;
+          valid = readCString(journal, pos, ns) && readCString(journal, pos, key);
+          if (!valid)
+          {
+            break;
+          }
+          if (type == Type::INT)
+          {
+            uint32_t value = 0;
+            valid = readU32(journal, pos, value);
+            if (valid)
+            {
+              setInt(ns.c_str(), key.c_str(), static_cast<int32_t>(value));
+            }
+          }
+          else
+          {
+            valid = pos + 2 <= journal.size();
+            if (!valid)
+            {
+              break;
+            }
+            const size_t length = static_cast<uint8_t>(journal[pos]) |
+                                  (static_cast<size_t>(static_cast<uint8_t>(journal[pos + 1])) << 8);
+            pos += 2;
+            valid = pos + length <= journal.size();
+            if (valid)
+            {
+              setString(ns.c_str(), key.c_str(), journal.substr(pos, length));
+              pos += length;
+            }
+          }
+        }
+      }
+
+      if (!valid)
+      {
+        LOG_ERROR(CONFIG, "Journal corrupto, descartado\n");
+      }
+      const int32_t generationValue =
+          static_cast<int32_t>(valid && journalGeneration > current ? journalGeneration : current);
+      writeMeta(nullptr, &generationValue);
+    }
+  } // namespace
+
+  void init() { ensureInit(); }
+
+  void deinit()
+  {
+    if (g_initialized)
+    {
+      nvs_flash_deinit();
+    }
+    g_initialized = false;
+    for (CacheEntry &entry : g_schemaCache)
+    {
+      entry = CacheEntry();
+    }
+    g_cache.clear();
+  }
+
+  esp_err_t setString(const char *ns, const char *key, const std::string &value)
+  {
+    const int index = findKey(ns, key);
+    if (index != kNotInSchema)
+    {
+      return setString(static_cast<Key>(index), value);
+    }
+    const esp_err_t err = writeString(ns, key, value, kDefaultMaxLen);
+    store(*slotFor(ns, key), err, CacheEntry::Kind::STRING, value, 0);
     return err;
   }
 
-  std::string getString(const char *ns, const char *key, const std::string &def)
+  esp_err_t setInt(const char *ns, const char *key, int32_t value)
   {
-    esp_err_t err = ensureInit();
-    if (err != ESP_OK)
+    const int index = findKey(ns, key);
+    if (index != kNotInSchema)
     {
-      return def;
+      return setInt(static_cast<Key>(index), value);
     }
+    const esp_err_t err = writeInt(ns, key, value);
+    store(*slotFor(ns, key), err, CacheEntry::Kind::INT, std::string(), value);
+    return err;
+  }
 
-    nvs_handle_t handle;
-    err = nvs_open(ns, NVS_READONLY, &handle);
-    if (err != ESP_OK)
+  std::string getString(const char *ns, const char *key, const std::string &def)
+  {
+    const CacheEntry *entry = lookup(ns, key);
+    if (entry && entry->kind == CacheEntry::Kind::MISSING)
     {
       logMissing(ns, key);
-      return def;
     }
+    return readString(entry, def);
+  }
 
-    size_t length = 0;
-    err = nvs_get_str(handle, key, nullptr, &length);
-    if (err == ESP_ERR_NVS_NOT_FOUND)
+  int32_t getInt(const char *ns, const char *key, int32_t def)
+  {
+    const CacheEntry *entry = lookup(ns, key);
+    if (entry && entry->kind == CacheEntry::Kind::MISSING)
     {
-      nvs_close(handle);
       logMissing(ns, key);
-      return def;
     }
-    if (err != ESP_OK || length == 0)
+    return readInt(entry, def);
+  }
+
+  bool exists(const char *ns, const char *key)
+  {
+    const CacheEntry *entry = lookup(ns, key);
+    return entry && entry->kind != CacheEntry::Kind::MISSING;
+  }
+
+  esp_err_t setString(Key key, const std::string &value)
+  {
+    if (!checkType(key, Type::STRING))
     {
-      nvs_close(handle);
-      return def;
+      return ESP_ERR_INVALID_ARG;
     }
+    const KeySpec &entry = spec(key);
+    const esp_err_t err = writeString(entry.ns, entry.key, value, entry.maxLen);
+    store(g_schemaCache[static_cast<size_t>(key)], err, CacheEntry::Kind::STRING, value, 0);
+    return err;
+  }
 
-    std::string value;
-    value.resize(length);
-    err = nvs_get_str(handle, key, &value[0], &length);
-    nvs_close(handle);
-    if (err != ESP_OK)
+  esp_err_t setInt(Key key, int32_t value)
+  {
+    if (!checkType(key, Type::INT))
+    {
+      return ESP_ERR_INVALID_ARG;
+    }
+    const KeySpec &entry = spec(key);
+    const esp_err_t err = writeInt(entry.ns, entry.key, value);
+    store(g_schemaCache[static_cast<size_t>(key)], err, CacheEntry::Kind::INT, std::string(), value);
+    return err;
+  }
+
+  std::string getString(Key key)
+  {
+    return getString(key, spec(key).defaultString);
+  }
+
+  std::string getString(Key key, const std::string &def)
+  {
+    if (!checkType(key, Type::STRING))
     {
       return def;
     }
-    if (!value.empty() && value.back() == '\0')
+    const CacheEntry *entry = lookup(key);
+    if (entry && entry->kind == CacheEntry::Kind::MISSING)
     {
-      value.pop_back();
+      logMissing(key);
     }
-    return value;
+    return readString(entry, def);
   }
 
-  int32_t getInt(const char *ns, const char *key, int32_t def)
+  int32_t getInt(Key key)
   {
-    esp_err_t err = ensureInit();
-    if (err != ESP_OK)
+    if (!checkType(key, Type::INT))
     {
-      return def;
+      return spec(key).defaultInt;
+    }
+    const CacheEntry *entry = lookup(key);
+    if (entry && entry->kind == CacheEntry::Kind::MISSING)
+    {
+      logMissing(key);
     }
+    return readInt(entry, spec(key).defaultInt);
+  }
 
-    nvs_handle_t handle;
-    err = nvs_open(ns, NVS_READONLY, &handle);
-    if (err != ESP_OK)
+  bool exists(Key key)
+  {
+    const CacheEntry *entry = lookup(key);
+    return entry && entry->kind != CacheEntry::Kind::MISSING;
+  }
+
+  bool seedDefaults(const char *firmwareVersion)
+  {
+    char stamp[64];
+    snprintf(stamp,
+             sizeof(stamp),
+             "%s/%08lx",
+             firmwareVersion ? firmwareVersion : "",
+             static_cast<unsigned long>(schemaHash()));
+
+    const CacheEntry *current = lookup(Key::SCHEMA_STAMP);
+    if (current && current->kind == CacheEntry::Kind::STRING && current->text == stamp)
     {
-      logMissing(ns, key);
-      return def;
+      return false;
     }
 
-    int32_t value = def;
-    err = nvs_get_i32(handle, key, &value);
-    nvs_close(handle);
-    if (err == ESP_ERR_NVS_NOT_FOUND)
+    bool complete = true;
+    for (const KeySpec &entry : kSchema)
     {
-      logMissing(ns, key);
-      return def;
+      if (!entry.seeded || exists(entry.id))
+      {
+        continue;
+      }
+      const esp_err_t err = entry.type == Type::STRING ? setString(entry.id, entry.defaultString)
+                                                       : setInt(entry.id, entry.defaultInt);
+      complete = complete && err == ESP_OK;
     }
-    if (err != ESP_OK)
+
+    // Sin stamp si algo fallo: se reintenta en el proximo arranque.
+    if (complete)
     {
-      return def;
+      setString(Key::SCHEMA_STAMP, stamp);
     }
-    return value;
+    return true;
   }
 
-  bool exists(const char *ns, const char *key)
+  Transaction::Write &Transaction::stage(Key key)
   {
-    if (ensureInit() != ESP_OK)
+    HeapMonitor::Scope heapScope(HeapMonitor::Tag::CONFIG);
+    for (Write &write : m_writes)
+    {
+      if (write.key == key)
+      {
+        return write;
+      }
+    }
+    m_writes.push_back(Write{key, std::string(), 0});
+    return m_writes.back();
+  }
+
+  bool Transaction::setString(Key key, const std::string &value)
+  {
+    const KeySpec &entry = spec(key);
+    if (!checkType(key, Type::STRING) || !validateLength(entry.ns, entry.key, value, entry.maxLen))
     {
       return false;
     }
+    stage(key).text = value;
+    return true;
+  }
 
-    nvs_handle_t handle;
-    esp_err_t err = nvs_open(ns, NVS_READONLY, &handle);
-    if (err != ESP_OK)
+  bool Transaction::setInt(Key key, int32_t value)
+  {
+    if (!checkType(key, Type::INT))
     {
       return false;
     }
+    stage(key).number = value;
+    return true;
+  }
 
-    size_t length = 0;
-    err = nvs_get_str(handle, key, nullptr, &length);
-    if (err == ESP_OK || err == ESP_ERR_NVS_INVALID_LENGTH)
+  esp_err_t Transaction::commit()
+  {
+    HeapMonitor::Scope heapScope(HeapMonitor::Tag::CONFIG);
+    if (m_writes.empty())
     {
-      nvs_close(handle);
-      return true;
+      return ESP_OK;
     }
-    if (err == ESP_ERR_NVS_TYPE_MISMATCH)
+    esp_err_t err = ensureInit();
+    if (err != ESP_OK)
     {
-      int32_t dummy = 0;
-      err = nvs_get_i32(handle, key, &dummy);
-      nvs_close(handle);
-      return err == ESP_OK;
+      return err;
+    }
+
+    const uint32_t next = generation() + 1;
+    std::string journal;
+    appendU32(journal, next);
+    for (const Write &write : m_writes)
+    {
+      const KeySpec &entry = spec(write.key);
+      journal.push_back(static_cast<char>(entry.type));
+      journal.append(entry.ns).push_back('\0');
+      journal.append(entry.key).push_back('\0');
+      if (entry.type == Type::INT)
+      {
+        appendU32(journal, static_cast<uint32_t>(write.number));
+      }
+      else
+      {
+        journal.push_back(static_cast<char>(write.text.size() & 0xFF));
+        journal.push_back(static_cast<char>(write.text.size() >> 8));
+        journal.append(write.text);
+      }
+    }
+
+    err = writeMeta(&journal, nullptr);
+    if (err != ESP_OK)
+    {
+      LOG_ERROR(CONFIG, "No se pudo guardar el journal (%d)\n", static_cast<int>(err));
+      return err;
     }
 
-    nvs_close(handle);
-    return false;
+    for (const char *ns : kNamespaces)
+    {
+      nvs_handle_t handle = 0;
+      bool opened = false;
+      for (const Write &write : m_writes)
+      {
+        const KeySpec &entry = spec(write.key);
+        if (strcmp(entry.ns, ns) != 0)
+        {
+          continue;
+        }
+        if (!opened)
+        {
+          err = nvs_open(ns, NVS_READWRITE, &handle);
+          if (err != ESP_OK)
+          {
+            break;
+          }
+          opened = true;
+        }
+        err = entry.type == Type::INT ? nvs_set_i32(handle, entry.key, write.number)
+                                      : nvs_set_str(handle, entry.key, write.text.c_str());
+        if (err != ESP_OK)
+        {
+          break;
+        }
+      }
+      if (opened)
+      {
+        if (err == ESP_OK)
+        {
+          err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+      }
+
+      for (const Write &write : m_writes)
+      {
+        if (strcmp(spec(write.key).ns, ns) == 0)
+        {
+          const bool isInt = spec(write.key).type == Type::INT;
+          store(g_schemaCache[static_cast<size_t>(write.key)],
+                err,
+                isInt ? CacheEntry::Kind::INT : CacheEntry::Kind::STRING,
+                write.text,
+                write.number);
+        }
+      }
+      if (err != ESP_OK)
+      {
+        // El journal queda en NVS: el proximo init() completa la transaccion.
+        LOG_WARN(CONFIG, "Transaccion interrumpida en %s (%d)\n", ns, static_cast<int>(err));
+        return err;
+      }
+    }
+
+    const int32_t generationValue = static_cast<int32_t>(next);
+    err = writeMeta(nullptr, &generationValue);
+    if (err == ESP_OK)
+    {
+      m_writes.clear();
+    }
+    return err;
+  }
+
+  uint32_t generation()
+  {
+    return static_cast<uint32_t>(getInt(Key::CONFIG_GENERATION));
+  }
+
+  CacheStats cacheStats()
+  {
+    CacheStats out = g_cacheStats;
+    for (const CacheEntry &entry : g_schemaCache)
+    {
+      out.entries += entry.loaded ? 1 : 0;
+    }
+    out.entries += static_cast<uint32_t>(g_cache.size());
+    return out;
   }
 
   void dump()
@@ -310,20 +880,26 @@ namespace Config
       return;
     }
 
+    const CacheStats stats = cacheStats();
+    LOG_RAW(CONFIG, DEBUG, "[CONFIG] Cache hits=%lu misses=%lu entradas=%lu\n",
+            static_cast<unsigned long>(stats.hits),
+            static_cast<unsigned long>(stats.misses),
+            static_cast<unsigned long>(stats.entries));
+
     for (const char *ns : kNamespaces)
     {
-      Serial.printf("[CONFIG] Namespace '%s'\n", ns);
+      LOG_RAW(CONFIG, DEBUG, "[CONFIG] Namespace '%s'\n", ns);
       nvs_iterator_t it = nvs_entry_find(NVS_DEFAULT_PART_NAME, ns, NVS_TYPE_ANY);
       if (!it)
       {
-        Serial.println("  (vacio)");
+        LOG_RAW(CONFIG, DEBUG, "  (vacio)\n");
         continue;
       }
 
       nvs_handle_t handle;
       if (nvs_open(ns, NVS_READONLY, &handle) != ESP_OK)
       {
-        Serial.println("  (no se puede abrir)");
+        LOG_RAW(CONFIG, DEBUG, "  (no se puede abrir)\n");
         nvs_release_iterator(it);
         continue;
       }
@@ -350,11 +926,11 @@ namespace Config
               }
               if (shouldHideValue(ns, info.key))
               {
-                Serial.printf("  %s = (oculto)\n", info.key);
+                LOG_RAW(CONFIG, DEBUG, "  %s = (oculto)\n", info.key);
               }
               else
               {
-                Serial.printf("  %s = %s\n", info.key, value.c_str());
+                LOG_RAW(CONFIG, DEBUG, "  %s = %s\n", info.key, value.c_str());
               }
             }
           }
@@ -365,12 +941,12 @@ namespace Config
           int32_t v = 0;
           if (nvs_get_i32(handle, info.key, &v) == ESP_OK)
           {
-            Serial.printf("  %s = %ld\n", info.key, static_cast<long>(v));
+            LOG_RAW(CONFIG, DEBUG, "  %s = %ld\n", info.key, static_cast<long>(v));
           }
           break;
         }
         default:
-          Serial.printf("  %s = (tipo %u)\n", info.key, static_cast<unsigned>(info.type));
+          LOG_RAW(CONFIG, DEBUG, "  %s = (tipo %u)\n", info.key, static_cast<unsigned>(info.type));
           break;
         }
         it = nvs_entry_next(it);
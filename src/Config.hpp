@@ -1,12 +1,25 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <esp_err.h>
 
+#include "ConfigSchema.hpp"
+
 namespace Config
 {
+  struct CacheStats
+  {
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t entries = 0;
+  };
+
+  // Inicializa NVS y completa una Transaction que un reset dejo a medias.
   void init();
+  // Cierra NVS y vacia la cache; permite simular un reinicio en host.
+  void deinit();
 
   esp_err_t setString(const char *ns, const char *key, const std::string &value);
   esp_err_t setInt(const char *ns, const char *key, int32_t value);
@@ -16,6 +29,48 @@ namespace Config
 
   bool exists(const char *ns, const char *key);
 
+  // Acceso por schema: valida tipo y longitud y usa el default de kSchema.
+  esp_err_t setString(Key key, const std::string &value);
+  esp_err_t setInt(Key key, int32_t value);
+  std::string getString(Key key);
+  std::string getString(Key key, const std::string &def);
+  int32_t getInt(Key key);
+  bool exists(Key key);
+
+  // Escribe los defaults del schema que falten. Solo toca NVS si el stamp
+  // (version de firmware + hash del schema) cambio; devuelve true en ese caso.
+  bool seedDefaults(const char *firmwareVersion);
+
+  // Agrupa escrituras de varias claves y las aplica con un commit por
+  // namespace, en el orden de kNamespaces. Antes se guarda un journal en
+  // "meta"; si un reset corta el commit, init() lo rejuega entero. Al final
+  // se incrementa meta/generation, que marca la configuracion completa.
+  class Transaction
+  {
+  public:
+    // Valida tipo y longitud al preparar; false si la escritura se descarta.
+    bool setString(Key key, const std::string &value);
+    bool setInt(Key key, int32_t value);
+    esp_err_t commit();
+    size_t size() const { return m_writes.size(); }
+
+  private:
+    struct Write
+    {
+      Key key;
+      std::string text;
+      int32_t number;
+    };
+
+    Write &stage(Key key);
+    std::vector<Write> m_writes;
+  };
+
+  uint32_t generation();
+
+  // Las lecturas pasan por una cache en RAM que los set mantienen al dia.
+  CacheStats cacheStats();
+
   void dump();
 } // namespace Config
 
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Config
+{
+  enum class Type : uint8_t
+  {
+    STRING,
+    INT,
+  };
+
+  // El orden debe coincidir con kSchema; se comprueba en compilacion.
+  enum class Key : uint8_t
+  {
+    AWS_ENDPOINT = 0,
+    AWS_REGION,
+    AWS_THING,
+    AWS_PORT,
+    DEVICE_ID,
+    DEVICE_USER,
+    DEVICE_ENV,
+    DEVICE_PROVISION_TOKEN,
+    WIFI_SSID,
+    WIFI_PASSWORD,
+    CERT_ROOT,
+    CERT_DEVICE,
+    CERT_PRIVATE,
+    DIAG_LAST_RESET,
+    DIAG_WIFI_RETRIES,
+    DIAG_MQTT_RETRIES,
+    DIAG_RESET_COUNT,
+    DIAG_WDT_RESETS,
+    SCHEMA_STAMP,
+    CONFIG_GENERATION,
+    COUNT,
+  };
+
+  struct KeySpec
+  {
+    Key id;
+    const char *ns;
+    const char *key;
+    Type type;
+    const char *defaultString;
+    int32_t defaultInt;
+    size_t maxLen;
+    bool seeded; // se escribe el default en NVS si falta
+  };
+
+  constexpr size_t kDefaultMaxLen = 512;
+
+  constexpr KeySpec kSchema[] = {
+      {Key::AWS_ENDPOINT, "aws", "endpoint", Type::STRING, "awvhj0h4worjs-ats.iot.us-east-1.amazonaws.com", 0, 256, true},
+      {Key::AWS_REGION, "aws", "region", Type::STRING, "us-east-1", 0, kDefaultMaxLen, true},
+      {Key::AWS_THING, "aws", "thing", Type::STRING, "", 0, 128, true},
+      {Key::AWS_PORT, "aws", "port", Type::INT, "", 8883, 0, true},
+      {Key::DEVICE_ID, "device", "device_id", Type::STRING, "", 0, 128, false},
+      {Key::DEVICE_USER, "device", "user_id", Type::STRING, "", 0, kDefaultMaxLen, false},
+      {Key::DEVICE_ENV, "device", "env", Type::STRING, "prod", 0, 64, true},
+      {Key::DEVICE_PROVISION_TOKEN, "device", "provision_token", Type::STRING, "", 0, kDefaultMaxLen, false},
+      {Key::WIFI_SSID, "wifi", "ssid", Type::STRING, "", 0, 128, false},
+      {Key::WIFI_PASSWORD, "wifi", "password", Type::STRING, "", 0, 128, false},
+      {Key::CERT_ROOT, "certs", "root_ca", Type::STRING, "/certs/AmazonRootCA1.pem", 0, 256, true},
+      {Key::CERT_DEVICE, "certs", "device_cert", Type::STRING, "/certs/device.pem.crt", 0, 256, true},
+      {Key::CERT_PRIVATE, "certs", "private_key", Type::STRING, "/certs/private.pem.key", 0, 256, true},
+      {Key::DIAG_LAST_RESET, "diag", "last_reset", Type::INT, "", 0, 0, true},
+      {Key::DIAG_WIFI_RETRIES, "diag", "wifi_retries", Type::INT, "", 0, 0, true},
+      {Key::DIAG_MQTT_RETRIES, "diag", "mqtt_retries", Type::INT, "", 0, 0, true},
+      {Key::DIAG_RESET_COUNT, "diag", "reset_count", Type::INT, "", 0, 0, true},
+      {Key::DIAG_WDT_RESETS, "diag", "wdt_resets", Type::INT, "", 0, 0, true},
+      {Key::SCHEMA_STAMP, "meta", "schema", Type::STRING, "", 0, 64, false},
+      {Key::CONFIG_GENERATION, "meta", "generation", Type::INT, "", 0, 0, true},
+  };
+
+  constexpr size_t kKeyCount = static_cast<size_t>(Key::COUNT);
+
+  constexpr bool schemaOrdered(size_t index = 0)
+  {
+    return index >= kKeyCount ||
+           (static_cast<size_t>(kSchema[index].id) == index && schemaOrdered(index + 1));
+  }
+
+  constexpr size_t nameLength(const char *text, size_t length = 0)
+  {
+    return text[length] == '\0' ? length : nameLength(text, length + 1);
+  }
+
+  // NVS rechaza claves y namespaces de mas de 15 caracteres (16 con el \0).
+  constexpr bool namesFit(size_t index = 0)
+  {
+    return index >= kKeyCount ||
+           (nameLength(kSchema[index].ns) <= 15 && nameLength(kSchema[index].key) <= 15 &&
+            namesFit(index + 1));
+  }
+
+  static_assert(sizeof(kSchema) / sizeof(kSchema[0]) == kKeyCount, "kSchema incompleto");
+  static_assert(namesFit(), "Clave de kSchema demasiado larga para NVS");
+  static_assert(schemaOrdered(), "kSchema fuera de orden respecto a Config::Key");
+
+  constexpr const KeySpec &spec(Key key)
+  {
+    return kSchema[static_cast<size_t>(key)];
+  }
+} // namespace Config
@@ -0,0 +1,54 @@
+#include "aws_certs.h"
+
+namespace AwsCerts
+{
+namespace
+{
+void clear(Bundle &bundle)
+{
+  bundle.rootCa = "";
+  bundle.deviceCert = "";
+  bundle.privateKey = "";
+}
+} // namespace
+
+LoadResult load(fs::FS &fs, const char *rootCaPath, const char *deviceCertPath,
+                const char *privateKeyPath, Bundle &out)
+{
+  clear(out);
+  if (!fs.exists(rootCaPath) || !fs.exists(deviceCertPath) || !fs.exists(privateKeyPath))
+  {
+    return LoadResult::NOT_FOUND;
+  }
+
+  File ca = fs.open(rootCaPath, "r");
+  File cert = fs.open(deviceCertPath, "r");
+  File key = fs.open(privateKeyPath, "r");
+
+  if (!ca || !cert || !key)
+  {
+    if (ca)
+      ca.close();
+    if (cert)
+      cert.close();
+    if (key)
+      key.close();
+    return LoadResult::OPEN_FAILED;
+  }
+
+  out.rootCa = ca.readString();
+  out.deviceCert = cert.readString();
+  out.privateKey = key.readString();
+
+  ca.close();
+  cert.close();
+  key.close();
+
+  if (out.rootCa.length() == 0 || out.deviceCert.length() == 0 || out.privateKey.length() == 0)
+  {
+    clear(out);
+    return LoadResult::EMPTY;
+  }
+  return LoadResult::OK;
+}
+} // namespace AwsCerts
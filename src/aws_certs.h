@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Lectura de los PEM de AWS IoT desde el sistema de ficheros. Separado de
+// setupAWS() para poder ejecutarlo en host contra el SPIFFS emulado.
+namespace AwsCerts
+{
+struct Bundle
+{
+  String rootCa;
+  String deviceCert;
+  String privateKey;
+};
+
+enum class LoadResult : uint8_t
+{
+  OK = 0,
+  NOT_FOUND,
+  OPEN_FAILED,
+  EMPTY,
+};
+
+// Si no devuelve OK, out queda vacio.
+LoadResult load(fs::FS &fs, const char *rootCaPath, const char *deviceCertPath,
+                const char *privateKeyPath, Bundle &out);
+} // namespace AwsCerts
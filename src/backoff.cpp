@@ -0,0 +1,59 @@
+#include "backoff.h"
+
+namespace Backoff
+{
+namespace
+{
+uint32_t nextRandom(State &state)
+{
+  // xorshift32: suficiente para dispersar reintentos, no es criptografico.
+  uint32_t x = state.rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  state.rng = x;
+  return x;
+}
+} // namespace
+
+void seed(State &state, uint32_t seedValue)
+{
+  state.rng = seedValue != 0 ? seedValue : 0x9E3779B9u;
+  // Descarta las primeras salidas para separar semillas cercanas (MACs consecutivas).
+  for (int i = 0; i < 8; ++i)
+  {
+    nextRandom(state);
+  }
+  reset(state);
+}
+
+void reset(State &state)
+{
+  state.previousMs = 0;
+  state.attempts = 0;
+}
+
+uint32_t next(State &state, const Policy &policy)
+{
+  const uint32_t base = policy.baseMs > 0 ? policy.baseMs : 1;
+  const uint32_t cap = policy.capMs > base ? policy.capMs : base;
+  const uint32_t previous = state.previousMs > base ? state.previousMs : base;
+
+  uint64_t upper = static_cast<uint64_t>(previous) * 3;
+  if (upper > cap)
+  {
+    upper = cap;
+  }
+
+  uint32_t delayMs = base;
+  if (upper > base)
+  {
+    const uint32_t span = static_cast<uint32_t>(upper - base) + 1;
+    delayMs = base + nextRandom(state) % span;
+  }
+
+  state.previousMs = delayMs;
+  ++state.attempts;
+  return delayMs;
+}
+} // namespace Backoff
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+// Backoff "decorrelated jitter": delay = min(cap, rand(base, previo * 3)).
+// Sin dependencias de Arduino para poder simular flotas en host.
+namespace Backoff
+{
+struct Policy
+{
+  uint32_t baseMs;
+  uint32_t capMs;
+};
+
+struct State
+{
+  uint32_t previousMs = 0;
+  uint32_t attempts = 0;
+  uint32_t rng = 1;
+};
+
+void seed(State &state, uint32_t seedValue);
+void reset(State &state);
+uint32_t next(State &state, const Policy &policy);
+} // namespace Backoff
@@ -0,0 +1,258 @@
+#include "chunk_transfer.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace ChunkTransfer
+{
+namespace
+{
+constexpr const char *kResultNames[] = {
+    "ok",
+    "listo",
+    "completo",
+    "cancelado",
+    "duplicado",
+    "trama",
+    "crc_chunk",
+    "rango",
+    "sin_transferencia",
+    "tamano",
+    "falta",
+    "crc",
+    "ocupado",
+    "memoria",
+};
+
+static_assert(sizeof(kResultNames) / sizeof(kResultNames[0]) ==
+                  static_cast<size_t>(Result::NO_MEMORY) + 1,
+              "kResultNames no cubre Result");
+
+uint16_t readU16(const uint8_t *data)
+{
+  return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t readU32(const uint8_t *data)
+{
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+bool hasChunk(const State &state, uint16_t seq)
+{
+  return (state.received[seq / 8] >> (seq % 8)) & 1u;
+}
+
+Result reject(State &state, Result result)
+{
+  state.stats.rejected++;
+  return result;
+}
+
+Result handleStart(State &state, const uint8_t *frame, size_t length)
+{
+  if (length != kStartFrameBytes || frame[1] >= static_cast<uint8_t>(Target::COUNT))
+  {
+    return reject(state, Result::MALFORMED);
+  }
+  const uint16_t chunkSize = readU16(frame + 2);
+  const uint32_t total = readU32(frame + 4);
+  if (chunkSize == 0 || chunkSize > maxChunkSize(state))
+  {
+    return reject(state, Result::OUT_OF_RANGE);
+  }
+  const uint32_t chunkCount = (total + chunkSize - 1) / chunkSize;
+  if (total == 0 || total > kMaxTransferBytes || chunkCount > kMaxChunks)
+  {
+    return reject(state, Result::TOO_LARGE);
+  }
+
+  // Un START nuevo sustituye a una transferencia a medias.
+  release(state);
+  const size_t bitmapBytes = (chunkCount + 7) / 8;
+  state.buffer = static_cast<uint8_t *>(std::malloc(total + bitmapBytes));
+  if (!state.buffer)
+  {
+    return reject(state, Result::NO_MEMORY);
+  }
+  state.received = state.buffer + total;
+  memset(state.received, 0, bitmapBytes);
+  state.target = static_cast<Target>(frame[1]);
+  state.chunkSize = chunkSize;
+  state.chunkCount = static_cast<uint16_t>(chunkCount);
+  state.totalLength = total;
+  state.crc = readU32(frame + 8);
+  state.active = true;
+  state.stats.transfers++;
+  return Result::STARTED;
+}
+
+Result handleData(State &state, const uint8_t *frame, size_t length)
+{
+  if (!state.active)
+  {
+    return reject(state, Result::NO_TRANSFER);
+  }
+  if (length < kDataHeaderBytes)
+  {
+    return reject(state, Result::MALFORMED);
+  }
+  const uint16_t seq = readU16(frame + 1);
+  const uint16_t expectedCrc = readU16(frame + 3);
+  const uint8_t *data = frame + kDataHeaderBytes;
+  const size_t dataLength = length - kDataHeaderBytes;
+
+  if (crc16(data, dataLength, crc16(frame + 1, 2)) != expectedCrc)
+  {
+    state.stats.crcErrors++;
+    return reject(state, Result::BAD_CHUNK_CRC);
+  }
+  if (seq >= state.chunkCount)
+  {
+    return reject(state, Result::OUT_OF_RANGE);
+  }
+  const size_t offset = static_cast<size_t>(seq) * state.chunkSize;
+  const size_t expectedLength =
+      seq + 1u == state.chunkCount ? state.totalLength - offset : state.chunkSize;
+  if (dataLength != expectedLength)
+  {
+    return reject(state, Result::MALFORMED);
+  }
+  if (hasChunk(state, seq))
+  {
+    state.stats.duplicates++;
+    return Result::DUPLICATE;
+  }
+
+  memcpy(state.buffer + offset, data, dataLength);
+  state.received[seq / 8] |= static_cast<uint8_t>(1u << (seq % 8));
+  state.receivedCount++;
+  state.stats.chunks++;
+  return Result::CHUNK_OK;
+}
+
+Result handleCommit(State &state)
+{
+  if (!state.active)
+  {
+    return reject(state, Result::NO_TRANSFER);
+  }
+  if (state.receivedCount < state.chunkCount)
+  {
+    return Result::MISSING_CHUNKS;
+  }
+  if (crc32(state.buffer, state.totalLength) != state.crc)
+  {
+    state.stats.crcErrors++;
+    release(state);
+    return reject(state, Result::BAD_CRC);
+  }
+  state.active = false;
+  state.complete = true;
+  state.stats.completed++;
+  return Result::COMPLETE;
+}
+} // namespace
+
+void release(State &state)
+{
+  std::free(state.buffer);
+  state.buffer = nullptr;
+  state.received = nullptr;
+  state.chunkSize = 0;
+  state.chunkCount = 0;
+  state.receivedCount = 0;
+  state.totalLength = 0;
+  state.crc = 0;
+  state.active = false;
+  state.complete = false;
+}
+
+void setMtu(State &state, uint16_t mtu)
+{
+  state.mtu = mtu < kDefaultMtu ? kDefaultMtu : mtu;
+}
+
+uint16_t maxChunkSize(const State &state)
+{
+  return static_cast<uint16_t>(state.mtu - kAttHeaderBytes - kDataHeaderBytes);
+}
+
+Result handleFrame(State &state, const uint8_t *frame, size_t length)
+{
+  if (!frame || length == 0)
+  {
+    return reject(state, Result::MALFORMED);
+  }
+  // El contenido completo es del consumidor hasta que llame a release().
+  if (state.complete && frame[0] != static_cast<uint8_t>(FrameType::ABORT))
+  {
+    return reject(state, Result::BUSY);
+  }
+
+  switch (static_cast<FrameType>(frame[0]))
+  {
+  case FrameType::START:
+    return handleStart(state, frame, length);
+  case FrameType::DATA:
+    return handleData(state, frame, length);
+  case FrameType::COMMIT:
+    return length == 1 ? handleCommit(state) : reject(state, Result::MALFORMED);
+  case FrameType::ABORT:
+    if (state.complete)
+    {
+      return reject(state, Result::BUSY);
+    }
+    release(state);
+    return Result::ABORTED;
+  default:
+    return reject(state, Result::MALFORMED);
+  }
+}
+
+uint16_t firstMissing(const State &state)
+{
+  for (uint16_t seq = 0; seq < state.chunkCount; ++seq)
+  {
+    if (!hasChunk(state, seq))
+    {
+      return seq;
+    }
+  }
+  return state.chunkCount;
+}
+
+const char *resultName(Result result)
+{
+  const size_t index = static_cast<size_t>(result);
+  return index < sizeof(kResultNames) / sizeof(kResultNames[0]) ? kResultNames[index] : "?";
+}
+
+uint16_t crc16(const uint8_t *data, size_t length, uint16_t crc)
+{
+  for (size_t i = 0; i < length; ++i)
+  {
+    crc ^= static_cast<uint16_t>(data[i] << 8);
+    for (uint8_t bit = 0; bit < 8; ++bit)
+    {
+      crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+    }
+  }
+  return crc;
+}
+
+uint32_t crc32(const uint8_t *data, size_t length, uint32_t crc)
+{
+  crc = ~crc;
+  for (size_t i = 0; i < length; ++i)
+  {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; ++bit)
+    {
+      crc = (crc & 1u) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+    }
+  }
+  return ~crc;
+}
+} // namespace ChunkTransfer
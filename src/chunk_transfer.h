@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef CHUNK_TRANSFER_MAX_BYTES
+#define CHUNK_TRANSFER_MAX_BYTES 4096
+#endif
+
+// Reensamblado de transferencias troceadas por BLE (certificados y config
+// que no caben en un valor ATT). Sin dependencias de BLE para probarlo en
+// host. Tramas, enteros little-endian:
+//   START  01 | target u8 | chunkSize u16 | total u32 | crc32 u32
+//   DATA   02 | seq u16 | crc16 u16 | datos (chunkSize, menos el ultimo)
+//   COMMIT 03
+//   ABORT  04
+// crc16 es CRC-16/CCITT-FALSE sobre seq + datos; crc32 es el IEEE de todo el
+// contenido. Los DATA pueden llegar en cualquier orden o repetidos; un
+// COMMIT con huecos devuelve MISSING_CHUNKS y firstMissing() dice cual
+// reenviar. El buffer se reserva en START con el tamano anunciado y se
+// libera en release(): sin transferencia no ocupa RAM.
+namespace ChunkTransfer
+{
+constexpr size_t kMaxTransferBytes = CHUNK_TRANSFER_MAX_BYTES;
+constexpr size_t kMaxChunks = 512;
+constexpr size_t kStartFrameBytes = 12;
+constexpr size_t kDataHeaderBytes = 5;
+constexpr uint16_t kDefaultMtu = 23;
+constexpr uint16_t kAttHeaderBytes = 3;
+
+enum class FrameType : uint8_t
+{
+  START = 0x01,
+  DATA = 0x02,
+  COMMIT = 0x03,
+  ABORT = 0x04,
+};
+
+enum class Target : uint8_t
+{
+  CREDENTIALS = 0, // mismo formato que la escritura unica
+  CERT_ROOT,
+  CERT_DEVICE,
+  CERT_PRIVATE,
+  COUNT,
+};
+
+enum class Result : uint8_t
+{
+  CHUNK_OK = 0,
+  STARTED,
+  COMPLETE,
+  ABORTED,
+  DUPLICATE,
+  MALFORMED,
+  BAD_CHUNK_CRC,
+  OUT_OF_RANGE,
+  NO_TRANSFER,
+  TOO_LARGE,
+  MISSING_CHUNKS,
+  BAD_CRC,
+  BUSY,
+  NO_MEMORY,
+};
+
+struct Stats
+{
+  uint32_t transfers = 0;
+  uint32_t completed = 0;
+  uint32_t chunks = 0;
+  uint32_t duplicates = 0;
+  uint32_t crcErrors = 0;
+  uint32_t rejected = 0;
+};
+
+struct State
+{
+  uint8_t *buffer = nullptr;   // totalLength bytes
+  uint8_t *received = nullptr; // bitmap de chunks, detras del contenido
+  Target target = Target::CREDENTIALS;
+  uint16_t chunkSize = 0;
+  uint16_t chunkCount = 0;
+  uint16_t receivedCount = 0;
+  uint32_t totalLength = 0;
+  uint32_t crc = 0;
+  uint16_t mtu = kDefaultMtu;
+  bool active = false;
+  // Tras COMPLETE el contenido sigue en buffer hasta release().
+  bool complete = false;
+  Stats stats;
+};
+
+// Descarta la transferencia en curso y libera el buffer; conserva MTU y
+// estadisticas.
+void release(State &state);
+void setMtu(State &state, uint16_t mtu);
+// Mayor chunkSize que admite START con el MTU actual.
+uint16_t maxChunkSize(const State &state);
+Result handleFrame(State &state, const uint8_t *frame, size_t length);
+// Primer seq que falta, o chunkCount si no falta ninguno.
+uint16_t firstMissing(const State &state);
+const char *resultName(Result result);
+
+uint16_t crc16(const uint8_t *data, size_t length, uint16_t crc = 0xFFFF);
+uint32_t crc32(const uint8_t *data, size_t length, uint32_t crc = 0);
+} // namespace ChunkTransfer
@@ -0,0 +1,251 @@
+#include "core_dump.h"
+
+#include <esp_core_dump.h>
+#include <esp_partition.h>
+#include <sdkconfig.h>
+
+#include <atomic>
+#include <cstring>
+
+#include "chunk_transfer.h"
+#include "log.h"
+
+namespace CoreDump
+{
+namespace
+{
+constexpr size_t kCrcBlockBytes = 256;
+
+Summary g_summary;
+Stats g_stats;
+const esp_partition_t *g_partition = nullptr;
+size_t g_imageOffset = 0; // dentro de la particion
+bool g_inFlight = false;
+uint32_t g_sentAtMs = 0;
+// Lo lee la tarea de esp-mqtt para filtrar los PUBLISHED.
+std::atomic<int> g_inFlightMsgId{-1};
+
+void putU16(uint8_t *out, uint16_t value)
+{
+  out[0] = static_cast<uint8_t>(value);
+  out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void putU32(uint8_t *out, uint32_t value)
+{
+  for (int i = 0; i < 4; ++i)
+  {
+    out[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+bool readImage(size_t offset, uint8_t *out, size_t length)
+{
+  return esp_partition_read(g_partition, g_imageOffset + offset, out, length) == ESP_OK;
+}
+
+bool computeDumpId(uint32_t &crc)
+{
+  uint8_t block[kCrcBlockBytes];
+  crc = 0;
+  for (size_t offset = 0; offset < g_summary.size; offset += sizeof(block))
+  {
+    const size_t length = g_summary.size - offset < sizeof(block) ? g_summary.size - offset : sizeof(block);
+    if (!readImage(offset, block, length))
+    {
+      return false;
+    }
+    crc = ChunkTransfer::crc32(block, length, crc);
+  }
+  return true;
+}
+
+void readSummary()
+{
+#if CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF
+  esp_core_dump_summary_t raw;
+  if (esp_core_dump_get_summary(&raw) != ESP_OK)
+  {
+    std::strcpy(g_summary.task, "?");
+    return;
+  }
+  std::strncpy(g_summary.task, raw.exc_task, sizeof(g_summary.task) - 1);
+  g_summary.pc = raw.exc_pc;
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+  const uint32_t depth = raw.exc_bt_info.depth < kMaxBacktrace ? raw.exc_bt_info.depth : kMaxBacktrace;
+  for (uint32_t i = 0; i < depth; ++i)
+  {
+    g_summary.backtrace[i] = raw.exc_bt_info.bt[i];
+  }
+  g_summary.depth = static_cast<uint8_t>(depth);
+  g_summary.backtraceCorrupted = raw.exc_bt_info.corrupted;
+  g_summary.cause = raw.ex_info.exc_cause;
+  g_summary.faultAddress = raw.ex_info.exc_vaddr;
+#else
+  // El resumen de RISC-V no desenrolla la pila: PC y ra son los dos primeros
+  // marcos; espcoredump.py saca el resto del volcado completo.
+  g_summary.backtrace[0] = raw.exc_pc;
+  g_summary.backtrace[1] = raw.ex_info.ra;
+  g_summary.depth = 2;
+  g_summary.cause = raw.ex_info.mcause;
+  g_summary.faultAddress = raw.ex_info.mtval;
+#endif
+#else
+  std::strcpy(g_summary.task, "?");
+#endif
+}
+
+void logSummary()
+{
+  LOG_WARN(COREDUMP, "Volcado %08lx de %lu bytes en flash (%u trozos)\n",
+           static_cast<unsigned long>(g_summary.dumpId),
+           static_cast<unsigned long>(g_summary.size),
+           static_cast<unsigned>(g_summary.chunkCount));
+  LOG_WARN(COREDUMP, "Tarea %s, PC 0x%08lx, causa %lu, direccion 0x%08lx\n",
+           g_summary.task,
+           static_cast<unsigned long>(g_summary.pc),
+           static_cast<unsigned long>(g_summary.cause),
+           static_cast<unsigned long>(g_summary.faultAddress));
+  for (uint8_t i = 0; i < g_summary.depth; ++i)
+  {
+    LOG_WARN(COREDUMP, "  #%u 0x%08lx\n", static_cast<unsigned>(i), static_cast<unsigned long>(g_summary.backtrace[i]));
+  }
+  if (g_summary.backtraceCorrupted)
+  {
+    LOG_WARN(COREDUMP, "  backtrace corrupto\n");
+  }
+}
+} // namespace
+
+bool begin()
+{
+  g_summary = Summary();
+  g_stats = Stats();
+  g_inFlight = false;
+  g_inFlightMsgId = -1;
+
+  size_t address = 0;
+  size_t size = 0;
+  if (esp_core_dump_image_get(&address, &size) != ESP_OK || size == 0)
+  {
+    return false;
+  }
+  g_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_COREDUMP, nullptr);
+  if (!g_partition || address < g_partition->address ||
+      address + size > g_partition->address + g_partition->size)
+  {
+    LOG_ERROR(COREDUMP, "Volcado fuera de la particion coredump\n");
+    return false;
+  }
+  g_imageOffset = address - g_partition->address;
+  g_summary.size = static_cast<uint32_t>(size);
+  g_summary.chunkCount = static_cast<uint16_t>((size + kChunkBytes - 1) / kChunkBytes);
+  if (!computeDumpId(g_summary.dumpId))
+  {
+    LOG_ERROR(COREDUMP, "No se pudo leer el volcado\n");
+    return false;
+  }
+  readSummary();
+  g_summary.present = true;
+  logSummary();
+  return true;
+}
+
+const Summary &summary()
+{
+  return g_summary;
+}
+
+bool uploadPending()
+{
+  return g_summary.present && !g_stats.uploaded;
+}
+
+bool chunkDue(uint32_t nowMs)
+{
+  if (!uploadPending())
+  {
+    return false;
+  }
+  return !g_inFlight || nowMs - g_sentAtMs >= CORE_DUMP_ACK_TIMEOUT_MS;
+}
+
+size_t buildChunk(uint8_t *out, size_t size)
+{
+  if (!uploadPending() || g_stats.chunksAcked >= g_summary.chunkCount)
+  {
+    return 0;
+  }
+  const uint32_t offset = static_cast<uint32_t>(g_stats.chunksAcked) * kChunkBytes;
+  const size_t remaining = g_summary.size - offset;
+  const size_t length = remaining < kChunkBytes ? remaining : kChunkBytes;
+  if (!out || size < kHeaderBytes + length || !readImage(offset, out + kHeaderBytes, length))
+  {
+    return 0;
+  }
+  putU16(out, kChunkMagic);
+  putU16(out + 2, g_stats.chunksAcked);
+  putU16(out + 4, g_summary.chunkCount);
+  putU16(out + 6, static_cast<uint16_t>(length));
+  putU32(out + 8, g_summary.dumpId);
+  putU32(out + 12, offset);
+  return kHeaderBytes + length;
+}
+
+void chunkPublished(int msgId, uint32_t nowMs)
+{
+  if (msgId < 0)
+  {
+    return;
+  }
+  if (g_inFlight)
+  {
+    g_stats.resends++;
+  }
+  g_inFlight = true;
+  g_sentAtMs = nowMs;
+  g_inFlightMsgId = msgId;
+}
+
+bool isInFlight(int msgId)
+{
+  return msgId >= 0 && g_inFlightMsgId.load() == msgId;
+}
+
+bool onAcked(int msgId)
+{
+  if (!g_inFlight || !isInFlight(msgId))
+  {
+    return false;
+  }
+  g_inFlight = false;
+  g_inFlightMsgId = -1;
+  const uint32_t offset = static_cast<uint32_t>(g_stats.chunksAcked) * kChunkBytes;
+  g_stats.bytesAcked += g_summary.size - offset < kChunkBytes ? g_summary.size - offset : kChunkBytes;
+  g_stats.chunksAcked++;
+  if (g_stats.chunksAcked < g_summary.chunkCount)
+  {
+    return false;
+  }
+
+  g_stats.uploaded = true;
+  // Subido: el siguiente panic puede volver a usar la particion.
+  const esp_err_t err = esp_core_dump_image_erase();
+  if (err == ESP_OK)
+  {
+    LOG_INFO(COREDUMP, "Volcado %08lx subido (%lu reenvios) y borrado\n",
+             static_cast<unsigned long>(g_summary.dumpId),
+             static_cast<unsigned long>(g_stats.resends));
+  }
+  else
+  {
+    LOG_ERROR(COREDUMP, "Volcado subido, error al borrarlo (%d)\n", static_cast<int>(err));
+  }
+  return true;
+}
+
+Stats stats()
+{
+  return g_stats;
+}
+} // namespace CoreDump
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Bytes de imagen por trozo; la cabecera va aparte.
+#ifndef CORE_DUMP_CHUNK_BYTES
+#define CORE_DUMP_CHUNK_BYTES 1024
+#endif
+
+// Sin confirmacion (MQTT_EVENT_PUBLISHED) en este tiempo, el trozo se reenvia.
+#ifndef CORE_DUMP_ACK_TIMEOUT_MS
+#define CORE_DUMP_ACK_TIMEOUT_MS 30000
+#endif
+
+// Core dump de ESP-IDF en la particion coredump. Tras un panic o watchdog,
+// begin() lo resume en el siguiente arranque (tarea, PC, backtrace) y el loop
+// lo sube por MQTT de trozo en trozo: uno en vuelo, con QoS 1, y el siguiente
+// solo tras su PUBLISHED. Subido entero, se borra de flash.
+// Cada trozo lleva una cabecera de kHeaderBytes, little endian:
+//   magic u16 | seq u16 | count u16 | length u16 | dumpId u32 | offset u32
+// dumpId es el CRC32 de la imagen completa. tools/coredump_join.py los junta.
+namespace CoreDump
+{
+constexpr size_t kChunkBytes = CORE_DUMP_CHUNK_BYTES;
+constexpr size_t kHeaderBytes = 16;
+constexpr uint16_t kChunkMagic = 0x4443; // "CD"
+constexpr size_t kMaxBacktrace = 16;
+constexpr size_t kTaskNameLength = 16;
+
+static_assert(kChunkBytes > 0 && kChunkBytes <= 0xFFFF, "CORE_DUMP_CHUNK_BYTES fuera de rango");
+
+struct Summary
+{
+  bool present = false;
+  uint32_t dumpId = 0;
+  uint32_t size = 0;
+  uint16_t chunkCount = 0;
+  char task[kTaskNameLength] = {};
+  uint32_t pc = 0;
+  // En RISC-V solo PC y direccion de retorno; el resto sale del volcado.
+  uint32_t backtrace[kMaxBacktrace] = {};
+  uint8_t depth = 0;
+  bool backtraceCorrupted = false;
+  uint32_t cause = 0;        // mcause / EXCCAUSE
+  uint32_t faultAddress = 0; // mtval / EXCVADDR
+};
+
+struct Stats
+{
+  uint16_t chunksAcked = 0;
+  uint32_t bytesAcked = 0;
+  uint32_t resends = 0;
+  bool uploaded = false;
+};
+
+// Busca un core dump valido en flash y lo resume en el log. Una vez, en setup().
+bool begin();
+const Summary &summary();
+bool uploadPending();
+
+// true si toca publicar: nada en vuelo, o el trozo en vuelo sin confirmar
+// tras CORE_DUMP_ACK_TIMEOUT_MS.
+bool chunkDue(uint32_t nowMs);
+// Cabecera y datos del siguiente trozo sin confirmar; 0 si no queda o falla la lectura.
+size_t buildChunk(uint8_t *out, size_t size);
+// msgId de esp_mqtt_client_publish() para el trozo de buildChunk(); < 0 no lo deja en vuelo.
+void chunkPublished(int msgId, uint32_t nowMs);
+// Desde la tarea de esp-mqtt: si msgId es el trozo en vuelo.
+bool isInFlight(int msgId);
+// Desde el loop, con el msg_id de MQTT_EVENT_PUBLISHED. Devuelve true con el ultimo.
+bool onAcked(int msgId);
+
+Stats stats();
+} // namespace CoreDump
@@ -0,0 +1,353 @@
+#include "credentials_parser.h"
+
+#include <climits>
+#include <cstring>
+
+namespace CredentialsParser
+{
+namespace
+{
+enum Field : uint8_t
+{
+  SSID = 0,
+  PASSWORD,
+  USER_ID,
+  DEVICE_ID,
+  ENDPOINT,
+  REGION,
+  ENVIRONMENT,
+  THING_NAME,
+  PROVISION_TOKEN,
+  AWS_PORT,
+  FIELD_COUNT,
+};
+
+struct Alias
+{
+  const char *name;
+  Field field;
+};
+
+constexpr Alias kAliases[] = {
+    {"ssid", SSID},
+    {"wifi_ssid", SSID},
+    {"password", PASSWORD},
+    {"pass", PASSWORD},
+    {"wifi_password", PASSWORD},
+    {"user_id", USER_ID},
+    {"userid", USER_ID},
+    {"device_id", DEVICE_ID},
+    {"endpoint", ENDPOINT},
+    {"aws_endpoint", ENDPOINT},
+    {"region", REGION},
+    {"aws_region", REGION},
+    {"env", ENVIRONMENT},
+    {"environment", ENVIRONMENT},
+    {"thing", THING_NAME},
+    {"thingname", THING_NAME},
+    {"thing_name", THING_NAME},
+    {"token", PROVISION_TOKEN},
+    {"provision_token", PROVISION_TOKEN},
+    {"aws_port", AWS_PORT},
+    {"port", AWS_PORT},
+};
+
+constexpr const char *kErrorNames[] = {
+    "",
+    "vacio",
+    "ssid",
+    "ssid_len",
+    "password_len",
+    "user_id_len",
+    "device_id",
+    "device_id_len",
+    "endpoint_len",
+    "region_len",
+    "environment_len",
+    "thing_name_len",
+    "token_len",
+    "aws_port",
+};
+
+static_assert(sizeof(kErrorNames) / sizeof(kErrorNames[0]) ==
+                  static_cast<size_t>(Error::AWS_PORT) + 1,
+              "kErrorNames no cubre Error");
+
+// Estado del parseo en la pila del llamador.
+struct State
+{
+  CredentialsPayload &out;
+  size_t lengths[FIELD_COUNT]; // longitud real aunque no quepa en el buffer
+  bool portProvided;
+};
+
+bool isWhitespace(char c)
+{
+  return c == '\r' || c == '\n' || c == '\t' || c == ' ';
+}
+
+bool isSeparator(char c)
+{
+  return c == '\n' || c == '|';
+}
+
+std::string_view trim(std::string_view text)
+{
+  while (!text.empty() && isWhitespace(text.front()))
+  {
+    text.remove_prefix(1);
+  }
+  while (!text.empty() && isWhitespace(text.back()))
+  {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+char *buffer(CredentialsPayload &out, Field field, size_t &capacity)
+{
+  switch (field)
+  {
+  case SSID:
+    capacity = sizeof(out.ssid);
+    return out.ssid;
+  case PASSWORD:
+    capacity = sizeof(out.password);
+    return out.password;
+  case USER_ID:
+    capacity = sizeof(out.userId);
+    return out.userId;
+  case DEVICE_ID:
+    capacity = sizeof(out.deviceId);
+    return out.deviceId;
+  case ENDPOINT:
+    capacity = sizeof(out.endpoint);
+    return out.endpoint;
+  case REGION:
+    capacity = sizeof(out.region);
+    return out.region;
+  case ENVIRONMENT:
+    capacity = sizeof(out.environment);
+    return out.environment;
+  case THING_NAME:
+    capacity = sizeof(out.thingName);
+    return out.thingName;
+  case PROVISION_TOKEN:
+    capacity = sizeof(out.provisionToken);
+    return out.provisionToken;
+  default:
+    capacity = 0;
+    return nullptr;
+  }
+}
+
+// Compara sin distinguir mayusculas y saltando '\r', como el formato antiguo.
+bool keyEquals(std::string_view key, const char *name)
+{
+  size_t matched = 0;
+  for (char c : key)
+  {
+    if (c == '\r')
+    {
+      continue;
+    }
+    const char lower = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    if (name[matched] == '\0' || lower != name[matched])
+    {
+      return false;
+    }
+    ++matched;
+  }
+  return name[matched] == '\0';
+}
+
+// Semantica de atoi: signo opcional y digitos hasta el primer otro caracter.
+int32_t parsePort(std::string_view value)
+{
+  size_t i = 0;
+  bool negative = false;
+  if (i < value.size() && (value[i] == '+' || value[i] == '-'))
+  {
+    negative = value[i] == '-';
+    ++i;
+  }
+  int64_t result = 0;
+  for (; i < value.size(); ++i)
+  {
+    if (value[i] == '\r')
+    {
+      continue;
+    }
+    if (value[i] < '0' || value[i] > '9')
+    {
+      break;
+    }
+    if (result <= INT32_MAX)
+    {
+      result = result * 10 + (value[i] - '0');
+    }
+  }
+  if (negative)
+  {
+    result = -result;
+  }
+  if (result > INT32_MAX)
+  {
+    return INT32_MAX;
+  }
+  return result < INT32_MIN ? INT32_MIN : static_cast<int32_t>(result);
+}
+
+void store(State &state, Field field, std::string_view value)
+{
+  if (field == AWS_PORT)
+  {
+    state.out.awsPort = parsePort(value);
+    state.portProvided = true;
+    return;
+  }
+
+  size_t capacity = 0;
+  char *dest = buffer(state.out, field, capacity);
+  size_t length = 0;
+  for (char c : value)
+  {
+    if (c == '\r')
+    {
+      continue;
+    }
+    if (c == '\0')
+    {
+      break;
+    }
+    if (length + 1 < capacity)
+    {
+      dest[length] = c;
+    }
+    ++length;
+  }
+  dest[length < capacity ? length : capacity - 1] = '\0';
+  state.lengths[field] = length;
+}
+
+void parseKeyValue(State &state, std::string_view token)
+{
+  token = trim(token);
+  const size_t eq = token.find('=');
+  if (token.empty() || eq == std::string_view::npos)
+  {
+    return;
+  }
+  const std::string_view key = trim(token.substr(0, eq));
+  if (key.empty())
+  {
+    return;
+  }
+  for (const Alias &alias : kAliases)
+  {
+    if (keyEquals(key, alias.name))
+    {
+      store(state, alias.field, trim(token.substr(eq + 1)));
+      return;
+    }
+  }
+}
+
+bool fits(const State &state, Field field, size_t capacity)
+{
+  return state.lengths[field] < capacity;
+}
+
+bool isValidDeviceId(const State &state)
+{
+  const size_t length = state.lengths[DEVICE_ID];
+  if (length > 32)
+  {
+    return false;
+  }
+  for (size_t i = 0; i < length; ++i)
+  {
+    const char c = state.out.deviceId[i];
+    const bool allowed = (c >= '0' && c <= '9') ||
+                         (c >= 'a' && c <= 'z') ||
+                         (c >= 'A' && c <= 'Z') ||
+                         c == '-' || c == '_';
+    if (!allowed)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+Error validate(const State &state)
+{
+  if (state.lengths[SSID] == 0)
+    return Error::SSID;
+  if (!fits(state, SSID, kMaxSsidLength))
+    return Error::SSID_LEN;
+  if (!fits(state, PASSWORD, kMaxPasswordLength))
+    return Error::PASSWORD_LEN;
+  if (!fits(state, USER_ID, kMaxUserIdLength))
+    return Error::USER_ID_LEN;
+  if (!isValidDeviceId(state))
+    return Error::DEVICE_ID;
+  if (!fits(state, DEVICE_ID, kMaxDeviceIdLength))
+    return Error::DEVICE_ID_LEN;
+  if (!fits(state, ENDPOINT, kMaxEndpointLength))
+    return Error::ENDPOINT_LEN;
+  if (!fits(state, REGION, kMaxRegionLength))
+    return Error::REGION_LEN;
+  if (!fits(state, ENVIRONMENT, kMaxEnvLength))
+    return Error::ENVIRONMENT_LEN;
+  if (!fits(state, THING_NAME, kMaxThingNameLength))
+    return Error::THING_NAME_LEN;
+  if (!fits(state, PROVISION_TOKEN, kMaxProvisionTokenLength))
+    return Error::TOKEN_LEN;
+  if (state.portProvided && !(state.out.awsPort > 0 && state.out.awsPort < 65536))
+    return Error::AWS_PORT;
+  return Error::NONE;
+}
+} // namespace
+
+Error parse(std::string_view raw, CredentialsPayload &out)
+{
+  memset(&out, 0, sizeof(out));
+  if (raw.empty())
+  {
+    return Error::EMPTY;
+  }
+
+  State state = {out, {}, false};
+  const bool keyValueMode = raw.find('=') != std::string_view::npos;
+  size_t position = 0;
+  size_t index = 0;
+  while (position < raw.size())
+  {
+    size_t end = position;
+    while (end < raw.size() && !isSeparator(raw[end]))
+    {
+      ++end;
+    }
+    const std::string_view token = raw.substr(position, end - position);
+    if (keyValueMode)
+    {
+      parseKeyValue(state, token);
+    }
+    else if (index <= USER_ID)
+    {
+      // Posicional: ssid, password, user_id.
+      store(state, static_cast<Field>(index), trim(token));
+    }
+    ++index;
+    position = end + 1;
+  }
+  return validate(state);
+}
+
+const char *errorName(Error error)
+{
+  const size_t index = static_cast<size_t>(error);
+  return index < sizeof(kErrorNames) / sizeof(kErrorNames[0]) ? kErrorNames[index] : "?";
+}
+} // namespace CredentialsParser
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Parser de las credenciales recibidas por BLE. Recorre el valor una sola
+// vez sobre string_view y copia cada campo validado a su buffer fijo: no
+// usa heap, asi que se puede llamar desde el callback de Bluedroid.
+//
+// Formatos aceptados (separador '\n' o '|', '\r' se ignora):
+//   clave=valor por linea: ssid, password, user_id, device_id, endpoint,
+//     region, env, thing, token, aws_port (y sus alias)
+//   posicional: ssid, password, user_id
+namespace CredentialsParser
+{
+constexpr size_t kMaxSsidLength = 33;     // 32 + null
+constexpr size_t kMaxPasswordLength = 65; // 64 + null (WPA2 max)
+constexpr size_t kMaxUserIdLength = 65;   // accommodate UUID or custom id
+constexpr size_t kMaxDeviceIdLength = 65;
+constexpr size_t kMaxEndpointLength = 129;
+constexpr size_t kMaxRegionLength = 33;
+constexpr size_t kMaxEnvLength = 17;
+constexpr size_t kMaxThingNameLength = 65;
+constexpr size_t kMaxProvisionTokenLength = 65;
+
+struct CredentialsPayload
+{
+  char ssid[kMaxSsidLength];
+  char password[kMaxPasswordLength];
+  char userId[kMaxUserIdLength];
+  char deviceId[kMaxDeviceIdLength];
+  char endpoint[kMaxEndpointLength];
+  char region[kMaxRegionLength];
+  char environment[kMaxEnvLength];
+  char thingName[kMaxThingNameLength];
+  char provisionToken[kMaxProvisionTokenLength];
+  int32_t awsPort;
+};
+
+enum class Error : uint8_t
+{
+  NONE = 0,
+  EMPTY,
+  SSID,
+  SSID_LEN,
+  PASSWORD_LEN,
+  USER_ID_LEN,
+  DEVICE_ID,
+  DEVICE_ID_LEN,
+  ENDPOINT_LEN,
+  REGION_LEN,
+  ENVIRONMENT_LEN,
+  THING_NAME_LEN,
+  TOKEN_LEN,
+  AWS_PORT,
+};
+
+// out se reescribe entero; solo es utilizable si devuelve Error::NONE.
+Error parse(std::string_view raw, CredentialsPayload &out);
+// Codigo corto para la notificacion "error:<codigo>".
+const char *errorName(Error error);
+} // namespace CredentialsParser
@@ -0,0 +1,164 @@
+#include "diag_counters.h"
+
+#include <esp_attr.h>
+#include <esp_system.h>
+
+#include "Config.hpp"
+#include "log.h"
+
+#ifndef DIAG_FLUSH_THRESHOLD
+#define DIAG_FLUSH_THRESHOLD 32
+#endif
+
+namespace DiagCounters
+{
+namespace
+{
+constexpr size_t kCounterCount = static_cast<size_t>(Counter::COUNT);
+constexpr uint32_t kRtcMagic = 0xD1A6C0DEu;
+constexpr Config::Key kKeys[kCounterCount] = {
+    Config::Key::DIAG_WIFI_RETRIES,
+    Config::Key::DIAG_MQTT_RETRIES,
+    Config::Key::DIAG_RESET_COUNT,
+    Config::Key::DIAG_WDT_RESETS,
+};
+
+// Totales absolutos, no deltas: recuperar dos veces el mismo valor no
+// duplica cuentas si el reset cae entre el commit y la limpieza.
+struct RtcMirror
+{
+  uint32_t magic;
+  uint32_t totals[kCounterCount];
+  uint32_t checksum;
+};
+
+RTC_NOINIT_ATTR RtcMirror g_rtc;
+
+uint32_t g_totals[kCounterCount] = {};
+uint32_t g_persisted[kCounterCount] = {};
+uint32_t g_pending = 0;
+Stats g_stats;
+bool g_started = false;
+
+uint32_t rtcChecksum(const RtcMirror &mirror)
+{
+  uint32_t sum = mirror.magic;
+  for (uint32_t value : mirror.totals)
+  {
+    sum = (sum << 5 | sum >> 27) ^ value;
+  }
+  return sum;
+}
+
+void writeRtc()
+{
+  g_rtc.magic = kRtcMagic;
+  for (size_t i = 0; i < kCounterCount; ++i)
+  {
+    g_rtc.totals[i] = g_totals[i];
+  }
+  g_rtc.checksum = rtcChecksum(g_rtc);
+}
+
+bool rtcValid()
+{
+  // En power-on la RTC trae basura; el checksum la descarta igualmente.
+  return esp_reset_reason() != ESP_RST_POWERON && g_rtc.magic == kRtcMagic &&
+         g_rtc.checksum == rtcChecksum(g_rtc);
+}
+
+void shutdownHandler()
+{
+  flush();
+}
+} // namespace
+
+void begin()
+{
+  if (g_started)
+  {
+    return;
+  }
+  g_started = true;
+
+  const bool recover = rtcValid();
+  for (size_t i = 0; i < kCounterCount; ++i)
+  {
+    const int32_t stored = Config::getInt(kKeys[i]);
+    g_persisted[i] = stored > 0 ? static_cast<uint32_t>(stored) : 0;
+    g_totals[i] = g_persisted[i];
+    if (recover && g_rtc.totals[i] > g_persisted[i])
+    {
+      g_stats.recovered += g_rtc.totals[i] - g_persisted[i];
+      g_pending += g_rtc.totals[i] - g_persisted[i];
+      g_totals[i] = g_rtc.totals[i];
+    }
+  }
+  writeRtc();
+
+  if (g_stats.recovered > 0)
+  {
+    LOG_INFO(DIAG, "Recuperados %lu incrementos desde RTC\n",
+             static_cast<unsigned long>(g_stats.recovered));
+    flush();
+  }
+  esp_register_shutdown_handler(shutdownHandler);
+}
+
+void increment(Counter counter)
+{
+  const size_t index = static_cast<size_t>(counter);
+  if (index >= kCounterCount)
+  {
+    return;
+  }
+  g_totals[index]++;
+  g_pending++;
+  g_stats.increments++;
+  writeRtc();
+  if (g_pending >= DIAG_FLUSH_THRESHOLD)
+  {
+    flush();
+  }
+}
+
+uint32_t total(Counter counter)
+{
+  const size_t index = static_cast<size_t>(counter);
+  return index < kCounterCount ? g_totals[index] : 0;
+}
+
+void flush()
+{
+  if (!g_started || g_pending == 0)
+  {
+    return;
+  }
+  for (size_t i = 0; i < kCounterCount; ++i)
+  {
+    if (g_totals[i] == g_persisted[i])
+    {
+      continue;
+    }
+    if (Config::setInt(kKeys[i], static_cast<int32_t>(g_totals[i])) == ESP_OK)
+    {
+      g_persisted[i] = g_totals[i];
+      g_stats.commits++;
+    }
+  }
+
+  g_pending = 0;
+  for (size_t i = 0; i < kCounterCount; ++i)
+  {
+    if (g_totals[i] != g_persisted[i])
+    {
+      // Fallo de escritura: se reintenta en el siguiente flush.
+      g_pending += g_totals[i] - g_persisted[i];
+    }
+  }
+}
+
+uint32_t pending() { return g_pending; }
+
+Stats stats() { return g_stats; }
+} // namespace DiagCounters
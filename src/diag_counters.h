@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Contadores de diagnostico en RAM con espejo en memoria RTC. Se vuelcan a
+// NVS ("diag") por tiempo, por umbral de incrementos pendientes y antes de
+// un reinicio, en vez de un commit por incremento. total() es siempre exacto.
+namespace DiagCounters
+{
+enum class Counter : uint8_t
+{
+  WIFI_RETRIES = 0,
+  MQTT_RETRIES,
+  RESET_COUNT,
+  WDT_RESETS,
+  COUNT,
+};
+
+struct Stats
+{
+  uint32_t increments = 0; // incrementos desde el arranque
+  uint32_t commits = 0;    // escrituras a NVS realizadas
+  uint32_t recovered = 0;  // incrementos rescatados de RTC tras un reset
+};
+
+// Carga los totales de NVS y recupera lo pendiente en RTC si el reset no
+// borro esa memoria. Requiere Config::init().
+void begin();
+void increment(Counter counter);
+uint32_t total(Counter counter);
+// Escribe en NVS los contadores con cambios pendientes.
+void flush();
+uint32_t pending();
+Stats stats();
+} // namespace DiagCounters
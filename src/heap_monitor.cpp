@@ -0,0 +1,226 @@
+#include "heap_monitor.h"
+
+#include <esp_heap_caps.h>
+
+namespace HeapMonitor
+{
+namespace
+{
+constexpr const char *kTagNames[kTagCount] = {"other", "mqtt", "json", "ble", "cfg"};
+
+portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+TagStats g_tags[kTagCount];
+uint32_t g_allocs = 0;
+
+// Un solo Scope activo a la vez (el loop); los anidados guardan el anterior.
+TaskHandle_t g_scopeTask = nullptr;
+Tag g_scopeTag = Tag::OTHER;
+TaskHandle_t g_taskTags[kTagCount] = {};
+
+Snapshot g_lastTrend;
+bool g_hasTrend = false;
+
+// Se llama desde malloc: nada de reservas ni logs aqui.
+Tag currentTag()
+{
+  const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  if (g_scopeTask && task == g_scopeTask)
+  {
+    return g_scopeTag;
+  }
+  for (size_t i = 1; i < kTagCount; ++i)
+  {
+    if (g_taskTags[i] && g_taskTags[i] == task)
+    {
+      return static_cast<Tag>(i);
+    }
+  }
+  return Tag::OTHER;
+}
+} // namespace
+
+uint8_t fragmentationPct(uint32_t freeBytes, uint32_t largestFreeBlock)
+{
+  if (freeBytes == 0 || largestFreeBlock >= freeBytes)
+  {
+    return 0;
+  }
+  return static_cast<uint8_t>(100 - static_cast<uint64_t>(largestFreeBlock) * 100 / freeBytes);
+}
+
+Snapshot snapshot()
+{
+  multi_heap_info_t info = {};
+  heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+
+  Snapshot result;
+  result.freeBytes = static_cast<uint32_t>(info.total_free_bytes);
+  result.largestFreeBlock = static_cast<uint32_t>(info.largest_free_block);
+  result.minFreeBytes = static_cast<uint32_t>(info.minimum_free_bytes);
+  result.allocatedBlocks = static_cast<uint32_t>(info.allocated_blocks);
+  portENTER_CRITICAL(&g_lock);
+  result.allocs = g_allocs;
+  portEXIT_CRITICAL(&g_lock);
+  result.fragmentationPct = fragmentationPct(result.freeBytes, result.largestFreeBlock);
+  return result;
+}
+
+Trend takeTrend(const Snapshot &current)
+{
+  Trend trend;
+  if (g_hasTrend)
+  {
+    trend.freeDelta = static_cast<int32_t>(current.freeBytes - g_lastTrend.freeBytes);
+    trend.largestDelta = static_cast<int32_t>(current.largestFreeBlock - g_lastTrend.largestFreeBlock);
+    trend.allocs = current.allocs - g_lastTrend.allocs;
+  }
+  else
+  {
+    trend.allocs = current.allocs;
+  }
+  g_lastTrend = current;
+  g_hasTrend = true;
+  return trend;
+}
+
+TagStats tagStats(Tag tag)
+{
+  const size_t index = static_cast<size_t>(tag);
+  if (index >= kTagCount)
+  {
+    return TagStats();
+  }
+  portENTER_CRITICAL(&g_lock);
+  const TagStats result = g_tags[index];
+  portEXIT_CRITICAL(&g_lock);
+  return result;
+}
+
+const char *name(Tag tag)
+{
+  const size_t index = static_cast<size_t>(tag);
+  return index < kTagCount ? kTagNames[index] : "?";
+}
+
+void resetTagStats()
+{
+  portENTER_CRITICAL(&g_lock);
+  for (TagStats &stats : g_tags)
+  {
+    stats = TagStats();
+  }
+  g_allocs = 0;
+  portEXIT_CRITICAL(&g_lock);
+  g_hasTrend = false;
+}
+
+void tagTask(TaskHandle_t task, Tag tag)
+{
+  portENTER_CRITICAL(&g_lock);
+  for (TaskHandle_t &slot : g_taskTags)
+  {
+    if (slot == task)
+    {
+      slot = nullptr;
+    }
+  }
+  const size_t index = static_cast<size_t>(tag);
+  if (task && index > 0 && index < kTagCount)
+  {
+    g_taskTags[index] = task;
+  }
+  portEXIT_CRITICAL(&g_lock);
+}
+
+void noteAlloc(size_t bytes)
+{
+  portENTER_CRITICAL(&g_lock);
+  TagStats &stats = g_tags[static_cast<size_t>(currentTag())];
+  stats.allocs++;
+  stats.bytes += static_cast<uint32_t>(bytes);
+  g_allocs++;
+  portEXIT_CRITICAL(&g_lock);
+}
+
+void noteFree()
+{
+  portENTER_CRITICAL(&g_lock);
+  g_tags[static_cast<size_t>(currentTag())].frees++;
+  portEXIT_CRITICAL(&g_lock);
+}
+
+Scope::Scope(Tag tag)
+{
+  const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  portENTER_CRITICAL(&g_lock);
+  previousTask_ = g_scopeTask;
+  previousTag_ = g_scopeTag;
+  g_scopeTask = task;
+  g_scopeTag = tag;
+  portEXIT_CRITICAL(&g_lock);
+}
+
+Scope::~Scope()
+{
+  portENTER_CRITICAL(&g_lock);
+  g_scopeTask = previousTask_;
+  g_scopeTag = previousTag_;
+  portEXIT_CRITICAL(&g_lock);
+}
+} // namespace HeapMonitor
+
+#if HEAP_MONITOR_HOOKS
+// Con --wrap el enlazador manda aqui todas las llamadas a malloc/free, tambien
+// las de las librerias precompiladas del core (lwIP, mbedTLS, Bluedroid).
+extern "C"
+{
+  void *__real_malloc(size_t size);
+  void __real_free(void *ptr);
+  void *__real_realloc(void *ptr, size_t size);
+  void *__real_calloc(size_t count, size_t size);
+
+  void *__wrap_malloc(size_t size)
+  {
+    void *ptr = __real_malloc(size);
+    if (ptr)
+    {
+      HeapMonitor::noteAlloc(size);
+    }
+    return ptr;
+  }
+
+  void __wrap_free(void *ptr)
+  {
+    if (ptr)
+    {
+      HeapMonitor::noteFree();
+    }
+    __real_free(ptr);
+  }
+
+  void *__wrap_realloc(void *ptr, size_t size)
+  {
+    void *result = __real_realloc(ptr, size);
+    // Si falla, el bloque original sigue vivo y no se cuenta nada.
+    if (ptr && (result || size == 0))
+    {
+      HeapMonitor::noteFree();
+    }
+    if (result && size > 0)
+    {
+      HeapMonitor::noteAlloc(size);
+    }
+    return result;
+  }
+
+  void *__wrap_calloc(size_t count, size_t size)
+  {
+    void *ptr = __real_calloc(count, size);
+    if (ptr)
+    {
+      HeapMonitor::noteAlloc(count * size);
+    }
+    return ptr;
+  }
+}
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// 1 con -Wl,--wrap=malloc,--wrap=free,--wrap=realloc,--wrap=calloc en
+// build_flags: cada reserva pasa por los hooks y se atribuye a un Tag.
+#ifndef HEAP_MONITOR_HOOKS
+#define HEAP_MONITOR_HOOKS 0
+#endif
+
+// Estado del heap (libre, bloque mas grande, minimo historico, bloques) y
+// reservas atribuidas por subsistema. El Tag sale del Scope abierto por la
+// tarea en curso o, si no hay, del tag fijo de la tarea (tagTask()).
+namespace HeapMonitor
+{
+enum class Tag : uint8_t
+{
+  OTHER = 0,
+  MQTT,
+  JSON,
+  PROVISIONING,
+  CONFIG,
+  COUNT,
+};
+
+constexpr size_t kTagCount = static_cast<size_t>(Tag::COUNT);
+
+struct TagStats
+{
+  uint32_t allocs = 0;
+  // Los free se atribuyen a quien libera: allocs - frees de un tag que no
+  // baja a cero entre heartbeats es memoria que sobrevive a su Scope.
+  uint32_t frees = 0;
+  uint32_t bytes = 0; // bytes pedidos (IDF 4.4 no da el tamano al liberar)
+};
+
+struct Snapshot
+{
+  uint32_t freeBytes = 0;
+  uint32_t largestFreeBlock = 0;
+  uint32_t minFreeBytes = 0;
+  uint32_t allocatedBlocks = 0;
+  uint32_t allocs = 0; // reservas vistas por los hooks desde el arranque
+  uint8_t fragmentationPct = 0;
+};
+
+struct Trend
+{
+  int32_t freeDelta = 0;
+  int32_t largestDelta = 0;
+  uint32_t allocs = 0; // reservas desde el takeTrend() anterior
+};
+
+// 100 - bloque mayor / libre: 0 con todo el libre contiguo.
+uint8_t fragmentationPct(uint32_t freeBytes, uint32_t largestFreeBlock);
+
+Snapshot snapshot();
+// Cambio respecto a la llamada anterior (una por heartbeat).
+Trend takeTrend(const Snapshot &current);
+TagStats tagStats(Tag tag);
+const char *name(Tag tag);
+void resetTagStats();
+
+// Tag para las reservas de otra tarea (p. ej. la de esp-mqtt).
+void tagTask(TaskHandle_t task, Tag tag);
+
+// Hooks: los llaman los wrappers de malloc/free.
+void noteAlloc(size_t bytes);
+void noteFree();
+
+class Scope
+{
+public:
+  explicit Scope(Tag tag);
+  ~Scope();
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+private:
+  TaskHandle_t previousTask_;
+  Tag previousTag_;
+};
+} // namespace HeapMonitor
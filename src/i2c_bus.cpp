@@ -0,0 +1,231 @@
+#include "i2c_bus.h"
+
+#include <Wire.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "log.h"
+
+namespace I2cBus
+{
+namespace
+{
+struct PinConfig
+{
+  uint8_t sdaPin = 0;
+  uint8_t sclPin = 0;
+  uint32_t clockHz = 100000;
+  bool configured = false;
+};
+
+SemaphoreHandle_t g_mutex = nullptr;
+portMUX_TYPE g_waitLock = portMUX_INITIALIZER_UNLOCKED;
+uint8_t g_waiting[kClientCount] = {};
+PinConfig g_pins[kClientCount];
+PinConfig g_applied;
+uint32_t g_ownerStartUs = 0;
+Stats g_stats;
+uint32_t g_windowStartMs = 0;
+
+size_t indexOf(Client client)
+{
+  return static_cast<size_t>(client);
+}
+
+void changeWaiting(size_t index, int delta)
+{
+  portENTER_CRITICAL(&g_waitLock);
+  g_waiting[index] = static_cast<uint8_t>(g_waiting[index] + delta);
+  portEXIT_CRITICAL(&g_waitLock);
+}
+
+bool higherPriorityWaiting(size_t index)
+{
+  bool waiting = false;
+  portENTER_CRITICAL(&g_waitLock);
+  for (size_t i = 0; i < index; ++i)
+  {
+    waiting = waiting || g_waiting[i] > 0;
+  }
+  portEXIT_CRITICAL(&g_waitLock);
+  return waiting;
+}
+
+// Solo con el mutex tomado. Cambiar de pines obliga a reiniciar el driver.
+void applyPins(const PinConfig &pins)
+{
+  if (g_applied.configured && g_applied.sdaPin == pins.sdaPin && g_applied.sclPin == pins.sclPin)
+  {
+    if (g_applied.clockHz != pins.clockHz)
+    {
+      Wire.setClock(pins.clockHz);
+      g_applied.clockHz = pins.clockHz;
+    }
+    return;
+  }
+
+  if (g_applied.configured)
+  {
+    Wire.end();
+    g_stats.pinSwitches++;
+  }
+  Wire.begin(pins.sdaPin, pins.sclPin, pins.clockHz);
+  g_applied = pins;
+}
+
+uint8_t percentOf(uint64_t busyUs, uint32_t windowMs)
+{
+  if (windowMs == 0)
+  {
+    return 0;
+  }
+  const uint64_t pct = busyUs / 10 / windowMs;
+  return static_cast<uint8_t>(pct > 100 ? 100 : pct);
+}
+} // namespace
+
+void begin()
+{
+  if (!g_mutex)
+  {
+    g_mutex = xSemaphoreCreateMutex();
+  }
+  resetStats();
+}
+
+void configure(Client client, uint8_t sdaPin, uint8_t sclPin, uint32_t clockHz)
+{
+  PinConfig &pins = g_pins[indexOf(client)];
+  pins.sdaPin = sdaPin;
+  pins.sclPin = sclPin;
+  pins.clockHz = clockHz;
+  pins.configured = true;
+}
+
+bool acquire(Client client, uint32_t timeoutMs)
+{
+  const size_t index = indexOf(client);
+  ClientStats &clientStats = g_stats.clients[index];
+  if (!g_mutex || !g_pins[index].configured)
+  {
+    clientStats.errors++;
+    return false;
+  }
+
+  const uint32_t startUs = micros();
+  bool owned = false;
+  bool yielded = false;
+  changeWaiting(index, 1);
+  for (;;)
+  {
+    const uint32_t waitedMs = (micros() - startUs) / 1000;
+    if (waitedMs > timeoutMs ||
+        xSemaphoreTake(g_mutex, pdMS_TO_TICKS(timeoutMs - waitedMs)) != pdTRUE)
+    {
+      break;
+    }
+    if (!higherPriorityWaiting(index))
+    {
+      owned = true;
+      break;
+    }
+    // Deja pasar al de mas prioridad y vuelve a la cola.
+    xSemaphoreGive(g_mutex);
+    yielded = true;
+    vTaskDelay(1);
+  }
+  changeWaiting(index, -1);
+
+  if (yielded)
+  {
+    clientStats.yields++;
+  }
+  if (!owned)
+  {
+    clientStats.timeouts++;
+    return false;
+  }
+
+  g_ownerStartUs = micros();
+  const uint32_t waitUs = g_ownerStartUs - startUs;
+  if (waitUs > clientStats.maxWaitUs)
+  {
+    clientStats.maxWaitUs = waitUs;
+  }
+  applyPins(g_pins[index]);
+  return true;
+}
+
+void release(Client client)
+{
+  ClientStats &clientStats = g_stats.clients[indexOf(client)];
+  clientStats.transactions++;
+  clientStats.busyUs += micros() - g_ownerStartUs;
+  xSemaphoreGive(g_mutex);
+}
+
+void noteError(Client client)
+{
+  g_stats.clients[indexOf(client)].errors++;
+}
+
+Stats stats()
+{
+  Stats out = g_stats;
+  out.windowMs = millis() - g_windowStartMs;
+  return out;
+}
+
+uint8_t utilizationPct(Client client)
+{
+  return percentOf(g_stats.clients[indexOf(client)].busyUs, millis() - g_windowStartMs);
+}
+
+uint8_t utilizationPct()
+{
+  uint64_t busyUs = 0;
+  for (const ClientStats &clientStats : g_stats.clients)
+  {
+    busyUs += clientStats.busyUs;
+  }
+  return percentOf(busyUs, millis() - g_windowStartMs);
+}
+
+void resetStats()
+{
+  g_stats = Stats();
+  g_windowStartMs = millis();
+}
+
+void dumpStats()
+{
+  for (size_t i = 0; i < kClientCount; ++i)
+  {
+    const Client client = static_cast<Client>(i);
+    const ClientStats &s = g_stats.clients[i];
+    LOG_RAW(I2C, DEBUG, "[I2C] %-6s tx=%lu busy=%u%% err=%lu timeout=%lu yield=%lu wait_max=%lu us\n",
+            name(client),
+            static_cast<unsigned long>(s.transactions),
+            static_cast<unsigned>(utilizationPct(client)),
+            static_cast<unsigned long>(s.errors),
+            static_cast<unsigned long>(s.timeouts),
+            static_cast<unsigned long>(s.yields),
+            static_cast<unsigned long>(s.maxWaitUs));
+  }
+  LOG_RAW(I2C, DEBUG, "[I2C] cambios de pines=%lu\n", static_cast<unsigned long>(g_stats.pinSwitches));
+}
+
+const char *name(Client client)
+{
+  switch (client)
+  {
+  case Client::SENSOR:
+    return "sensor";
+  case Client::OLED:
+    return "oled";
+  default:
+    return "?";
+  }
+}
+} // namespace I2cBus
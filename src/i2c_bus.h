@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Dueno del controlador I2C: el C3 tiene uno solo y lo comparten la OLED y
+// el SHT45, cada uno con sus pines. acquire() serializa las transacciones,
+// remapea los pines cuando cambia el cliente y, si hay varios esperando,
+// cede el bus al de mas prioridad (el sensor antes que los frames).
+namespace I2cBus
+{
+// Orden de prioridad: el primero gana.
+enum class Client : uint8_t
+{
+  SENSOR = 0,
+  OLED,
+  COUNT,
+};
+
+constexpr size_t kClientCount = static_cast<size_t>(Client::COUNT);
+
+struct ClientStats
+{
+  uint32_t transactions = 0;
+  uint32_t errors = 0;   // reportados por el cliente con noteError()
+  uint32_t timeouts = 0; // acquire() sin bus dentro del plazo
+  uint32_t yields = 0;   // cedio el turno a un cliente de mas prioridad
+  uint32_t maxWaitUs = 0;
+  uint64_t busyUs = 0;
+};
+
+struct Stats
+{
+  ClientStats clients[kClientCount];
+  uint32_t pinSwitches = 0;
+  uint32_t windowMs = 0; // desde begin() o resetStats()
+};
+
+void begin();
+// Pines y reloj del cliente; se aplican en su siguiente acquire().
+void configure(Client client, uint8_t sdaPin, uint8_t sclPin, uint32_t clockHz);
+bool acquire(Client client, uint32_t timeoutMs);
+void release(Client client);
+void noteError(Client client);
+
+Stats stats();
+// Porcentaje de la ventana con el bus ocupado por el cliente.
+uint8_t utilizationPct(Client client);
+uint8_t utilizationPct();
+void resetStats();
+void dumpStats();
+const char *name(Client client);
+
+class Lock
+{
+public:
+  Lock(Client client, uint32_t timeoutMs) : client_(client), owned_(acquire(client, timeoutMs)) {}
+  ~Lock()
+  {
+    if (owned_)
+    {
+      release(client_);
+    }
+  }
+  Lock(const Lock &) = delete;
+  Lock &operator=(const Lock &) = delete;
+
+  bool owned() const { return owned_; }
+
+private:
+  Client client_;
+  bool owned_;
+};
+} // namespace I2cBus
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "log_ring.h"
+
+// Niveles de log por modulo, fijados en compilacion desde build_flags:
+//   -D LOG_LEVEL=LOG_LEVEL_WARN            todos los modulos
+//   -D LOG_LEVEL_SHT45=LOG_LEVEL_DEBUG     uno concreto
+// Una llamada por encima del nivel de su modulo queda en una rama
+// if constexpr descartada: no genera codigo, no evalua sus argumentos y su
+// cadena de formato no llega a flash.
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Por defecto se compila todo, como antes de los niveles.
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+// El nombre del modulo es la etiqueta que precede a cada linea ("[WIFI] ...").
+#ifndef LOG_LEVEL_AWS
+#define LOG_LEVEL_AWS LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_BLE
+#define LOG_LEVEL_BLE LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_BOOT
+#define LOG_LEVEL_BOOT LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_CONFIG
+#define LOG_LEVEL_CONFIG LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_CONN
+#define LOG_LEVEL_CONN LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_COREDUMP
+#define LOG_LEVEL_COREDUMP LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_DIAG
+#define LOG_LEVEL_DIAG LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_ESTADO
+#define LOG_LEVEL_ESTADO LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_HEARTBEAT
+#define LOG_LEVEL_HEARTBEAT LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_I2C
+#define LOG_LEVEL_I2C LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_IDENTIDAD
+#define LOG_LEVEL_IDENTIDAD LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_LZ
+#define LOG_LEVEL_LZ LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_METRICS
+#define LOG_LEVEL_METRICS LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_MQTT
+#define LOG_LEVEL_MQTT LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_PROF
+#define LOG_LEVEL_PROF LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_SCHED
+#define LOG_LEVEL_SCHED LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_SHT45
+#define LOG_LEVEL_SHT45 LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_SNTP
+#define LOG_LEVEL_SNTP LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_SPIFFS
+#define LOG_LEVEL_SPIFFS LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_STACK
+#define LOG_LEVEL_STACK LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_TELEMETRY
+#define LOG_LEVEL_TELEMETRY LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_WATCHDOG
+#define LOG_LEVEL_WATCHDOG LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_WIFI
+#define LOG_LEVEL_WIFI LOG_LEVEL
+#endif
+
+// Un modulo sin LOG_LEVEL_<modulo> definido no compila.
+#define LOG_ENABLED(module, level) (LOG_LEVEL_##module >= LOG_LEVEL_##level)
+
+// Lineas al anillo de LogRing (formato diferido, prefijo con el device_id).
+#define LOG_AT(module, level, fmt, ...)                       \
+  do                                                          \
+  {                                                           \
+    if constexpr (LOG_ENABLED(module, level))                 \
+    {                                                         \
+      LogRing::log("[" #module "] " fmt, ##__VA_ARGS__);      \
+    }                                                         \
+  } while (0)
+
+#define LOG_ERROR(module, fmt, ...) LOG_AT(module, ERROR, fmt, ##__VA_ARGS__)
+#define LOG_WARN(module, fmt, ...) LOG_AT(module, WARN, fmt, ##__VA_ARGS__)
+#define LOG_INFO(module, fmt, ...) LOG_AT(module, INFO, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(module, fmt, ...) LOG_AT(module, DEBUG, fmt, ##__VA_ARGS__)
+
+// Volcados de tablas: sin etiqueta ni prefijo, con el mismo filtro por nivel.
+// Se formatean en el momento y los saca log_drain (LogRing::raw).
+#define LOG_RAW(module, level, fmt, ...)                      \
+  do                                                          \
+  {                                                           \
+    if constexpr (LOG_ENABLED(module, level))                 \
+    {                                                         \
+      LogRing::raw(fmt, ##__VA_ARGS__);                       \
+    }                                                         \
+  } while (0)
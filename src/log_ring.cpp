@@ -0,0 +1,574 @@
+#include "log_ring.h"
+
+#include <esp_attr.h>
+#include <esp_ota_ops.h>
+#include <esp_system.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "spsc_ring.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace LogRing
+{
+namespace
+{
+constexpr uint32_t kRtcMagic = 0x474F4C52u; // "RLOG"
+constexpr uint16_t kRtcVersion = 1;
+constexpr size_t kShaLength = 8;
+constexpr size_t kRawBytesPerLine = 32;
+constexpr uint32_t kDrainPollMs = 100;
+constexpr uint32_t kDrainStackBytes = 3072;
+constexpr size_t kRawChunkBytes = 64;
+
+static_assert((kCapacity & (kCapacity - 1)) == 0, "LOG_RING_ENTRIES debe ser potencia de 2");
+
+// Mismo layout que lee tools/log_decode.py.
+struct RtcRing
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t entryBytes;
+  uint16_t capacity;
+  uint16_t reserved;
+  uint32_t written; // entradas escritas desde que se vacio; indice = written % kCapacity
+  char elfSha[kShaLength];
+  Entry entries[kCapacity];
+};
+
+RTC_NOINIT_ATTR RtcRing g_rtc;
+
+portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+uint32_t g_readIndex = 0;
+uint32_t g_bootIndex = 0;
+Stats g_stats;
+char g_prefix[kPrefixLength] = "UNKNOWN";
+TaskHandle_t g_drainTask = nullptr;
+// Texto de LOG_RAW: escribe la tarea que arranco el drain, lee el drain.
+SpscRing<char, LOG_RAW_BUFFER_BYTES> g_rawText;
+TaskHandle_t g_rawProducer = nullptr;
+
+// Solo los usa el drain.
+uint32_t g_lostReported = 0;
+bool g_previousAnnounced = false;
+bool g_rawDumpPending = false;
+
+bool isSoftReset(esp_reset_reason_t reason)
+{
+  return reason == ESP_RST_SW || reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT ||
+         reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT;
+}
+
+struct Arg
+{
+  ArgType type;
+  uint64_t integer;
+  double real;
+  const char *text;
+};
+
+struct ArgReader
+{
+  const uint8_t *data;
+  size_t length;
+  size_t pos;
+};
+
+bool nextArg(ArgReader &reader, Arg &arg)
+{
+  if (reader.pos >= reader.length)
+  {
+    return false;
+  }
+  arg.type = static_cast<ArgType>(reader.data[reader.pos++]);
+  const size_t left = reader.length - reader.pos;
+  switch (arg.type)
+  {
+  case ArgType::INT32:
+  {
+    if (left < 4)
+    {
+      return false;
+    }
+    uint32_t value = 0;
+    std::memcpy(&value, reader.data + reader.pos, 4);
+    arg.integer = value;
+    reader.pos += 4;
+    return true;
+  }
+  case ArgType::INT64:
+    if (left < 8)
+    {
+      return false;
+    }
+    std::memcpy(&arg.integer, reader.data + reader.pos, 8);
+    reader.pos += 8;
+    return true;
+  case ArgType::DOUBLE:
+    if (left < 8)
+    {
+      return false;
+    }
+    std::memcpy(&arg.real, reader.data + reader.pos, 8);
+    reader.pos += 8;
+    return true;
+  case ArgType::STRING:
+  {
+    const void *end = std::memchr(reader.data + reader.pos, '\0', left);
+    if (!end)
+    {
+      return false;
+    }
+    arg.text = reinterpret_cast<const char *>(reader.data + reader.pos);
+    reader.pos = static_cast<const uint8_t *>(end) - reader.data + 1;
+    return true;
+  }
+  }
+  return false;
+}
+
+bool reserve(Entry &entry, size_t bytes)
+{
+  if (entry.flags & kFlagTruncated)
+  {
+    return false;
+  }
+  if (entry.argBytes + bytes > sizeof(entry.args))
+  {
+    // A partir de aqui no se guarda nada: los argumentos siguientes no
+    // casarian con su especificador.
+    entry.flags |= kFlagTruncated;
+    return false;
+  }
+  return true;
+}
+
+void appendSpec(char *spec, size_t &specLength, const char *text)
+{
+  while (*text && specLength + 1 < 16)
+  {
+    spec[specLength++] = *text++;
+  }
+  spec[specLength] = '\0';
+}
+
+bool isUnsignedConversion(char conversion)
+{
+  return conversion == 'u' || conversion == 'x' || conversion == 'X' || conversion == 'o';
+}
+
+bool isFloatConversion(char conversion)
+{
+  return std::strchr("fFeEgGaA", conversion) != nullptr;
+}
+
+// Un especificador con su argumento; la longitud (l, ll, z...) se rehace a
+// partir del tipo guardado, no del que pedia el formato.
+int formatOne(char *out, size_t size, char *spec, size_t specLength, char conversion, const Arg &arg)
+{
+  const char conversionText[2] = {conversion, '\0'};
+  if (conversion == 's' && arg.type == ArgType::STRING)
+  {
+    appendSpec(spec, specLength, conversionText);
+    return snprintf(out, size, spec, arg.text);
+  }
+  if (isFloatConversion(conversion) && arg.type == ArgType::DOUBLE)
+  {
+    appendSpec(spec, specLength, conversionText);
+    return snprintf(out, size, spec, arg.real);
+  }
+  if (conversion == 'p' && (arg.type == ArgType::INT32 || arg.type == ArgType::INT64))
+  {
+    appendSpec(spec, specLength, "p");
+    return snprintf(out, size, spec, reinterpret_cast<void *>(static_cast<uintptr_t>(arg.integer)));
+  }
+  if (arg.type == ArgType::INT64)
+  {
+    appendSpec(spec, specLength, "ll");
+    appendSpec(spec, specLength, conversion == 'i' || conversion == 'c' ? "d" : conversionText);
+    return isUnsignedConversion(conversion)
+               ? snprintf(out, size, spec, static_cast<unsigned long long>(arg.integer))
+               : snprintf(out, size, spec, static_cast<long long>(arg.integer));
+  }
+  if (arg.type == ArgType::INT32 && (std::strchr("dic", conversion) || isUnsignedConversion(conversion)))
+  {
+    appendSpec(spec, specLength, conversionText);
+    const uint32_t value = static_cast<uint32_t>(arg.integer);
+    return isUnsignedConversion(conversion)
+               ? snprintf(out, size, spec, static_cast<unsigned>(value))
+               : snprintf(out, size, spec, static_cast<int>(static_cast<int32_t>(value)));
+  }
+  return snprintf(out, size, "<?>");
+}
+
+void printRaw()
+{
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&g_rtc);
+  Serial.printf("[LOG] raw inicio %u bytes\n", static_cast<unsigned>(sizeof(g_rtc)));
+  for (size_t offset = 0; offset < sizeof(g_rtc); offset += kRawBytesPerLine)
+  {
+    uint8_t chunk[kRawBytesPerLine];
+    const size_t count = sizeof(g_rtc) - offset < kRawBytesPerLine ? sizeof(g_rtc) - offset : kRawBytesPerLine;
+    portENTER_CRITICAL(&g_lock);
+    std::memcpy(chunk, bytes + offset, count);
+    portEXIT_CRITICAL(&g_lock);
+
+    char hex[kRawBytesPerLine * 2 + 1];
+    for (size_t i = 0; i < count; ++i)
+    {
+      snprintf(hex + i * 2, 3, "%02x", chunk[i]);
+    }
+    Serial.printf("[LOG] raw %04x %s\n", static_cast<unsigned>(offset), hex);
+  }
+  Serial.println("[LOG] raw fin");
+}
+
+void drainRawText()
+{
+  char chunk[kRawChunkBytes];
+  size_t length = 0;
+  while (g_rawText.pop(chunk[length]))
+  {
+    if (++length == sizeof(chunk))
+    {
+      Serial.printf("%.*s", static_cast<int>(length), chunk);
+      length = 0;
+    }
+  }
+  if (length > 0)
+  {
+    Serial.printf("%.*s", static_cast<int>(length), chunk);
+  }
+}
+
+void drainTask(void *)
+{
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(kDrainPollMs));
+    drain(SIZE_MAX);
+  }
+}
+} // namespace
+
+void begin()
+{
+  char sha[kShaLength + 1] = {0};
+  esp_ota_get_app_elf_sha256(sha, sizeof(sha));
+  const bool sameLayout = g_rtc.magic == kRtcMagic && g_rtc.version == kRtcVersion &&
+                          g_rtc.entryBytes == kEntryBytes && g_rtc.capacity == kCapacity &&
+                          std::memcmp(g_rtc.elfSha, sha, kShaLength) == 0;
+  const bool keep = sameLayout && isSoftReset(esp_reset_reason());
+
+  portENTER_CRITICAL(&g_lock);
+  g_stats = Stats();
+  if (keep)
+  {
+    const uint32_t count = g_rtc.written < kCapacity ? g_rtc.written : kCapacity;
+    g_readIndex = g_rtc.written - count;
+    g_bootIndex = g_rtc.written;
+    g_stats.previousBoot = count;
+  }
+  else
+  {
+    std::memset(&g_rtc, 0, sizeof(g_rtc));
+    g_rtc.magic = kRtcMagic;
+    g_rtc.version = kRtcVersion;
+    g_rtc.entryBytes = kEntryBytes;
+    g_rtc.capacity = kCapacity;
+    std::memcpy(g_rtc.elfSha, sha, kShaLength);
+    g_readIndex = 0;
+    g_bootIndex = 0;
+  }
+  g_lostReported = 0;
+  g_previousAnnounced = false;
+  portEXIT_CRITICAL(&g_lock);
+}
+
+void startDrain()
+{
+  if (g_drainTask)
+  {
+    return;
+  }
+  g_rawProducer = xTaskGetCurrentTaskHandle();
+  // Prioridad de idle: solo corre cuando el loop esta bloqueado.
+  if (xTaskCreate(drainTask, "log_drain", kDrainStackBytes, nullptr, tskIDLE_PRIORITY, &g_drainTask) != pdTRUE)
+  {
+    g_drainTask = nullptr;
+    Serial.println("[LOG] No se pudo crear la tarea log_drain");
+  }
+}
+
+void setPrefix(const char *prefix)
+{
+  portENTER_CRITICAL(&g_lock);
+  snprintf(g_prefix, sizeof(g_prefix), "%s", prefix && prefix[0] ? prefix : "UNKNOWN");
+  portEXIT_CRITICAL(&g_lock);
+}
+
+void beginEntry(Entry &entry, const char *format)
+{
+  entry.format = format;
+  entry.ms = millis();
+  entry.argBytes = 0;
+  entry.flags = 0;
+  entry.reserved = 0;
+}
+
+void commit(const Entry &entry)
+{
+  portENTER_CRITICAL(&g_lock);
+  g_rtc.entries[g_rtc.written % kCapacity] = entry;
+  g_rtc.written++;
+  g_stats.logged++;
+  if (entry.flags & kFlagTruncated)
+  {
+    g_stats.truncated++;
+  }
+  portEXIT_CRITICAL(&g_lock);
+  if (g_drainTask)
+  {
+    xTaskNotifyGive(g_drainTask);
+  }
+}
+
+bool pop(Entry &entry, bool *previousBoot)
+{
+  portENTER_CRITICAL(&g_lock);
+  const uint32_t written = g_rtc.written;
+  if (written - g_readIndex > kCapacity)
+  {
+    g_stats.lost += written - kCapacity - g_readIndex;
+    g_readIndex = written - kCapacity;
+  }
+  if (g_readIndex == written)
+  {
+    portEXIT_CRITICAL(&g_lock);
+    return false;
+  }
+  entry = g_rtc.entries[g_readIndex % kCapacity];
+  if (previousBoot)
+  {
+    *previousBoot = static_cast<int32_t>(g_readIndex - g_bootIndex) < 0;
+  }
+  g_readIndex++;
+  g_stats.drained++;
+  portEXIT_CRITICAL(&g_lock);
+  return true;
+}
+
+size_t format(const Entry &entry, char *out, size_t size)
+{
+  if (!out || size == 0)
+  {
+    return 0;
+  }
+  ArgReader reader = {entry.args, entry.argBytes < sizeof(entry.args) ? entry.argBytes : sizeof(entry.args), 0};
+  const char *cursor = entry.format ? entry.format : "";
+  size_t length = 0;
+  while (*cursor && length + 1 < size)
+  {
+    if (*cursor != '%')
+    {
+      out[length++] = *cursor++;
+      continue;
+    }
+    if (cursor[1] == '%')
+    {
+      out[length++] = '%';
+      cursor += 2;
+      continue;
+    }
+
+    char spec[16] = "%";
+    size_t specLength = 1;
+    ++cursor;
+    while (*cursor && std::strchr("-+ #0123456789.", *cursor))
+    {
+      const char flag[2] = {*cursor++, '\0'};
+      appendSpec(spec, specLength, flag);
+    }
+    while (*cursor && std::strchr("hlLqjzt", *cursor))
+    {
+      ++cursor;
+    }
+    const char conversion = *cursor;
+    if (!conversion)
+    {
+      break;
+    }
+    ++cursor;
+
+    Arg arg = {};
+    const int written = nextArg(reader, arg)
+                            ? formatOne(out + length, size - length, spec, specLength, conversion, arg)
+                            : snprintf(out + length, size - length, "<?>");
+    if (written > 0)
+    {
+      length += static_cast<size_t>(written) < size - length ? static_cast<size_t>(written) : size - length - 1;
+    }
+  }
+  out[length] = '\0';
+  return length;
+}
+
+size_t drain(size_t maxEntries)
+{
+  if (g_rawDumpPending)
+  {
+    g_rawDumpPending = false;
+    printRaw();
+  }
+
+  size_t count = 0;
+  Entry entry;
+  bool previous = false;
+  char line[kLineLength];
+  char prefix[kPrefixLength];
+  while (count < maxEntries && pop(entry, &previous))
+  {
+    portENTER_CRITICAL(&g_lock);
+    std::memcpy(prefix, g_prefix, sizeof(prefix));
+    const uint32_t lost = g_stats.lost;
+    const uint32_t previousCount = g_stats.previousBoot;
+    portEXIT_CRITICAL(&g_lock);
+
+    if (lost != g_lostReported)
+    {
+      Serial.printf("[%s] [LOG] %lu entradas perdidas\n", prefix,
+                    static_cast<unsigned long>(lost - g_lostReported));
+      g_lostReported = lost;
+    }
+    if (previous && !g_previousAnnounced)
+    {
+      Serial.printf("[LOG] %lu entradas del arranque anterior:\n", static_cast<unsigned long>(previousCount));
+      g_previousAnnounced = true;
+    }
+
+    format(entry, line, sizeof(line));
+    if (previous)
+    {
+      Serial.printf("[%s] (anterior, %lu ms) %s", prefix, static_cast<unsigned long>(entry.ms), line);
+    }
+    else
+    {
+      Serial.printf("[%s] %s", prefix, line);
+    }
+    ++count;
+  }
+  drainRawText();
+  return count;
+}
+
+void raw(const char *format, ...)
+{
+  char line[kLineLength];
+  va_list args;
+  va_start(args, format);
+  const int written = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  if (written <= 0)
+  {
+    return;
+  }
+  const size_t length = static_cast<size_t>(written) < sizeof(line) ? static_cast<size_t>(written) : sizeof(line) - 1;
+
+  const bool queue = g_drainTask && xTaskGetCurrentTaskHandle() == g_rawProducer &&
+                     g_rawText.capacity() - g_rawText.size() >= length;
+  if (!queue)
+  {
+    Serial.print(line);
+    portENTER_CRITICAL(&g_lock);
+    g_stats.rawDirect++;
+    portEXIT_CRITICAL(&g_lock);
+    return;
+  }
+  for (size_t i = 0; i < length; ++i)
+  {
+    g_rawText.push(line[i]);
+  }
+  portENTER_CRITICAL(&g_lock);
+  g_stats.rawQueued++;
+  portEXIT_CRITICAL(&g_lock);
+  xTaskNotifyGive(g_drainTask);
+}
+
+void requestRawDump()
+{
+  g_rawDumpPending = true;
+  if (g_drainTask)
+  {
+    xTaskNotifyGive(g_drainTask);
+  }
+}
+
+Stats stats()
+{
+  portENTER_CRITICAL(&g_lock);
+  const Stats result = g_stats;
+  portEXIT_CRITICAL(&g_lock);
+  return result;
+}
+
+void packInt(Entry &entry, uint64_t value, bool wide)
+{
+  const size_t bytes = wide ? 8 : 4;
+  if (!reserve(entry, 1 + bytes))
+  {
+    return;
+  }
+  entry.args[entry.argBytes++] = static_cast<uint8_t>(wide ? ArgType::INT64 : ArgType::INT32);
+  if (wide)
+  {
+    std::memcpy(entry.args + entry.argBytes, &value, 8);
+  }
+  else
+  {
+    const uint32_t narrow = static_cast<uint32_t>(value);
+    std::memcpy(entry.args + entry.argBytes, &narrow, 4);
+  }
+  entry.argBytes += bytes;
+}
+
+void pack(Entry &entry, double value)
+{
+  if (!reserve(entry, 1 + sizeof(value)))
+  {
+    return;
+  }
+  entry.args[entry.argBytes++] = static_cast<uint8_t>(ArgType::DOUBLE);
+  std::memcpy(entry.args + entry.argBytes, &value, sizeof(value));
+  entry.argBytes += sizeof(value);
+}
+
+void pack(Entry &entry, const char *text)
+{
+  if (!text)
+  {
+    text = "(null)";
+  }
+  // Tipo y terminador como minimo; el resto de la cadena si cabe.
+  if (!reserve(entry, 2))
+  {
+    return;
+  }
+  const size_t room = sizeof(entry.args) - entry.argBytes - 2;
+  size_t length = 0;
+  while (text[length] && length < room)
+  {
+    ++length;
+  }
+  if (text[length])
+  {
+    entry.flags |= kFlagTruncated;
+  }
+  entry.args[entry.argBytes++] = static_cast<uint8_t>(ArgType::STRING);
+  std::memcpy(entry.args + entry.argBytes, text, length);
+  entry.argBytes += length;
+  entry.args[entry.argBytes++] = '\0';
+}
+} // namespace LogRing
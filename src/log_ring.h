@@ -0,0 +1,120 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <type_traits>
+
+// Entradas del anillo. Viven en RTC: las ultimas sobreviven a un reset por
+// software, panic o watchdog.
+#ifndef LOG_RING_ENTRIES
+#define LOG_RING_ENTRIES 32
+#endif
+
+// Bytes del buffer de texto de los volcados de tablas (LOG_RAW). En RAM
+// normal: no compite con el anillo de la RTC.
+#ifndef LOG_RAW_BUFFER_BYTES
+#define LOG_RAW_BUFFER_BYTES 2048
+#endif
+
+// Log binario con formato diferido. log() solo copia el puntero al formato
+// (una cadena en flash), millis() y los argumentos crudos a una entrada de
+// 64 bytes; la tarea log_drain, con prioridad de idle, los formatea y los
+// saca por Serial cuando el loop no tiene nada que hacer.
+// tools/log_decode.py decodifica volcados del anillo con el ELF del firmware.
+namespace LogRing
+{
+constexpr size_t kCapacity = LOG_RING_ENTRIES;
+constexpr size_t kEntryBytes = 64;
+constexpr size_t kPrefixLength = 32;
+constexpr size_t kLineLength = 256;
+
+enum class ArgType : uint8_t
+{
+  INT32 = 1,
+  INT64,
+  DOUBLE,
+  STRING, // bytes + '\0', recortada si no cabe
+};
+
+constexpr uint8_t kFlagTruncated = 0x01;
+
+struct Entry
+{
+  const char *format;
+  uint32_t ms;
+  uint8_t argBytes;
+  uint8_t flags;
+  uint16_t reserved;
+  // Por argumento: ArgType y el valor en little endian.
+  uint8_t args[kEntryBytes - sizeof(const char *) - 8];
+};
+
+static_assert(sizeof(Entry) == kEntryBytes, "Entry debe ocupar kEntryBytes");
+
+struct Stats
+{
+  uint32_t logged = 0;
+  uint32_t drained = 0;
+  uint32_t lost = 0; // pisadas antes de que el drain las sacara
+  uint32_t truncated = 0;
+  uint32_t previousBoot = 0; // recuperadas de la RTC en begin()
+  uint32_t rawQueued = 0;    // lineas de LOG_RAW encoladas para log_drain
+  uint32_t rawDirect = 0;    // lineas de LOG_RAW escritas en el momento
+};
+
+// Recupera el anillo de la RTC si el reinicio fue por software, panic o
+// watchdog y el firmware es el mismo; si no, lo vacia. Antes del primer log.
+void begin();
+// Arranca la tarea que vacia el anillo.
+void startDrain();
+// Texto que precede a cada linea (el device_id).
+void setPrefix(const char *prefix);
+
+void beginEntry(Entry &entry, const char *format);
+void commit(const Entry &entry);
+
+// Para el drain y los tests. previousBoot indica una entrada del arranque anterior.
+bool pop(Entry &entry, bool *previousBoot = nullptr);
+// Formatea una entrada sin prefijo ni salto de linea final extra.
+size_t format(const Entry &entry, char *out, size_t size);
+// Saca hasta maxEntries por Serial; devuelve cuantas.
+size_t drain(size_t maxEntries);
+// Texto ya formateado de LOG_RAW, sin prefijo. Va a un buffer que vacia
+// log_drain; sale por Serial en el momento si no hay drain, si no cabe o si
+// no la llama la tarea que arranco el drain (el buffer tiene un productor).
+void raw(const char *format, ...) __attribute__((format(printf, 1, 2)));
+// Pide al drain el anillo crudo en lineas "[LOG] raw" (tools/log_decode.py).
+void requestRawDump();
+
+Stats stats();
+
+void packInt(Entry &entry, uint64_t value, bool wide);
+void pack(Entry &entry, double value);
+void pack(Entry &entry, const char *text);
+
+inline void pack(Entry &entry, char *text)
+{
+  pack(entry, static_cast<const char *>(text));
+}
+
+inline void pack(Entry &entry, const void *pointer)
+{
+  packInt(entry, reinterpret_cast<uintptr_t>(pointer), sizeof(pointer) > 4);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+pack(Entry &entry, T value)
+{
+  packInt(entry, static_cast<uint64_t>(value), sizeof(T) > 4);
+}
+
+template <typename... Args>
+void log(const char *format, Args... args)
+{
+  Entry entry;
+  beginEntry(entry, format);
+  (pack(entry, args), ...);
+  commit(entry);
+}
+} // namespace LogRing
@@ -0,0 +1,235 @@
+#include "loop_profiler.h"
+
+#include <esp_attr.h>
+#include <esp_system.h>
+
+#include "log.h"
+
+namespace LoopProfiler
+{
+size_t bucketFor(uint32_t us)
+{
+  if (us < 4)
+  {
+    return 0;
+  }
+  const size_t log2 = 31 - static_cast<size_t>(__builtin_clz(us));
+  return log2 - 1 < kBucketCount ? log2 - 1 : kBucketCount - 1;
+}
+
+uint32_t bucketFloorUs(size_t bucket)
+{
+  return bucket == 0 ? 0 : static_cast<uint32_t>(1) << (bucket + 1);
+}
+
+#if LOOP_PROFILER_ENABLED
+namespace
+{
+constexpr uint32_t kRtcMagic = 0x9A0F11E5u;
+
+struct RtcActive
+{
+  uint32_t magic;
+  SlotId slot;
+  uint32_t sinceMs;
+};
+
+RTC_NOINIT_ATTR RtcActive g_rtc;
+
+SlotStats g_slots[kMaxSlots];
+size_t g_slotCount = 0;
+Sample g_worst[kWorstCount];
+size_t g_worstCount = 0;
+
+void noteWorst(SlotId slot, uint32_t us, uint32_t atMs)
+{
+  if (g_worstCount == kWorstCount && us <= g_worst[kWorstCount - 1].us)
+  {
+    return;
+  }
+  size_t pos = g_worstCount < kWorstCount ? g_worstCount++ : kWorstCount - 1;
+  while (pos > 0 && g_worst[pos - 1].us < us)
+  {
+    g_worst[pos] = g_worst[pos - 1];
+    --pos;
+  }
+  g_worst[pos].slot = slot;
+  g_worst[pos].us = us;
+  g_worst[pos].atMs = atMs;
+}
+
+bool isWatchdogOrPanic(esp_reset_reason_t reason)
+{
+  return reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT ||
+         reason == ESP_RST_PANIC;
+}
+} // namespace
+
+SlotId addSlot(const char *name)
+{
+  if (g_slotCount >= kMaxSlots)
+  {
+    LOG_WARN(PROF, "Sin hueco para %s\n", name ? name : "?");
+    return kInvalidSlot;
+  }
+  const SlotId id = static_cast<SlotId>(g_slotCount++);
+  g_slots[id] = SlotStats();
+  g_slots[id].name = name;
+  return id;
+}
+
+void begin()
+{
+  const bool valid = g_rtc.magic == kRtcMagic && g_rtc.slot < g_slotCount;
+  if (valid && isWatchdogOrPanic(esp_reset_reason()))
+  {
+    LOG_WARN(PROF, "Reset previo dentro de %s (%lu ms de uptime al entrar)\n",
+             g_slots[g_rtc.slot].name, static_cast<unsigned long>(g_rtc.sinceMs));
+  }
+  g_rtc.magic = kRtcMagic;
+  g_rtc.slot = kInvalidSlot;
+  g_rtc.sinceMs = 0;
+}
+
+Mark enter(SlotId slot)
+{
+  const Mark mark = {slot, g_rtc.slot, micros()};
+  if (slot < g_slotCount)
+  {
+    g_rtc.slot = slot;
+    g_rtc.sinceMs = millis();
+  }
+  return mark;
+}
+
+void leave(const Mark &mark)
+{
+  if (mark.slot >= g_slotCount)
+  {
+    return;
+  }
+  record(mark.slot, micros() - mark.startUs);
+  g_rtc.slot = mark.previous;
+}
+
+void record(SlotId slot, uint32_t us)
+{
+  if (slot >= g_slotCount)
+  {
+    return;
+  }
+  SlotStats &s = g_slots[slot];
+  s.calls++;
+  s.totalUs += us;
+  s.buckets[bucketFor(us)]++;
+  if (us > s.windowMaxUs)
+  {
+    s.windowMaxUs = us;
+  }
+  if (us > s.maxUs)
+  {
+    s.maxUs = us;
+    s.maxAtMs = millis();
+  }
+  noteWorst(slot, us, millis());
+}
+
+bool stats(SlotId slot, SlotStats &out)
+{
+  if (slot >= g_slotCount)
+  {
+    return false;
+  }
+  out = g_slots[slot];
+  return true;
+}
+
+const char *name(SlotId slot)
+{
+  return slot < g_slotCount && g_slots[slot].name ? g_slots[slot].name : "?";
+}
+
+size_t slotCount() { return g_slotCount; }
+
+size_t worst(Sample *out, size_t capacity)
+{
+  const size_t count = g_worstCount < capacity ? g_worstCount : capacity;
+  for (size_t i = 0; i < count; ++i)
+  {
+    out[i] = g_worst[i];
+  }
+  return count;
+}
+
+size_t takeWindow(Sample *out, size_t capacity)
+{
+  size_t count = 0;
+  const uint32_t now = millis();
+  for (size_t i = 0; i < g_slotCount; ++i)
+  {
+    const uint32_t us = g_slots[i].windowMaxUs;
+    g_slots[i].windowMaxUs = 0;
+    if (us == 0 || capacity == 0 || (count == capacity && us <= out[count - 1].us))
+    {
+      continue;
+    }
+    size_t pos = count < capacity ? count++ : capacity - 1;
+    while (pos > 0 && out[pos - 1].us < us)
+    {
+      out[pos] = out[pos - 1];
+      --pos;
+    }
+    out[pos].slot = static_cast<SlotId>(i);
+    out[pos].us = us;
+    out[pos].atMs = now;
+  }
+  return count;
+}
+
+void reset()
+{
+  for (size_t i = 0; i < g_slotCount; ++i)
+  {
+    const char *name = g_slots[i].name;
+    g_slots[i] = SlotStats();
+    g_slots[i].name = name;
+  }
+  g_worstCount = 0;
+}
+
+void dump()
+{
+  for (size_t i = 0; i < g_slotCount; ++i)
+  {
+    const SlotStats &s = g_slots[i];
+    if (s.calls == 0)
+    {
+      continue;
+    }
+    LOG_RAW(PROF, DEBUG, "[PROF] %-14s n=%lu avg=%lu max=%lu us @%lu ms |",
+            s.name,
+            static_cast<unsigned long>(s.calls),
+            static_cast<unsigned long>(s.totalUs / s.calls),
+            static_cast<unsigned long>(s.maxUs),
+            static_cast<unsigned long>(s.maxAtMs));
+    for (size_t b = 0; b < kBucketCount; ++b)
+    {
+      if (s.buckets[b] > 0)
+      {
+        LOG_RAW(PROF, DEBUG, " >=%lu:%lu", static_cast<unsigned long>(bucketFloorUs(b)),
+                static_cast<unsigned long>(s.buckets[b]));
+      }
+    }
+    LOG_RAW(PROF, DEBUG, "\n");
+  }
+  for (size_t i = 0; i < g_worstCount; ++i)
+  {
+    LOG_RAW(PROF, DEBUG, "[PROF] peor #%u %s %lu us @%lu ms\n",
+            static_cast<unsigned>(i + 1),
+            name(g_worst[i].slot),
+            static_cast<unsigned long>(g_worst[i].us),
+            static_cast<unsigned long>(g_worst[i].atMs));
+  }
+}
+#endif
+} // namespace LoopProfiler
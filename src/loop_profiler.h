@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Con 0 los Scope y addSlot() quedan vacios y el perfilado desaparece del
+// binario.
+#ifndef LOOP_PROFILER_ENABLED
+#define LOOP_PROFILER_ENABLED 1
+#endif
+
+// Latencia por handler de la tarea de loop(): histograma logaritmico fijo,
+// maximo con su instante y los peores casos globales. El handler en curso
+// queda en RTC para saber en el siguiente arranque cual se colgo si el
+// reset fue de watchdog. Solo se usa desde la tarea de loop().
+namespace LoopProfiler
+{
+using SlotId = uint8_t;
+
+constexpr SlotId kInvalidSlot = 0xFF;
+constexpr size_t kMaxSlots = 32;
+constexpr size_t kBucketCount = 16;
+constexpr size_t kWorstCount = 4;
+
+struct SlotStats
+{
+  const char *name = nullptr;
+  uint32_t calls = 0;
+  uint64_t totalUs = 0;
+  uint32_t maxUs = 0;
+  uint32_t maxAtMs = 0;
+  uint32_t windowMaxUs = 0; // desde el ultimo takeWindow()
+  uint32_t buckets[kBucketCount] = {};
+};
+
+struct Sample
+{
+  SlotId slot = kInvalidSlot;
+  uint32_t us = 0;
+  uint32_t atMs = 0;
+};
+
+// Cubo 0: < 4 us; cubo i: [2^(i+1), 2^(i+2)) us; el ultimo, todo desde 65 ms.
+size_t bucketFor(uint32_t us);
+uint32_t bucketFloorUs(size_t bucket);
+
+struct Mark
+{
+  SlotId slot;
+  SlotId previous;
+  uint32_t startUs;
+};
+
+#if LOOP_PROFILER_ENABLED
+SlotId addSlot(const char *name);
+// Informa del handler que estaba en curso si el reset anterior fue de
+// watchdog o panic. Llamar con los slots ya registrados.
+void begin();
+Mark enter(SlotId slot);
+void leave(const Mark &mark);
+// Registra una duracion ya medida (tests, handlers sin Scope).
+void record(SlotId slot, uint32_t us);
+
+bool stats(SlotId slot, SlotStats &out);
+const char *name(SlotId slot);
+size_t slotCount();
+// Peores muestras desde el arranque, de mayor a menor; devuelve cuantas hay.
+size_t worst(Sample *out, size_t capacity);
+// Los n slots con mayor maximo en la ventana actual, y abre una nueva.
+size_t takeWindow(Sample *out, size_t capacity);
+void reset();
+void dump();
+#else
+inline SlotId addSlot(const char *) { return kInvalidSlot; }
+inline void begin() {}
+inline Mark enter(SlotId slot) { return {slot, kInvalidSlot, 0}; }
+inline void leave(const Mark &) {}
+inline void dump() {}
+#endif
+
+class Scope
+{
+public:
+  explicit Scope(SlotId slot) : mark_(enter(slot)) {}
+  ~Scope() { leave(mark_); }
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+private:
+  Mark mark_;
+};
+} // namespace LoopProfiler
@@ -0,0 +1,178 @@
+#include "lz_codec.h"
+
+namespace LzCodec
+{
+namespace
+{
+struct BitWriter
+{
+  uint8_t *out;
+  size_t capacity;
+  size_t index;
+  uint8_t current;
+  uint8_t used;
+  bool overflow;
+};
+
+void putBits(BitWriter &writer, uint32_t value, uint8_t count)
+{
+  while (count > 0)
+  {
+    --count;
+    writer.current = static_cast<uint8_t>((writer.current << 1) | ((value >> count) & 1u));
+    if (++writer.used == 8)
+    {
+      if (writer.index >= writer.capacity)
+      {
+        writer.overflow = true;
+        return;
+      }
+      writer.out[writer.index++] = writer.current;
+      writer.current = 0;
+      writer.used = 0;
+    }
+  }
+}
+
+struct BitReader
+{
+  const uint8_t *in;
+  size_t length;
+  size_t bitIndex;
+};
+
+size_t bitsLeft(const BitReader &reader)
+{
+  return reader.length * 8 - reader.bitIndex;
+}
+
+uint32_t getBits(BitReader &reader, uint8_t count)
+{
+  uint32_t value = 0;
+  while (count > 0)
+  {
+    const uint8_t byte = reader.in[reader.bitIndex / 8];
+    const uint8_t bit = (byte >> (7 - reader.bitIndex % 8)) & 1u;
+    value = (value << 1) | bit;
+    ++reader.bitIndex;
+    --count;
+  }
+  return value;
+}
+
+bool validParams(const Params &params)
+{
+  // Mismos limites que heatshrink.
+  return params.windowBits >= 4 && params.windowBits <= 15 &&
+         params.lookaheadBits >= 3 && params.lookaheadBits < params.windowBits;
+}
+} // namespace
+
+size_t compress(const uint8_t *in, size_t length, uint8_t *out, size_t outCapacity,
+                const Params &params)
+{
+  if (!in || !out || length == 0 || !validParams(params))
+  {
+    return 0;
+  }
+
+  const size_t windowSize = static_cast<size_t>(1) << params.windowBits;
+  const size_t maxMatch = static_cast<size_t>(1) << params.lookaheadBits;
+  // Una referencia solo compensa si ocupa menos que los literales que sustituye.
+  const size_t breakEven = (1u + params.windowBits + params.lookaheadBits) / 8;
+
+  BitWriter writer = {out, outCapacity, 0, 0, 0, false};
+  size_t pos = 0;
+  while (pos < length && !writer.overflow)
+  {
+    const size_t windowStart = pos > windowSize ? pos - windowSize : 0;
+    const size_t limit = length - pos < maxMatch ? length - pos : maxMatch;
+    size_t bestLength = 0;
+    size_t bestOffset = 0;
+    // Busca desde lo mas cercano: a igual longitud gana el offset menor.
+    for (size_t candidate = pos; candidate-- > windowStart;)
+    {
+      size_t matched = 0;
+      while (matched < limit && in[candidate + matched] == in[pos + matched])
+      {
+        ++matched;
+      }
+      if (matched > bestLength)
+      {
+        bestLength = matched;
+        bestOffset = pos - candidate;
+        if (matched == limit)
+        {
+          break;
+        }
+      }
+    }
+
+    if (bestLength > breakEven)
+    {
+      putBits(writer, 0, 1);
+      putBits(writer, static_cast<uint32_t>(bestOffset - 1), params.windowBits);
+      putBits(writer, static_cast<uint32_t>(bestLength - 1), params.lookaheadBits);
+      pos += bestLength;
+    }
+    else
+    {
+      putBits(writer, 1, 1);
+      putBits(writer, in[pos], 8);
+      ++pos;
+    }
+  }
+
+  if (writer.used > 0 && !writer.overflow)
+  {
+    putBits(writer, 0, static_cast<uint8_t>(8 - writer.used));
+  }
+  return writer.overflow ? 0 : writer.index;
+}
+
+size_t decompress(const uint8_t *in, size_t length, uint8_t *out, size_t outCapacity,
+                  const Params &params)
+{
+  if (!in || !out || !validParams(params))
+  {
+    return 0;
+  }
+
+  BitReader reader = {in, length, 0};
+  const uint8_t backrefBits = params.windowBits + params.lookaheadBits;
+  size_t produced = 0;
+  while (bitsLeft(reader) > 0)
+  {
+    if (getBits(reader, 1) == 1)
+    {
+      if (bitsLeft(reader) < 8)
+      {
+        break;
+      }
+      if (produced >= outCapacity)
+      {
+        return 0;
+      }
+      out[produced++] = static_cast<uint8_t>(getBits(reader, 8));
+      continue;
+    }
+
+    // Un tag 0 sin bits suficientes es el relleno del ultimo byte.
+    if (bitsLeft(reader) < backrefBits)
+    {
+      break;
+    }
+    const size_t offset = getBits(reader, params.windowBits) + 1;
+    const size_t count = getBits(reader, params.lookaheadBits) + 1;
+    if (offset > produced || count > outCapacity - produced)
+    {
+      return 0;
+    }
+    for (size_t i = 0; i < count; ++i, ++produced)
+    {
+      out[produced] = out[produced - offset];
+    }
+  }
+  return produced;
+}
+} // namespace LzCodec
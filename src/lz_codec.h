@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Compresion LZSS con el formato de bits de heatshrink: tag 1 + literal de
+// 8 bits, o tag 0 + indice (windowBits) + longitud (lookaheadBits), MSB
+// primero. Con los parametros por defecto (-w 8 -l 4) lo decodifica tanto
+// tools/lz_decode.py como heatshrink estandar. No usa heap ni buffers
+// propios: la ventana es la misma entrada ya emitida.
+namespace LzCodec
+{
+struct Params
+{
+  uint8_t windowBits;
+  uint8_t lookaheadBits;
+};
+
+constexpr Params kDefaultParams = {8, 4};
+
+// Devuelve los bytes escritos en out, o 0 si no cabe en outCapacity (el
+// llamador publica entonces el payload sin comprimir).
+size_t compress(const uint8_t *in, size_t length, uint8_t *out, size_t outCapacity,
+                const Params &params = kDefaultParams);
+
+// Devuelve los bytes escritos en out, o 0 si la entrada es invalida o no cabe.
+size_t decompress(const uint8_t *in, size_t length, uint8_t *out, size_t outCapacity,
+                  const Params &params = kDefaultParams);
+} // namespace LzCodec
@@ -1,7 +1,7 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <esp_wifi.h>
-#include <stdarg.h>
+#include <esp_event.h>
 #include <esp_system.h>
 #include <esp_task_wdt.h>
 #include <mqtt_client.h>
@@ -9,6 +9,10 @@
 #include "soc/timer_group_struct.h"
 #include "soc/timer_group_reg.h"
 #include "soc/soc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 #include <ArduinoJson.h>
 #include <FS.h>
 #include <SPIFFS.h>
@@ -16,10 +20,25 @@
 #include <string>
 
 #include "Config.hpp"
+#include "aws_certs.h"
+#include "backoff.h"
+#include "core_dump.h"
+#include "diag_counters.h"
+#include "heap_monitor.h"
+#include "i2c_bus.h"
+#include "log.h"
+#include "log_ring.h"
+#include "loop_profiler.h"
+#include "lz_codec.h"
+#include "metrics.h"
 #include "oled_display.h"
 #include "provisioning.h"
+#include "publish_limiter.h"
+#include "scheduler.h"
 #include "sensor_registry.h"
 #include "sht45_sensor.h"
+#include "stack_monitor.h"
+#include "time_sync.h"
 
 #ifndef DEVICE_PREFIX
 #define DEVICE_PREFIX "ERROR_PREFIX_"
@@ -33,35 +52,84 @@
 #define FW_VERSION "dev"
 #endif
 
+#ifndef WIFI_BACKOFF_BASE_MS
+#define WIFI_BACKOFF_BASE_MS 2000
+#endif
+
+#ifndef WIFI_BACKOFF_CAP_MS
+#define WIFI_BACKOFF_CAP_MS 60000
+#endif
+
+#ifndef WIFI_BACKOFF_MAX_RETRIES
+#define WIFI_BACKOFF_MAX_RETRIES 6
+#endif
+
+#ifndef MQTT_BACKOFF_BASE_MS
+#define MQTT_BACKOFF_BASE_MS 1000
+#endif
+
+#ifndef MQTT_BACKOFF_CAP_MS
+#define MQTT_BACKOFF_CAP_MS 16000
+#endif
+
+#ifndef DIAG_FLUSH_INTERVAL_MS
+#define DIAG_FLUSH_INTERVAL_MS 600000
+#endif
+
+#ifndef METRICS_INTERVAL_MS
+#define METRICS_INTERVAL_MS 60000
+#endif
+
+// El minimo de pila es historico: el intervalo solo retrasa el aviso.
+#ifndef STACK_SAMPLE_INTERVAL_MS
+#define STACK_SAMPLE_INTERVAL_MS 30000
+#endif
+
+// -D LOOP_TASK_STACK_BYTES / -D MQTT_TASK_STACK_BYTES ajustan la pila del
+// loop y de esp-mqtt con los datos de StackMonitor; sin definir se quedan
+// los valores de arduino-esp32 (8 KB) y de esp-mqtt (6 KB).
+#ifdef LOOP_TASK_STACK_BYTES
+SET_LOOP_TASK_STACK_SIZE(LOOP_TASK_STACK_BYTES);
+#endif
+
+// Un trozo del core dump como mucho cada intervalo, y solo con el resto de
+// publicaciones al dia.
+#ifndef CORE_DUMP_CHUNK_INTERVAL_MS
+#define CORE_DUMP_CHUNK_INTERVAL_MS 1000
+#endif
+
+// Los payloads comprimidos se publican en <topic>/hs; el backend debe
+// suscribirse a ambos antes de activarlo.
+#ifndef MQTT_COMPRESSION_ENABLED
+#define MQTT_COMPRESSION_ENABLED 0
+#endif
+
+#ifndef MQTT_COMPRESSION_MIN_BYTES
+#define MQTT_COMPRESSION_MIN_BYTES 256
+#endif
+
+#ifndef MQTT_COMPRESSION_BENCHMARK
+#define MQTT_COMPRESSION_BENCHMARK 0
+#endif
+
+// Con credenciales guardadas y la ventana de provisioning cerrada, libera
+// Bluedroid y la memoria del controlador BLE. Reaprovisionar requiere la
+// pulsacion larga, que reinicia en un arranque con BLE.
+// 1 levanta el stack BLE en setup() aunque haya credenciales, como antes;
+// sirve para comparar el tiempo hasta el primer publish.
+#ifndef BLE_EAGER_INIT
+#define BLE_EAGER_INIT 0
+#endif
+
+#ifndef BLE_RELEASE_AFTER_WINDOW
+#define BLE_RELEASE_AFTER_WINDOW 0
+#endif
+
 // ======================
 // 🔹 CONFIGURACIÓN AWS
 // ======================
-constexpr const char kDefaultAwsEndpoint[] = "awvhj0h4worjs-ats.iot.us-east-1.amazonaws.com";
-constexpr int32_t kDefaultAwsPort = 8883;
-constexpr const char kDefaultAwsRegion[] = "us-east-1";
-constexpr const char kDefaultThingName[] = "";
-constexpr const char kDefaultEnv[] = "prod";
+// Claves NVS y sus defaults: ver kSchema en ConfigSchema.hpp.
 constexpr const char kDefaultDeviceKind[] = "climate_sensor";
-constexpr const char kDefaultRootCaPath[] = "/certs/AmazonRootCA1.pem";
-constexpr const char kDefaultDeviceCertPath[] = "/certs/device.pem.crt";
-constexpr const char kDefaultPrivateKeyPath[] = "/certs/private.pem.key";
-constexpr const char kDiagWifiRetriesKey[] = "wifi_retries";
-constexpr const char kDiagMqttRetriesKey[] = "mqtt_retries";
-constexpr const char kDiagLastResetKey[] = "last_reset_reason";
-constexpr const char kDiagResetCountKey[] = "reset_count_total";
-constexpr const char kDiagWdtKey[] = "wdt_resets";
-constexpr const char kCertRootKey[] = "root_ca";
-constexpr const char kCertDeviceKey[] = "device_cert";
-constexpr const char kCertPrivateKey[] = "private_key";
-constexpr const char kAwsEndpointKey[] = "endpoint";
-constexpr const char kAwsPortKey[] = "port";
-constexpr const char kAwsThingKey[] = "thing";
-constexpr const char kAwsRegionKey[] = "region";
-constexpr const char kDeviceIdKey[] = "device_id";
-constexpr const char kDeviceUserKey[] = "user_id";
-constexpr const char kDeviceEnvKey[] = "env";
-constexpr const char kWifiSsidKey[] = "ssid";
-constexpr const char kWifiPassKey[] = "password";
 
 esp_mqtt_client_handle_t g_mqttClient = nullptr;
 
@@ -74,15 +142,24 @@ namespace
   constexpr uint32_t kBleActivationHoldMs = 3000;
   constexpr uint32_t kIdentityLogDelayMs = 6000;
   constexpr uint16_t kMqttKeepAliveSeconds = 15;
-  constexpr uint32_t kAwsBackoffInitialMs = 1000;
-  constexpr uint32_t kAwsBackoffMaxMs = 16000;
-  constexpr uint32_t kAwsInitialConnectGraceMs = 3000;
-  constexpr uint32_t kWifiBackoffDelaysMs[] = {2000, 4000, 8000, 16000, 30000, 60000};
-  constexpr size_t kWifiBackoffStepCount =
-      sizeof(kWifiBackoffDelaysMs) / sizeof(kWifiBackoffDelaysMs[0]);
+  constexpr Backoff::Policy kAwsBackoffPolicy = {MQTT_BACKOFF_BASE_MS, MQTT_BACKOFF_CAP_MS};
+  constexpr Backoff::Policy kWifiBackoffPolicy = {WIFI_BACKOFF_BASE_MS, WIFI_BACKOFF_CAP_MS};
+  constexpr uint32_t kWifiMaxRetriesBeforeRestart = WIFI_BACKOFF_MAX_RETRIES;
   constexpr uint32_t kTaskWatchdogTimeoutSeconds = 8;
   constexpr uint32_t kHardwareWatchdogTimeoutMs = 12000;
   constexpr uint32_t kHardwareWatchdogPrescaler = 8000;
+  constexpr size_t kConnEventQueueLength = 16;
+  constexpr uint32_t kButtonPollMs = 50;
+  constexpr uint32_t kWatchdogFeedIntervalMs = 1000;
+  constexpr uint32_t kDisplayTickMs = 100;
+  constexpr uint32_t kSchedulerStatsIntervalMs = 300000;
+  // Desfase entre los volcados de tablas: cada uno cabe en el buffer de
+  // LOG_RAW y log_drain lo saca antes de que llegue el siguiente.
+  constexpr uint32_t kStatsDumpStaggerMs = 10000;
+  constexpr uint32_t kMaxIdleWaitMs = 1000;
+  constexpr size_t kMaxDeferredTelemetry = 8;
+  constexpr uint32_t kBleReleaseCheckMs = 60000;
+  constexpr const char kCompressedTopicSuffix[] = "/hs";
 
   enum class SystemState : uint8_t
   {
@@ -91,6 +168,35 @@ namespace
     BLE_ACTIVE,
   };
 
+  enum class ConnPhase : uint8_t
+  {
+    IDLE = 0,
+    WIFI_CONNECTING,
+    WIFI_BACKOFF,
+    WIFI_ONLINE,
+    TLS_CONNECTING,
+    MQTT_ONLINE,
+    MQTT_BACKOFF,
+  };
+
+  enum class ConnEventType : uint8_t
+  {
+    WIFI_ASSOCIATED = 0,
+    WIFI_GOT_IP,
+    WIFI_DISCONNECTED,
+    MQTT_BEFORE_CONNECT,
+    MQTT_CONNECTED,
+    MQTT_DISCONNECTED,
+    MQTT_ERROR,
+    MQTT_PUBLISHED, // solo el del trozo de core dump en vuelo
+  };
+
+  struct ConnEvent
+  {
+    ConnEventType type;
+    int32_t detail;
+  };
+
   String g_deviceId;
   String g_userId;
   String g_environment;
@@ -99,26 +205,71 @@ namespace
   String g_bootSessionId;
   SystemState g_state = SystemState::WIFI_DISCONNECTED;
 
+  ConnPhase g_connPhase = ConnPhase::IDLE;
+  QueueHandle_t g_connEventQueue = nullptr;
+  SemaphoreHandle_t g_mqttMutex = nullptr;
+  volatile uint32_t g_connEventDrops = 0;
+
   bool g_wifiConnected = false;
   bool g_wifiConnecting = false;
-  uint32_t g_wifiConnectStart = 0;
-  uint32_t g_nextWifiAttemptMs = 0;
-  size_t g_wifiBackoffIndex = 0;
+  bool g_hasWifiCredentials = false;
+  Backoff::State g_wifiBackoff;
 
   bool g_bleActive = false;
-  uint32_t g_bleStartMs = 0;
 
   volatile bool g_bleButtonInterrupt = false;
   uint32_t g_lastButtonHandledMs = 0;
   bool g_bleButtonPending = false;
   uint32_t g_bleButtonPressStartMs = 0;
-  uint32_t g_identityLogTargetMs = 0;
-  bool g_identityLogReady = false;
+
+  Scheduler::JobId g_wifiRetryJob = Scheduler::kInvalidJob;
+  Scheduler::JobId g_wifiTimeoutJob = Scheduler::kInvalidJob;
+  Scheduler::JobId g_awsRetryJob = Scheduler::kInvalidJob;
+  Scheduler::JobId g_bleTimeoutJob = Scheduler::kInvalidJob;
+#if BLE_RELEASE_AFTER_WINDOW
+  Scheduler::JobId g_bleReleaseJob = Scheduler::kInvalidJob;
+#endif
+  Scheduler::JobId g_bleButtonJob = Scheduler::kInvalidJob;
+  Scheduler::JobId g_identityLogJob = Scheduler::kInvalidJob;
+  Scheduler::JobId g_displayJob = Scheduler::kInvalidJob;
+  Scheduler::JobId g_publishRetryJob = Scheduler::kInvalidJob;
+
+  // Handlers que loop() llama directamente; los jobs tienen su slot propio.
+  LoopProfiler::SlotId g_profConnEvents = LoopProfiler::kInvalidSlot;
+  LoopProfiler::SlotId g_profBleButton = LoopProfiler::kInvalidSlot;
+  LoopProfiler::SlotId g_profAws = LoopProfiler::kInvalidSlot;
+  LoopProfiler::SlotId g_profSystemState = LoopProfiler::kInvalidSlot;
+  LoopProfiler::SlotId g_profProvisioning = LoopProfiler::kInvalidSlot;
+
+  // Mensajes retenidos por el rate limiter; se envian al liberarse tokens.
+  bool g_claimDeferred = false;
+  bool g_sensorRegistryDeferred = false;
+  bool g_heartbeatDeferred = false;
+  bool g_metricsDeferred = false;
+  Sht45Sensor::Reading g_deferredTelemetry[kMaxDeferredTelemetry];
+  size_t g_deferredTelemetryHead = 0;
+  size_t g_deferredTelemetryCount = 0;
+  uint32_t g_deferredTelemetryDropped = 0;
+
+  // Para contar reconexiones y no la primera conexion.
+  bool g_wifiConnectedOnce = false;
+  bool g_mqttConnectedOnce = false;
+  char g_metricsPayload[512];
+
+  bool g_coreDumpSummaryPending = false;
+  bool g_coreDumpDeferred = false;
+  uint8_t g_coreDumpChunk[CoreDump::kHeaderBytes + CoreDump::kChunkBytes];
+
+#if MQTT_COMPRESSION_ENABLED
+  uint8_t g_compressionBuffer[768];
+  uint32_t g_compressionSavedBytes = 0;
+#endif
+  // millis() del primer publish aceptado por esp-mqtt; 0 hasta entonces.
+  uint32_t g_firstPublishMs = 0;
 
   // ===== AWS Flags
   bool g_mqttConnected = false;
-  uint32_t g_nextAwsAttemptMs = 0;
-  uint32_t g_currentAwsBackoffMs = kAwsBackoffInitialMs;
+  Backoff::State g_awsBackoff;
   bool g_claimPending = false;
   bool g_sensorRegistryPending = true;
   bool g_awsCredentialsLoaded = false;
@@ -132,9 +283,6 @@ namespace
   String g_privateKeyPem;
   bool g_taskWatchdogEnabled = false;
   bool g_hwWatchdogEnabled = false;
-  unsigned long lastHeartbeatMs = 0;
-  unsigned long lastTelemetryMs = 0;
-  unsigned long lastSensorLogMs = 0;
   const unsigned long HEARTBEAT_INTERVAL = 60000; // 60s
   const unsigned long TELEMETRY_INTERVAL = 8000; // Tiempo en que se envia playload
   const unsigned long SENSOR_LOG_INTERVAL = 8000; // Tiempo de registro en esp32
@@ -175,130 +323,154 @@ namespace
 
   void seedConfigDefaults()
   {
-    if (!Config::exists("aws", kAwsEndpointKey))
-    {
-      Config::setString("aws", kAwsEndpointKey, std::string(kDefaultAwsEndpoint));
-    }
-    if (!Config::exists("aws", kAwsRegionKey))
-    {
-      Config::setString("aws", kAwsRegionKey, std::string(kDefaultAwsRegion));
-    }
-    if (!Config::exists("aws", kAwsThingKey))
-    {
-      Config::setString("aws", kAwsThingKey, std::string(kDefaultThingName));
-    }
-    if (!Config::exists("aws", kAwsPortKey))
-    {
-      Config::setInt("aws", kAwsPortKey, kDefaultAwsPort);
-    }
-    if (!Config::exists("device", kDeviceEnvKey))
-    {
-      Config::setString("device", kDeviceEnvKey, std::string(kDefaultEnv));
-    }
-    if (!Config::exists("certs", kCertRootKey))
-    {
-      Config::setString("certs", kCertRootKey, std::string(kDefaultRootCaPath));
-    }
-    if (!Config::exists("certs", kCertDeviceKey))
-    {
-      Config::setString("certs", kCertDeviceKey, std::string(kDefaultDeviceCertPath));
-    }
-    if (!Config::exists("certs", kCertPrivateKey))
-    {
-      Config::setString("certs", kCertPrivateKey, std::string(kDefaultPrivateKeyPath));
-    }
-    if (!Config::exists("diag", kDiagWifiRetriesKey))
-    {
-      Config::setInt("diag", kDiagWifiRetriesKey, 0);
-    }
-    if (!Config::exists("diag", kDiagMqttRetriesKey))
-    {
-      Config::setInt("diag", kDiagMqttRetriesKey, 0);
-    }
-    if (!Config::exists("diag", kDiagLastResetKey))
-    {
-      Config::setInt("diag", kDiagLastResetKey, 0);
-    }
-    if (!Config::exists("diag", kDiagResetCountKey))
+    const uint32_t start = micros();
+    const bool seeded = Config::seedDefaults(FW_VERSION);
+    LOG_INFO(CONFIG, "Defaults %s en %lu us\n",
+             seeded ? "sembrados" : "vigentes",
+             static_cast<unsigned long>(micros() - start));
+  }
+
+  bool loadWifiCredentials(String &ssid, String &password)
+  {
+    ssid = toArduino(Config::getString(Config::Key::WIFI_SSID));
+    password = toArduino(Config::getString(Config::Key::WIFI_PASSWORD));
+    return ssid.length() > 0;
+  }
+
+  void IRAM_ATTR onBleButtonPressed()
+  {
+    g_bleButtonInterrupt = true;
+    Scheduler::wakeFromIsr();
+  }
+
+  // ========================== CONECTIVIDAD
+  class MqttLock
+  {
+  public:
+    MqttLock()
     {
-      Config::setInt("diag", kDiagResetCountKey, 0);
+      if (g_mqttMutex)
+      {
+        xSemaphoreTake(g_mqttMutex, portMAX_DELAY);
+      }
     }
-    if (!Config::exists("diag", kDiagWdtKey))
+    ~MqttLock()
     {
-      Config::setInt("diag", kDiagWdtKey, 0);
+      if (g_mqttMutex)
+      {
+        xSemaphoreGive(g_mqttMutex);
+      }
     }
-  }
+  };
 
-  void incrementDiagCounter(const char *key)
-  {
-    const int32_t current = Config::getInt("diag", key, 0);
-    Config::setInt("diag", key, current + 1);
+  const char *formatConnPhase(ConnPhase phase)
+  {
+    switch (phase)
+    {
+    case ConnPhase::WIFI_CONNECTING:
+      return "WIFI_CONNECTING";
+    case ConnPhase::WIFI_BACKOFF:
+      return "WIFI_BACKOFF";
+    case ConnPhase::WIFI_ONLINE:
+      return "WIFI_ONLINE";
+    case ConnPhase::TLS_CONNECTING:
+      return "TLS_CONNECTING";
+    case ConnPhase::MQTT_ONLINE:
+      return "MQTT_ONLINE";
+    case ConnPhase::MQTT_BACKOFF:
+      return "MQTT_BACKOFF";
+    default:
+      return "IDLE";
+    }
   }
 
-  bool loadWifiCredentials(String &ssid, String &password)
+  void setConnPhase(ConnPhase phase)
   {
-    ssid = toArduino(Config::getString("wifi", kWifiSsidKey, ""));
-    password = toArduino(Config::getString("wifi", kWifiPassKey, ""));
-    return ssid.length() > 0;
+    if (phase == g_connPhase)
+    {
+      return;
+    }
+    LOG_INFO(CONN, "%s -> %s\n", formatConnPhase(g_connPhase), formatConnPhase(phase));
+    g_connPhase = phase;
   }
 
-  // ========================== LOGGING
-  void logWithDeviceId(const char *fmt, ...)
+  void postConnEvent(ConnEventType type, int32_t detail)
   {
-    char buffer[256] = {0};
-    va_list args;
-    va_start(args, fmt);
-    vsnprintf(buffer, sizeof(buffer), fmt, args);
-    va_end(args);
-
-    const char *deviceId = g_deviceId.length() > 0 ? g_deviceId.c_str() : "UNKNOWN";
-    Serial.printf("[%s] %s", deviceId, buffer);
+    if (!g_connEventQueue)
+    {
+      return;
+    }
+    const ConnEvent event = {type, detail};
+    if (xQueueSend(g_connEventQueue, &event, 0) != pdTRUE)
+    {
+      ++g_connEventDrops;
+    }
+    Scheduler::wake();
   }
-  void IRAM_ATTR onBleButtonPressed() { g_bleButtonInterrupt = true; }
 
   // ========================== AWS HELPERS
   void clearAwsCredentials()
   {
-    if (g_mqttClient)
     {
-      esp_mqtt_client_stop(g_mqttClient);
-      esp_mqtt_client_destroy(g_mqttClient);
-      g_mqttClient = nullptr;
+      MqttLock lock;
+      if (g_mqttClient)
+      {
+        esp_mqtt_client_stop(g_mqttClient);
+        esp_mqtt_client_destroy(g_mqttClient);
+        g_mqttClient = nullptr;
+      }
+      g_mqttClientStarted = false;
+      g_awsCredentialsLoaded = false;
     }
-    g_mqttClientStarted = false;
     g_mqttConnected = false;
-    g_awsCredentialsLoaded = false;
     g_sensorRegistryPending = true;
     g_rootCaPem = "";
     g_deviceCertPem = "";
     g_privateKeyPem = "";
-    g_nextAwsAttemptMs = 0;
-    g_currentAwsBackoffMs = kAwsBackoffInitialMs;
+    Scheduler::cancel(g_awsRetryJob);
+    Backoff::reset(g_awsBackoff);
     g_pendingClaimEventKey = "";
     g_pendingSensorRegistryEventKey = "";
   }
 
   void resetAwsBackoff()
   {
-    g_currentAwsBackoffMs = kAwsBackoffInitialMs;
-    g_nextAwsAttemptMs = 0;
+    Backoff::reset(g_awsBackoff);
+    Scheduler::cancel(g_awsRetryJob);
   }
 
   void scheduleAwsBackoff(const char *reason)
   {
-    incrementDiagCounter(kDiagMqttRetriesKey);
-    const uint32_t delayMs = g_currentAwsBackoffMs;
-    logWithDeviceId("[MQTT] Reintento por %s en %lu ms\n",
-                    reason ? reason : "reintento",
-                    static_cast<unsigned long>(delayMs));
-    g_nextAwsAttemptMs = millis() + delayMs;
-    if (g_currentAwsBackoffMs < kAwsBackoffMaxMs)
+    DiagCounters::increment(DiagCounters::Counter::MQTT_RETRIES);
+    const uint32_t delayMs = Backoff::next(g_awsBackoff, kAwsBackoffPolicy);
+    LOG_WARN(MQTT, "Reintento por %s en %lu ms\n",
+             reason ? reason : "reintento",
+             static_cast<unsigned long>(delayMs));
+    Scheduler::scheduleIn(g_awsRetryJob, delayMs);
+    setConnPhase(ConnPhase::MQTT_BACKOFF);
+  }
+
+  // Llamar con g_mqttMutex tomado.
+  bool startMqttClientLocked()
+  {
+    if (!g_awsCredentialsLoaded || !g_mqttClient)
     {
-      const uint32_t doubled = g_currentAwsBackoffMs * 2;
-      g_currentAwsBackoffMs = doubled > kAwsBackoffMaxMs ? kAwsBackoffMaxMs : doubled;
+      return false;
     }
+    if (!g_mqttClientStarted)
+    {
+      if (esp_mqtt_client_start(g_mqttClient) != ESP_OK)
+      {
+        return false;
+      }
+      g_mqttClientStarted = true;
+      return true;
+    }
+    return esp_mqtt_client_reconnect(g_mqttClient) == ESP_OK;
   }
 
+  // Los handlers de eventos corren en las tareas de esp_event y esp-mqtt:
+  // solo encolan, el estado se actualiza en loop().
   esp_err_t mqttEventHandler(esp_mqtt_event_handle_t event)
   {
     if (!event)
@@ -308,18 +480,26 @@ namespace
 
     switch (event->event_id)
     {
+    case MQTT_EVENT_BEFORE_CONNECT:
+      // Lo que reserve la tarea de esp-mqtt (buffers, TLS) cuenta como MQTT.
+      HeapMonitor::tagTask(xTaskGetCurrentTaskHandle(), HeapMonitor::Tag::MQTT);
+      postConnEvent(ConnEventType::MQTT_BEFORE_CONNECT, 0);
+      break;
     case MQTT_EVENT_CONNECTED:
-      g_mqttConnected = true;
-      resetAwsBackoff();
-      logWithDeviceId("[MQTT] Conectado\n");
+      postConnEvent(ConnEventType::MQTT_CONNECTED, 0);
       break;
     case MQTT_EVENT_DISCONNECTED:
-      g_mqttConnected = false;
-      logWithDeviceId("[MQTT] Desconectado\n");
-      scheduleAwsBackoff("desconexion");
+      postConnEvent(ConnEventType::MQTT_DISCONNECTED, 0);
       break;
     case MQTT_EVENT_ERROR:
-      logWithDeviceId("[MQTT] Error en evento MQTT\n");
+      postConnEvent(ConnEventType::MQTT_ERROR,
+                    event->error_handle ? static_cast<int32_t>(event->error_handle->error_type) : -1);
+      break;
+    case MQTT_EVENT_PUBLISHED:
+      if (CoreDump::isInFlight(event->msg_id))
+      {
+        postConnEvent(ConnEventType::MQTT_PUBLISHED, event->msg_id);
+      }
       break;
     default:
       break;
@@ -328,84 +508,98 @@ namespace
     return ESP_OK;
   }
 
-  bool setupAWS()
-{
-  if (g_awsCredentialsLoaded && g_mqttClient)
+  void onWifiEvent(void *, esp_event_base_t, int32_t eventId, void *eventData)
   {
-    return true;
+    if (eventId == WIFI_EVENT_STA_CONNECTED)
+    {
+      postConnEvent(ConnEventType::WIFI_ASSOCIATED, 0);
+    }
+    else if (eventId == WIFI_EVENT_STA_DISCONNECTED)
+    {
+      const auto *info = static_cast<const wifi_event_sta_disconnected_t *>(eventData);
+      postConnEvent(ConnEventType::WIFI_DISCONNECTED, info ? static_cast<int32_t>(info->reason) : 0);
+    }
   }
 
-  if (!g_spiffsReady)
+  void onIpEvent(void *, esp_event_base_t, int32_t eventId, void *)
   {
-    Serial.println("[AWS] ? SPIFFS no montado");
-    return false;
-  }
+    if (eventId != IP_EVENT_STA_GOT_IP)
+    {
+      return;
+    }
 
-  g_rootCaPath = toArduino(Config::getString("certs", kCertRootKey, kDefaultRootCaPath));
-  g_deviceCertPath = toArduino(Config::getString("certs", kCertDeviceKey, kDefaultDeviceCertPath));
-  g_privateKeyPath = toArduino(Config::getString("certs", kCertPrivateKey, kDefaultPrivateKeyPath));
+    // Arranca MQTT sin esperar a la siguiente pasada de loop(); si el mutex
+    // esta ocupado, loop() lo inicia al procesar el evento.
+    int32_t mqttStarted = 0;
+    if (g_mqttMutex && xSemaphoreTake(g_mqttMutex, pdMS_TO_TICKS(50)) == pdTRUE)
+    {
+      mqttStarted = startMqttClientLocked() ? 1 : 0;
+      xSemaphoreGive(g_mqttMutex);
+    }
+    postConnEvent(ConnEventType::WIFI_GOT_IP, mqttStarted);
+  }
 
-  if (!SPIFFS.exists(g_rootCaPath.c_str()) || !SPIFFS.exists(g_deviceCertPath.c_str()) ||
-      !SPIFFS.exists(g_privateKeyPath.c_str()))
+  bool setupAWS()
+{
+  if (g_awsCredentialsLoaded && g_mqttClient)
   {
-    Serial.println("[AWS] ? Certificados no encontrados en SPIFFS");
-    clearAwsCredentials();
-    return false;
+    return true;
   }
 
-  File ca = SPIFFS.open(g_rootCaPath.c_str(), "r");
-  File cert = SPIFFS.open(g_deviceCertPath.c_str(), "r");
-  File key = SPIFFS.open(g_privateKeyPath.c_str(), "r");
-
-  if (!ca || !cert || !key)
+  if (!g_spiffsReady)
   {
-    Serial.println("[AWS] ? No se pudieron abrir los certificados");
-    if (ca)
-      ca.close();
-    if (cert)
-      cert.close();
-    if (key)
-      key.close();
-    clearAwsCredentials();
+    LOG_ERROR(AWS, "? SPIFFS no montado\n");
     return false;
   }
 
-  g_rootCaPem = ca.readString();
-  g_deviceCertPem = cert.readString();
-  g_privateKeyPem = key.readString();
-
-  ca.close();
-  cert.close();
-  key.close();
+  g_rootCaPath = toArduino(Config::getString(Config::Key::CERT_ROOT));
+  g_deviceCertPath = toArduino(Config::getString(Config::Key::CERT_DEVICE));
+  g_privateKeyPath = toArduino(Config::getString(Config::Key::CERT_PRIVATE));
 
-  if (g_rootCaPem.length() == 0 || g_deviceCertPem.length() == 0 || g_privateKeyPem.length() == 0)
+  AwsCerts::Bundle certs;
+  const AwsCerts::LoadResult certResult =
+      AwsCerts::load(SPIFFS, g_rootCaPath.c_str(), g_deviceCertPath.c_str(),
+                     g_privateKeyPath.c_str(), certs);
+  if (certResult != AwsCerts::LoadResult::OK)
   {
-    Serial.println("[AWS] ? Certificados vacios o corruptos");
+    if (certResult == AwsCerts::LoadResult::NOT_FOUND)
+      LOG_ERROR(AWS, "? Certificados no encontrados en SPIFFS\n");
+    else if (certResult == AwsCerts::LoadResult::OPEN_FAILED)
+      LOG_ERROR(AWS, "? No se pudieron abrir los certificados\n");
+    else
+      LOG_ERROR(AWS, "? Certificados vacios o corruptos\n");
     clearAwsCredentials();
     return false;
   }
 
-  if (g_mqttClient)
+  g_rootCaPem = std::move(certs.rootCa);
+  g_deviceCertPem = std::move(certs.deviceCert);
+  g_privateKeyPem = std::move(certs.privateKey);
+
   {
-    esp_mqtt_client_stop(g_mqttClient);
-    esp_mqtt_client_destroy(g_mqttClient);
-    g_mqttClient = nullptr;
-    g_mqttClientStarted = false;
+    MqttLock lock;
+    if (g_mqttClient)
+    {
+      esp_mqtt_client_stop(g_mqttClient);
+      esp_mqtt_client_destroy(g_mqttClient);
+      g_mqttClient = nullptr;
+      g_mqttClientStarted = false;
+    }
   }
 
-  String endpoint = toArduino(Config::getString("aws", kAwsEndpointKey, kDefaultAwsEndpoint));
-  g_awsRegion = toArduino(Config::getString("aws", kAwsRegionKey, kDefaultAwsRegion));
+  String endpoint = toArduino(Config::getString(Config::Key::AWS_ENDPOINT));
+  g_awsRegion = toArduino(Config::getString(Config::Key::AWS_REGION));
   String thingName =
-      toArduino(Config::getString("aws", kAwsThingKey, std::string(g_deviceId.c_str())));
+      toArduino(Config::getString(Config::Key::AWS_THING, std::string(g_deviceId.c_str())));
   if (thingName.isEmpty())
   {
     thingName = g_deviceId;
   }
-  const int32_t awsPort = Config::getInt("aws", kAwsPortKey, kDefaultAwsPort);
+  const int32_t awsPort = Config::getInt(Config::Key::AWS_PORT);
 
   if (endpoint.isEmpty())
   {
-    Serial.println("[AWS] ? Endpoint no configurado");
+    LOG_ERROR(AWS, "? Endpoint no configurado\n");
     return false;
   }
 
@@ -420,19 +614,27 @@ namespace
   config.buffer_size = 1024;
   config.keepalive = kMqttKeepAliveSeconds;
   config.event_handle = mqttEventHandler;
+  config.disable_auto_reconnect = true;
+#ifdef MQTT_TASK_STACK_BYTES
+  config.task_stack = MQTT_TASK_STACK_BYTES;
+#endif
 
-  g_mqttClient = esp_mqtt_client_init(&config);
-  if (!g_mqttClient)
+  esp_mqtt_client_handle_t client = esp_mqtt_client_init(&config);
+  if (!client)
   {
-    Serial.println("[AWS] ? No se pudo crear el cliente MQTT");
+    LOG_ERROR(AWS, "? No se pudo crear el cliente MQTT\n");
     clearAwsCredentials();
     return false;
   }
 
-  g_awsCredentialsLoaded = true;
-  g_mqttClientStarted = false;
+  {
+    MqttLock lock;
+    g_mqttClient = client;
+    g_awsCredentialsLoaded = true;
+    g_mqttClientStarted = false;
+  }
   resetAwsBackoff();
-  logWithDeviceId("[AWS] Configuracion MQTT lista\n");
+  LOG_INFO(AWS, "Configuracion MQTT lista\n");
   return true;
 }
 
@@ -444,40 +646,111 @@ bool connectAWS()
       return false;
     }
 
-    const uint32_t now = millis();
-    if (g_nextAwsAttemptMs != 0 && now < g_nextAwsAttemptMs)
+    bool started = false;
     {
-      return false;
+      MqttLock lock;
+      started = startMqttClientLocked();
     }
 
-    if (!g_mqttClientStarted)
+    if (started)
     {
-      Serial.print("[AWS] 🔌 Iniciando cliente MQTT... ");
-      if (esp_mqtt_client_start(g_mqttClient) == ESP_OK)
-      {
-        Serial.println("listo");
-        g_mqttClientStarted = true;
-        g_nextAwsAttemptMs = millis() + kAwsInitialConnectGraceMs;
-        return true;
-      }
-      Serial.println("fallo");
-      scheduleAwsBackoff("inicio fallido");
-      return false;
+      LOG_INFO(AWS, "Conexion MQTT iniciada\n");
+      setConnPhase(ConnPhase::TLS_CONNECTING);
+      return true;
     }
 
-    esp_err_t err = esp_mqtt_client_reconnect(g_mqttClient);
-    if (err == ESP_OK)
+    LOG_ERROR(AWS, "Error al iniciar conexion MQTT\n");
+    scheduleAwsBackoff("error conexion");
+    return false;
+  }
+
+  // Devuelve false si la clase no tiene tokens; el mensaje queda diferido y
+  // g_publishRetryJob se arma para cuando haya uno disponible.
+  bool acquirePublishSlot(PublishLimiter::TopicClass cls, bool &deferred)
+  {
+    const uint32_t now = millis();
+    const uint32_t waitMs = PublishLimiter::msUntilAvailable(cls, now);
+    if (waitMs == 0 && PublishLimiter::tryAcquire(cls, now))
     {
-      Serial.println("[AWS] Reintentando conexion MQTT");
-      g_nextAwsAttemptMs = millis() + g_currentAwsBackoffMs;
+      deferred = false;
       return true;
     }
-
-    logWithDeviceId("[AWS] Error al reintentar MQTT (%d)\n", static_cast<int>(err));
-    scheduleAwsBackoff("error reconectar");
+    if (!deferred)
+    {
+      PublishLimiter::markDeferred(cls);
+      deferred = true;
+    }
+    Scheduler::scheduleWithin(g_publishRetryJob, waitMs > 0 ? waitMs : 1);
     return false;
   }
 
+  void noteFirstPublish()
+  {
+    if (g_firstPublishMs != 0)
+    {
+      return;
+    }
+    g_firstPublishMs = millis();
+    LOG_INFO(BOOT, "Primer publish a %lu ms del arranque (BLE %s, init %lu ms)\n",
+             static_cast<unsigned long>(g_firstPublishMs),
+             Provisioning::isUp() ? "iniciado" : "diferido",
+             static_cast<unsigned long>(Provisioning::bringUpMs()));
+  }
+
+  void notePublish(int msgId, size_t bytes)
+  {
+    if (msgId < 0)
+    {
+      Metrics::increment(Metrics::Counter::PUBLISH_FAILURES);
+      return;
+    }
+    Metrics::increment(Metrics::Counter::PUBLISHES);
+    Metrics::increment(Metrics::Counter::BYTES_SENT, static_cast<uint32_t>(bytes));
+    Metrics::observe(Metrics::Histogram::PUBLISH_BYTES, static_cast<uint32_t>(bytes));
+    noteFirstPublish();
+  }
+
+  // Publica en topic, o comprimido en topic + "/hs" si el payload supera el
+  // umbral y el resultado es mas corto.
+  int publishPayload(const String &topic, const char *payload, size_t length, int qos)
+  {
+    HeapMonitor::Scope heapScope(HeapMonitor::Tag::MQTT);
+#if MQTT_COMPRESSION_ENABLED
+    if (length >= MQTT_COMPRESSION_MIN_BYTES)
+    {
+      const size_t capacity = length - 1 < sizeof(g_compressionBuffer) ? length - 1 : sizeof(g_compressionBuffer);
+      const size_t packed = LzCodec::compress(reinterpret_cast<const uint8_t *>(payload),
+                                              length,
+                                              g_compressionBuffer,
+                                              capacity);
+      if (packed > 0)
+      {
+        const String compressedTopic = topic + kCompressedTopicSuffix;
+        const int msgId = esp_mqtt_client_publish(g_mqttClient,
+                                                  compressedTopic.c_str(),
+                                                  reinterpret_cast<const char *>(g_compressionBuffer),
+                                                  static_cast<int>(packed),
+                                                  qos,
+                                                  0);
+        notePublish(msgId, packed);
+        if (msgId >= 0)
+        {
+          g_compressionSavedBytes += length - packed;
+        }
+        return msgId;
+      }
+    }
+#endif
+    const int msgId = esp_mqtt_client_publish(g_mqttClient,
+                                              topic.c_str(),
+                                              payload,
+                                              static_cast<int>(length),
+                                              qos,
+                                              0);
+    notePublish(msgId, length);
+    return msgId;
+  }
+
   void sendProvisioningClaim()
   {
     if (!g_claimPending || !g_mqttClient || !g_mqttConnected)
@@ -487,11 +760,17 @@ bool connectAWS()
 
     if (g_userId.isEmpty())
     {
-      logWithDeviceId("[AWS] Mensaje MQTT no enviado (user_id vacio)\n");
+      LOG_WARN(AWS, "Mensaje MQTT no enviado (user_id vacio)\n");
       g_claimPending = false;
       return;
     }
 
+    if (!acquirePublishSlot(PublishLimiter::TopicClass::CONTROL, g_claimDeferred))
+    {
+      return;
+    }
+
+    HeapMonitor::Scope heapScope(HeapMonitor::Tag::JSON);
     if (g_pendingClaimEventKey.length() == 0)
     {
       g_pendingClaimEventKey = nextEventKey("claim");
@@ -503,23 +782,18 @@ bool connectAWS()
                            "\",\"event_key\":\"" + g_pendingClaimEventKey + "\"}";
     const String topic = String(TOPIC_BASE) + g_deviceId + "/claim";
 
-    logWithDeviceId("[AWS] Publicando claim -> topic=%s\n", topic.c_str());
+    LOG_DEBUG(AWS, "Publicando claim -> topic=%s\n", topic.c_str());
 
-    const int msgId = esp_mqtt_client_publish(g_mqttClient,
-                                              topic.c_str(),
-                                              payload.c_str(),
-                                              static_cast<int>(payload.length()),
-                                              1,
-                                              0);
+    const int msgId = publishPayload(topic, payload.c_str(), payload.length(), 1);
     if (msgId >= 0)
     {
-      logWithDeviceId("[AWS] Mensaje MQTT enviado\n");
+      LOG_INFO(AWS, "Mensaje MQTT enviado\n");
       g_claimPending = false;
       g_pendingClaimEventKey = "";
     }
     else
     {
-      logWithDeviceId("[AWS] Mensaje MQTT no enviado\n");
+      LOG_ERROR(AWS, "Mensaje MQTT no enviado\n");
     }
   }
 
@@ -530,6 +804,12 @@ bool connectAWS()
       return;
     }
 
+    if (!acquirePublishSlot(PublishLimiter::TopicClass::CONTROL, g_sensorRegistryDeferred))
+    {
+      return;
+    }
+
+    HeapMonitor::Scope heapScope(HeapMonitor::Tag::JSON);
     const String topic = SensorRegistry::buildTopic(g_deviceId);
     if (g_pendingSensorRegistryEventKey.length() == 0)
     {
@@ -537,26 +817,30 @@ bool connectAWS()
     }
     const String payload = SensorRegistry::buildPayload(g_deviceId, g_pendingSensorRegistryEventKey);
 
-    logWithDeviceId("[AWS] Publicando sensor_registry -> topic=%s bytes=%u\n",
-                    topic.c_str(),
-                    static_cast<unsigned>(payload.length()));
+    LOG_DEBUG(AWS, "Publicando sensor_registry -> topic=%s bytes=%u\n",
+              topic.c_str(),
+              static_cast<unsigned>(payload.length()));
 
-    const int msgId = esp_mqtt_client_publish(g_mqttClient,
-                                              topic.c_str(),
-                                              payload.c_str(),
-                                              static_cast<int>(payload.length()),
-                                              1,
-                                              0);
+    const int msgId = publishPayload(topic, payload.c_str(), payload.length(), 1);
     if (msgId >= 0)
     {
-      logWithDeviceId("[AWS] sensor_registry enviado\n");
+      LOG_INFO(AWS, "sensor_registry enviado\n");
       g_sensorRegistryPending = false;
       g_pendingSensorRegistryEventKey = "";
     }
     else
     {
-      logWithDeviceId("[AWS] sensor_registry no enviado\n");
+      LOG_ERROR(AWS, "sensor_registry no enviado\n");
+    }
+  }
+
+  void runAwsRetry()
+  {
+    if (!g_wifiConnected || g_mqttConnected || g_connPhase != ConnPhase::MQTT_BACKOFF)
+    {
+      return;
     }
+    connectAWS();
   }
 
   void handleAWS()
@@ -570,7 +854,6 @@ bool connectAWS()
 
     if (!g_mqttConnected)
     {
-      connectAWS();
       return;
     }
 
@@ -604,107 +887,455 @@ bool connectAWS()
 
     if (newState != g_state)
     {
-      g_state = newState;
-      logWithDeviceId("[ESTADO] %s\n", formatState(g_state).c_str());
+      g_state = newState;
+      LOG_INFO(ESTADO, "%s\n", formatState(g_state).c_str());
+    }
+  }
+
+  // El job "display" es el unico que dibuja el panel. Queda armado mientras
+  // haya un cambio pendiente o parpadeo BLE.
+  void armDisplay()
+  {
+    const uint32_t waitMs = Display::msUntilUpdate(millis());
+    if (waitMs == Display::kNoUpdate)
+    {
+      Scheduler::cancel(g_displayJob);
+      return;
+    }
+    Scheduler::scheduleWithin(g_displayJob, waitMs);
+  }
+
+  void runDisplay()
+  {
+    Display::loop();
+    const uint32_t waitMs = Display::msUntilUpdate(millis());
+    if (waitMs != Display::kNoUpdate)
+    {
+      // Sigue sucio si el bus I2C estaba ocupado: reintenta en un tick.
+      Scheduler::scheduleIn(g_displayJob, waitMs > 0 ? waitMs : kDisplayTickMs);
+    }
+  }
+
+  void applyWifiConnectionStatus(bool connected)
+  {
+    if (g_wifiConnected != connected)
+    {
+      g_wifiConnected = connected;
+      LOG_INFO(WIFI, "Estado -> %s\n", connected ? "conectado" : "desconectado");
+      Display::setConnectionStatus(connected);
+      armDisplay();
+      updateSystemState();
+    }
+    else
+    {
+      Display::setConnectionStatus(connected);
+      armDisplay();
+    }
+  }
+
+  void publishHeartbeat()
+  {
+      // Antes de crear el documento, para no medir el propio heartbeat.
+      const HeapMonitor::Snapshot heap = HeapMonitor::snapshot();
+      const HeapMonitor::Trend heapTrend = HeapMonitor::takeTrend(heap);
+      HeapMonitor::Scope heapScope(HeapMonitor::Tag::JSON);
+
+      String topic = String(TOPIC_BASE) + g_deviceId + "/heartbeat";
+      const String eventKey = nextEventKey("heartbeat");
+
+      JsonDocument doc;
+      doc["mqtt_topic"] = topic;
+      doc["client_id"] = g_deviceId;
+      doc["wifi_rssi"] = WiFi.RSSI();
+      doc["heap_free"] = heap.freeBytes;
+      JsonObject heapStats = doc["heap"].to<JsonObject>();
+      heapStats["largest"] = heap.largestFreeBlock;
+      heapStats["min"] = heap.minFreeBytes;
+      heapStats["frag"] = heap.fragmentationPct;
+      heapStats["blocks"] = heap.allocatedBlocks;
+      heapStats["allocs"] = heap.allocs;
+      heapStats["d_free"] = heapTrend.freeDelta;
+      heapStats["d_largest"] = heapTrend.largestDelta;
+      heapStats["d_allocs"] = heapTrend.allocs;
+#if HEAP_MONITOR_HOOKS
+      // [reservas, liberaciones, bytes pedidos] por subsistema desde el arranque.
+      JsonObject heapTags = heapStats["tags"].to<JsonObject>();
+      for (size_t i = 0; i < HeapMonitor::kTagCount; ++i)
+      {
+          const auto tag = static_cast<HeapMonitor::Tag>(i);
+          const HeapMonitor::TagStats tagStats = HeapMonitor::tagStats(tag);
+          JsonArray entry = heapTags[HeapMonitor::name(tag)].to<JsonArray>();
+          entry.add(tagStats.allocs);
+          entry.add(tagStats.frees);
+          entry.add(tagStats.bytes);
+      }
+#endif
+      const TimeSync::Timestamp now = TimeSync::now();
+      doc["uptime_ms"] = now.monotonicMs;
+      doc["time_synced"] = now.synced;
+      if (now.synced)
+      {
+          doc["ts_ms"] = now.epochMs;
+      }
+      doc["fw"] = FW_VERSION;
+      doc["sched_late_max_ms"] = Scheduler::maxLatenessMs();
+      doc["boot_pub_ms"] = g_firstPublishMs;
+      const DiagCounters::Stats diagStats = DiagCounters::stats();
+      JsonArray diagNvs = doc["diag_nvs"].to<JsonArray>();
+      diagNvs.add(diagStats.increments);
+      diagNvs.add(diagStats.commits);
+      const Config::CacheStats configCache = Config::cacheStats();
+      JsonArray configCacheStats = doc["cfg_cache"].to<JsonArray>();
+      configCacheStats.add(configCache.hits);
+      configCacheStats.add(configCache.misses);
+      const Provisioning::QueueStats bleQueues = Provisioning::queueStats();
+      JsonArray bleQueueStats = doc["ble_q"].to<JsonArray>();
+      bleQueueStats.add(bleQueues.notifyDropped);
+      bleQueueStats.add(bleQueues.credentialsDropped);
+      const Provisioning::ReleaseInfo bleRelease = Provisioning::releaseInfo();
+      if (bleRelease.released)
+      {
+          JsonArray bleHeap = doc["ble_heap"].to<JsonArray>();
+          bleHeap.add(bleRelease.heapBefore);
+          bleHeap.add(bleRelease.heapAfter);
+      }
+      const Display::Stats oledStats = Display::stats();
+      JsonArray oled = doc["oled"].to<JsonArray>();
+      oled.add(oledStats.i2cBytes);
+      oled.add(oledStats.maxRenderUs);
+      const I2cBus::Stats i2cStats = I2cBus::stats();
+      JsonObject i2c = doc["i2c"].to<JsonObject>();
+      i2c["util_pct"] = I2cBus::utilizationPct();
+      i2c["pin_sw"] = i2cStats.pinSwitches;
+      for (size_t i = 0; i < I2cBus::kClientCount; ++i)
+      {
+          const I2cBus::ClientStats &clientStats = i2cStats.clients[i];
+          JsonArray entry = i2c[I2cBus::name(static_cast<I2cBus::Client>(i))].to<JsonArray>();
+          entry.add(clientStats.transactions);
+          entry.add(clientStats.errors + clientStats.timeouts);
+      }
+#if LOOP_PROFILER_ENABLED
+      // Los handlers mas lentos desde el heartbeat anterior y el peor caso.
+      LoopProfiler::Sample window[3];
+      const size_t windowCount = LoopProfiler::takeWindow(window, 3);
+      JsonObject loopProf = doc["loop_prof"].to<JsonObject>();
+      JsonArray loopWindow = loopProf["win"].to<JsonArray>();
+      for (size_t i = 0; i < windowCount; ++i)
+      {
+          JsonArray entry = loopWindow.add<JsonArray>();
+          entry.add(LoopProfiler::name(window[i].slot));
+          entry.add(window[i].us);
+      }
+      LoopProfiler::Sample worst;
+      if (LoopProfiler::worst(&worst, 1) == 1)
+      {
+          JsonArray loopWorst = loopProf["worst"].to<JsonArray>();
+          loopWorst.add(LoopProfiler::name(worst.slot));
+          loopWorst.add(worst.us);
+          loopWorst.add(worst.atMs);
+      }
+#endif
+      JsonObject limiter = doc["rate_limit"].to<JsonObject>();
+      for (size_t i = 0; i < static_cast<size_t>(PublishLimiter::TopicClass::COUNT); ++i)
+      {
+          const auto cls = static_cast<PublishLimiter::TopicClass>(i);
+          const PublishLimiter::Stats stats = PublishLimiter::stats(cls);
+          JsonArray entry = limiter[PublishLimiter::name(cls)].to<JsonArray>();
+          entry.add(stats.allowed);
+          entry.add(stats.deferred);
+      }
+      limiter["tel_dropped"] = g_deferredTelemetryDropped;
+#if MQTT_COMPRESSION_ENABLED
+      doc["lz_saved_bytes"] = g_compressionSavedBytes;
+#endif
+      if (CoreDump::uploadPending())
+      {
+          // [bytes confirmados, tamano] del core dump que se esta subiendo.
+          JsonArray coreDump = doc["coredump"].to<JsonArray>();
+          coreDump.add(CoreDump::stats().bytesAcked);
+          coreDump.add(CoreDump::summary().size);
+      }
+      // Minimo de pila libre (bytes) de cada tarea desde el arranque.
+      JsonObject stack = doc["stack"].to<JsonObject>();
+      for (size_t i = 0; i < StackMonitor::taskCount(); ++i)
+      {
+          const StackMonitor::TaskStats &taskStack = StackMonitor::task(i);
+          stack[taskStack.name] = taskStack.minFreeBytes;
+      }
+      doc["event_key"] = eventKey;
+
+      // Estatico: fuera de la pila del loop, que era su mayor consumo.
+      static char buffer[1536];
+      const size_t len = serializeJson(doc, buffer, sizeof(buffer));
+      if (len == 0 || len >= sizeof(buffer))
+      {
+          LOG_ERROR(HEARTBEAT, "serialize failed\n");
+          return;
+      }
+
+      int mid = publishPayload(topic, buffer, len, 1);
+
+      if (mid < 0)
+      {
+          LOG_ERROR(HEARTBEAT, "Publicación fallida en %s\n", topic.c_str());
+      }
+      else
+      {
+          LOG_DEBUG(HEARTBEAT, "Enviado MID=%d -> %s\n", mid, topic.c_str());
+      }
+  }
+
+  void sendHeartbeat()
+  {
+      if (!g_mqttConnected)
+      {
+          LOG_WARN(HEARTBEAT, "Saltado (MQTT offline)\n");
+          return;
+      }
+
+      if (!acquirePublishSlot(PublishLimiter::TopicClass::HEARTBEAT, g_heartbeatDeferred))
+      {
+          LOG_WARN(HEARTBEAT, "Diferido (rate limit)\n");
+          return;
+      }
+      publishHeartbeat();
+  }
+
+  void publishTelemetry(const Sht45Sensor::Reading &reading)
+  {
+      HeapMonitor::Scope heapScope(HeapMonitor::Tag::JSON);
+      const String topic = Sht45Sensor::buildTelemetryTopic(g_deviceId);
+      const String eventKey = nextEventKey("telemetry");
+      const String payload = Sht45Sensor::buildTelemetryPayload(g_deviceId, reading, eventKey);
+
+      const int mid = publishPayload(topic, payload.c_str(), payload.length(), 1);
+
+      if (mid < 0)
+      {
+          LOG_ERROR(TELEMETRY, "Publicacion fallida en %s\n", topic.c_str());
+      }
+      else
+      {
+          LOG_DEBUG(TELEMETRY, "Enviado MID=%d -> %s\n", mid, topic.c_str());
+      }
+  }
+
+  void deferTelemetry(const Sht45Sensor::Reading &reading)
+  {
+      if (g_deferredTelemetryCount == kMaxDeferredTelemetry)
+      {
+          g_deferredTelemetryHead = (g_deferredTelemetryHead + 1) % kMaxDeferredTelemetry;
+          --g_deferredTelemetryCount;
+          ++g_deferredTelemetryDropped;
+      }
+      const size_t tail = (g_deferredTelemetryHead + g_deferredTelemetryCount) % kMaxDeferredTelemetry;
+      g_deferredTelemetry[tail] = reading;
+      ++g_deferredTelemetryCount;
+  }
+
+  void sendTelemetry()
+  {
+      if (!g_mqttConnected)
+      {
+          LOG_WARN(TELEMETRY, "Saltado (MQTT offline)\n");
+          return;
+      }
+
+      Sht45Sensor::Reading reading;
+      if (!Sht45Sensor::read(reading) || !reading.valid)
+      {
+          LOG_ERROR(TELEMETRY, "Lectura SHT45 fallida\n");
+          return;
+      }
+
+      // Si hay lecturas diferidas, esta va detras para conservar el orden.
+      if (g_deferredTelemetryCount == 0)
+      {
+          bool deferred = false;
+          if (acquirePublishSlot(PublishLimiter::TopicClass::TELEMETRY, deferred))
+          {
+              publishTelemetry(reading);
+              return;
+          }
+      }
+      else
+      {
+          PublishLimiter::markDeferred(PublishLimiter::TopicClass::TELEMETRY);
+      }
+      deferTelemetry(reading);
+      LOG_WARN(TELEMETRY, "Diferida (rate limit)\n");
+  }
+
+  // Deltas desde el ultimo snapshot publicado; sin MQTT se acumulan para el
+  // siguiente.
+  void publishMetrics()
+  {
+    Metrics::set(Metrics::Gauge::HEAP_FREE, static_cast<int32_t>(HeapMonitor::snapshot().freeBytes));
+    Metrics::set(Metrics::Gauge::WIFI_RSSI, WiFi.RSSI());
+    Metrics::set(Metrics::Gauge::TELEMETRY_QUEUE, static_cast<int32_t>(g_deferredTelemetryCount));
+
+    const size_t length = Metrics::writeSnapshot(g_metricsPayload, sizeof(g_metricsPayload), millis());
+    if (length == 0)
+    {
+      LOG_ERROR(METRICS, "Snapshot demasiado grande\n");
+      return;
+    }
+    const String topic = String(TOPIC_BASE) + g_deviceId + "/metrics";
+    if (publishPayload(topic, g_metricsPayload, length, 1) >= 0)
+    {
+      Metrics::commitSnapshot();
     }
   }
 
-  void applyWifiConnectionStatus(bool connected)
+  void sendMetrics()
   {
-    if (g_wifiConnected != connected)
+    if (!g_mqttClient || !g_mqttConnected)
     {
-      g_wifiConnected = connected;
-      logWithDeviceId("[WIFI] Estado -> %s\n", connected ? "conectado" : "desconectado");
-      Display::setConnectionStatus(connected);
-      updateSystemState();
+      return;
     }
-    else
+    if (!acquirePublishSlot(PublishLimiter::TopicClass::DIAG, g_metricsDeferred))
     {
-      Display::setConnectionStatus(connected);
+      LOG_WARN(METRICS, "Diferido (rate limit)\n");
+      return;
     }
+    publishMetrics();
   }
 
-  void sendHeartbeat()
+  void flushDeferredPublishes()
   {
       if (!g_mqttConnected)
       {
-          Serial.println("[HEARTBEAT] Saltado (MQTT offline)");
           return;
       }
 
-      String topic = String(TOPIC_BASE) + g_deviceId + "/heartbeat";
-      const String eventKey = nextEventKey("heartbeat");
-
-      JsonDocument doc;
-      doc["mqtt_topic"] = topic;
-      doc["client_id"] = g_deviceId;
-      doc["wifi_rssi"] = WiFi.RSSI();
-      doc["heap_free"] = esp_get_free_heap_size();
-      doc["uptime_ms"] = millis();
-      doc["fw"] = FW_VERSION;
-      doc["event_key"] = eventKey;
-
-      char buffer[256] = {0};
-      const size_t len = serializeJson(doc, buffer, sizeof(buffer));
-      if (len == 0 || len >= sizeof(buffer))
+      if (g_heartbeatDeferred &&
+          acquirePublishSlot(PublishLimiter::TopicClass::HEARTBEAT, g_heartbeatDeferred))
       {
-          Serial.println("[HEARTBEAT] serialize failed");
-          return;
+          publishHeartbeat();
       }
 
-      int mid = esp_mqtt_client_publish(
-          g_mqttClient,
-          topic.c_str(),
-          buffer,
-          static_cast<int>(len),
-          1,
-          0);
-
-      if (mid < 0)
+      if (g_metricsDeferred &&
+          acquirePublishSlot(PublishLimiter::TopicClass::DIAG, g_metricsDeferred))
       {
-          Serial.printf("[HEARTBEAT] Publicación fallida en %s\n", topic.c_str());
+          publishMetrics();
       }
-      else
+
+      while (g_deferredTelemetryCount > 0)
       {
-          Serial.printf("[HEARTBEAT] Enviado MID=%d -> %s\n", mid, topic.c_str());
+          bool deferred = true;
+          if (!acquirePublishSlot(PublishLimiter::TopicClass::TELEMETRY, deferred))
+          {
+              break;
+          }
+          const Sht45Sensor::Reading reading = g_deferredTelemetry[g_deferredTelemetryHead];
+          g_deferredTelemetryHead = (g_deferredTelemetryHead + 1) % kMaxDeferredTelemetry;
+          --g_deferredTelemetryCount;
+          publishTelemetry(reading);
       }
+
+      handleAWS();
   }
 
-  void sendTelemetry()
+  void publishCoreDumpSummary()
   {
-      if (!g_mqttConnected)
-      {
-          Serial.println("[TELEMETRY] Saltado (MQTT offline)");
-          return;
-      }
+    HeapMonitor::Scope heapScope(HeapMonitor::Tag::JSON);
+    const CoreDump::Summary &summary = CoreDump::summary();
+    char hex[11];
 
-      Sht45Sensor::Reading reading;
-      if (!Sht45Sensor::read(reading) || !reading.valid)
-      {
-          Serial.println("[TELEMETRY] Lectura SHT45 fallida");
-          return;
-      }
+    JsonDocument doc;
+    doc["device_id"] = g_deviceId;
+    doc["boot_session_id"] = g_bootSessionId;
+    snprintf(hex, sizeof(hex), "%08lx", static_cast<unsigned long>(summary.dumpId));
+    doc["dump_id"] = hex;
+    doc["size"] = summary.size;
+    doc["chunks"] = summary.chunkCount;
+    doc["task"] = summary.task;
+    snprintf(hex, sizeof(hex), "0x%08lx", static_cast<unsigned long>(summary.pc));
+    doc["pc"] = hex;
+    JsonArray backtrace = doc["bt"].to<JsonArray>();
+    for (uint8_t i = 0; i < summary.depth; ++i)
+    {
+      snprintf(hex, sizeof(hex), "0x%08lx", static_cast<unsigned long>(summary.backtrace[i]));
+      backtrace.add(hex);
+    }
+    if (summary.backtraceCorrupted)
+    {
+      doc["bt_corrupt"] = true;
+    }
+    doc["cause"] = summary.cause;
+    snprintf(hex, sizeof(hex), "0x%08lx", static_cast<unsigned long>(summary.faultAddress));
+    doc["addr"] = hex;
+    doc["event_key"] = nextEventKey("coredump");
 
-      const String topic = Sht45Sensor::buildTelemetryTopic(g_deviceId);
-      const String eventKey = nextEventKey("telemetry");
-      const String payload = Sht45Sensor::buildTelemetryPayload(g_deviceId, reading, millis(), eventKey);
+    String payload;
+    serializeJson(doc, payload);
+    const String topic = String(TOPIC_BASE) + g_deviceId + "/coredump/summary";
+    if (publishPayload(topic, payload.c_str(), payload.length(), 1) >= 0)
+    {
+      g_coreDumpSummaryPending = false;
+    }
+  }
 
-      const int mid = esp_mqtt_client_publish(
-          g_mqttClient,
-          topic.c_str(),
-          payload.c_str(),
-          static_cast<int>(payload.length()),
-          1,
-          0);
+  // Como acquirePublishSlot() pero sin armar g_publishRetryJob: el job
+  // "coredump" ya vuelve a intentarlo cada CORE_DUMP_CHUNK_INTERVAL_MS.
+  bool acquireCoreDumpSlot()
+  {
+    if (PublishLimiter::tryAcquire(PublishLimiter::TopicClass::DIAG, millis()))
+    {
+      g_coreDumpDeferred = false;
+      return true;
+    }
+    if (!g_coreDumpDeferred)
+    {
+      PublishLimiter::markDeferred(PublishLimiter::TopicClass::DIAG);
+      g_coreDumpDeferred = true;
+    }
+    return false;
+  }
 
-      if (mid < 0)
-      {
-          Serial.printf("[TELEMETRY] Publicacion fallida en %s\n", topic.c_str());
-      }
-      else
+  // Prioridad baja: con telemetria, heartbeat o mensajes de control
+  // esperando no sale nada, y nunca hay mas de un trozo en vuelo.
+  void sendCoreDumpChunk()
+  {
+    if (!CoreDump::uploadPending() || !g_mqttClient || !g_mqttConnected)
+    {
+      return;
+    }
+    if (g_deferredTelemetryCount > 0 || g_heartbeatDeferred || g_metricsDeferred || g_claimPending ||
+        g_sensorRegistryPending)
+    {
+      return;
+    }
+    if (g_coreDumpSummaryPending)
+    {
+      if (acquireCoreDumpSlot())
       {
-          Serial.printf("[TELEMETRY] Enviado MID=%d -> %s\n", mid, topic.c_str());
+        publishCoreDumpSummary();
       }
+      return;
+    }
+
+    const uint32_t now = millis();
+    if (!CoreDump::chunkDue(now))
+    {
+      return;
+    }
+    // El token despues de leer la flash: una lectura fallida no lo gasta.
+    const size_t length = CoreDump::buildChunk(g_coreDumpChunk, sizeof(g_coreDumpChunk));
+    if (length == 0 || !acquireCoreDumpSlot())
+    {
+      return;
+    }
+    // Binario y sin pasar por publishPayload(): el volcado no va comprimido.
+    const String topic = String(TOPIC_BASE) + g_deviceId + "/coredump";
+    const int msgId = esp_mqtt_client_publish(g_mqttClient,
+                                              topic.c_str(),
+                                              reinterpret_cast<const char *>(g_coreDumpChunk),
+                                              static_cast<int>(length),
+                                              1,
+                                              0);
+    notePublish(msgId, length);
+    CoreDump::chunkPublished(msgId, now);
   }
 
   void logSensorReading()
@@ -712,43 +1343,40 @@ bool connectAWS()
       Sht45Sensor::Reading reading;
       if (!Sht45Sensor::read(reading) || !reading.valid)
       {
-          Serial.println("[SHT45] Lectura fallida");
+          LOG_ERROR(SHT45, "Lectura fallida\n");
           return;
       }
 
-      Serial.printf("[SHT45] T=%.2f C H=%.2f %% VPD=%.2f kPa\n",
-                    reading.temperatureC,
-                    reading.humidityRh,
-                    reading.vpdKpa);
+      LOG_DEBUG(SHT45, "T=%.2f C H=%.2f %% VPD=%.2f kPa\n",
+                reading.temperatureC,
+                reading.humidityRh,
+                reading.vpdKpa);
   }
 
   void resetWifiBackoff()
   {
-    g_wifiBackoffIndex = 0;
-    g_nextWifiAttemptMs = 0;
+    Backoff::reset(g_wifiBackoff);
+    Scheduler::cancel(g_wifiRetryJob);
   }
 
   void scheduleWifiReconnect(const char *reason)
   {
-    incrementDiagCounter(kDiagWifiRetriesKey);
-    if (g_wifiBackoffIndex >= kWifiBackoffStepCount)
+    DiagCounters::increment(DiagCounters::Counter::WIFI_RETRIES);
+    if (g_wifiBackoff.attempts >= kWifiMaxRetriesBeforeRestart)
     {
-      logWithDeviceId("[WIFI] Backoff maximo alcanzado, reiniciando...\n");
+      LOG_WARN(WIFI, "Backoff maximo alcanzado, reiniciando...\n");
+      DiagCounters::flush();
       delay(100);
       esp_restart();
       return;
     }
 
-    const size_t idx = g_wifiBackoffIndex;
-    const uint32_t delayMs = kWifiBackoffDelaysMs[idx];
-    logWithDeviceId("[WIFI] Reintento por %s en %lu ms\n",
-                    reason ? reason : "reintento",
-                    static_cast<unsigned long>(delayMs));
-    g_nextWifiAttemptMs = millis() + delayMs;
-    if (g_wifiBackoffIndex < kWifiBackoffStepCount)
-    {
-      ++g_wifiBackoffIndex;
-    }
+    const uint32_t delayMs = Backoff::next(g_wifiBackoff, kWifiBackoffPolicy);
+    LOG_WARN(WIFI, "Reintento por %s en %lu ms\n",
+             reason ? reason : "reintento",
+             static_cast<unsigned long>(delayMs));
+    Scheduler::scheduleIn(g_wifiRetryJob, delayMs);
+    setConnPhase(ConnPhase::WIFI_BACKOFF);
   }
 
   void clearStoredWifiCredentials()
@@ -756,15 +1384,19 @@ bool connectAWS()
     const bool wasConnected = g_wifiConnected;
     WiFi.disconnect(true, true);
     g_wifiConnecting = false;
+    Scheduler::cancel(g_wifiTimeoutJob);
+    g_mqttConnected = false;
     applyWifiConnectionStatus(false);
     resetWifiBackoff();
-    Config::setString("wifi", kWifiSsidKey, std::string());
-    Config::setString("wifi", kWifiPassKey, std::string());
+    Config::setString(Config::Key::WIFI_SSID, std::string());
+    Config::setString(Config::Key::WIFI_PASSWORD, std::string());
+    g_hasWifiCredentials = false;
+    setConnPhase(ConnPhase::IDLE);
     if (wasConnected)
     {
       Provisioning::notifyStatus("wifi:desconectado");
     }
-    logWithDeviceId("[WIFI] Credenciales eliminadas\n");
+    LOG_INFO(WIFI, "Credenciales eliminadas\n");
   }
 
   void stopBleSession()
@@ -776,7 +1408,9 @@ bool connectAWS()
 
     Provisioning::stopBle();
     g_bleActive = false;
+    Scheduler::cancel(g_bleTimeoutJob);
     Display::setBleActive(false);
+    armDisplay();
     updateSystemState();
   }
 
@@ -784,24 +1418,25 @@ bool connectAWS()
   {
     if (!Provisioning::isProvisioningAllowed())
     {
-      logWithDeviceId("[BLE] Ventana de aprovisionamiento cerrada\n");
+      LOG_INFO(BLE, "Ventana de aprovisionamiento cerrada\n");
       return;
     }
     if (Provisioning::startBle())
     {
       g_bleActive = true;
-      g_bleStartMs = millis();
+      Scheduler::scheduleIn(g_bleTimeoutJob, kBleSessionDurationMs);
       Display::setBleActive(true);
+      armDisplay();
       updateSystemState();
-      logWithDeviceId("[BLE] Sesion de aprovisionamiento activa por 60s\n");
+      LOG_INFO(BLE, "Sesion de aprovisionamiento activa por 60s\n");
     }
     else if (g_bleActive)
     {
-      g_bleStartMs = millis();
+      Scheduler::scheduleIn(g_bleTimeoutJob, kBleSessionDurationMs);
     }
     else
     {
-      logWithDeviceId("[BLE] No se pudo iniciar el modo de aprovisionamiento\n");
+      LOG_ERROR(BLE, "No se pudo iniciar el modo de aprovisionamiento\n");
     }
   }
 
@@ -824,15 +1459,19 @@ bool connectAWS()
     }
     else if (!loadWifiCredentials(connectSsid, connectPassword))
     {
-      logWithDeviceId("[WIFI] No hay credenciales configuradas\n");
+      LOG_WARN(WIFI, "No hay credenciales configuradas\n");
+      g_hasWifiCredentials = false;
+      setConnPhase(ConnPhase::IDLE);
       return;
     }
 
-    logWithDeviceId("[WIFI] Conectando a '%s'\n", connectSsid.c_str());
+    LOG_INFO(WIFI, "Conectando a '%s'\n", connectSsid.c_str());
     WiFi.begin(connectSsid.c_str(), connectPassword.length() > 0 ? connectPassword.c_str() : nullptr);
 
     g_wifiConnecting = true;
-    g_wifiConnectStart = millis();
+    Scheduler::cancel(g_wifiRetryJob);
+    Scheduler::scheduleIn(g_wifiTimeoutJob, kWifiConnectTimeoutMs);
+    setConnPhase(ConnPhase::WIFI_CONNECTING);
   }
 
   bool hasStoredCredentials()
@@ -842,50 +1481,38 @@ bool connectAWS()
     return loadWifiCredentials(ssid, password);
   }
 
-  void persistDeviceId()
+  void persistDeviceId(Config::Transaction &tx)
   {
-    Config::setString("device", kDeviceIdKey, std::string(g_deviceId.c_str()));
-    if (!Config::exists("aws", kAwsThingKey) ||
-        Config::getString("aws", kAwsThingKey, "").empty())
+    tx.setString(Config::Key::DEVICE_ID, std::string(g_deviceId.c_str()));
+    if (!Config::exists(Config::Key::AWS_THING) ||
+        Config::getString(Config::Key::AWS_THING).empty())
     {
-      Config::setString("aws", kAwsThingKey, std::string(g_deviceId.c_str()));
+      tx.setString(Config::Key::AWS_THING, std::string(g_deviceId.c_str()));
     }
   }
 
   void loadStoredUserId()
   {
-    g_userId = toArduino(Config::getString("device", kDeviceUserKey, ""));
+    g_userId = toArduino(Config::getString(Config::Key::DEVICE_USER));
   }
 
-  void storeUserId(const String &userId)
+  void storeUserId(const String &userId, Config::Transaction &tx)
   {
     g_userId = userId;
-    Config::setString("device", kDeviceUserKey, std::string(g_userId.c_str()));
+    tx.setString(Config::Key::DEVICE_USER, std::string(g_userId.c_str()));
   }
 
   void scheduleIdentityLog()
   {
-    g_identityLogTargetMs = millis() + kIdentityLogDelayMs;
-    g_identityLogReady = false;
+    Scheduler::scheduleIn(g_identityLogJob, kIdentityLogDelayMs);
   }
 
-  void logIdentityIfDue()
+  void logIdentity()
   {
-    if (g_identityLogReady)
-    {
-      return;
-    }
-
-    if (millis() < g_identityLogTargetMs)
-    {
-      return;
-    }
-
     const char *userId = g_userId.length() > 0 ? g_userId.c_str() : "(sin user_id)";
-    logWithDeviceId("[IDENTIDAD] MAC disponible\n");
-    logWithDeviceId("[IDENTIDAD] user_id %s\n",
-                    g_userId.length() > 0 ? "configurado" : "ausente");
-    g_identityLogReady = true;
+    LOG_INFO(IDENTIDAD, "MAC disponible\n");
+    LOG_INFO(IDENTIDAD, "user_id %s\n",
+             g_userId.length() > 0 ? "configurado" : "ausente");
   }
 
   String buildDeviceId()
@@ -911,7 +1538,7 @@ bool connectAWS()
 
   void ensureDeviceIdentity()
   {
-    const std::string storedId = Config::getString("device", kDeviceIdKey, "");
+    const std::string storedId = Config::getString(Config::Key::DEVICE_ID);
     if (!storedId.empty())
     {
       g_deviceId = storedId.c_str();
@@ -919,61 +1546,91 @@ bool connectAWS()
     else
     {
       g_deviceId = buildDeviceId();
-      persistDeviceId();
+      Config::Transaction tx;
+      persistDeviceId(tx);
+      tx.commit();
     }
-    g_environment = toArduino(Config::getString("device", kDeviceEnvKey, kDefaultEnv));
+    LogRing::setPrefix(g_deviceId.c_str());
+    g_environment = toArduino(Config::getString(Config::Key::DEVICE_ENV));
   }
 
   void onProvisionedCredentials(const Provisioning::CredentialsData &creds)
   {
-    logWithDeviceId("[BLE] Credenciales recibidas via BLE\n");
-    Config::setString("wifi", kWifiSsidKey, std::string(creds.ssid.c_str()));
-    Config::setString("wifi", kWifiPassKey, std::string(creds.password.c_str()));
-    const std::string storedToken = Config::getString("device", "provision_token", "");
+    LOG_INFO(BLE, "Credenciales recibidas via BLE\n");
+    // Todo lo recibido se guarda junto: un reset no deja Wi-Fi y AWS mezclados.
+    Config::Transaction tx;
+    tx.setString(Config::Key::WIFI_SSID, std::string(creds.ssid.c_str()));
+    tx.setString(Config::Key::WIFI_PASSWORD, std::string(creds.password.c_str()));
+    const std::string storedToken = Config::getString(Config::Key::DEVICE_PROVISION_TOKEN);
     if (storedToken.empty() && creds.provisionToken.length() > 0)
     {
-      Config::setString("device", "provision_token", std::string(creds.provisionToken.c_str()));
+      tx.setString(Config::Key::DEVICE_PROVISION_TOKEN, std::string(creds.provisionToken.c_str()));
     }
 
-    if (creds.deviceId.length() > 0 && creds.deviceId != g_deviceId)
+    const bool deviceIdChanged = creds.deviceId.length() > 0 && creds.deviceId != g_deviceId;
+    if (deviceIdChanged)
     {
       g_deviceId = creds.deviceId;
-      persistDeviceId();
-      Provisioning::begin(g_deviceId, onProvisionedCredentials);
+      LogRing::setPrefix(g_deviceId.c_str());
+      persistDeviceId(tx);
     }
 
     if (creds.endpoint.length() > 0)
     {
-      Config::setString("aws", kAwsEndpointKey, std::string(creds.endpoint.c_str()));
+      tx.setString(Config::Key::AWS_ENDPOINT, std::string(creds.endpoint.c_str()));
     }
     if (creds.region.length() > 0)
     {
-      Config::setString("aws", kAwsRegionKey, std::string(creds.region.c_str()));
+      tx.setString(Config::Key::AWS_REGION, std::string(creds.region.c_str()));
       g_awsRegion = creds.region;
     }
     if (creds.environment.length() > 0)
     {
-      Config::setString("device", kDeviceEnvKey, std::string(creds.environment.c_str()));
+      tx.setString(Config::Key::DEVICE_ENV, std::string(creds.environment.c_str()));
       g_environment = creds.environment;
     }
     if (creds.thingName.length() > 0)
     {
-      Config::setString("aws", kAwsThingKey, std::string(creds.thingName.c_str()));
+      tx.setString(Config::Key::AWS_THING, std::string(creds.thingName.c_str()));
     }
     if (creds.awsPort > 0)
     {
-      Config::setInt("aws", kAwsPortKey, creds.awsPort);
+      tx.setInt(Config::Key::AWS_PORT, creds.awsPort);
+    }
+    const bool userIdReceived = creds.userId.length() > 0;
+    if (userIdReceived)
+    {
+      storeUserId(creds.userId, tx);
+    }
+
+    const esp_err_t err = tx.commit();
+    if (err != ESP_OK)
+    {
+      LOG_ERROR(CONFIG, "Error guardando credenciales (%d)\n", static_cast<int>(err));
+    }
+    else
+    {
+      LOG_INFO(CONFIG, "Credenciales guardadas, generacion %lu\n",
+               static_cast<unsigned long>(Config::generation()));
+    }
+
+    if (deviceIdChanged)
+    {
+      Provisioning::begin(g_deviceId, onProvisionedCredentials);
     }
 
+    g_hasWifiCredentials = true;
+    clearAwsCredentials();
+    setupAWS();
+
     Provisioning::notifyStatus("wifi:conectando");
     applyWifiConnectionStatus(false);
     startWifiConnection(creds.ssid.c_str(), creds.password.c_str(), true);
 
-    if (creds.userId.length() > 0)
+    if (userIdReceived)
     {
-      storeUserId(creds.userId);
       scheduleIdentityLog();
-      logWithDeviceId("[BLE] user_id recibido\n");
+      LOG_INFO(BLE, "user_id recibido\n");
     }
 
     g_claimPending = true;
@@ -981,124 +1638,270 @@ bool connectAWS()
 
   void handleBleButton()
   {
-    uint32_t now = millis();
-
-    if (g_bleButtonInterrupt)
+    if (!g_bleButtonInterrupt)
     {
-      g_bleButtonInterrupt = false;
+      return;
+    }
+    g_bleButtonInterrupt = false;
 
-      if (now - g_lastButtonHandledMs >= kButtonDebounceMs &&
-          digitalRead(kBleButtonPin) == LOW)
+    const uint32_t now = millis();
+    if (now - g_lastButtonHandledMs >= kButtonDebounceMs &&
+        digitalRead(kBleButtonPin) == LOW)
+    {
+      if (!g_bleButtonPending)
       {
-        if (!g_bleButtonPending)
-        {
-          g_bleButtonPending = true;
-          g_bleButtonPressStartMs = now;
-        }
-        g_lastButtonHandledMs = now;
+        g_bleButtonPending = true;
+        g_bleButtonPressStartMs = now;
+        Scheduler::scheduleIn(g_bleButtonJob, kButtonPollMs);
       }
+      g_lastButtonHandledMs = now;
     }
+  }
 
-    if (!g_bleButtonPending)
+  // Solo armado mientras el boton esta presionado.
+  void pollBleButton()
+  {
+    if (!g_bleButtonPending || digitalRead(kBleButtonPin) != LOW)
     {
+      g_bleButtonPending = false;
+      Scheduler::cancel(g_bleButtonJob);
       return;
     }
 
-    if (digitalRead(kBleButtonPin) == LOW)
+    const uint32_t now = millis();
+    if (now - g_bleButtonPressStartMs >= kBleActivationHoldMs)
     {
-      now = millis();
-      if (now - g_bleButtonPressStartMs >= kBleActivationHoldMs)
+      g_bleButtonPending = false;
+      Scheduler::cancel(g_bleButtonJob);
+      g_lastButtonHandledMs = now;
+      clearStoredWifiCredentials();
+      if (Provisioning::isReleased())
       {
-        g_bleButtonPending = false;
-        g_lastButtonHandledMs = now;
-        clearStoredWifiCredentials();
-        startBleSession();
+        Provisioning::rebootForProvisioning();
       }
-      return;
+      startBleSession();
     }
-
-    g_bleButtonPending = false;
   }
 
-  void handleBleTimeout()
+#if BLE_RELEASE_AFTER_WINDOW
+  void maybeReleaseBle()
   {
-    if (!g_bleActive)
+    if (Provisioning::isReleased())
+    {
+      Scheduler::cancel(g_bleReleaseJob);
+      return;
+    }
+    // Sin credenciales el BLE es la unica via para configurar el equipo.
+    if (!g_hasWifiCredentials || g_bleActive || Provisioning::isProvisioningAllowed())
     {
       return;
     }
+    if (Provisioning::releaseStack())
+    {
+      Scheduler::cancel(g_bleReleaseJob);
+    }
+  }
+#endif
 
-    if (millis() - g_bleStartMs >= kBleSessionDurationMs)
+  void onBleSessionTimeout()
+  {
+    if (!g_bleActive)
     {
-      logWithDeviceId("[BLE] Tiempo de aprovisionamiento agotado\n");
-      stopBleSession();
+      return;
     }
+    LOG_WARN(BLE, "Tiempo de aprovisionamiento agotado\n");
+    stopBleSession();
   }
 
-  void handleWifiStatus()
+  void onWifiGotIp(bool mqttStartedFromEvent)
   {
-    if (!g_wifiConnected && !g_wifiConnecting && hasStoredCredentials())
+    g_wifiConnecting = false;
+    Scheduler::cancel(g_wifiTimeoutJob);
+    if (g_wifiConnected)
     {
-      if (g_nextWifiAttemptMs == 0 || millis() >= g_nextWifiAttemptMs)
-      {
-        if (g_nextWifiAttemptMs != 0)
-        {
-          logWithDeviceId("[WIFI] Ejecutando reintento programado\n");
-        }
-        startWifiConnection();
-      }
+      return;
     }
 
-    wl_status_t status = WiFi.status();
+    applyWifiConnectionStatus(true);
+    if (g_wifiConnectedOnce)
+    {
+      Metrics::increment(Metrics::Counter::WIFI_RECONNECTS);
+    }
+    g_wifiConnectedOnce = true;
+    {
+      String ip = WiFi.localIP().toString();
+      LOG_INFO(WIFI, "IP: %s\n", ip.c_str());
+    }
+    Provisioning::notifyStatus("wifi:conectado");
+    TimeSync::begin();
+    g_claimPending = true;
+    g_sensorRegistryPending = true;
+    stopBleSession();
+    resetWifiBackoff();
+    resetAwsBackoff();
 
-    if (status == WL_CONNECTED)
+    if (mqttStartedFromEvent)
+    {
+      LOG_INFO(AWS, "Conexion MQTT iniciada desde GOT_IP\n");
+      setConnPhase(ConnPhase::TLS_CONNECTING);
+    }
+    else if (!setupAWS() || !connectAWS())
     {
-      if (!g_wifiConnected)
+      if (g_connPhase != ConnPhase::MQTT_BACKOFF)
       {
-        applyWifiConnectionStatus(true);
-        {
-          String ip = WiFi.localIP().toString();
-          logWithDeviceId("[WIFI] IP: %s\n", ip.c_str());
-        }
-        Provisioning::notifyStatus("wifi:conectado");
-        if (setupAWS())
-        {
-          connectAWS();   // 👈 Se conecta a AWS inmediatamente
-        }
-        g_claimPending = true;
-        g_sensorRegistryPending = true;
-        stopBleSession();
-        resetWifiBackoff();
+        setConnPhase(ConnPhase::WIFI_ONLINE);
       }
-      g_wifiConnecting = false;
-      return;
     }
+  }
 
+  void onWifiDisconnected(int32_t reason)
+  {
     if (g_wifiConnected)
     {
-      logWithDeviceId("[WIFI] Conexion perdida\n");
+      LOG_WARN(WIFI, "Conexion perdida (motivo %ld)\n", static_cast<long>(reason));
       applyWifiConnectionStatus(false);
       Provisioning::notifyStatus("wifi:desconectado");
       g_wifiConnecting = false;
+      Scheduler::cancel(g_wifiTimeoutJob);
+      g_mqttConnected = false;
       scheduleWifiReconnect("desconexion wifi");
+      return;
     }
 
-    if (!g_wifiConnecting)
+    // WIFI_REASON_ASSOC_LEAVE lo genera nuestro propio WiFi.disconnect().
+    if (!g_wifiConnecting || reason == WIFI_REASON_ASSOC_LEAVE)
+    {
+      return;
+    }
+
+    LOG_ERROR(WIFI, "Error al conectar (motivo %ld)\n", static_cast<long>(reason));
+    Provisioning::notifyStatus("wifi:error");
+    WiFi.disconnect(false, false);
+    g_wifiConnecting = false;
+    Scheduler::cancel(g_wifiTimeoutJob);
+    applyWifiConnectionStatus(false);
+    scheduleWifiReconnect("error conexion");
+  }
+
+  void onMqttEvent(const ConnEvent &event)
+  {
+    switch (event.type)
+    {
+    case ConnEventType::MQTT_BEFORE_CONNECT:
+      setConnPhase(ConnPhase::TLS_CONNECTING);
+      break;
+    case ConnEventType::MQTT_CONNECTED:
+      g_mqttConnected = true;
+      if (g_mqttConnectedOnce)
+      {
+        Metrics::increment(Metrics::Counter::MQTT_RECONNECTS);
+      }
+      g_mqttConnectedOnce = true;
+      resetAwsBackoff();
+      setConnPhase(ConnPhase::MQTT_ONLINE);
+      Scheduler::scheduleIn(g_publishRetryJob, 0);
+      LOG_INFO(MQTT, "Conectado\n");
+      break;
+    case ConnEventType::MQTT_DISCONNECTED:
+      g_mqttConnected = false;
+      LOG_INFO(MQTT, "Desconectado\n");
+      if (g_wifiConnected)
+      {
+        scheduleAwsBackoff("desconexion");
+      }
+      break;
+    case ConnEventType::MQTT_ERROR:
+      LOG_ERROR(MQTT, "Error en evento MQTT (tipo %ld)\n", static_cast<long>(event.detail));
+      break;
+    case ConnEventType::MQTT_PUBLISHED:
+      CoreDump::onAcked(event.detail);
+      break;
+    default:
+      break;
+    }
+  }
+
+  void processConnEvents()
+  {
+    if (!g_connEventQueue)
     {
       return;
     }
 
-    const uint32_t elapsed = millis() - g_wifiConnectStart;
-    if (status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL ||
-        elapsed > kWifiConnectTimeoutMs)
+    ConnEvent event;
+    while (xQueueReceive(g_connEventQueue, &event, 0) == pdTRUE)
+    {
+      switch (event.type)
+      {
+      case ConnEventType::WIFI_ASSOCIATED:
+        LOG_INFO(WIFI, "Asociado al AP, esperando IP\n");
+        break;
+      case ConnEventType::WIFI_GOT_IP:
+        onWifiGotIp(event.detail != 0);
+        break;
+      case ConnEventType::WIFI_DISCONNECTED:
+        onWifiDisconnected(event.detail);
+        break;
+      default:
+        onMqttEvent(event);
+        break;
+      }
+    }
+
+    const uint32_t drops = g_connEventDrops;
+    if (drops > 0)
+    {
+      g_connEventDrops = 0;
+      LOG_WARN(CONN, "Cola de eventos llena, %lu eventos descartados\n",
+               static_cast<unsigned long>(drops));
+    }
+  }
+
+  void runWifiRetry()
+  {
+    if (g_wifiConnected || g_wifiConnecting || !g_hasWifiCredentials)
     {
-      logWithDeviceId("[WIFI] Error al conectar\n");
-      Provisioning::notifyStatus("wifi:error");
-      WiFi.disconnect(false, false);
-      g_wifiConnecting = false;
-      applyWifiConnectionStatus(false);
-      scheduleWifiReconnect("error conexion");
       return;
     }
+    LOG_DEBUG(WIFI, "Ejecutando reintento programado\n");
+    startWifiConnection();
+  }
+
+  void onWifiConnectTimeout()
+  {
+    if (!g_wifiConnecting)
+    {
+      return;
+    }
+    LOG_WARN(WIFI, "Tiempo de conexion agotado\n");
+    Provisioning::notifyStatus("wifi:error");
+    WiFi.disconnect(false, false);
+    g_wifiConnecting = false;
+    applyWifiConnectionStatus(false);
+    scheduleWifiReconnect("error conexion");
+  }
+
+  // Semilla distinta por dispositivo para que la flota no reintente al unisono
+  // tras una caida del AP o del broker.
+  void seedBackoff()
+  {
+    uint8_t mac[6] = {0};
+    esp_wifi_get_mac(WIFI_IF_STA, mac);
+    uint32_t seedValue = static_cast<uint32_t>(esp_random());
+    for (size_t i = 0; i < sizeof(mac); ++i)
+    {
+      seedValue = (seedValue * 31u) ^ mac[i];
+    }
+    Backoff::seed(g_wifiBackoff, seedValue);
+    Backoff::seed(g_awsBackoff, seedValue ^ 0xA5A5A5A5u);
+  }
+
+  void registerConnectivityEvents()
+  {
+    g_connEventQueue = xQueueCreate(kConnEventQueueLength, sizeof(ConnEvent));
+    g_mqttMutex = xSemaphoreCreateMutex();
+    esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &onWifiEvent, nullptr);
+    esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &onIpEvent, nullptr);
   }
 
   void configureButton()
@@ -1203,7 +2006,7 @@ bool connectAWS()
 
     if (initialized)
     {
-      logWithDeviceId("[WATCHDOG] initialized\n");
+      LOG_INFO(WATCHDOG, "initialized\n");
     }
   }
 
@@ -1219,7 +2022,7 @@ bool connectAWS()
     const uint32_t now = millis();
     if (now - lastLogMs >= 30000)
     {
-      logWithDeviceId("[WATCHDOG] alive\n");
+      LOG_DEBUG(WATCHDOG, "alive\n");
       lastLogMs = now;
     }
   }
@@ -1235,15 +2038,119 @@ bool connectAWS()
     disableHardwareWatchdog();
   }
 
+  void registerJobs()
+  {
+    Scheduler::begin();
+    Scheduler::addJob("watchdog", feedWatchdog, kWatchdogFeedIntervalMs, 0);
+    Scheduler::addJob("heartbeat", sendHeartbeat, HEARTBEAT_INTERVAL, HEARTBEAT_INTERVAL);
+    Scheduler::addJob("telemetry", sendTelemetry, TELEMETRY_INTERVAL, TELEMETRY_INTERVAL);
+    Scheduler::addJob("sensor_log", logSensorReading, SENSOR_LOG_INTERVAL, SENSOR_LOG_INTERVAL);
+    Scheduler::addJob("sched_stats", Scheduler::dumpStats, kSchedulerStatsIntervalMs, kSchedulerStatsIntervalMs);
+    Scheduler::addJob("i2c_stats", I2cBus::dumpStats, kSchedulerStatsIntervalMs, kSchedulerStatsIntervalMs + kStatsDumpStaggerMs);
+    Scheduler::addJob("diag_flush", DiagCounters::flush, DIAG_FLUSH_INTERVAL_MS, DIAG_FLUSH_INTERVAL_MS);
+    Scheduler::addJob("metrics", sendMetrics, METRICS_INTERVAL_MS, METRICS_INTERVAL_MS);
+    Scheduler::addJob("stack", StackMonitor::sample, STACK_SAMPLE_INTERVAL_MS, STACK_SAMPLE_INTERVAL_MS);
+    Scheduler::addJob("stack_stats", StackMonitor::dumpStats, kSchedulerStatsIntervalMs, kSchedulerStatsIntervalMs + 2 * kStatsDumpStaggerMs);
+    Scheduler::addJob("coredump", sendCoreDumpChunk, CORE_DUMP_CHUNK_INTERVAL_MS, CORE_DUMP_CHUNK_INTERVAL_MS);
+    g_wifiRetryJob = Scheduler::addJob("wifi_retry", runWifiRetry, 0, -1);
+    g_wifiTimeoutJob = Scheduler::addJob("wifi_timeout", onWifiConnectTimeout, 0, -1);
+    g_awsRetryJob = Scheduler::addJob("aws_retry", runAwsRetry, 0, -1);
+    g_bleTimeoutJob = Scheduler::addJob("ble_timeout", onBleSessionTimeout, 0, -1);
+    g_bleButtonJob = Scheduler::addJob("ble_button", pollBleButton, kButtonPollMs, -1);
+    g_identityLogJob = Scheduler::addJob("identity_log", logIdentity, 0, -1);
+    g_displayJob = Scheduler::addJob("display", runDisplay, 0, -1);
+    g_publishRetryJob = Scheduler::addJob("publish_retry", flushDeferredPublishes, 0, -1);
+#if BLE_RELEASE_AFTER_WINDOW
+    g_bleReleaseJob = Scheduler::addJob("ble_release", maybeReleaseBle, kBleReleaseCheckMs, kBleReleaseCheckMs);
+#endif
+#if LOOP_PROFILER_ENABLED
+    Scheduler::addJob("prof_dump", LoopProfiler::dump, kSchedulerStatsIntervalMs, kSchedulerStatsIntervalMs + 3 * kStatsDumpStaggerMs);
+#endif
+
+    g_profConnEvents = LoopProfiler::addSlot("conn_events");
+    g_profBleButton = LoopProfiler::addSlot("ble_btn_isr");
+    g_profAws = LoopProfiler::addSlot("aws");
+    g_profSystemState = LoopProfiler::addSlot("sys_state");
+    g_profProvisioning = LoopProfiler::addSlot("ble_loop");
+  }
+
+  void runProfiled(LoopProfiler::SlotId slot, void (*handler)())
+  {
+    LoopProfiler::Scope profile(slot);
+    handler();
+  }
+
+#if MQTT_COMPRESSION_BENCHMARK
+  // Ratio vs CPU sobre los payloads reales, medido en el propio C3.
+  void runCompressionBenchmark()
+  {
+    constexpr int kIterations = 50;
+    constexpr LzCodec::Params kConfigs[] = {{6, 3}, {7, 4}, {8, 4}, {9, 5}, {10, 5}};
+
+    Sht45Sensor::Reading reading;
+    reading.temperatureC = 24.37f;
+    reading.humidityRh = 61.53f;
+    reading.vpdKpa = 1.17f;
+    reading.capturedAt = TimeSync::now();
+    reading.valid = true;
+
+    String batch = "[";
+    for (int i = 0; i < 8; ++i)
+    {
+      if (i > 0)
+      {
+        batch += ",";
+      }
+      batch += Sht45Sensor::buildTelemetryPayload(g_deviceId, reading, nextEventKey("telemetry"));
+    }
+    batch += "]";
+
+    const String samples[] = {
+        SensorRegistry::buildPayload(g_deviceId, nextEventKey("sensor_registry")),
+        Sht45Sensor::buildTelemetryPayload(g_deviceId, reading, nextEventKey("telemetry")),
+        batch,
+    };
+    const char *names[] = {"registry", "telemetry", "telemetry_x8"};
+
+    static uint8_t out[2048];
+    for (size_t s = 0; s < 3; ++s)
+    {
+      const String &payload = samples[s];
+      for (const LzCodec::Params &params : kConfigs)
+      {
+        size_t packed = 0;
+        const uint32_t start = micros();
+        for (int i = 0; i < kIterations; ++i)
+        {
+          packed = LzCodec::compress(reinterpret_cast<const uint8_t *>(payload.c_str()),
+                                     payload.length(), out, sizeof(out), params);
+        }
+        const uint32_t elapsedUs = micros() - start;
+        LOG_RAW(LZ, DEBUG, "[LZ] %-13s w=%2u l=%u %4u -> %4u bytes (%3u%%) %6lu us\n",
+                names[s],
+                params.windowBits,
+                params.lookaheadBits,
+                static_cast<unsigned>(payload.length()),
+                static_cast<unsigned>(packed),
+                static_cast<unsigned>(packed * 100 / payload.length()),
+                static_cast<unsigned long>(elapsedUs / kIterations));
+      }
+    }
+  }
+#endif
+
   void recordResetInfo()
   {
     const esp_reset_reason_t reason = esp_reset_reason();
-    Config::setInt("diag", kDiagLastResetKey, static_cast<int32_t>(reason));
-    incrementDiagCounter(kDiagResetCountKey);
+    Config::setInt(Config::Key::DIAG_LAST_RESET, static_cast<int32_t>(reason));
+    DiagCounters::begin();
+    DiagCounters::increment(DiagCounters::Counter::RESET_COUNT);
     if (reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT)
     {
-      incrementDiagCounter(kDiagWdtKey);
+      DiagCounters::increment(DiagCounters::Counter::WDT_RESETS);
     }
+    // Un corte de alimentacion borra la RTC: los resets se persisten ya.
+    DiagCounters::flush();
   }
 
   void logWatchdogResetIfNeeded()
@@ -1251,7 +2158,13 @@ bool connectAWS()
     const esp_reset_reason_t reason = esp_reset_reason();
     if (reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT)
     {
-      logWithDeviceId("[WATCHDOG] *** reset detected ***\n");
+      LOG_WARN(WATCHDOG, "*** reset detected ***\n");
+    }
+    if (reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT ||
+        reason == ESP_RST_WDT)
+    {
+      // Las ultimas lineas antes del fallo, en crudo para log_decode.py.
+      LogRing::requestRawDump();
     }
   }
 
@@ -1260,106 +2173,116 @@ bool connectAWS()
 void setup()
 {
   Serial.begin(115200);
+  LogRing::begin();
+  LogRing::startDrain();
+  registerJobs();
+  PublishLimiter::begin(millis());
   Config::init();
   seedConfigDefaults();
   recordResetInfo();
   logWatchdogResetIfNeeded();
+  g_coreDumpSummaryPending = CoreDump::begin();
+  LoopProfiler::begin();
 
   g_spiffsReady = SPIFFS.begin(false);
   if (g_spiffsReady)
   {
-    Serial.println("[SPIFFS] OK: montado correctamente");
+    LOG_INFO(SPIFFS, "OK: montado correctamente\n");
   }
   else
   {
-    Serial.println("[SPIFFS] Aviso: error al montar (sin formatear)");
+    LOG_WARN(SPIFFS, "Aviso: error al montar (sin formatear)\n");
     g_spiffsReady = SPIFFS.begin(true);
     if (g_spiffsReady)
     {
-      Serial.println("[SPIFFS] OK: formateado y montado");
+      LOG_INFO(SPIFFS, "OK: formateado y montado\n");
     }
     else
     {
-      Serial.println("[SPIFFS] ❌ No se pudo montar SPIFFS");
+      LOG_ERROR(SPIFFS, "❌ No se pudo montar SPIFFS\n");
     }
   }
 
   WiFi.mode(WIFI_STA);
-  WiFi.setAutoReconnect(true);
+  // Sin el reintento inmediato del core: el unico camino de reconexion es
+  // scheduleWifiReconnect() con Backoff, con jitter por dispositivo.
+  WiFi.setAutoReconnect(false);
   WiFi.persistent(true);
+  seedBackoff();
+  registerConnectivityEvents();
 
   ensureDeviceIdentity();
   loadStoredUserId();
   scheduleIdentityLog();
-  logWithDeviceId("[BOOT] device_id: %s\n", g_deviceId.c_str());
-  logWithDeviceId("[BOOT] entorno: %s\n", g_environment.c_str());
+  LOG_INFO(BOOT, "device_id: %s\n", g_deviceId.c_str());
+  LOG_INFO(BOOT, "entorno: %s\n", g_environment.c_str());
   g_bootSessionId = buildBootSessionId();
-  logWithDeviceId("[BOOT] boot_session_id: %s\n", g_bootSessionId.c_str());
+  LOG_INFO(BOOT, "boot_session_id: %s\n", g_bootSessionId.c_str());
+#if MQTT_COMPRESSION_BENCHMARK
+  runCompressionBenchmark();
+#endif
 
+  I2cBus::begin();
   Display::begin();
   Display::setConnectionStatus(false);
   Display::setBleActive(false);
   Display::forceRender();
+  armDisplay();
 
   if (Sht45Sensor::begin())
   {
-    Serial.println("[SHT45] Sensor inicializado");
+    LOG_INFO(SHT45, "Sensor inicializado\n");
   }
   else
   {
-    Serial.println("[SHT45] No se encontro SHT45");
+    LOG_WARN(SHT45, "No se encontro SHT45\n");
   }
 
   Provisioning::begin(g_deviceId, onProvisionedCredentials);
-
+#if BLE_EAGER_INIT
+  Provisioning::bringUp();
+#endif
 
   configureButton();
   setupWatchdogs();
 
-  if (hasStoredCredentials())
+  g_hasWifiCredentials = hasStoredCredentials();
+  if (g_hasWifiCredentials)
   {
-    logWithDeviceId("[WIFI] Credenciales guardadas detectadas\n");
+    LOG_INFO(WIFI, "Credenciales guardadas detectadas\n");
+    setupAWS();
     startWifiConnection(nullptr, nullptr, true);
   }
   else
   {
-    logWithDeviceId("[WIFI] No hay credenciales guardadas\n");
+    LOG_WARN(WIFI, "No hay credenciales guardadas\n");
+    // Sin credenciales el BLE es la via de configuracion: se deja listo.
+    Provisioning::bringUp();
     applyWifiConnectionStatus(false);
     updateSystemState();
   }
+
+  if (Provisioning::bootedForProvisioning())
+  {
+    LOG_INFO(BLE, "Arranque para aprovisionamiento\n");
+    startBleSession();
+  }
 }
 
 void loop()
 {
-  feedWatchdog();
-  unsigned long now = millis();
-  if (now - lastHeartbeatMs >= HEARTBEAT_INTERVAL) {
-    sendHeartbeat();
-    lastHeartbeatMs = now;
-  }
-  if (now - lastTelemetryMs >= TELEMETRY_INTERVAL) {
-    sendTelemetry();
-    lastTelemetryMs = now;
-  }
-  if (now - lastSensorLogMs >= SENSOR_LOG_INTERVAL) {
-    logSensorReading();
-    lastSensorLogMs = now;
-  }
-  handleBleButton();
-  handleBleTimeout();
-  handleWifiStatus();
-  logIdentityIfDue();
-  handleAWS(); // 👈 mantiene viva la conexión MQTT
+  runProfiled(g_profConnEvents, processConnEvents);
+  runProfiled(g_profBleButton, handleBleButton);
+  Scheduler::runDue();
+  runProfiled(g_profAws, handleAWS); // 👈 mantiene viva la conexión MQTT
 
   if (!g_wifiConnecting && !g_wifiConnected && !g_bleActive)
   {
-    updateSystemState();
+    runProfiled(g_profSystemState, updateSystemState);
   }
 
-  Provisioning::loop();
-  Display::loop();
+  runProfiled(g_profProvisioning, Provisioning::loop);
 
-  delay(1);
+  // Bloquea hasta el siguiente deadline o un evento (Wi-Fi, MQTT, BLE, boton).
+  Scheduler::waitForWork(kMaxIdleWaitMs);
 }
-
-
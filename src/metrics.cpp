@@ -0,0 +1,271 @@
+#include "metrics.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+namespace Metrics
+{
+namespace
+{
+struct Values
+{
+  uint32_t counters[kCounterCount] = {};
+  int32_t gauges[kGaugeCount] = {};
+  bool gaugeSet[kGaugeCount] = {};
+  HistogramStats histograms[kHistogramCount];
+};
+
+Values g_current;
+Values g_base;    // lo ya publicado
+Values g_pending; // lo de writeSnapshot(), hasta commitSnapshot()
+uint32_t g_baseMs = 0;
+uint32_t g_pendingMs = 0;
+uint32_t g_sequence = 0;
+
+// Append con snprintf; marca el desborde en vez de devolver un JSON roto.
+struct Writer
+{
+  char *out;
+  size_t size;
+  size_t length;
+  bool overflow;
+
+  void append(const char *format, ...) __attribute__((format(printf, 2, 3)))
+  {
+    if (overflow)
+    {
+      return;
+    }
+    va_list args;
+    va_start(args, format);
+    const int written = vsnprintf(out + length, size - length, format, args);
+    va_end(args);
+    if (written < 0 || static_cast<size_t>(written) >= size - length)
+    {
+      overflow = true;
+      return;
+    }
+    length += static_cast<size_t>(written);
+  }
+};
+} // namespace
+
+void increment(Counter counter, uint32_t amount)
+{
+  const size_t index = static_cast<size_t>(counter);
+  if (index < kCounterCount)
+  {
+    g_current.counters[index] += amount;
+  }
+}
+
+void set(Gauge gauge, int32_t value)
+{
+  const size_t index = static_cast<size_t>(gauge);
+  if (index < kGaugeCount)
+  {
+    g_current.gauges[index] = value;
+    g_current.gaugeSet[index] = true;
+  }
+}
+
+size_t bucketFor(uint32_t value)
+{
+  if (value == 0)
+  {
+    return 0;
+  }
+  const size_t bucket = static_cast<size_t>(32 - __builtin_clz(value));
+  return bucket < kBucketCount ? bucket : kBucketCount - 1;
+}
+
+void observe(Histogram histogram, uint32_t value)
+{
+  const size_t index = static_cast<size_t>(histogram);
+  if (index >= kHistogramCount)
+  {
+    return;
+  }
+  HistogramStats &stats = g_current.histograms[index];
+  stats.count++;
+  stats.sum += value;
+  if (value > stats.max)
+  {
+    stats.max = value;
+  }
+  stats.buckets[bucketFor(value)]++;
+}
+
+uint32_t value(Counter counter)
+{
+  const size_t index = static_cast<size_t>(counter);
+  return index < kCounterCount ? g_current.counters[index] : 0;
+}
+
+int32_t value(Gauge gauge)
+{
+  const size_t index = static_cast<size_t>(gauge);
+  return index < kGaugeCount ? g_current.gauges[index] : 0;
+}
+
+HistogramStats stats(Histogram histogram)
+{
+  const size_t index = static_cast<size_t>(histogram);
+  return index < kHistogramCount ? g_current.histograms[index] : HistogramStats();
+}
+
+const char *name(Counter counter)
+{
+  switch (counter)
+  {
+  case Counter::PUBLISHES:
+    return "pub";
+  case Counter::PUBLISH_FAILURES:
+    return "pub_fail";
+  case Counter::BYTES_SENT:
+    return "tx_bytes";
+  case Counter::MQTT_RECONNECTS:
+    return "mqtt_reconn";
+  case Counter::WIFI_RECONNECTS:
+    return "wifi_reconn";
+  case Counter::SENSOR_ERRORS:
+    return "sensor_err";
+  default:
+    return "?";
+  }
+}
+
+const char *name(Gauge gauge)
+{
+  switch (gauge)
+  {
+  case Gauge::HEAP_FREE:
+    return "heap_free";
+  case Gauge::WIFI_RSSI:
+    return "rssi";
+  case Gauge::TELEMETRY_QUEUE:
+    return "tel_queue";
+  default:
+    return "?";
+  }
+}
+
+const char *name(Histogram histogram)
+{
+  switch (histogram)
+  {
+  case Histogram::LOOP_LAG_MS:
+    return "lag_ms";
+  case Histogram::PUBLISH_BYTES:
+    return "pub_bytes";
+  default:
+    return "?";
+  }
+}
+
+size_t writeSnapshot(char *out, size_t size, uint32_t nowMs)
+{
+  if (!out || size == 0)
+  {
+    return 0;
+  }
+  g_pending = g_current;
+  g_pendingMs = nowMs;
+
+  Writer writer = {out, size, 0, false};
+  writer.append("{\"seq\":%lu,\"dt\":%lu",
+                static_cast<unsigned long>(g_sequence),
+                static_cast<unsigned long>(nowMs - g_baseMs));
+
+  bool open = false;
+  for (size_t i = 0; i < kCounterCount; ++i)
+  {
+    const uint32_t delta = g_pending.counters[i] - g_base.counters[i];
+    if (delta != 0)
+    {
+      writer.append("%s\"%s\":%lu", open ? "," : ",\"c\":{", name(static_cast<Counter>(i)),
+                    static_cast<unsigned long>(delta));
+      open = true;
+    }
+  }
+  if (open)
+  {
+    writer.append("}");
+  }
+
+  open = false;
+  for (size_t i = 0; i < kGaugeCount; ++i)
+  {
+    const bool changed = g_pending.gaugeSet[i] &&
+                         (!g_base.gaugeSet[i] || g_pending.gauges[i] != g_base.gauges[i]);
+    if (changed)
+    {
+      writer.append("%s\"%s\":%ld", open ? "," : ",\"g\":{", name(static_cast<Gauge>(i)),
+                    static_cast<long>(g_pending.gauges[i]));
+      open = true;
+    }
+  }
+  if (open)
+  {
+    writer.append("}");
+  }
+
+  open = false;
+  for (size_t i = 0; i < kHistogramCount; ++i)
+  {
+    const HistogramStats &current = g_pending.histograms[i];
+    const HistogramStats &base = g_base.histograms[i];
+    const uint32_t count = current.count - base.count;
+    if (count == 0)
+    {
+      continue;
+    }
+    writer.append("%s\"%s\":[%lu,%lu,%lu",
+                  open ? "," : ",\"h\":{",
+                  name(static_cast<Histogram>(i)),
+                  static_cast<unsigned long>(count),
+                  static_cast<unsigned long>(current.sum - base.sum),
+                  static_cast<unsigned long>(current.max));
+    size_t last = kBucketCount;
+    while (last > 0 && current.buckets[last - 1] == base.buckets[last - 1])
+    {
+      --last;
+    }
+    for (size_t b = 0; b < last; ++b)
+    {
+      writer.append(",%lu", static_cast<unsigned long>(current.buckets[b] - base.buckets[b]));
+    }
+    writer.append("]");
+    open = true;
+  }
+  if (open)
+  {
+    writer.append("}");
+  }
+  writer.append("}");
+
+  return writer.overflow ? 0 : writer.length;
+}
+
+void commitSnapshot()
+{
+  g_base = g_pending;
+  g_baseMs = g_pendingMs;
+  g_sequence++;
+  // El maximo de cada histograma es por ventana.
+  for (size_t i = 0; i < kHistogramCount; ++i)
+  {
+    g_current.histograms[i].max = 0;
+  }
+}
+
+void reset(uint32_t nowMs)
+{
+  g_current = Values();
+  g_base = Values();
+  g_pending = Values();
+  g_baseMs = nowMs;
+  g_pendingMs = nowMs;
+  g_sequence = 0;
+}
+} // namespace Metrics
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Registro de metricas en RAM: contadores, gauges e histogramas con nombre,
+// indexados por enum para que cada actualizacion sea O(1) y sin reservas.
+// Solo se actualiza desde la tarea del loop, como el Scheduler.
+// writeSnapshot() genera el JSON compacto del topic metrics con lo que cambio
+// desde el ultimo snapshot confirmado con commitSnapshot(); si el publish
+// falla, el siguiente snapshot incluye tambien esos cambios.
+namespace Metrics
+{
+enum class Counter : uint8_t
+{
+  PUBLISHES = 0,
+  PUBLISH_FAILURES,
+  BYTES_SENT,
+  MQTT_RECONNECTS,
+  WIFI_RECONNECTS,
+  SENSOR_ERRORS,
+  COUNT,
+};
+
+enum class Gauge : uint8_t
+{
+  HEAP_FREE = 0,
+  WIFI_RSSI,
+  TELEMETRY_QUEUE, // lecturas retenidas por el rate limiter
+  COUNT,
+};
+
+enum class Histogram : uint8_t
+{
+  LOOP_LAG_MS = 0, // retraso de cada job del Scheduler sobre su deadline
+  PUBLISH_BYTES,
+  COUNT,
+};
+
+constexpr size_t kCounterCount = static_cast<size_t>(Counter::COUNT);
+constexpr size_t kGaugeCount = static_cast<size_t>(Gauge::COUNT);
+constexpr size_t kHistogramCount = static_cast<size_t>(Histogram::COUNT);
+// Cubos por potencias de 2: 0, 1, 2-3, 4-7, ... y el ultimo abierto (>= 1024).
+constexpr size_t kBucketCount = 12;
+
+struct HistogramStats
+{
+  uint32_t count = 0;
+  uint32_t sum = 0;
+  uint32_t max = 0; // desde el ultimo snapshot confirmado
+  uint32_t buckets[kBucketCount] = {};
+};
+
+void increment(Counter counter, uint32_t amount = 1);
+void set(Gauge gauge, int32_t value);
+void observe(Histogram histogram, uint32_t value);
+
+uint32_t value(Counter counter);
+int32_t value(Gauge gauge);
+HistogramStats stats(Histogram histogram);
+
+const char *name(Counter counter);
+const char *name(Gauge gauge);
+const char *name(Histogram histogram);
+size_t bucketFor(uint32_t value);
+
+// {"seq":N,"dt":ms,"c":{...},"g":{...},"h":{"lag":[n,sum,max,cubo0,...]}}
+// Solo contadores con delta != 0, gauges que cambiaron e histogramas con
+// muestras; los cubos sin los ceros finales. Devuelve 0 si no cabe.
+size_t writeSnapshot(char *out, size_t size, uint32_t nowMs);
+// Toma el ultimo writeSnapshot() como base de los siguientes deltas.
+void commitSnapshot();
+// Olvida todo; para los tests.
+void reset(uint32_t nowMs);
+} // namespace Metrics
@@ -2,6 +2,15 @@
 
 #include <U8g2lib.h>
 #include <algorithm>
+#include <cstring>
+
+#include "i2c_bus.h"
+
+// 1: buffer de una pagina (128 bytes en vez de 1 KB + sombra). Sin sombra no
+// hay diff por tiles: cada render reenvia las filas de la ventana completas.
+#ifndef OLED_PAGE_BUFFER
+#define OLED_PAGE_BUFFER 0
+#endif
 
 namespace {
 constexpr int kWidth = 72;
@@ -9,24 +18,65 @@ constexpr int kHeight = 39;
 constexpr int kXOffset = 28;
 constexpr int kYOffset = 25;
 constexpr uint32_t kBlinkIntervalMs = 600;
-
-U8G2_SSD1306_128X64_NONAME_F_HW_I2C g_u8g2(U8G2_R0, U8X8_PIN_NONE, 6, 5);
-
+constexpr uint8_t kSdaPin = 5;
+constexpr uint8_t kSclPin = 6;
+constexpr uint32_t kBusClockHz = 400000;
+// Sin espera: si el sensor tiene el bus, el frame sale en el siguiente tick.
+constexpr uint32_t kLockTimeoutMs = 0;
+
+// Tiles de 8x8 que cubren la ventana; fuera de ella nunca se dibuja.
+constexpr int kTileX0 = kXOffset / 8;
+constexpr int kTileX1 = (kXOffset + kWidth + 7) / 8;
+constexpr int kTileY0 = kYOffset / 8;
+constexpr int kTileY1 = (kYOffset + kHeight + 7) / 8;
+constexpr int kTileCols = kTileX1 - kTileX0;
+constexpr int kTileRows = kTileY1 - kTileY0;
+constexpr int kScreenTileCols = 16;
+
+// Estimacion de bytes en el bus (u8x8_cad_ssd13xx_fast_i2c): direccion,
+// control y 3 comandos de posicion por tramo; datos en bloques de 24 bytes
+// con su direccion y byte de control.
+constexpr uint32_t kI2cRunOverhead = 5;
+constexpr uint32_t kI2cChunkBytes = 24;
+constexpr uint32_t kI2cChunkOverhead = 2;
+
+#if OLED_PAGE_BUFFER
+// Los pines los aplica I2cBus; U8g2 solo usa Wire ya iniciado.
+U8G2_SSD1306_128X64_NONAME_1_HW_I2C g_u8g2(U8G2_R0, U8X8_PIN_NONE);
+#else
+// Los pines los aplica I2cBus; U8g2 solo usa Wire ya iniciado.
+U8G2_SSD1306_128X64_NONAME_F_HW_I2C g_u8g2(U8G2_R0, U8X8_PIN_NONE);
+// Copia de los tiles de la ventana tal como estan en el panel.
+uint8_t g_sentTiles[kTileRows][kTileCols * 8];
+bool g_panelValid = false;
+#endif
+
+bool g_panelStarted = false;
 bool g_wifiConnected = false;
 bool g_bleActive = false;
 bool g_blinkOn = true;
 bool g_dirty = true;
 uint32_t g_lastBlinkMs = 0;
+Display::Stats g_stats;
+
+uint32_t i2cBytesForRun(int tiles) {
+  const uint32_t bytes = static_cast<uint32_t>(tiles) * 8;
+  return kI2cRunOverhead + bytes + (bytes + kI2cChunkBytes - 1) / kI2cChunkBytes * kI2cChunkOverhead;
+}
+
+void noteTiles(int tiles) {
+  g_stats.tilesSent += tiles;
+  g_stats.i2cBytes += i2cBytesForRun(tiles);
+}
 
 void drawFrame() { g_u8g2.drawFrame(kXOffset, kYOffset, kWidth, kHeight); }
 
-void render() {
+void drawScene() {
   const int16_t centerX = kXOffset + (kWidth / 2);
   const int16_t centerY = kYOffset + (kHeight / 2);
   const int16_t circleRadius = (std::min(kWidth, kHeight) / 2) - 8;
   const int16_t fillRadius = std::max<int16_t>(0, circleRadius - 1);
 
-  g_u8g2.clearBuffer();
   drawFrame();
 
   bool shouldFill = false;
@@ -40,16 +90,111 @@ void render() {
   }
 
   g_u8g2.drawCircle(centerX, centerY, circleRadius);
+}
+
+#if OLED_PAGE_BUFFER
+void sendScene() {
+  // El resto del panel quedo en negro con clearDisplay() en begin().
+  for (int row = kTileY0; row < kTileY1; ++row) {
+    g_u8g2.setBufferCurrTileRow(row);
+    g_u8g2.clearBuffer();
+    drawScene();
+    g_u8g2.sendBuffer();
+    noteTiles(kScreenTileCols);
+  }
+  g_stats.fullFrames++;
+}
+#else
+void copySentTiles() {
+  const uint8_t* buffer = g_u8g2.getBufferPtr();
+  for (int row = 0; row < kTileRows; ++row) {
+    const uint8_t* src = buffer + ((kTileY0 + row) * kScreenTileCols + kTileX0) * 8;
+    std::memcpy(g_sentTiles[row], src, sizeof(g_sentTiles[row]));
+  }
+}
+
+void sendScene() {
+  g_u8g2.clearBuffer();
+  drawScene();
+
+  if (!g_panelValid) {
+    g_u8g2.sendBuffer();
+    for (int row = 0; row < 8; ++row) {
+      noteTiles(kScreenTileCols);
+    }
+    copySentTiles();
+    g_panelValid = true;
+    g_stats.fullFrames++;
+    return;
+  }
+
+  // Por fila, cada tramo de tiles cambiados va en un solo updateDisplayArea.
+  const uint8_t* buffer = g_u8g2.getBufferPtr();
+  for (int row = 0; row < kTileRows; ++row) {
+    const uint8_t* src = buffer + ((kTileY0 + row) * kScreenTileCols + kTileX0) * 8;
+    uint8_t* sent = g_sentTiles[row];
+    int col = 0;
+    while (col < kTileCols) {
+      if (std::memcmp(src + col * 8, sent + col * 8, 8) == 0) {
+        ++col;
+        continue;
+      }
+      const int start = col;
+      while (col < kTileCols && std::memcmp(src + col * 8, sent + col * 8, 8) != 0) {
+        ++col;
+      }
+      const int count = col - start;
+      g_u8g2.updateDisplayArea(kTileX0 + start, kTileY0 + row, count, 1);
+      std::memcpy(sent + start * 8, src + start * 8, count * 8);
+      noteTiles(count);
+    }
+  }
+}
+#endif
 
-  g_u8g2.sendBuffer();
+void startPanel() {
+  // begin() incluye clearDisplay(): el panel entero en negro.
+  g_u8g2.begin();
+  for (int row = 0; row < 8; ++row) {
+    noteTiles(kScreenTileCols);
+  }
+  g_u8g2.setContrast(255);
+  g_u8g2.setBusClock(kBusClockHz);
+  g_panelStarted = true;
+#if !OLED_PAGE_BUFFER
+  g_panelValid = false;
+#endif
+}
+
+// false si el bus estaba ocupado; el llamador mantiene g_dirty.
+bool render() {
+  I2cBus::Lock lock(I2cBus::Client::OLED, kLockTimeoutMs);
+  if (!lock.owned()) {
+    g_stats.deferred++;
+    return false;
+  }
+  if (!g_panelStarted) {
+    startPanel();
+  }
+
+  const uint32_t startUs = micros();
+  sendScene();
+  const uint32_t elapsedUs = micros() - startUs;
+
+  g_stats.renders++;
+  g_stats.lastRenderUs = elapsedUs;
+  g_stats.totalRenderUs += elapsedUs;
+  if (elapsedUs > g_stats.maxRenderUs) {
+    g_stats.maxRenderUs = elapsedUs;
+  }
+  return true;
 }
 }  // namespace
 
 namespace Display {
 void begin() {
-  g_u8g2.begin();
-  g_u8g2.setContrast(255);
-  g_u8g2.setBusClock(400000);
+  I2cBus::configure(I2cBus::Client::OLED, kSdaPin, kSclPin, kBusClockHz);
+  g_panelStarted = false;
   g_lastBlinkMs = millis();
   g_dirty = true;
 }
@@ -71,9 +216,10 @@ void setBleActive(bool active) {
 }
 
 void forceRender() {
-  g_dirty = true;
-  render();
-  g_dirty = false;
+#if !OLED_PAGE_BUFFER
+  g_panelValid = false;
+#endif
+  g_dirty = !render();
   g_lastBlinkMs = millis();
 }
 
@@ -87,9 +233,22 @@ void loop() {
   }
 
   if (g_dirty) {
-    render();
-    g_dirty = false;
+    g_dirty = !render();
   }
 }
-}  // namespace Display
 
+uint32_t msUntilUpdate(uint32_t nowMs) {
+  if (g_dirty) {
+    return 0;
+  }
+  if (!g_bleActive) {
+    return kNoUpdate;
+  }
+  const uint32_t elapsed = nowMs - g_lastBlinkMs;
+  return elapsed >= kBlinkIntervalMs ? 0 : kBlinkIntervalMs - elapsed;
+}
+
+const Stats& stats() { return g_stats; }
+
+void resetStats() { g_stats = Stats(); }
+}  // namespace Display
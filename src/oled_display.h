@@ -3,14 +3,36 @@
 #include <Arduino.h>
 
 namespace Display {
+struct Stats {
+  uint32_t renders = 0;
+  uint32_t fullFrames = 0;  // renders que reenviaron todo el panel
+  uint32_t deferred = 0;    // renders aplazados por bus I2C ocupado
+  uint32_t tilesSent = 0;
+  uint32_t i2cBytes = 0;    // estimados, ver oled_display.cpp
+  uint32_t lastRenderUs = 0;
+  uint32_t maxRenderUs = 0;
+  uint64_t totalRenderUs = 0;
+};
+
+// Solo registra los pines en I2cBus; el panel arranca en el primer render.
 void begin();
 
 void setConnectionStatus(bool connected);
 
 void setBleActive(bool active);
 
+// Redibuja y reenvia el panel completo.
 void forceRender();
 
 void loop();
-}
 
+constexpr uint32_t kNoUpdate = UINT32_MAX;
+
+// Cuanto falta para que loop() tenga algo que hacer: 0 con un cambio
+// pendiente, el resto del parpadeo con BLE activo y kNoUpdate si no hay nada.
+uint32_t msUntilUpdate(uint32_t nowMs);
+
+const Stats& stats();
+
+void resetStats();
+}
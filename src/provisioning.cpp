@@ -5,18 +5,21 @@
 #include <BLEDevice.h>
 #include <BLEServer.h>
 #include <BLEUtils.h>
+#include <SPIFFS.h>
+#include <esp_attr.h>
+#include <esp_system.h>
 
-#include <algorithm>
-#include <cctype>
 #include <cstdio>
-#include <cstdlib>
 #include <cstring>
-#include <string>
-#include <vector>
-
-#include "freertos/FreeRTOS.h"
+#include <string_view>
 
 #include "Config.hpp"
+#include "chunk_transfer.h"
+#include "credentials_parser.h"
+#include "heap_monitor.h"
+#include "log.h"
+#include "scheduler.h"
+#include "spsc_ring.h"
 
 namespace Provisioning
 {
@@ -24,6 +27,8 @@ namespace Provisioning
   {
     constexpr char kServiceUuid[] = "12345678-1234-1234-1234-1234567890ab";
     constexpr char kCharacteristicUuid[] = "87654321-4321-4321-4321-0987654321ba";
+    constexpr char kChunkCharacteristicUuid[] = "87654321-4321-4321-4321-0987654321bb";
+    constexpr uint16_t kPreferredMtu = 517;
     constexpr uint16_t kInvalidConnId = 0xFFFF;
 
     BLEServer *g_server = nullptr;
@@ -39,17 +44,17 @@ namespace Provisioning
     bool g_bleDeviceInitialized = false;
     uint32_t g_bootMillis = 0;
     bool g_windowWarningLogged = false;
+    bool g_released = false;
+    bool g_bootRequestChecked = false;
+    bool g_bootedForProvisioning = false;
+    ReleaseInfo g_releaseInfo;
+    uint32_t g_bringUpUs = 0;
+
+    // Sobrevive a esp_restart(): pide un arranque con BLE y sesion abierta.
+    constexpr uint32_t kBleBootMagic = 0xB1EB007Au;
+    RTC_NOINIT_ATTR uint32_t g_bleBootRequest;
 
     constexpr size_t kMaxNotifyLength = 64;
-    constexpr size_t kMaxSsidLength = 33;     // 32 + null
-    constexpr size_t kMaxPasswordLength = 65; // 64 + null (WPA2 max)
-    constexpr size_t kMaxUserIdLength = 65;   // accommodate UUID or custom id
-    constexpr size_t kMaxDeviceIdLength = 65;
-    constexpr size_t kMaxEndpointLength = 129;
-    constexpr size_t kMaxRegionLength = 33;
-    constexpr size_t kMaxEnvLength = 17;
-    constexpr size_t kMaxThingNameLength = 65;
-    constexpr size_t kMaxProvisionTokenLength = 65;
     constexpr uint32_t kProvisioningWindowMs = 10UL * 60UL * 1000UL;
     constexpr int kProvisioningButtonPin = 0;
 
@@ -58,367 +63,170 @@ namespace Provisioning
       char message[kMaxNotifyLength];
     };
 
-    struct CredentialsPayload
-    {
-      char ssid[kMaxSsidLength];
-      char password[kMaxPasswordLength];
-      char userId[kMaxUserIdLength];
-      char deviceId[kMaxDeviceIdLength];
-      char endpoint[kMaxEndpointLength];
-      char region[kMaxRegionLength];
-      char environment[kMaxEnvLength];
-      char thingName[kMaxThingNameLength];
-      char provisionToken[kMaxProvisionTokenLength];
-      int32_t awsPort;
-    };
+    using CredentialsParser::CredentialsPayload;
 
-    portMUX_TYPE g_queueMux = portMUX_INITIALIZER_UNLOCKED;
-    volatile bool g_pendingNotify = false;
-    volatile bool g_pendingCredentials = false;
-    NotifyPayload g_notifyBuffer = {};
-    CredentialsPayload g_credentialsBuffer = {};
+    constexpr size_t kNotifyRingSize = 8;
+    constexpr size_t kCredentialsRingSize = 2;
 
-    struct ParsedCredentials
-    {
-      bool valid = false;
-      String ssid;
-      String password;
-      String userId;
-      String deviceId;
-      String endpoint;
-      String region;
-      String environment;
-      String thingName;
-      String provisionToken;
-      int32_t awsPort = 0;
-      bool awsPortProvided = false;
-      String error;
-    };
+    // Productor: tarea BLE (callbacks). Consumidor: loop().
+    SpscRing<NotifyPayload, kNotifyRingSize> g_notifyRing;
+    SpscRing<CredentialsPayload, kCredentialsRingSize> g_credentialsRing;
+    // Solo la tarea BLE la modifica, salvo release() desde loop() cuando hay
+    // un certificado completo pendiente de escribir.
+    ChunkTransfer::State g_transfer;
+    volatile bool g_pendingCertificate = false;
 
-    bool isWhitespace(char c)
-    {
-      return c == '\r' || c == '\n' || c == '\t' || c == ' ';
-    }
-
-    void trim(std::string &text)
+    void queueNotify(const char *message)
     {
-      while (!text.empty() && isWhitespace(text.front()))
-      {
-        text.erase(text.begin());
-      }
-      while (!text.empty() && isWhitespace(text.back()))
+      if (!message)
       {
-        text.pop_back();
+        return;
       }
+      NotifyPayload payload;
+      strncpy(payload.message, message, sizeof(payload.message) - 1);
+      payload.message[sizeof(payload.message) - 1] = '\0';
+      g_notifyRing.push(payload);
+      Scheduler::wake();
     }
 
-    std::vector<std::string> splitTokens(const std::string &payload)
+    void queueCredentials(const CredentialsPayload &payload)
     {
-      std::vector<std::string> tokens;
-      size_t start = 0;
-      while (start < payload.size())
-      {
-        size_t end = payload.find('\n', start);
-        if (end == std::string::npos)
-        {
-          end = payload.size();
-        }
-        tokens.emplace_back(payload.substr(start, end - start));
-        start = end + 1;
-      }
-      return tokens;
+      g_credentialsRing.push(payload);
+      Scheduler::wake();
     }
 
-    bool isValidDeviceId(const String &id)
+    void notify(const String &message)
     {
-      if (id.isEmpty())
-      {
-        return true;
-      }
-      if (id.length() > 32)
+      if (!g_characteristic)
       {
-        return false;
+        return;
       }
-      for (size_t i = 0; i < id.length(); ++i)
+      g_characteristic->setValue(message.c_str());
+      if (g_centralConnected)
       {
-        const char c = id[i];
-        const bool allowed = (c >= '0' && c <= '9') ||
-                             (c >= 'a' && c <= 'z') ||
-                             (c >= 'A' && c <= 'Z') ||
-                             c == '-' || c == '_';
-        if (!allowed)
-        {
-          return false;
-        }
+        g_characteristic->notify();
       }
-      return true;
     }
 
-    bool isValidPort(int32_t port)
+    void handleCredentials(std::string_view value)
     {
-      return port > 0 && port < 65536;
-    }
+      CredentialsPayload payload;
+      const CredentialsParser::Error error = CredentialsParser::parse(value, payload);
 
-    bool isValidLength(const String &value, size_t maxLen)
-    {
-      return value.length() < maxLen;
+      if (error != CredentialsParser::Error::NONE)
+      {
+        char message[kMaxNotifyLength];
+        snprintf(message, sizeof(message), "error:%s", CredentialsParser::errorName(error));
+        queueNotify(message);
+        return;
+      }
+
+      queueNotify("credenciales");
+      queueCredentials(payload);
     }
 
-    ParsedCredentials parseCredentials(const std::string &raw)
+    class ProvisioningCallbacks : public BLECharacteristicCallbacks
     {
-      ParsedCredentials result;
-      if (raw.empty())
+      void onWrite(BLECharacteristic *characteristic) override
       {
-        result.error = "vacio";
-        return result;
+        // getData() evita la copia a std::string de getValue(): nada de heap
+        // en la tarea de Bluedroid.
+        handleCredentials(std::string_view(reinterpret_cast<const char *>(characteristic->getData()),
+                                           characteristic->getLength()));
       }
+    };
 
-      std::string payload = raw;
-      payload.erase(std::remove(payload.begin(), payload.end(), '\r'), payload.end());
-      std::replace(payload.begin(), payload.end(), '|', '\n');
-
-      const bool keyValueMode = payload.find('=') != std::string::npos;
-      std::vector<std::string> tokens = splitTokens(payload);
-
-      if (keyValueMode)
+    class ChunkCallbacks : public BLECharacteristicCallbacks
+    {
+      void onWrite(BLECharacteristic *characteristic) override
       {
-        for (std::string token : tokens)
+        const ChunkTransfer::Result result = ChunkTransfer::handleFrame(
+            g_transfer, characteristic->getData(), characteristic->getLength());
+        char message[kMaxNotifyLength];
+        switch (result)
         {
-          trim(token);
-          if (token.empty())
-          {
-            continue;
-          }
-          size_t eq = token.find('=');
-          if (eq == std::string::npos)
-          {
-            continue;
-          }
-
-          std::string key(token.begin(), token.begin() + eq);
-          std::string value(token.begin() + eq + 1, token.end());
-          trim(key);
-          trim(value);
-          if (key.empty())
-          {
-            continue;
-          }
-          std::transform(key.begin(), key.end(), key.begin(),
-                         [](unsigned char c)
-                         { return static_cast<char>(std::tolower(c)); });
-          String valueStr(value.c_str());
-
-          if (key == "ssid" || key == "wifi_ssid")
-          {
-            result.ssid = valueStr;
-          }
-          else if (key == "password" || key == "pass" || key == "wifi_password")
-          {
-            result.password = valueStr;
-          }
-          else if (key == "user_id" || key == "userid")
-          {
-            result.userId = valueStr;
-          }
-          else if (key == "device_id")
-          {
-            result.deviceId = valueStr;
-          }
-          else if (key == "endpoint" || key == "aws_endpoint")
-          {
-            result.endpoint = valueStr;
-          }
-          else if (key == "region" || key == "aws_region")
-          {
-            result.region = valueStr;
-          }
-          else if (key == "env" || key == "environment")
-          {
-            result.environment = valueStr;
-          }
-          else if (key == "thing" || key == "thingname" || key == "thing_name")
-          {
-            result.thingName = valueStr;
-          }
-          else if (key == "token" || key == "provision_token")
-          {
-            result.provisionToken = valueStr;
-          }
-          else if (key == "aws_port" || key == "port")
+        case ChunkTransfer::Result::CHUNK_OK:
+        case ChunkTransfer::Result::DUPLICATE:
+          // Write-without-response: los chunks correctos no se confirman.
+          return;
+        case ChunkTransfer::Result::STARTED:
+          snprintf(message, sizeof(message), "chunk:listo:%u",
+                   static_cast<unsigned>(g_transfer.chunkCount));
+          break;
+        case ChunkTransfer::Result::MISSING_CHUNKS:
+          snprintf(message, sizeof(message), "chunk:falta:%u",
+                   static_cast<unsigned>(ChunkTransfer::firstMissing(g_transfer)));
+          break;
+        case ChunkTransfer::Result::COMPLETE:
+          if (g_transfer.target == ChunkTransfer::Target::CREDENTIALS)
           {
-            result.awsPort = atoi(value.c_str());
-            result.awsPortProvided = true;
+            handleCredentials(std::string_view(reinterpret_cast<const char *>(g_transfer.buffer),
+                                               g_transfer.totalLength));
+            ChunkTransfer::release(g_transfer);
+            return;
           }
+          // SPIFFS es lento para la tarea BLE: escribe loop().
+          g_pendingCertificate = true;
+          Scheduler::wake();
+          return;
+        case ChunkTransfer::Result::ABORTED:
+          snprintf(message, sizeof(message), "chunk:cancelado");
+          break;
+        default:
+          snprintf(message, sizeof(message), "chunk:error:%s", ChunkTransfer::resultName(result));
+          break;
         }
+        queueNotify(message);
       }
-      else
-      {
-        if (!tokens.empty())
-        {
-          std::string ssid(tokens[0]);
-          trim(ssid);
-          result.ssid = String(ssid.c_str());
-        }
-        if (tokens.size() > 1)
-        {
-          std::string password(tokens[1]);
-          trim(password);
-          result.password = String(password.c_str());
-        }
-        if (tokens.size() > 2)
-        {
-          std::string user(tokens[2]);
-          trim(user);
-          result.userId = String(user.c_str());
-        }
-      }
-
-      if (result.ssid.isEmpty())
-      {
-        result.error = "ssid";
-        return result;
-      }
-
-      if (!isValidLength(result.ssid, kMaxSsidLength))
-      {
-        result.error = "ssid_len";
-        return result;
-      }
-
-      if (!isValidLength(result.password, kMaxPasswordLength))
-      {
-        result.error = "password_len";
-        return result;
-      }
-
-      if (!isValidLength(result.userId, kMaxUserIdLength))
-      {
-        result.error = "user_id_len";
-        return result;
-      }
-
-      if (!isValidDeviceId(result.deviceId))
-      {
-        result.error = "device_id";
-        return result;
-      }
-
-      if (!isValidLength(result.deviceId, kMaxDeviceIdLength))
-      {
-        result.error = "device_id_len";
-        return result;
-      }
-
-      if (!isValidLength(result.endpoint, kMaxEndpointLength))
-      {
-        result.error = "endpoint_len";
-        return result;
-      }
-
-      if (!isValidLength(result.region, kMaxRegionLength))
-      {
-        result.error = "region_len";
-        return result;
-      }
-
-      if (!isValidLength(result.environment, kMaxEnvLength))
-      {
-        result.error = "environment_len";
-        return result;
-      }
-
-      if (!isValidLength(result.thingName, kMaxThingNameLength))
-      {
-        result.error = "thing_name_len";
-        return result;
-      }
-
-      if (!isValidLength(result.provisionToken, kMaxProvisionTokenLength))
-      {
-        result.error = "token_len";
-        return result;
-      }
-
-      if (result.awsPortProvided && !isValidPort(result.awsPort))
-      {
-        result.error = "aws_port";
-        return result;
-      }
-
-      result.valid = true;
-      return result;
-    }
+    };
 
-    void queueNotify(const char *message)
+    Config::Key certificateKey(ChunkTransfer::Target target)
     {
-      if (!message)
+      switch (target)
       {
-        return;
+      case ChunkTransfer::Target::CERT_ROOT:
+        return Config::Key::CERT_ROOT;
+      case ChunkTransfer::Target::CERT_DEVICE:
+        return Config::Key::CERT_DEVICE;
+      default:
+        return Config::Key::CERT_PRIVATE;
       }
-      portENTER_CRITICAL(&g_queueMux);
-      strncpy(g_notifyBuffer.message, message, sizeof(g_notifyBuffer.message) - 1);
-      g_notifyBuffer.message[sizeof(g_notifyBuffer.message) - 1] = '\0';
-      g_pendingNotify = true;
-      portEXIT_CRITICAL(&g_queueMux);
     }
 
-    void queueCredentials(const CredentialsPayload &payload)
+    // Escribe en un temporal y lo renombra: un corte no deja un PEM a medias.
+    bool writeCertificate()
     {
-      portENTER_CRITICAL(&g_queueMux);
-      g_credentialsBuffer = payload;
-      g_pendingCredentials = true;
-      portEXIT_CRITICAL(&g_queueMux);
-    }
-
-    void notify(const String &message)
-    {
-      if (!g_characteristic)
+      const std::string path = Config::getString(certificateKey(g_transfer.target));
+      const std::string tmpPath = path + ".tmp";
+      File file = SPIFFS.open(tmpPath.c_str(), "w");
+      if (!file)
       {
-        return;
+        return false;
       }
-      g_characteristic->setValue(message.c_str());
-      if (g_centralConnected)
+      const bool written = file.write(g_transfer.buffer, g_transfer.totalLength) == g_transfer.totalLength;
+      file.close();
+      if (!written)
       {
-        g_characteristic->notify();
+        SPIFFS.remove(tmpPath.c_str());
+        return false;
       }
-    }
-
-    class ProvisioningCallbacks : public BLECharacteristicCallbacks
-    {
-      void onWrite(BLECharacteristic *characteristic) override
+      if (SPIFFS.exists(path.c_str()))
       {
-        const std::string value = characteristic->getValue();
-        ParsedCredentials credentials = parseCredentials(value);
-
-        if (!credentials.valid)
-        {
-          char message[kMaxNotifyLength];
-          snprintf(message, sizeof(message), "error:%s", credentials.error.c_str());
-          queueNotify(message);
-          return;
-        }
-
-        queueNotify("credenciales");
-
-        CredentialsPayload payload = {};
-        snprintf(payload.ssid, sizeof(payload.ssid), "%s", credentials.ssid.c_str());
-        snprintf(payload.password, sizeof(payload.password), "%s", credentials.password.c_str());
-        snprintf(payload.userId, sizeof(payload.userId), "%s", credentials.userId.c_str());
-        snprintf(payload.deviceId, sizeof(payload.deviceId), "%s", credentials.deviceId.c_str());
-        snprintf(payload.endpoint, sizeof(payload.endpoint), "%s", credentials.endpoint.c_str());
-        snprintf(payload.region, sizeof(payload.region), "%s", credentials.region.c_str());
-        snprintf(payload.environment, sizeof(payload.environment), "%s", credentials.environment.c_str());
-        snprintf(payload.thingName, sizeof(payload.thingName), "%s", credentials.thingName.c_str());
-        snprintf(payload.provisionToken, sizeof(payload.provisionToken), "%s", credentials.provisionToken.c_str());
-        payload.awsPort = credentials.awsPort;
-        queueCredentials(payload);
+        SPIFFS.remove(path.c_str());
       }
-    };
+      const bool renamed = SPIFFS.rename(tmpPath.c_str(), path.c_str());
+      LOG_INFO(BLE, "Certificado %s (%lu bytes) %s\n", path.c_str(),
+               static_cast<unsigned long>(g_transfer.totalLength),
+               renamed ? "guardado" : "no se pudo guardar");
+      return renamed;
+    }
 
     class ServerCallbacks : public BLEServerCallbacks
     {
       void onConnect(BLEServer *server) override
       {
+        // Los callbacks corren en la tarea BTC: sus reservas son de BLE.
+        HeapMonitor::tagTask(xTaskGetCurrentTaskHandle(), HeapMonitor::Tag::PROVISIONING);
         g_centralConnected = true;
         g_connId = server->getConnId();
       }
@@ -427,11 +235,26 @@ namespace Provisioning
       {
         g_centralConnected = false;
         g_connId = kInvalidConnId;
+        if (!g_transfer.complete)
+        {
+          ChunkTransfer::release(g_transfer);
+        }
+        ChunkTransfer::setMtu(g_transfer, ChunkTransfer::kDefaultMtu);
         if (g_sessionActive)
         {
           g_restartAdvertising = true;
+          Scheduler::wake();
         }
       }
+
+      void onMtuChanged(BLEServer *server, esp_ble_gatts_cb_param_t *param) override
+      {
+        ChunkTransfer::setMtu(g_transfer, param->mtu.mtu);
+        char message[kMaxNotifyLength];
+        snprintf(message, sizeof(message), "mtu:%u",
+                 static_cast<unsigned>(ChunkTransfer::maxChunkSize(g_transfer)));
+        queueNotify(message);
+      }
     };
 
     void configureAdvertising()
@@ -456,22 +279,14 @@ namespace Provisioning
       g_advertising->setMaxPreferred(0x12);
     }
 
-    void ensureInitialized(const String &deviceId)
+    void ensureInitialized()
     {
-      if (g_bootMillis == 0)
-      {
-        g_bootMillis = millis();
-      }
-
-      g_deviceId = deviceId;
       if (!g_bleDeviceInitialized)
       {
         BLEDevice::init(g_deviceId.c_str());
+        BLEDevice::setMTU(kPreferredMtu);
         g_bleDeviceInitialized = true;
       }
-      else
-      {
-      }
 
       if (!g_server)
       {
@@ -487,6 +302,11 @@ namespace Provisioning
         g_characteristic->setCallbacks(new ProvisioningCallbacks());
         g_characteristic->setValue("inactivo");
 
+        BLECharacteristic *chunkCharacteristic = service->createCharacteristic(
+            kChunkCharacteristicUuid,
+            BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_WRITE_NR);
+        chunkCharacteristic->setCallbacks(new ChunkCallbacks());
+
         service->start();
 
         g_advertising = BLEDevice::getAdvertising();
@@ -504,14 +324,55 @@ namespace Provisioning
 
   void begin(const String &deviceId, CredentialsCallback callback)
   {
+    if (!g_bootRequestChecked)
+    {
+      g_bootRequestChecked = true;
+      g_bootedForProvisioning =
+          esp_reset_reason() == ESP_RST_SW && g_bleBootRequest == kBleBootMagic;
+      g_bleBootRequest = 0;
+    }
+    if (g_bootMillis == 0)
+    {
+      g_bootMillis = millis();
+    }
     g_callback = callback;
-    ensureInitialized(deviceId);
-    notify("inactivo");
+    g_deviceId = deviceId;
+    // El stack se levanta en bringUp()/startBle(); si ya esta arriba solo
+    // se actualiza el nombre anunciado.
+    if (g_initialized)
+    {
+      configureAdvertising();
+      notify("inactivo");
+    }
+  }
+
+  bool bringUp()
+  {
+    HeapMonitor::Scope heapScope(HeapMonitor::Tag::PROVISIONING);
+    if (g_released)
+    {
+      // Bluedroid no se puede reiniciar sin reiniciar el chip.
+      return false;
+    }
+    if (!g_initialized)
+    {
+      const uint32_t startUs = micros();
+      ensureInitialized();
+      g_bringUpUs = micros() - startUs;
+      LOG_INFO(BLE, "Stack iniciado en %lu ms\n",
+               static_cast<unsigned long>(g_bringUpUs / 1000));
+      notify("inactivo");
+    }
+    return g_initialized;
   }
 
+  bool isUp() { return g_initialized; }
+
+  uint32_t bringUpMs() { return g_bringUpUs / 1000; }
+
   bool startBle()
   {
-    if (!g_initialized || !g_advertising)
+    if (!bringUp() || !g_advertising)
     {
       return false;
     }
@@ -548,6 +409,51 @@ namespace Provisioning
 
   bool isActive() { return g_sessionActive; }
 
+  bool releaseStack()
+  {
+    if (g_released || !g_bleDeviceInitialized || g_sessionActive || g_pendingCertificate)
+    {
+      return false;
+    }
+
+    g_releaseInfo.heapBefore = esp_get_free_heap_size();
+    if (g_advertising)
+    {
+      g_advertising->stop();
+    }
+    // true: libera tambien la memoria del controlador (esp_bt_controller_mem_release).
+    BLEDevice::deinit(true);
+    ChunkTransfer::release(g_transfer);
+    g_server = nullptr;
+    g_characteristic = nullptr;
+    g_advertising = nullptr;
+    g_initialized = false;
+    g_bleDeviceInitialized = false;
+    g_released = true;
+    g_releaseInfo.released = true;
+    g_releaseInfo.heapAfter = esp_get_free_heap_size();
+    LOG_INFO(BLE, "Bluedroid liberado: heap %lu -> %lu bytes (+%ld)\n",
+             static_cast<unsigned long>(g_releaseInfo.heapBefore),
+             static_cast<unsigned long>(g_releaseInfo.heapAfter),
+             static_cast<long>(g_releaseInfo.heapAfter) -
+                 static_cast<long>(g_releaseInfo.heapBefore));
+    return true;
+  }
+
+  bool isReleased() { return g_released; }
+
+  ReleaseInfo releaseInfo() { return g_releaseInfo; }
+
+  void rebootForProvisioning()
+  {
+    LOG_INFO(BLE, "Reiniciando con BLE para aprovisionar\n");
+    g_bleBootRequest = kBleBootMagic;
+    Serial.flush();
+    esp_restart();
+  }
+
+  bool bootedForProvisioning() { return g_bootedForProvisioning; }
+
   bool isProvisioningAllowed()
   {
     if (g_bootMillis == 0)
@@ -564,7 +470,7 @@ namespace Provisioning
     }
     if (!g_windowWarningLogged)
     {
-      Serial.println("[BLE] Provisioning no permitido (fuera de ventana)");
+      LOG_WARN(BLE, "Provisioning no permitido (fuera de ventana)\n");
       g_windowWarningLogged = true;
     }
     return false;
@@ -572,34 +478,31 @@ namespace Provisioning
 
   void notifyStatus(const String &message) { notify(message); }
 
+  QueueStats queueStats()
+  {
+    QueueStats stats;
+    stats.notifyDelivered = g_notifyRing.popped();
+    stats.notifyDropped = g_notifyRing.dropped();
+    stats.notifyHighWater = g_notifyRing.highWater();
+    stats.credentialsDropped = g_credentialsRing.dropped();
+    return stats;
+  }
+
   void loop()
   {
-    if (g_pendingNotify)
+    HeapMonitor::Scope heapScope(HeapMonitor::Tag::PROVISIONING);
+    NotifyPayload notice;
+    while (g_notifyRing.pop(notice))
     {
-      NotifyPayload payload = {};
-      portENTER_CRITICAL(&g_queueMux);
-      if (g_pendingNotify)
-      {
-        payload = g_notifyBuffer;
-        g_pendingNotify = false;
-      }
-      portEXIT_CRITICAL(&g_queueMux);
-      if (payload.message[0])
+      if (notice.message[0])
       {
-        notify(String(payload.message));
+        notify(String(notice.message));
       }
     }
 
-    if (g_pendingCredentials && g_callback)
+    CredentialsPayload payload;
+    while (g_callback && g_credentialsRing.pop(payload))
     {
-      CredentialsPayload payload = {};
-      portENTER_CRITICAL(&g_queueMux);
-      if (g_pendingCredentials)
-      {
-        payload = g_credentialsBuffer;
-        g_pendingCredentials = false;
-      }
-      portEXIT_CRITICAL(&g_queueMux);
       if (payload.ssid[0])
       {
         CredentialsData data;
@@ -617,6 +520,14 @@ namespace Provisioning
       }
     }
 
+    if (g_pendingCertificate)
+    {
+      const bool written = writeCertificate();
+      ChunkTransfer::release(g_transfer);
+      g_pendingCertificate = false;
+      notify(written ? "cert:ok" : "cert:error");
+    }
+
     if (g_restartAdvertising && g_sessionActive && g_advertising)
     {
       g_restartAdvertising = false;
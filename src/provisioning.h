@@ -19,20 +19,59 @@ struct CredentialsData
   int32_t awsPort = 0;
 };
 
+// Colas de la tarea BLE hacia loop(); los descartes indican que loop() no
+// las vacio a tiempo.
+struct QueueStats
+{
+  uint32_t notifyDelivered = 0;
+  uint32_t notifyDropped = 0;
+  uint32_t notifyHighWater = 0;
+  uint32_t credentialsDropped = 0;
+};
+
+struct ReleaseInfo
+{
+  bool released = false;
+  uint32_t heapBefore = 0;
+  uint32_t heapAfter = 0;
+};
+
 using CredentialsCallback = std::function<void(const CredentialsData &)>;
 
+// Solo registra identidad y callback: el stack BLE no se levanta hasta
+// bringUp() o startBle(), asi un equipo aprovisionado va directo a Wi-Fi.
 void begin(const String &deviceId, CredentialsCallback callback);
 
+// Inicializa Bluedroid, el servidor GATT y el advertising si no lo estaban.
+bool bringUp();
+bool isUp();
+// Duracion de la ultima puesta en marcha del stack.
+uint32_t bringUpMs();
+
 bool startBle();
 
 void stopBle();
 
 bool isActive();
 
+// Desinicializa Bluedroid y libera la memoria del controlador BLE. Solo sin
+// sesion activa; hasta reiniciar, startBle() falla y las notificaciones se
+// ignoran.
+bool releaseStack();
+bool isReleased();
+ReleaseInfo releaseInfo();
+// Reinicia el chip marcando en RTC que el siguiente arranque debe abrir una
+// sesion BLE (la ventana de provisioning vuelve a contar desde el boot).
+void rebootForProvisioning();
+bool bootedForProvisioning();
+
 bool isProvisioningAllowed();
 
+// Desde loop(): notifica en el momento, sin pasar por la cola.
 void notifyStatus(const String &message);
 
+QueueStats queueStats();
+
 void loop();
 }
 
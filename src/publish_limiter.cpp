@@ -0,0 +1,179 @@
+#include "publish_limiter.h"
+
+#include <cstddef>
+
+#ifndef PUBLISH_LIMIT_CONTROL_BURST
+#define PUBLISH_LIMIT_CONTROL_BURST 5
+#endif
+
+#ifndef PUBLISH_LIMIT_CONTROL_INTERVAL_MS
+#define PUBLISH_LIMIT_CONTROL_INTERVAL_MS 2000
+#endif
+
+#ifndef PUBLISH_LIMIT_TELEMETRY_BURST
+#define PUBLISH_LIMIT_TELEMETRY_BURST 10
+#endif
+
+#ifndef PUBLISH_LIMIT_TELEMETRY_INTERVAL_MS
+#define PUBLISH_LIMIT_TELEMETRY_INTERVAL_MS 1000
+#endif
+
+#ifndef PUBLISH_LIMIT_HEARTBEAT_BURST
+#define PUBLISH_LIMIT_HEARTBEAT_BURST 2
+#endif
+
+#ifndef PUBLISH_LIMIT_HEARTBEAT_INTERVAL_MS
+#define PUBLISH_LIMIT_HEARTBEAT_INTERVAL_MS 15000
+#endif
+
+#ifndef PUBLISH_LIMIT_DIAG_BURST
+#define PUBLISH_LIMIT_DIAG_BURST 2
+#endif
+
+#ifndef PUBLISH_LIMIT_DIAG_INTERVAL_MS
+#define PUBLISH_LIMIT_DIAG_INTERVAL_MS 1000
+#endif
+
+namespace PublishLimiter
+{
+namespace
+{
+constexpr size_t kClassCount = static_cast<size_t>(TopicClass::COUNT);
+
+struct Bucket
+{
+  BucketConfig config = {1, 1000};
+  uint32_t tokens = 0;
+  uint32_t lastRefillMs = 0;
+  Stats stats;
+};
+
+Bucket g_buckets[kClassCount];
+
+Bucket *bucketFor(TopicClass cls)
+{
+  const size_t index = static_cast<size_t>(cls);
+  return index < kClassCount ? &g_buckets[index] : nullptr;
+}
+
+void refill(Bucket &bucket, uint32_t nowMs)
+{
+  if (bucket.tokens >= bucket.config.burst)
+  {
+    bucket.lastRefillMs = nowMs;
+    return;
+  }
+  const uint32_t elapsed = nowMs - bucket.lastRefillMs;
+  const uint32_t added = elapsed / bucket.config.refillIntervalMs;
+  if (added == 0)
+  {
+    return;
+  }
+  const uint32_t room = bucket.config.burst - bucket.tokens;
+  if (added >= room)
+  {
+    bucket.tokens = bucket.config.burst;
+    bucket.lastRefillMs = nowMs;
+    return;
+  }
+  bucket.tokens += added;
+  bucket.lastRefillMs += added * bucket.config.refillIntervalMs;
+}
+} // namespace
+
+void begin(uint32_t nowMs)
+{
+  configure(TopicClass::CONTROL,
+            {PUBLISH_LIMIT_CONTROL_BURST, PUBLISH_LIMIT_CONTROL_INTERVAL_MS}, nowMs);
+  configure(TopicClass::TELEMETRY,
+            {PUBLISH_LIMIT_TELEMETRY_BURST, PUBLISH_LIMIT_TELEMETRY_INTERVAL_MS}, nowMs);
+  configure(TopicClass::HEARTBEAT,
+            {PUBLISH_LIMIT_HEARTBEAT_BURST, PUBLISH_LIMIT_HEARTBEAT_INTERVAL_MS}, nowMs);
+  configure(TopicClass::DIAG,
+            {PUBLISH_LIMIT_DIAG_BURST, PUBLISH_LIMIT_DIAG_INTERVAL_MS}, nowMs);
+}
+
+void configure(TopicClass cls, const BucketConfig &config, uint32_t nowMs)
+{
+  Bucket *bucket = bucketFor(cls);
+  if (!bucket)
+  {
+    return;
+  }
+  bucket->config.burst = config.burst > 0 ? config.burst : 1;
+  bucket->config.refillIntervalMs = config.refillIntervalMs > 0 ? config.refillIntervalMs : 1;
+  bucket->tokens = bucket->config.burst;
+  bucket->lastRefillMs = nowMs;
+}
+
+bool tryAcquire(TopicClass cls, uint32_t nowMs)
+{
+  Bucket *bucket = bucketFor(cls);
+  if (!bucket)
+  {
+    return false;
+  }
+  refill(*bucket, nowMs);
+  if (bucket->tokens == 0)
+  {
+    return false;
+  }
+  bucket->tokens--;
+  bucket->stats.allowed++;
+  return true;
+}
+
+void markDeferred(TopicClass cls)
+{
+  Bucket *bucket = bucketFor(cls);
+  if (bucket)
+  {
+    bucket->stats.deferred++;
+  }
+}
+
+uint32_t msUntilAvailable(TopicClass cls, uint32_t nowMs)
+{
+  Bucket *bucket = bucketFor(cls);
+  if (!bucket)
+  {
+    return 0;
+  }
+  refill(*bucket, nowMs);
+  if (bucket->tokens > 0)
+  {
+    return 0;
+  }
+  const uint32_t elapsed = nowMs - bucket->lastRefillMs;
+  return elapsed >= bucket->config.refillIntervalMs ? 0 : bucket->config.refillIntervalMs - elapsed;
+}
+
+Stats stats(TopicClass cls)
+{
+  Bucket *bucket = bucketFor(cls);
+  if (!bucket)
+  {
+    return Stats();
+  }
+  Stats out = bucket->stats;
+  out.tokens = bucket->tokens;
+  return out;
+}
+
+const char *name(TopicClass cls)
+{
+  switch (cls)
+  {
+  case TopicClass::CONTROL:
+    return "ctl";
+  case TopicClass::TELEMETRY:
+    return "tel";
+  case TopicClass::HEARTBEAT:
+    return "hb";
+  case TopicClass::DIAG:
+    return "diag";
+  default:
+    return "?";
+  }
+}
+} // namespace PublishLimiter
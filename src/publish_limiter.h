@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+// Token buckets por clase de topic delante de esp_mqtt_client_publish.
+// El tiempo se pasa explicito para poder usarlo en host.
+namespace PublishLimiter
+{
+enum class TopicClass : uint8_t
+{
+  CONTROL = 0, // claim, sensor_registry
+  TELEMETRY,
+  HEARTBEAT,
+  DIAG, // metrics y core dump; prioridad baja
+  COUNT,
+};
+
+struct BucketConfig
+{
+  uint32_t burst;            // tokens maximos acumulados
+  uint32_t refillIntervalMs; // 1 token cada refillIntervalMs
+};
+
+struct Stats
+{
+  uint32_t allowed = 0;
+  uint32_t deferred = 0;
+  uint32_t tokens = 0;
+};
+
+void begin(uint32_t nowMs);
+void configure(TopicClass cls, const BucketConfig &config, uint32_t nowMs);
+bool tryAcquire(TopicClass cls, uint32_t nowMs);
+void markDeferred(TopicClass cls);
+uint32_t msUntilAvailable(TopicClass cls, uint32_t nowMs);
+Stats stats(TopicClass cls);
+const char *name(TopicClass cls);
+} // namespace PublishLimiter
@@ -0,0 +1,268 @@
+#include "scheduler.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "log.h"
+#include "loop_profiler.h"
+#include "metrics.h"
+
+namespace Scheduler
+{
+namespace
+{
+constexpr size_t kMaxJobs = 24;
+
+struct Job
+{
+  JobFn fn = nullptr;
+  uint32_t periodMs = 0;
+  uint32_t deadlineMs = 0;
+  bool armed = false;
+  LoopProfiler::SlotId profSlot = LoopProfiler::kInvalidSlot;
+  JobStats stats;
+};
+
+Job g_jobs[kMaxJobs];
+size_t g_jobCount = 0;
+// Jobs armados ordenados por deadline ascendente.
+JobId g_queue[kMaxJobs];
+size_t g_queueLength = 0;
+TaskHandle_t g_task = nullptr;
+
+bool isBefore(uint32_t a, uint32_t b)
+{
+  return static_cast<int32_t>(a - b) < 0;
+}
+
+bool isValid(JobId id)
+{
+  return id < g_jobCount;
+}
+
+void unlink(JobId id)
+{
+  for (size_t i = 0; i < g_queueLength; ++i)
+  {
+    if (g_queue[i] != id)
+    {
+      continue;
+    }
+    for (size_t j = i + 1; j < g_queueLength; ++j)
+    {
+      g_queue[j - 1] = g_queue[j];
+    }
+    --g_queueLength;
+    break;
+  }
+  g_jobs[id].armed = false;
+}
+
+void link(JobId id, uint32_t deadlineMs)
+{
+  if (g_jobs[id].armed)
+  {
+    unlink(id);
+  }
+
+  size_t pos = g_queueLength;
+  while (pos > 0 && isBefore(deadlineMs, g_jobs[g_queue[pos - 1]].deadlineMs))
+  {
+    g_queue[pos] = g_queue[pos - 1];
+    --pos;
+  }
+  g_queue[pos] = id;
+  ++g_queueLength;
+
+  g_jobs[id].deadlineMs = deadlineMs;
+  g_jobs[id].armed = true;
+}
+} // namespace
+
+void begin()
+{
+  g_task = xTaskGetCurrentTaskHandle();
+}
+
+JobId addJob(const char *name, JobFn fn, uint32_t periodMs, int32_t firstDelayMs)
+{
+  if (!fn || g_jobCount >= kMaxJobs)
+  {
+    LOG_ERROR(SCHED, "No se pudo registrar job %s\n", name ? name : "?");
+    return kInvalidJob;
+  }
+
+  const JobId id = static_cast<JobId>(g_jobCount++);
+  Job &job = g_jobs[id];
+  job.fn = fn;
+  job.periodMs = periodMs;
+  job.stats = JobStats();
+  job.stats.name = name;
+  job.profSlot = LoopProfiler::addSlot(name);
+  if (firstDelayMs >= 0)
+  {
+    link(id, millis() + static_cast<uint32_t>(firstDelayMs));
+  }
+  return id;
+}
+
+void scheduleIn(JobId id, uint32_t delayMs)
+{
+  if (!isValid(id))
+  {
+    return;
+  }
+  link(id, millis() + delayMs);
+}
+
+void scheduleWithin(JobId id, uint32_t delayMs)
+{
+  if (!isValid(id))
+  {
+    return;
+  }
+  const uint32_t deadline = millis() + delayMs;
+  if (g_jobs[id].armed && !isBefore(deadline, g_jobs[id].deadlineMs))
+  {
+    return;
+  }
+  link(id, deadline);
+}
+
+void cancel(JobId id)
+{
+  if (!isValid(id) || !g_jobs[id].armed)
+  {
+    return;
+  }
+  unlink(id);
+}
+
+bool isArmed(JobId id)
+{
+  return isValid(id) && g_jobs[id].armed;
+}
+
+void runDue()
+{
+  // Cota para que un job que se re-arma con delay 0 no bloquee el loop.
+  for (size_t budget = kMaxJobs * 2; budget > 0 && g_queueLength > 0; --budget)
+  {
+    const JobId id = g_queue[0];
+    Job &job = g_jobs[id];
+    const uint32_t now = millis();
+    if (isBefore(now, job.deadlineMs))
+    {
+      return;
+    }
+
+    const uint32_t lateness = now - job.deadlineMs;
+    unlink(id);
+    if (job.periodMs > 0)
+    {
+      uint32_t next = job.deadlineMs + job.periodMs;
+      if (!isBefore(now, next))
+      {
+        next = now + job.periodMs;
+      }
+      link(id, next);
+    }
+
+    job.stats.runs++;
+    job.stats.lastLatenessMs = lateness;
+    job.stats.totalLatenessMs += lateness;
+    if (lateness > job.stats.maxLatenessMs)
+    {
+      job.stats.maxLatenessMs = lateness;
+    }
+    Metrics::observe(Metrics::Histogram::LOOP_LAG_MS, lateness);
+    LoopProfiler::Scope profile(job.profSlot);
+    job.fn();
+  }
+}
+
+uint32_t msUntilNextDeadline(uint32_t maxWaitMs)
+{
+  if (g_queueLength == 0)
+  {
+    return maxWaitMs;
+  }
+  const uint32_t now = millis();
+  const uint32_t deadline = g_jobs[g_queue[0]].deadlineMs;
+  if (!isBefore(now, deadline))
+  {
+    return 0;
+  }
+  const uint32_t remaining = deadline - now;
+  return remaining < maxWaitMs ? remaining : maxWaitMs;
+}
+
+void waitForWork(uint32_t maxWaitMs)
+{
+  const uint32_t waitMs = msUntilNextDeadline(maxWaitMs);
+  if (waitMs == 0)
+  {
+    return;
+  }
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+}
+
+void wake()
+{
+  if (g_task)
+  {
+    xTaskNotifyGive(g_task);
+  }
+}
+
+void IRAM_ATTR wakeFromIsr()
+{
+  if (!g_task)
+  {
+    return;
+  }
+  BaseType_t higherPriorityWoken = pdFALSE;
+  vTaskNotifyGiveFromISR(g_task, &higherPriorityWoken);
+  portYIELD_FROM_ISR(higherPriorityWoken);
+}
+
+bool stats(JobId id, JobStats &out)
+{
+  if (!isValid(id))
+  {
+    return false;
+  }
+  out = g_jobs[id].stats;
+  return true;
+}
+
+size_t jobCount() { return g_jobCount; }
+
+uint32_t maxLatenessMs()
+{
+  uint32_t worst = 0;
+  for (size_t i = 0; i < g_jobCount; ++i)
+  {
+    if (g_jobs[i].stats.maxLatenessMs > worst)
+    {
+      worst = g_jobs[i].stats.maxLatenessMs;
+    }
+  }
+  return worst;
+}
+
+void dumpStats()
+{
+  for (size_t i = 0; i < g_jobCount; ++i)
+  {
+    const JobStats &s = g_jobs[i].stats;
+    const unsigned long avg =
+        s.runs > 0 ? static_cast<unsigned long>(s.totalLatenessMs / s.runs) : 0UL;
+    LOG_RAW(SCHED, DEBUG, "[SCHED] %-12s runs=%lu late_last=%lu late_avg=%lu late_max=%lu ms\n",
+            s.name ? s.name : "?",
+            static_cast<unsigned long>(s.runs),
+            static_cast<unsigned long>(s.lastLatenessMs),
+            avg,
+            static_cast<unsigned long>(s.maxLatenessMs));
+  }
+}
+} // namespace Scheduler
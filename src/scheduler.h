@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Planificador cooperativo para la tarea de loop(): timers ordenados por
+// deadline y despertares por evento. Solo se manipula desde la tarea que
+// llamo a begin(); desde otras tareas o ISRs usar wake()/wakeFromIsr().
+namespace Scheduler
+{
+using JobFn = void (*)();
+using JobId = uint8_t;
+
+constexpr JobId kInvalidJob = 0xFF;
+
+struct JobStats
+{
+  const char *name = nullptr;
+  uint32_t runs = 0;
+  uint32_t lastLatenessMs = 0;
+  uint32_t maxLatenessMs = 0;
+  uint64_t totalLatenessMs = 0;
+};
+
+void begin();
+
+// periodMs == 0 crea un job de un solo disparo que queda desarmado hasta
+// el siguiente scheduleIn(). firstDelayMs < 0 lo crea desarmado.
+JobId addJob(const char *name, JobFn fn, uint32_t periodMs, int32_t firstDelayMs);
+void scheduleIn(JobId id, uint32_t delayMs);
+// Como scheduleIn, pero no retrasa un job que ya vence antes.
+void scheduleWithin(JobId id, uint32_t delayMs);
+void cancel(JobId id);
+bool isArmed(JobId id);
+
+void runDue();
+uint32_t msUntilNextDeadline(uint32_t maxWaitMs);
+void waitForWork(uint32_t maxWaitMs);
+
+void wake();
+void wakeFromIsr();
+
+bool stats(JobId id, JobStats &out);
+size_t jobCount();
+uint32_t maxLatenessMs();
+void dumpStats();
+} // namespace Scheduler
@@ -5,6 +5,10 @@
 #include <Wire.h>
 #include <math.h>
 
+#include "i2c_bus.h"
+#include "log.h"
+#include "metrics.h"
+
 #ifndef TOPIC_BASE
 #define TOPIC_BASE "ERROR_TOPIC/"
 #endif
@@ -18,30 +22,47 @@ constexpr uint8_t kI2cSdaPin = 8;
 constexpr uint8_t kI2cSclPin = 9;
 constexpr uint8_t kAltI2cSdaPin = 5;
 constexpr uint8_t kAltI2cSclPin = 6;
+constexpr uint32_t kI2cClockHz = 400000;
+constexpr uint8_t kSht4xAddress = 0x44;
+constexpr uint32_t kBootLockTimeoutMs = 1000;
+// Una medida de alta precision tarda ~9 ms; si la OLED tiene el bus, espera
+// como mucho a que termine su frame.
+constexpr uint32_t kReadLockTimeoutMs = 50;
 Adafruit_SHT4x g_sht4;
 bool g_initialized = false;
 bool g_available = false;
 
-void scanI2cBus(uint8_t sdaPin, uint8_t sclPin)
+// Devuelve si el SHT4x responde en esos pines.
+bool scanI2cBus(uint8_t sdaPin, uint8_t sclPin)
 {
+  I2cBus::configure(I2cBus::Client::SENSOR, sdaPin, sclPin, kI2cClockHz);
+  I2cBus::Lock lock(I2cBus::Client::SENSOR, kBootLockTimeoutMs);
+  if (!lock.owned())
+  {
+    LOG_WARN(SHT45, "Bus I2C ocupado, sin escaneo en SDA=%u SCL=%u\n", sdaPin, sclPin);
+    return false;
+  }
+
   bool foundDevice = false;
-  Wire.begin(sdaPin, sclPin);
-  Serial.printf("[SHT45] Escaneando I2C SDA=%u SCL=%u\n", sdaPin, sclPin);
+  bool foundSensor = false;
+  LOG_DEBUG(SHT45, "Escaneando I2C SDA=%u SCL=%u\n", sdaPin, sclPin);
   for (uint8_t address = 1; address < 127; ++address)
   {
     Wire.beginTransmission(address);
     const uint8_t error = Wire.endTransmission();
     if (error == 0)
     {
-      Serial.printf("[SHT45] I2C detectado en 0x%02X\n", address);
+      LOG_DEBUG(SHT45, "I2C detectado en 0x%02X\n", address);
       foundDevice = true;
+      foundSensor = foundSensor || address == kSht4xAddress;
     }
   }
 
   if (!foundDevice)
   {
-    Serial.println("[SHT45] No se detectaron dispositivos I2C");
+    LOG_WARN(SHT45, "No se detectaron dispositivos I2C\n");
   }
+  return foundSensor;
 }
 
 float saturationVpKpa(float temperatureC)
@@ -71,17 +92,27 @@ bool begin()
   }
 
   g_initialized = true;
-  scanI2cBus(kI2cSdaPin, kI2cSclPin);
-  scanI2cBus(kAltI2cSdaPin, kAltI2cSclPin);
-  Wire.begin(kI2cSdaPin, kI2cSclPin);
-  g_available = g_sht4.begin();
+  const bool onPrimary = scanI2cBus(kI2cSdaPin, kI2cSclPin);
+  const bool onAlt = scanI2cBus(kAltI2cSdaPin, kAltI2cSclPin);
+  if (!onPrimary && onAlt)
+  {
+    LOG_INFO(SHT45, "Usando pines alternativos SDA=%u SCL=%u\n", kAltI2cSdaPin, kAltI2cSclPin);
+  }
+  else
+  {
+    I2cBus::configure(I2cBus::Client::SENSOR, kI2cSdaPin, kI2cSclPin, kI2cClockHz);
+  }
+
+  I2cBus::Lock lock(I2cBus::Client::SENSOR, kBootLockTimeoutMs);
+  g_available = lock.owned() && g_sht4.begin(&Wire);
   if (!g_available)
   {
-    Serial.println("[SHT45] begin() fallo");
+    I2cBus::noteError(I2cBus::Client::SENSOR);
+    LOG_ERROR(SHT45, "begin() fallo\n");
     return false;
   }
 
-  Serial.printf("[SHT45] Sensor detectado, serial=0x%lX\n", static_cast<unsigned long>(g_sht4.readSerial()));
+  LOG_INFO(SHT45, "Sensor detectado, serial=0x%lX\n", static_cast<unsigned long>(g_sht4.readSerial()));
   g_sht4.setPrecision(SHT4X_HIGH_PRECISION);
   g_sht4.setHeater(SHT4X_NO_HEATER);
   return true;
@@ -91,13 +122,27 @@ bool read(Reading &reading)
 {
   if (!begin())
   {
+    Metrics::increment(Metrics::Counter::SENSOR_ERRORS);
     reading.valid = false;
     return false;
   }
 
   sensors_event_t humidity;
   sensors_event_t temp;
-  g_sht4.getEvent(&humidity, &temp);
+  {
+    I2cBus::Lock lock(I2cBus::Client::SENSOR, kReadLockTimeoutMs);
+    if (!lock.owned() || !g_sht4.getEvent(&humidity, &temp))
+    {
+      if (lock.owned())
+      {
+        I2cBus::noteError(I2cBus::Client::SENSOR);
+      }
+      Metrics::increment(Metrics::Counter::SENSOR_ERRORS);
+      reading.valid = false;
+      return false;
+    }
+  }
+  reading.capturedAt = TimeSync::now();
 
   reading.temperatureC = roundToTwoDecimals(temp.temperature);
   reading.humidityRh = roundToTwoDecimals(humidity.relative_humidity);
@@ -111,7 +156,7 @@ String buildTelemetryTopic(const String &deviceId)
   return String(TOPIC_BASE) + deviceId + "/telemetry";
 }
 
-String buildTelemetryPayload(const String &deviceId, const Reading &reading, uint32_t uptimeMs, const String &eventKey)
+String buildTelemetryPayload(const String &deviceId, const Reading &reading, const String &eventKey)
 {
   JsonDocument doc;
   doc["device_id"] = deviceId;
@@ -119,7 +164,12 @@ String buildTelemetryPayload(const String &deviceId, const Reading &reading, uin
   doc["temperature_c"] = reading.temperatureC;
   doc["humidity_rh"] = reading.humidityRh;
   doc["vpd_kpa"] = reading.vpdKpa;
-  doc["uptime_ms"] = uptimeMs;
+  doc["uptime_ms"] = reading.capturedAt.monotonicMs;
+  doc["time_synced"] = reading.capturedAt.synced;
+  if (reading.capturedAt.synced)
+  {
+    doc["ts_ms"] = reading.capturedAt.epochMs;
+  }
   doc["event_key"] = eventKey;
 
   String payload;
@@ -2,6 +2,8 @@
 
 #include <Arduino.h>
 
+#include "time_sync.h"
+
 namespace Sht45Sensor
 {
 struct Reading
@@ -10,10 +12,11 @@ struct Reading
   float humidityRh = 0.0f;
   float vpdKpa = 0.0f;
   bool valid = false;
+  TimeSync::Timestamp capturedAt;
 };
 
 bool begin();
 bool read(Reading &reading);
 String buildTelemetryTopic(const String &deviceId);
-String buildTelemetryPayload(const String &deviceId, const Reading &reading, uint32_t uptimeMs, const String &eventKey);
+String buildTelemetryPayload(const String &deviceId, const Reading &reading, const String &eventKey);
 } // namespace Sht45Sensor
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Cola circular de capacidad fija para un productor y un consumidor (p.ej.
+// callbacks de la tarea BLE -> loop()). Sin locks ni secciones criticas:
+// cada indice solo lo escribe un lado y solo se usan loads/stores atomicos,
+// que el ESP32-C3 (RV32IMC, sin extension A) hace sin emular RMW.
+// Si esta llena, push() descarta el elemento nuevo y lo cuenta.
+template <typename T, size_t N>
+class SpscRing
+{
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "N debe ser potencia de 2");
+
+public:
+  // Solo productor.
+  bool push(const T &item)
+  {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    const uint32_t tail = tail_.load(std::memory_order_acquire);
+    if (head - tail >= N)
+    {
+      dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    slots_[head & (N - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+    const uint32_t used = head + 1 - tail;
+    if (used > highWater_.load(std::memory_order_relaxed))
+    {
+      highWater_.store(used, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  // Solo consumidor.
+  bool pop(T &out)
+  {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    out = slots_[tail & (N - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const
+  {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+  size_t size() const
+  {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  static constexpr size_t capacity() { return N; }
+  // Entregados al consumidor desde el arranque.
+  uint32_t popped() const { return tail_.load(std::memory_order_relaxed); }
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+  uint32_t highWater() const { return highWater_.load(std::memory_order_relaxed); }
+
+private:
+  T slots_[N] = {};
+  // Contadores libres; head - tail es la ocupacion aunque den la vuelta.
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<uint32_t> highWater_{0};
+};
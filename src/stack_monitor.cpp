@@ -0,0 +1,129 @@
+#include "stack_monitor.h"
+
+#include <cstring>
+
+#include "log.h"
+
+#if !configUSE_TRACE_FACILITY
+#error "StackMonitor necesita configUSE_TRACE_FACILITY"
+#endif
+
+namespace StackMonitor
+{
+namespace
+{
+// Estatico: en la pila del loop inflaria justo lo que se mide.
+TaskStatus_t g_status[kMaxTasks];
+TaskStats g_tasks[kMaxTasks];
+size_t g_taskCount = 0;
+bool g_overflowWarned = false;
+
+TaskStats *find(const char *name)
+{
+  for (size_t i = 0; i < g_taskCount; ++i)
+  {
+    if (std::strncmp(g_tasks[i].name, name, kNameLength) == 0)
+    {
+      return &g_tasks[i];
+    }
+  }
+  if (g_taskCount == kMaxTasks)
+  {
+    return nullptr;
+  }
+  TaskStats &added = g_tasks[g_taskCount++];
+  added = TaskStats();
+  std::strncpy(added.name, name, kNameLength - 1);
+  added.minFreeBytes = UINT32_MAX;
+  return &added;
+}
+} // namespace
+
+void sample()
+{
+  const UBaseType_t count = uxTaskGetSystemState(g_status, kMaxTasks, nullptr);
+  if (count == 0)
+  {
+    // Hay mas tareas que huecos y FreeRTOS no rellena ninguna.
+    if (!g_overflowWarned)
+    {
+      LOG_WARN(STACK, "Mas de %u tareas, no se puede muestrear\n", static_cast<unsigned>(kMaxTasks));
+      g_overflowWarned = true;
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < g_taskCount; ++i)
+  {
+    g_tasks[i].alive = false;
+  }
+  for (UBaseType_t i = 0; i < count; ++i)
+  {
+    const TaskStatus_t &status = g_status[i];
+    TaskStats *stats = find(status.pcTaskName ? status.pcTaskName : "?");
+    if (!stats)
+    {
+      continue;
+    }
+    stats->alive = true;
+    const uint32_t freeBytes = static_cast<uint32_t>(status.usStackHighWaterMark);
+    if (freeBytes < stats->minFreeBytes)
+    {
+      stats->minFreeBytes = freeBytes;
+    }
+    if (!stats->warned && stats->minFreeBytes < STACK_WARN_BYTES)
+    {
+      LOG_WARN(STACK, "%s: quedan %lu bytes de pila libres\n", stats->name,
+               static_cast<unsigned long>(stats->minFreeBytes));
+      stats->warned = true;
+    }
+  }
+}
+
+size_t taskCount()
+{
+  return g_taskCount;
+}
+
+const TaskStats &task(size_t index)
+{
+  static const TaskStats kEmpty;
+  return index < g_taskCount ? g_tasks[index] : kEmpty;
+}
+
+const TaskStats *tightest()
+{
+  const TaskStats *result = nullptr;
+  for (size_t i = 0; i < g_taskCount; ++i)
+  {
+    if (!result || g_tasks[i].minFreeBytes < result->minFreeBytes)
+    {
+      result = &g_tasks[i];
+    }
+  }
+  return result;
+}
+
+void dumpStats()
+{
+  for (size_t i = 0; i < g_taskCount; ++i)
+  {
+    const TaskStats &stats = g_tasks[i];
+    LOG_RAW(STACK, DEBUG, "[STACK] %-16s libre_min=%5lu B%s%s\n",
+            stats.name,
+            static_cast<unsigned long>(stats.minFreeBytes),
+            stats.minFreeBytes < STACK_WARN_BYTES ? " BAJO" : "",
+            stats.alive ? "" : " (terminada)");
+  }
+}
+
+void reset()
+{
+  for (TaskStats &stats : g_tasks)
+  {
+    stats = TaskStats();
+  }
+  g_taskCount = 0;
+  g_overflowWarned = false;
+}
+} // namespace StackMonitor
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Aviso cuando a una tarea le quedan menos bytes de pila libres.
+#ifndef STACK_WARN_BYTES
+#define STACK_WARN_BYTES 512
+#endif
+
+// Minimo historico de pila libre de todas las tareas (loop, esp-mqtt, Wi-Fi,
+// lwIP, BLE...) con uxTaskGetSystemState(), que da el mismo dato que
+// uxTaskGetStackHighWaterMark() para cada una. En ESP-IDF va en bytes.
+// Cada tarea se recuerda por nombre: si se borra y se vuelve a crear (BLE)
+// se conserva el peor valor visto.
+namespace StackMonitor
+{
+constexpr size_t kMaxTasks = 20;
+constexpr size_t kNameLength = configMAX_TASK_NAME_LEN;
+
+struct TaskStats
+{
+  char name[kNameLength] = {};
+  uint32_t minFreeBytes = 0;
+  bool alive = false; // estaba en el ultimo sample()
+  bool warned = false;
+};
+
+// Lo llama el Scheduler.
+void sample();
+size_t taskCount();
+const TaskStats &task(size_t index);
+// Tarea con menos pila libre; nullptr antes del primer sample().
+const TaskStats *tightest();
+void dumpStats();
+// Olvida todo; para los tests.
+void reset();
+} // namespace StackMonitor
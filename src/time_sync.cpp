@@ -0,0 +1,85 @@
+#include "time_sync.h"
+
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "log.h"
+
+namespace TimeSync
+{
+namespace
+{
+constexpr const char kNtpPrimary[] = "pool.ntp.org";
+constexpr const char kNtpSecondary[] = "time.google.com";
+
+portMUX_TYPE g_timeMux = portMUX_INITIALIZER_UNLOCKED;
+bool g_started = false;
+bool g_synced = false;
+int64_t g_epochOffsetMs = 0;
+
+void onTimeSynced(struct timeval *tv)
+{
+  if (!tv)
+  {
+    return;
+  }
+  const int64_t epochMs = static_cast<int64_t>(tv->tv_sec) * 1000LL + tv->tv_usec / 1000;
+  const int64_t offsetMs = epochMs - static_cast<int64_t>(monotonicMs());
+
+  portENTER_CRITICAL(&g_timeMux);
+  const bool firstSync = !g_synced;
+  g_epochOffsetMs = offsetMs;
+  g_synced = true;
+  portEXIT_CRITICAL(&g_timeMux);
+
+  if (firstSync)
+  {
+    LOG_INFO(SNTP, "Hora sincronizada epoch_ms=%llu\n", static_cast<unsigned long long>(epochMs));
+  }
+}
+} // namespace
+
+void begin()
+{
+  if (g_started)
+  {
+    return;
+  }
+  g_started = true;
+  sntp_set_time_sync_notification_cb(onTimeSynced);
+  configTime(0, 0, kNtpPrimary, kNtpSecondary);
+  LOG_INFO(SNTP, "Sincronizacion iniciada\n");
+}
+
+bool isSynced()
+{
+  portENTER_CRITICAL(&g_timeMux);
+  const bool synced = g_synced;
+  portEXIT_CRITICAL(&g_timeMux);
+  return synced;
+}
+
+uint64_t monotonicMs()
+{
+  return static_cast<uint64_t>(esp_timer_get_time() / 1000);
+}
+
+Timestamp now()
+{
+  Timestamp ts;
+  ts.monotonicMs = monotonicMs();
+
+  portENTER_CRITICAL(&g_timeMux);
+  ts.synced = g_synced;
+  const int64_t offsetMs = g_epochOffsetMs;
+  portEXIT_CRITICAL(&g_timeMux);
+
+  if (ts.synced)
+  {
+    ts.epochMs = static_cast<uint64_t>(static_cast<int64_t>(ts.monotonicMs) + offsetMs);
+  }
+  return ts;
+}
+} // namespace TimeSync
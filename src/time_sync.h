@@ -0,0 +1,18 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace TimeSync
+{
+struct Timestamp
+{
+  uint64_t epochMs = 0;     // valido solo si synced == true
+  uint64_t monotonicMs = 0; // esp_timer desde el arranque, no hace wrap
+  bool synced = false;
+};
+
+void begin();
+bool isSynced();
+uint64_t monotonicMs();
+Timestamp now();
+} // namespace TimeSync
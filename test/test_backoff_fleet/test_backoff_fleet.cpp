@@ -0,0 +1,124 @@
+#include <unity.h>
+
+#include <cstdio>
+#include <vector>
+
+#include "backoff.h"
+
+namespace {
+constexpr size_t kFleetSize = 1000;
+constexpr uint32_t kOutageMs = 120000;
+constexpr uint32_t kBucketMs = 1000;
+constexpr Backoff::Policy kPolicy = {1000, 16000};
+
+// Modelo del backoff anterior: duplica 1 s -> 16 s, igual en todos los equipos.
+uint32_t lockstepReconnectMs() {
+  uint32_t t = 0;
+  uint32_t delayMs = kPolicy.baseMs;
+  while (t < kOutageMs) {
+    t += delayMs;
+    delayMs = delayMs * 2 > kPolicy.capMs ? kPolicy.capMs : delayMs * 2;
+  }
+  return t;
+}
+
+uint32_t jitteredReconnectMs(uint32_t seedValue, std::vector<uint32_t>& attempts) {
+  Backoff::State state;
+  Backoff::seed(state, seedValue);
+  uint32_t t = 0;
+  while (t < kOutageMs) {
+    t += Backoff::next(state, kPolicy);
+    const size_t bucket = t / kBucketMs;
+    if (bucket < attempts.size()) {
+      attempts[bucket]++;
+    }
+  }
+  return t;
+}
+
+uint32_t peak(const std::vector<uint32_t>& buckets) {
+  uint32_t worst = 0;
+  for (uint32_t v : buckets) {
+    worst = v > worst ? v : worst;
+  }
+  return worst;
+}
+
+// Semillas como en el firmware: MAC consecutivas de un mismo lote.
+uint32_t deviceSeed(size_t index) {
+  const uint8_t mac[6] = {0x34, 0x85, 0x18, static_cast<uint8_t>(index >> 16),
+                          static_cast<uint8_t>(index >> 8), static_cast<uint8_t>(index)};
+  uint32_t seedValue = 0;
+  for (uint8_t b : mac) {
+    seedValue = (seedValue * 31u) ^ b;
+  }
+  return seedValue;
+}
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_delay_stays_within_policy() {
+  Backoff::State state;
+  Backoff::seed(state, 42);
+  for (int i = 0; i < 1000; ++i) {
+    const uint32_t d = Backoff::next(state, kPolicy);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(kPolicy.baseMs, d);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(kPolicy.capMs, d);
+  }
+  TEST_ASSERT_EQUAL_UINT32(1000, state.attempts);
+  Backoff::reset(state);
+  TEST_ASSERT_EQUAL_UINT32(0, state.attempts);
+}
+
+void test_neighbouring_seeds_diverge() {
+  Backoff::State a;
+  Backoff::State b;
+  Backoff::seed(a, deviceSeed(1));
+  Backoff::seed(b, deviceSeed(2));
+  size_t equal = 0;
+  for (int i = 0; i < 20; ++i) {
+    equal += Backoff::next(a, kPolicy) == Backoff::next(b, kPolicy) ? 1 : 0;
+  }
+  TEST_ASSERT_LESS_THAN(3, equal);
+}
+
+// Supone que el backoff es el unico reintento: en el firmware el
+// autoreconnect de arduino-esp32 esta desactivado (setup()), porque reintenta
+// al instante desde su tarea de eventos y volveria a sincronizar la flota.
+void test_fleet_reconnect_burst_flattens() {
+  const size_t bucketCount = (kOutageMs + kPolicy.capMs) / kBucketMs + 1;
+  std::vector<uint32_t> lockstep(bucketCount, 0);
+  std::vector<uint32_t> jittered(bucketCount, 0);
+  std::vector<uint32_t> jitteredAttempts(bucketCount, 0);
+
+  for (size_t i = 0; i < kFleetSize; ++i) {
+    lockstep[lockstepReconnectMs() / kBucketMs]++;
+    jittered[jitteredReconnectMs(deviceSeed(i), jitteredAttempts) / kBucketMs]++;
+  }
+
+  const uint32_t lockstepPeak = peak(lockstep);
+  const uint32_t jitteredPeak = peak(jittered);
+  const uint32_t attemptPeak = peak(jitteredAttempts);
+
+  char message[160];
+  snprintf(message, sizeof(message),
+           "fleet=%u reconexiones/s pico: lockstep=%u jitter=%u (intentos/s pico durante la caida=%u)",
+           static_cast<unsigned>(kFleetSize), static_cast<unsigned>(lockstepPeak),
+           static_cast<unsigned>(jitteredPeak), static_cast<unsigned>(attemptPeak));
+  TEST_MESSAGE(message);
+
+  TEST_ASSERT_EQUAL_UINT32(kFleetSize, lockstepPeak);
+  TEST_ASSERT_LESS_THAN_UINT32(kFleetSize / 5, jitteredPeak);
+  // El primer reintento cae en [base, 3 * base]; aun asi queda lejos del lockstep.
+  TEST_ASSERT_LESS_THAN_UINT32(kFleetSize * 2 / 3, attemptPeak);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_delay_stays_within_policy);
+  RUN_TEST(test_neighbouring_seeds_diverge);
+  RUN_TEST(test_fleet_reconnect_burst_flattens);
+  return UNITY_END();
+}
@@ -0,0 +1,257 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "chunk_transfer.h"
+
+namespace {
+using ChunkTransfer::Result;
+using Frame = std::vector<uint8_t>;
+
+ChunkTransfer::State g_state;
+std::vector<uint8_t> g_content;
+
+void putU16(Frame& frame, uint16_t value) {
+  frame.push_back(static_cast<uint8_t>(value));
+  frame.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void putU32(Frame& frame, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    frame.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+void makeContent(size_t length) {
+  g_content.resize(length);
+  for (size_t i = 0; i < length; ++i) {
+    g_content[i] = static_cast<uint8_t>('A' + (i * 7) % 26);
+  }
+}
+
+Frame startFrame(ChunkTransfer::Target target, uint16_t chunkSize) {
+  Frame frame = {static_cast<uint8_t>(ChunkTransfer::FrameType::START),
+                 static_cast<uint8_t>(target)};
+  putU16(frame, chunkSize);
+  putU32(frame, static_cast<uint32_t>(g_content.size()));
+  putU32(frame, ChunkTransfer::crc32(g_content.data(), g_content.size()));
+  return frame;
+}
+
+// Trocea g_content como lo haria la app.
+void dataFrames(uint16_t chunkSize, std::vector<Frame>& frames) {
+  frames.clear();
+  for (size_t offset = 0, seq = 0; offset < g_content.size(); offset += chunkSize, ++seq) {
+    const size_t length = std::min<size_t>(chunkSize, g_content.size() - offset);
+    Frame frame = {static_cast<uint8_t>(ChunkTransfer::FrameType::DATA)};
+    putU16(frame, static_cast<uint16_t>(seq));
+    const uint16_t crc = ChunkTransfer::crc16(g_content.data() + offset, length,
+                                              ChunkTransfer::crc16(frame.data() + 1, 2));
+    putU16(frame, crc);
+    frame.insert(frame.end(), g_content.begin() + offset, g_content.begin() + offset + length);
+    frames.push_back(frame);
+  }
+}
+
+Result send(const Frame& frame) {
+  return ChunkTransfer::handleFrame(g_state, frame.data(), frame.size());
+}
+
+Result commit() {
+  const Frame frame = {static_cast<uint8_t>(ChunkTransfer::FrameType::COMMIT)};
+  return send(frame);
+}
+
+void expect(Result expected, Result actual) {
+  TEST_ASSERT_EQUAL_STRING(ChunkTransfer::resultName(expected), ChunkTransfer::resultName(actual));
+}
+
+void expectContent() {
+  TEST_ASSERT_TRUE(g_state.complete);
+  TEST_ASSERT_EQUAL_UINT32(g_content.size(), g_state.totalLength);
+  TEST_ASSERT_EQUAL_MEMORY(g_content.data(), g_state.buffer, g_content.size());
+}
+}  // namespace
+
+void setUp() {
+  ChunkTransfer::release(g_state);
+  g_state = ChunkTransfer::State();
+  ChunkTransfer::setMtu(g_state, 247);
+}
+void tearDown() {}
+
+void test_crc_reference_values() {
+  const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  TEST_ASSERT_EQUAL_HEX32(0x29B1, ChunkTransfer::crc16(check, sizeof(check)));
+  TEST_ASSERT_EQUAL_HEX32(0xCBF43926u, ChunkTransfer::crc32(check, sizeof(check)));
+}
+
+void test_in_order_transfer() {
+  // Sin transferencia no hay buffer reservado.
+  TEST_ASSERT_NULL(g_state.buffer);
+  makeContent(1700);  // clave privada RSA-2048 en PEM
+  const uint16_t chunkSize = ChunkTransfer::maxChunkSize(g_state);
+  std::vector<Frame> frames;
+  dataFrames(chunkSize, frames);
+
+  expect(Result::STARTED, send(startFrame(ChunkTransfer::Target::CERT_PRIVATE, chunkSize)));
+  for (const Frame& frame : frames) {
+    expect(Result::CHUNK_OK, send(frame));
+  }
+  expect(Result::COMPLETE, commit());
+  expectContent();
+  TEST_ASSERT_EQUAL(static_cast<int>(ChunkTransfer::Target::CERT_PRIVATE),
+                    static_cast<int>(g_state.target));
+
+  // Hasta release() no se acepta otra transferencia.
+  expect(Result::BUSY, send(startFrame(ChunkTransfer::Target::CERT_ROOT, chunkSize)));
+  ChunkTransfer::release(g_state);
+  TEST_ASSERT_NULL(g_state.buffer);
+  expect(Result::STARTED, send(startFrame(ChunkTransfer::Target::CERT_ROOT, chunkSize)));
+  TEST_ASSERT_NOT_NULL(g_state.buffer);
+}
+
+// Reordena, duplica y pierde chunks al azar; el COMMIT informa del primer
+// hueco y la app reenvia solo ese hasta completar.
+void test_dropped_and_reordered_chunks() {
+  std::mt19937 rng(1234);
+  uint32_t chunks = 0;
+  uint32_t duplicates = 0;
+  for (int round = 0; round < 50; ++round) {
+    setUp();
+    makeContent(500 + rng() % 3500);
+    const uint16_t chunkSize = 20 + rng() % (ChunkTransfer::maxChunkSize(g_state) - 20);
+    std::vector<Frame> frames;
+    dataFrames(chunkSize, frames);
+
+    expect(Result::STARTED, send(startFrame(ChunkTransfer::Target::CREDENTIALS, chunkSize)));
+    std::vector<size_t> order(frames.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    for (size_t index : order) {
+      const uint32_t fate = rng() % 10;
+      if (fate < 2) {
+        continue;  // perdido
+      }
+      send(frames[index]);
+      if (fate == 9) {
+        expect(Result::DUPLICATE, send(frames[index]));
+      }
+    }
+
+    size_t retransmissions = 0;
+    Result result = commit();
+    while (result == Result::MISSING_CHUNKS) {
+      const uint16_t missing = ChunkTransfer::firstMissing(g_state);
+      TEST_ASSERT_TRUE(missing < frames.size());
+      expect(Result::CHUNK_OK, send(frames[missing]));
+      ++retransmissions;
+      result = commit();
+    }
+    expect(Result::COMPLETE, result);
+    expectContent();
+    TEST_ASSERT_TRUE(retransmissions <= frames.size());
+    chunks += g_state.stats.chunks;
+    duplicates += g_state.stats.duplicates;
+  }
+  printf("[BLE] 50 transferencias con perdidas y desorden: %lu chunks, %lu duplicados\n",
+         static_cast<unsigned long>(chunks), static_cast<unsigned long>(duplicates));
+}
+
+void test_corrupted_chunk_is_rejected_and_resent() {
+  makeContent(300);
+  std::vector<Frame> frames;
+  dataFrames(100, frames);
+  expect(Result::STARTED, send(startFrame(ChunkTransfer::Target::CERT_ROOT, 100)));
+
+  Frame corrupted = frames[1];
+  corrupted[20] ^= 0x01;
+  expect(Result::BAD_CHUNK_CRC, send(corrupted));
+  Frame badSeq = frames[1];
+  badSeq[1] = 7;  // la CRC cubre el seq
+  expect(Result::BAD_CHUNK_CRC, send(badSeq));
+  TEST_ASSERT_EQUAL_UINT32(2, g_state.stats.crcErrors);
+
+  expect(Result::CHUNK_OK, send(frames[0]));
+  expect(Result::CHUNK_OK, send(frames[2]));
+  expect(Result::MISSING_CHUNKS, commit());
+  TEST_ASSERT_EQUAL_UINT32(1, ChunkTransfer::firstMissing(g_state));
+  expect(Result::CHUNK_OK, send(frames[1]));
+  expect(Result::COMPLETE, commit());
+  expectContent();
+}
+
+void test_whole_content_crc_mismatch_resets() {
+  makeContent(300);
+  std::vector<Frame> frames;
+  dataFrames(100, frames);
+  Frame start = startFrame(ChunkTransfer::Target::CERT_DEVICE, 100);
+  start[8] ^= 0xFF;
+  expect(Result::STARTED, send(start));
+  for (const Frame& frame : frames) {
+    send(frame);
+  }
+  expect(Result::BAD_CRC, commit());
+  TEST_ASSERT_FALSE(g_state.active);
+  TEST_ASSERT_FALSE(g_state.complete);
+  TEST_ASSERT_NULL(g_state.buffer);
+  expect(Result::NO_TRANSFER, send(frames[0]));
+}
+
+void test_start_limits_follow_mtu() {
+  makeContent(1000);
+  ChunkTransfer::setMtu(g_state, ChunkTransfer::kDefaultMtu);
+  TEST_ASSERT_EQUAL_UINT32(15, ChunkTransfer::maxChunkSize(g_state));
+  expect(Result::OUT_OF_RANGE, send(startFrame(ChunkTransfer::Target::CREDENTIALS, 16)));
+  expect(Result::STARTED, send(startFrame(ChunkTransfer::Target::CREDENTIALS, 15)));
+
+  ChunkTransfer::setMtu(g_state, 517);
+  TEST_ASSERT_EQUAL_UINT32(509, ChunkTransfer::maxChunkSize(g_state));
+  makeContent(ChunkTransfer::kMaxTransferBytes + 1);
+  expect(Result::TOO_LARGE, send(startFrame(ChunkTransfer::Target::CREDENTIALS, 509)));
+
+  // Un chunk intermedio mas corto que chunkSize es una trama invalida.
+  makeContent(300);
+  std::vector<Frame> frames;
+  dataFrames(100, frames);
+  expect(Result::STARTED, send(startFrame(ChunkTransfer::Target::CREDENTIALS, 150)));
+  expect(Result::MALFORMED, send(frames[0]));
+  const Frame abort = {static_cast<uint8_t>(ChunkTransfer::FrameType::ABORT)};
+  expect(Result::ABORTED, send(abort));
+  expect(Result::NO_TRANSFER, commit());
+}
+
+// START + DATA + COMMIT por fichero para CA, certificado y clave.
+void test_frames_per_certificate_by_mtu() {
+  const uint32_t sizes[] = {1200, 1250, 1700};
+  const uint16_t mtus[] = {23, 185, 247, 517};
+  uint32_t writes = 0;
+  for (uint16_t mtu : mtus) {
+    ChunkTransfer::setMtu(g_state, mtu);
+    const uint32_t chunkSize = ChunkTransfer::maxChunkSize(g_state);
+    writes = 0;
+    for (uint32_t size : sizes) {
+      writes += 2 + (size + chunkSize - 1) / chunkSize;
+    }
+    printf("[BLE] MTU %3u: chunk %3lu bytes, %lu escrituras para CA + cert + clave\n", mtu,
+           static_cast<unsigned long>(chunkSize), static_cast<unsigned long>(writes));
+  }
+  TEST_ASSERT_EQUAL_UINT32(16, writes);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc_reference_values);
+  RUN_TEST(test_in_order_transfer);
+  RUN_TEST(test_dropped_and_reordered_chunks);
+  RUN_TEST(test_corrupted_chunk_is_rejected_and_resent);
+  RUN_TEST(test_whole_content_crc_mismatch_resets);
+  RUN_TEST(test_start_limits_follow_mtu);
+  RUN_TEST(test_frames_per_certificate_by_mtu);
+  return UNITY_END();
+}
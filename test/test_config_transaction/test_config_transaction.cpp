@@ -0,0 +1,173 @@
+#include <unity.h>
+
+#include <cstdio>
+#include <string>
+
+#include "Config.hpp"
+#include "nvs_host.h"
+
+namespace {
+constexpr char kNvsFile[] = "test_config_transaction.nvs";
+
+struct Provisioning {
+  const char* ssid;
+  const char* password;
+  const char* endpoint;
+  const char* region;
+  const char* env;
+  const char* thing;
+  int32_t port;
+  const char* deviceId;
+  const char* userId;
+  const char* token;
+};
+
+const Provisioning kFirst = {"lab-net", "secret-1", "a1.iot.us-east-1.amazonaws.com",
+                             "us-east-1", "prod", "thing-1", 8883, "lab_000001",
+                             "user-1", "token-1"};
+const Provisioning kSecond = {"field-net", "secret-2", "b2.iot.eu-west-1.amazonaws.com",
+                              "eu-west-1", "staging", "thing-2", 443, "lab_000002",
+                              "user-2", "token-2"};
+
+// Las mismas diez claves que onProvisionedCredentials().
+void stage(Config::Transaction& tx, const Provisioning& p) {
+  tx.setString(Config::Key::WIFI_SSID, p.ssid);
+  tx.setString(Config::Key::WIFI_PASSWORD, p.password);
+  tx.setString(Config::Key::DEVICE_PROVISION_TOKEN, p.token);
+  tx.setString(Config::Key::DEVICE_ID, p.deviceId);
+  tx.setString(Config::Key::AWS_ENDPOINT, p.endpoint);
+  tx.setString(Config::Key::AWS_REGION, p.region);
+  tx.setString(Config::Key::DEVICE_ENV, p.env);
+  tx.setString(Config::Key::AWS_THING, p.thing);
+  tx.setInt(Config::Key::AWS_PORT, p.port);
+  tx.setString(Config::Key::DEVICE_USER, p.userId);
+}
+
+void writeOneByOne(const Provisioning& p) {
+  Config::setString(Config::Key::WIFI_SSID, p.ssid);
+  Config::setString(Config::Key::WIFI_PASSWORD, p.password);
+  Config::setString(Config::Key::DEVICE_PROVISION_TOKEN, p.token);
+  Config::setString(Config::Key::DEVICE_ID, p.deviceId);
+  Config::setString(Config::Key::AWS_ENDPOINT, p.endpoint);
+  Config::setString(Config::Key::AWS_REGION, p.region);
+  Config::setString(Config::Key::DEVICE_ENV, p.env);
+  Config::setString(Config::Key::AWS_THING, p.thing);
+  Config::setInt(Config::Key::AWS_PORT, p.port);
+  Config::setString(Config::Key::DEVICE_USER, p.userId);
+}
+
+bool matches(const Provisioning& p) {
+  return Config::getString(Config::Key::WIFI_SSID) == p.ssid &&
+         Config::getString(Config::Key::WIFI_PASSWORD) == p.password &&
+         Config::getString(Config::Key::DEVICE_PROVISION_TOKEN) == p.token &&
+         Config::getString(Config::Key::DEVICE_ID) == p.deviceId &&
+         Config::getString(Config::Key::AWS_ENDPOINT) == p.endpoint &&
+         Config::getString(Config::Key::AWS_REGION) == p.region &&
+         Config::getString(Config::Key::DEVICE_ENV) == p.env &&
+         Config::getString(Config::Key::AWS_THING) == p.thing &&
+         Config::getInt(Config::Key::AWS_PORT) == p.port &&
+         Config::getString(Config::Key::DEVICE_USER) == p.userId;
+}
+
+void freshDevice() {
+  Config::deinit();
+  NvsHost::reset(kNvsFile);
+  Config::init();
+  Config::seedDefaults("test");
+}
+
+void rebootDevice() {
+  Config::deinit();
+  NvsHost::reboot();
+  Config::init();
+}
+}  // namespace
+
+void setUp() { freshDevice(); }
+void tearDown() { remove(kNvsFile); }
+
+void test_transaction_commits_once_per_namespace() {
+  NvsHost::resetStats();
+  writeOneByOne(kFirst);
+  const NvsHost::Stats legacy = NvsHost::stats();
+
+  freshDevice();
+  NvsHost::resetStats();
+  Config::Transaction tx;
+  stage(tx, kFirst);
+  TEST_ASSERT_EQUAL(ESP_OK, tx.commit());
+  const NvsHost::Stats batched = NvsHost::stats();
+
+  printf("[CONFIG] provisioning: %lu commits / %lu opens una a una, %lu / %lu con Transaction\n",
+         static_cast<unsigned long>(legacy.commits), static_cast<unsigned long>(legacy.opens),
+         static_cast<unsigned long>(batched.commits), static_cast<unsigned long>(batched.opens));
+
+  TEST_ASSERT_EQUAL_UINT32(10, legacy.commits);
+  // journal + aws + wifi + device + generation
+  TEST_ASSERT_EQUAL_UINT32(5, batched.commits);
+  TEST_ASSERT_EQUAL_UINT32(5, batched.opens);
+  TEST_ASSERT_TRUE(matches(kFirst));
+  TEST_ASSERT_EQUAL_UINT32(1, Config::generation());
+
+  rebootDevice();
+  TEST_ASSERT_TRUE(matches(kFirst));
+  TEST_ASSERT_EQUAL_UINT32(1, Config::generation());
+}
+
+void test_staging_validates_and_dedupes() {
+  Config::Transaction tx;
+  TEST_ASSERT_FALSE(tx.setInt(Config::Key::WIFI_SSID, 1));
+  TEST_ASSERT_FALSE(tx.setString(Config::Key::DEVICE_ENV, std::string(65, 'x')));
+  TEST_ASSERT_TRUE(tx.setString(Config::Key::DEVICE_ENV, "dev"));
+  TEST_ASSERT_TRUE(tx.setString(Config::Key::DEVICE_ENV, "staging"));
+  TEST_ASSERT_EQUAL_UINT32(1, tx.size());
+  TEST_ASSERT_EQUAL(ESP_OK, tx.commit());
+  TEST_ASSERT_EQUAL_STRING("staging", Config::getString(Config::Key::DEVICE_ENV).c_str());
+}
+
+// Corta la alimentacion tras cada posible numero de escrituras durante el
+// segundo provisioning: tras reiniciar debe verse entero el primero o el
+// segundo, nunca una mezcla, y la generacion debe corresponder.
+void test_power_cut_never_mixes_configurations() {
+  uint32_t sawFirst = 0;
+  uint32_t sawSecond = 0;
+  for (uint32_t cut = 0;; ++cut) {
+    freshDevice();
+    Config::Transaction first;
+    stage(first, kFirst);
+    TEST_ASSERT_EQUAL(ESP_OK, first.commit());
+
+    NvsHost::cutPowerAfterWrites(cut);
+    Config::Transaction second;
+    stage(second, kSecond);
+    const esp_err_t err = second.commit();
+    const bool interrupted = NvsHost::powerCut();
+    rebootDevice();
+
+    if (matches(kFirst)) {
+      TEST_ASSERT_EQUAL_UINT32(1, Config::generation());
+      ++sawFirst;
+    } else {
+      TEST_ASSERT_TRUE(matches(kSecond));
+      TEST_ASSERT_EQUAL_UINT32(2, Config::generation());
+      ++sawSecond;
+    }
+
+    if (!interrupted) {
+      TEST_ASSERT_EQUAL(ESP_OK, err);
+      break;
+    }
+  }
+  printf("[CONFIG] cortes simulados: %lu -> config anterior, %lu -> config nueva\n",
+         static_cast<unsigned long>(sawFirst), static_cast<unsigned long>(sawSecond));
+  TEST_ASSERT_EQUAL_UINT32(1, sawFirst);
+  TEST_ASSERT_GREATER_THAN(10, sawSecond);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_transaction_commits_once_per_namespace);
+  RUN_TEST(test_staging_validates_and_dedupes);
+  RUN_TEST(test_power_cut_never_mixes_configurations);
+  return UNITY_END();
+}
@@ -0,0 +1,161 @@
+#include <unity.h>
+
+#include <core_dump_host.h>
+
+#include <cstring>
+#include <vector>
+
+#include "chunk_transfer.h"
+#include "core_dump.h"
+
+namespace {
+std::vector<uint8_t> g_image;
+
+void installDump(size_t length) {
+  g_image.resize(length);
+  for (size_t i = 0; i < length; ++i) {
+    g_image[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  esp_core_dump_summary_t summary = {};
+  std::strcpy(summary.exc_task, "loopTask");
+  summary.exc_pc = 0x42001234;
+  summary.ex_info.ra = 0x42005678;
+  summary.ex_info.mcause = 7;
+  summary.ex_info.mtval = 0x0000001C;
+  CoreDumpHost::setImage(g_image.data(), g_image.size(), summary);
+}
+
+uint16_t getU16(const uint8_t* data) {
+  return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t getU32(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+uint8_t g_chunk[CoreDump::kHeaderBytes + CoreDump::kChunkBytes];
+}  // namespace
+
+void setUp() {
+  CoreDumpHost::clear();
+}
+
+void tearDown() {}
+
+void test_no_dump_means_nothing_to_upload() {
+  TEST_ASSERT_FALSE(CoreDump::begin());
+  TEST_ASSERT_FALSE(CoreDump::uploadPending());
+  TEST_ASSERT_FALSE(CoreDump::chunkDue(0));
+  TEST_ASSERT_EQUAL_UINT32(0, CoreDump::buildChunk(g_chunk, sizeof(g_chunk)));
+}
+
+void test_summary_from_flash() {
+  installDump(2500);
+  TEST_ASSERT_TRUE(CoreDump::begin());
+
+  const CoreDump::Summary& summary = CoreDump::summary();
+  TEST_ASSERT_TRUE(summary.present);
+  TEST_ASSERT_EQUAL_UINT32(2500, summary.size);
+  TEST_ASSERT_EQUAL_UINT32(3, summary.chunkCount);
+  TEST_ASSERT_EQUAL_UINT32(ChunkTransfer::crc32(g_image.data(), g_image.size()), summary.dumpId);
+  TEST_ASSERT_EQUAL_STRING("loopTask", summary.task);
+  TEST_ASSERT_EQUAL_UINT32(0x42001234, summary.pc);
+  TEST_ASSERT_EQUAL_UINT32(2, summary.depth);
+  TEST_ASSERT_EQUAL_UINT32(0x42001234, summary.backtrace[0]);
+  TEST_ASSERT_EQUAL_UINT32(0x42005678, summary.backtrace[1]);
+  TEST_ASSERT_EQUAL_UINT32(7, summary.cause);
+  TEST_ASSERT_EQUAL_UINT32(0x1C, summary.faultAddress);
+}
+
+void test_unreadable_dump_is_not_uploaded() {
+  installDump(600);
+  CoreDumpHost::failNextRead();
+  TEST_ASSERT_FALSE(CoreDump::begin());
+  TEST_ASSERT_FALSE(CoreDump::uploadPending());
+}
+
+void test_upload_one_chunk_in_flight_then_erase() {
+  installDump(2500);
+  TEST_ASSERT_TRUE(CoreDump::begin());
+  const uint32_t dumpId = CoreDump::summary().dumpId;
+
+  std::vector<uint8_t> rebuilt(g_image.size(), 0);
+  uint32_t now = 1000;
+  int msgId = 10;
+  for (uint16_t seq = 0; seq < 3; ++seq) {
+    TEST_ASSERT_TRUE(CoreDump::chunkDue(now));
+    const size_t length = CoreDump::buildChunk(g_chunk, sizeof(g_chunk));
+    TEST_ASSERT_TRUE(length > CoreDump::kHeaderBytes);
+    TEST_ASSERT_EQUAL_UINT16(CoreDump::kChunkMagic, getU16(g_chunk));
+    TEST_ASSERT_EQUAL_UINT16(seq, getU16(g_chunk + 2));
+    TEST_ASSERT_EQUAL_UINT16(3, getU16(g_chunk + 4));
+    TEST_ASSERT_EQUAL_UINT32(length - CoreDump::kHeaderBytes, getU16(g_chunk + 6));
+    TEST_ASSERT_EQUAL_UINT32(dumpId, getU32(g_chunk + 8));
+    const uint32_t offset = getU32(g_chunk + 12);
+    TEST_ASSERT_EQUAL_UINT32(seq * CoreDump::kChunkBytes, offset);
+    std::memcpy(rebuilt.data() + offset, g_chunk + CoreDump::kHeaderBytes, length - CoreDump::kHeaderBytes);
+
+    CoreDump::chunkPublished(msgId, now);
+    TEST_ASSERT_FALSE(CoreDump::chunkDue(now + 1000));
+    TEST_ASSERT_TRUE(CoreDump::isInFlight(msgId));
+    TEST_ASSERT_FALSE(CoreDump::onAcked(msgId + 100));
+    const bool last = CoreDump::onAcked(msgId);
+    TEST_ASSERT_EQUAL(seq == 2, last);
+    TEST_ASSERT_FALSE(CoreDump::isInFlight(msgId));
+    ++msgId;
+    now += 1000;
+  }
+
+  TEST_ASSERT_EQUAL_MEMORY(g_image.data(), rebuilt.data(), g_image.size());
+  TEST_ASSERT_FALSE(CoreDump::uploadPending());
+  TEST_ASSERT_FALSE(CoreDump::chunkDue(now));
+  TEST_ASSERT_EQUAL_UINT32(1, CoreDumpHost::eraseCount());
+  TEST_ASSERT_EQUAL_UINT32(2500, CoreDump::stats().bytesAcked);
+  TEST_ASSERT_EQUAL_UINT32(0, CoreDump::stats().resends);
+
+  // Borrado: el siguiente arranque no encuentra nada.
+  TEST_ASSERT_FALSE(CoreDump::begin());
+}
+
+void test_unacked_chunk_is_resent_after_timeout() {
+  installDump(1500);
+  TEST_ASSERT_TRUE(CoreDump::begin());
+
+  // Un publish rechazado no deja nada en vuelo.
+  TEST_ASSERT_TRUE(CoreDump::buildChunk(g_chunk, sizeof(g_chunk)) > 0);
+  CoreDump::chunkPublished(-1, 0);
+  TEST_ASSERT_TRUE(CoreDump::chunkDue(0));
+
+  CoreDump::chunkPublished(5, 0);
+  TEST_ASSERT_FALSE(CoreDump::chunkDue(CORE_DUMP_ACK_TIMEOUT_MS - 1));
+  TEST_ASSERT_TRUE(CoreDump::chunkDue(CORE_DUMP_ACK_TIMEOUT_MS));
+  TEST_ASSERT_TRUE(CoreDump::buildChunk(g_chunk, sizeof(g_chunk)) > 0);
+  TEST_ASSERT_EQUAL_UINT16(0, getU16(g_chunk + 2));
+  CoreDump::chunkPublished(6, CORE_DUMP_ACK_TIMEOUT_MS);
+  TEST_ASSERT_EQUAL_UINT32(1, CoreDump::stats().resends);
+
+  // El PUBLISHED tardio del primer envio ya no cuenta.
+  TEST_ASSERT_FALSE(CoreDump::isInFlight(5));
+  TEST_ASSERT_FALSE(CoreDump::onAcked(5));
+  TEST_ASSERT_FALSE(CoreDump::onAcked(6));
+  TEST_ASSERT_EQUAL_UINT32(1, CoreDump::stats().chunksAcked);
+}
+
+void test_small_buffer_is_rejected() {
+  installDump(1500);
+  TEST_ASSERT_TRUE(CoreDump::begin());
+  uint8_t small[CoreDump::kHeaderBytes + 10];
+  TEST_ASSERT_EQUAL_UINT32(0, CoreDump::buildChunk(small, sizeof(small)));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_no_dump_means_nothing_to_upload);
+  RUN_TEST(test_summary_from_flash);
+  RUN_TEST(test_unreadable_dump_is_not_uploaded);
+  RUN_TEST(test_upload_one_chunk_in_flight_then_erase);
+  RUN_TEST(test_unacked_chunk_is_resent_after_timeout);
+  RUN_TEST(test_small_buffer_is_rejected);
+  return UNITY_END();
+}
@@ -0,0 +1,211 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "credentials_parser.h"
+
+// Cuenta reservas de heap para comprobar que parse() no las hace.
+namespace {
+size_t g_allocations = 0;
+}
+
+void* operator new(size_t size) {
+  ++g_allocations;
+  void* p = std::malloc(size ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+using CredentialsParser::CredentialsPayload;
+using CredentialsParser::Error;
+
+constexpr char kFullPayload[] =
+    "ssid=lab-net\r\npassword=secret pass\r\nuser_id=9f1c2a4e-3b7d-4c1e-8f00-1234567890ab\r\n"
+    "device_id=lab_000001\r\nendpoint=a1b2c3d4e5f6-ats.iot.us-east-1.amazonaws.com\r\n"
+    "region=us-east-1\r\nenv=prod\r\nthing=lab_000001\r\ntoken=tok-123456\r\naws_port=8883\r\n";
+
+void expectError(const char* raw, Error expected) {
+  CredentialsPayload out;
+  TEST_ASSERT_EQUAL(static_cast<int>(expected),
+                    static_cast<int>(CredentialsParser::parse(raw, out)));
+}
+
+// Tokenizer anterior (copia, erase de '\r', vector de tokens y trim por la
+// izquierda), solo como referencia para el benchmark.
+void legacyTrim(std::string& text) {
+  while (!text.empty() && (text.front() == ' ' || text.front() == '\t' || text.front() == '\n')) {
+    text.erase(text.begin());
+  }
+  while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\n')) {
+    text.pop_back();
+  }
+}
+
+void legacyParse(const std::string& raw, CredentialsPayload& payload) {
+  std::string text = raw;
+  text.erase(std::remove(text.begin(), text.end(), '\r'), text.end());
+  std::replace(text.begin(), text.end(), '|', '\n');
+  std::vector<std::string> tokens;
+  for (size_t start = 0; start < text.size();) {
+    size_t end = text.find('\n', start);
+    if (end == std::string::npos) {
+      end = text.size();
+    }
+    tokens.emplace_back(text.substr(start, end - start));
+    start = end + 1;
+  }
+  std::string fields[10];
+  const char* names[10] = {"ssid", "password", "user_id", "device_id", "endpoint",
+                           "region", "env", "thing", "token", "aws_port"};
+  for (std::string token : tokens) {
+    legacyTrim(token);
+    const size_t eq = token.find('=');
+    if (eq == std::string::npos) {
+      continue;
+    }
+    std::string key = token.substr(0, eq);
+    std::string value = token.substr(eq + 1);
+    legacyTrim(key);
+    legacyTrim(value);
+    std::transform(key.begin(), key.end(), key.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    for (size_t i = 0; i < 10; ++i) {
+      if (key == names[i]) {
+        fields[i] = value;
+      }
+    }
+  }
+  snprintf(payload.ssid, sizeof(payload.ssid), "%s", fields[0].c_str());
+  snprintf(payload.password, sizeof(payload.password), "%s", fields[1].c_str());
+  snprintf(payload.userId, sizeof(payload.userId), "%s", fields[2].c_str());
+  snprintf(payload.deviceId, sizeof(payload.deviceId), "%s", fields[3].c_str());
+  snprintf(payload.endpoint, sizeof(payload.endpoint), "%s", fields[4].c_str());
+  snprintf(payload.region, sizeof(payload.region), "%s", fields[5].c_str());
+  snprintf(payload.environment, sizeof(payload.environment), "%s", fields[6].c_str());
+  snprintf(payload.thingName, sizeof(payload.thingName), "%s", fields[7].c_str());
+  snprintf(payload.provisionToken, sizeof(payload.provisionToken), "%s", fields[8].c_str());
+  payload.awsPort = atoi(fields[9].c_str());
+}
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_key_value_payload() {
+  CredentialsPayload out;
+  TEST_ASSERT_EQUAL(static_cast<int>(Error::NONE),
+                    static_cast<int>(CredentialsParser::parse(kFullPayload, out)));
+  TEST_ASSERT_EQUAL_STRING("lab-net", out.ssid);
+  TEST_ASSERT_EQUAL_STRING("secret pass", out.password);
+  TEST_ASSERT_EQUAL_STRING("9f1c2a4e-3b7d-4c1e-8f00-1234567890ab", out.userId);
+  TEST_ASSERT_EQUAL_STRING("lab_000001", out.deviceId);
+  TEST_ASSERT_EQUAL_STRING("a1b2c3d4e5f6-ats.iot.us-east-1.amazonaws.com", out.endpoint);
+  TEST_ASSERT_EQUAL_STRING("us-east-1", out.region);
+  TEST_ASSERT_EQUAL_STRING("prod", out.environment);
+  TEST_ASSERT_EQUAL_STRING("lab_000001", out.thingName);
+  TEST_ASSERT_EQUAL_STRING("tok-123456", out.provisionToken);
+  TEST_ASSERT_EQUAL_INT32(8883, out.awsPort);
+}
+
+void test_aliases_pipes_and_overrides() {
+  CredentialsPayload out;
+  TEST_ASSERT_EQUAL(static_cast<int>(Error::NONE),
+                    static_cast<int>(CredentialsParser::parse(
+                        " WIFI_SSID = first | Pass=p\rw |ssid=second|thing_name=t|Port=443|junk|=x",
+                        out)));
+  TEST_ASSERT_EQUAL_STRING("second", out.ssid);
+  TEST_ASSERT_EQUAL_STRING("pw", out.password);
+  TEST_ASSERT_EQUAL_STRING("t", out.thingName);
+  TEST_ASSERT_EQUAL_INT32(443, out.awsPort);
+}
+
+void test_positional_payload() {
+  CredentialsPayload out;
+  TEST_ASSERT_EQUAL(static_cast<int>(Error::NONE),
+                    static_cast<int>(CredentialsParser::parse("  lab-net \r\n\r\nuser-1\nextra", out)));
+  TEST_ASSERT_EQUAL_STRING("lab-net", out.ssid);
+  TEST_ASSERT_EQUAL_STRING("", out.password);
+  TEST_ASSERT_EQUAL_STRING("user-1", out.userId);
+  TEST_ASSERT_EQUAL_INT32(0, out.awsPort);
+}
+
+void test_validation_errors() {
+  expectError("", Error::EMPTY);
+  expectError("\r\n|", Error::SSID);
+  expectError("password=x", Error::SSID);
+  expectError("ssid=0123456789012345678901234567890123", Error::SSID_LEN);
+  expectError("ssid=a\ndevice_id=bad id", Error::DEVICE_ID);
+  expectError("ssid=a\ndevice_id=012345678901234567890123456789012", Error::DEVICE_ID);
+  expectError("ssid=a\nenv=01234567890123456", Error::ENVIRONMENT_LEN);
+  expectError("ssid=a\naws_port=0", Error::AWS_PORT);
+  expectError("ssid=a\naws_port=65536", Error::AWS_PORT);
+  expectError("ssid=a\naws_port=abc", Error::AWS_PORT);
+  expectError("ssid=a\naws_port=99999999999999999999", Error::AWS_PORT);
+  // Un valor largo sustituido despues por uno valido no es error.
+  expectError("ssid=0123456789012345678901234567890123|ssid=ok", Error::NONE);
+  TEST_ASSERT_EQUAL_STRING("device_id", CredentialsParser::errorName(Error::DEVICE_ID));
+  TEST_ASSERT_EQUAL_STRING("vacio", CredentialsParser::errorName(Error::EMPTY));
+}
+
+void test_parse_does_not_allocate() {
+  CredentialsPayload out;
+  const size_t before = g_allocations;
+  for (int i = 0; i < 100; ++i) {
+    CredentialsParser::parse(kFullPayload, out);
+    CredentialsParser::parse("ssid=a\ndevice_id=bad id", out);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, static_cast<uint32_t>(g_allocations - before));
+}
+
+void test_benchmark_against_legacy_tokenizer() {
+  constexpr int kIterations = 20000;
+  const std::string raw(kFullPayload);
+  CredentialsPayload out;
+
+  size_t before = g_allocations;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    legacyParse(raw, out);
+  }
+  const double legacyNs =
+      std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+      kIterations;
+  const double legacyAllocs = static_cast<double>(g_allocations - before) / kIterations;
+
+  before = g_allocations;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    CredentialsParser::parse(raw, out);
+  }
+  const double viewNs =
+      std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+      kIterations;
+
+  printf("[BLE] parse %zu bytes: anterior %.0f ns y %.1f reservas, string_view %.0f ns y %zu reservas\n",
+         raw.size(), legacyNs, legacyAllocs, viewNs, g_allocations - before);
+  TEST_ASSERT_EQUAL_INT32(8883, out.awsPort);
+  TEST_ASSERT_TRUE(viewNs < legacyNs);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_key_value_payload);
+  RUN_TEST(test_aliases_pipes_and_overrides);
+  RUN_TEST(test_positional_payload);
+  RUN_TEST(test_validation_errors);
+  RUN_TEST(test_parse_does_not_allocate);
+  RUN_TEST(test_benchmark_against_legacy_tokenizer);
+  return UNITY_END();
+}
@@ -0,0 +1,195 @@
+#include <unity.h>
+
+#include <heap_caps_host.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "Config.hpp"
+#include "heap_monitor.h"
+#include "nvs_host.h"
+
+// Los tests usan el binario enlazado con --wrap (build_flags de native): las
+// reservas de aqui pasan por los mismos hooks que en el dispositivo.
+namespace {
+constexpr char kNvsFile[] = "test_heap_monitor.nvs";
+
+void* volatile g_sink = nullptr;
+
+void allocateAndFree(size_t bytes) {
+  g_sink = std::malloc(bytes);
+  std::free(g_sink);
+  g_sink = nullptr;
+}
+}  // namespace
+
+void setUp() {
+  HeapCapsHost::reset();
+  HeapMonitor::resetTagStats();
+}
+
+void tearDown() {}
+
+void test_fragmentation_pct() {
+  TEST_ASSERT_EQUAL_UINT8(0, HeapMonitor::fragmentationPct(0, 0));
+  TEST_ASSERT_EQUAL_UINT8(0, HeapMonitor::fragmentationPct(100000, 100000));
+  TEST_ASSERT_EQUAL_UINT8(50, HeapMonitor::fragmentationPct(100000, 50000));
+  TEST_ASSERT_EQUAL_UINT8(90, HeapMonitor::fragmentationPct(100000, 10000));
+  TEST_ASSERT_EQUAL_UINT8(100, HeapMonitor::fragmentationPct(100000, 0));
+}
+
+void test_untagged_allocations_count_as_other() {
+  allocateAndFree(64);
+
+  const HeapMonitor::TagStats other = HeapMonitor::tagStats(HeapMonitor::Tag::OTHER);
+  TEST_ASSERT_EQUAL_UINT32(1, other.allocs);
+  TEST_ASSERT_EQUAL_UINT32(1, other.frees);
+  TEST_ASSERT_EQUAL_UINT32(64, other.bytes);
+  TEST_ASSERT_EQUAL_UINT32(0, HeapMonitor::tagStats(HeapMonitor::Tag::JSON).allocs);
+}
+
+void test_nested_scopes_restore_previous_tag() {
+  {
+    HeapMonitor::Scope json(HeapMonitor::Tag::JSON);
+    allocateAndFree(100);
+    {
+      HeapMonitor::Scope mqtt(HeapMonitor::Tag::MQTT);
+      allocateAndFree(30);
+    }
+    allocateAndFree(20);
+  }
+  allocateAndFree(8);
+
+  TEST_ASSERT_EQUAL_UINT32(2, HeapMonitor::tagStats(HeapMonitor::Tag::JSON).allocs);
+  TEST_ASSERT_EQUAL_UINT32(120, HeapMonitor::tagStats(HeapMonitor::Tag::JSON).bytes);
+  TEST_ASSERT_EQUAL_UINT32(1, HeapMonitor::tagStats(HeapMonitor::Tag::MQTT).allocs);
+  TEST_ASSERT_EQUAL_UINT32(30, HeapMonitor::tagStats(HeapMonitor::Tag::MQTT).bytes);
+  TEST_ASSERT_EQUAL_UINT32(1, HeapMonitor::tagStats(HeapMonitor::Tag::OTHER).allocs);
+}
+
+void test_free_outside_scope_shows_surviving_block() {
+  void* block = nullptr;
+  {
+    HeapMonitor::Scope json(HeapMonitor::Tag::JSON);
+    block = std::malloc(256);
+    g_sink = block;
+  }
+  std::free(block);
+  g_sink = nullptr;
+
+  const HeapMonitor::TagStats json = HeapMonitor::tagStats(HeapMonitor::Tag::JSON);
+  TEST_ASSERT_EQUAL_UINT32(1, json.allocs);
+  TEST_ASSERT_EQUAL_UINT32(0, json.frees);
+  TEST_ASSERT_EQUAL_UINT32(1, HeapMonitor::tagStats(HeapMonitor::Tag::OTHER).frees);
+}
+
+void test_realloc_counts_free_and_alloc() {
+  HeapMonitor::Scope config(HeapMonitor::Tag::CONFIG);
+  void* block = std::malloc(16);
+  block = std::realloc(block, 4096);
+  g_sink = block;
+  std::free(block);
+  g_sink = nullptr;
+
+  const HeapMonitor::TagStats stats = HeapMonitor::tagStats(HeapMonitor::Tag::CONFIG);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.allocs);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.frees);
+  TEST_ASSERT_EQUAL_UINT32(16 + 4096, stats.bytes);
+}
+
+void test_scope_only_applies_to_its_task() {
+  HeapMonitor::Scope json(HeapMonitor::Tag::JSON);
+  std::thread other([] {
+    HeapMonitor::tagTask(xTaskGetCurrentTaskHandle(), HeapMonitor::Tag::MQTT);
+    allocateAndFree(48);
+    HeapMonitor::tagTask(xTaskGetCurrentTaskHandle(), HeapMonitor::Tag::OTHER);
+    allocateAndFree(48);
+  });
+  other.join();
+
+  TEST_ASSERT_EQUAL_UINT32(1, HeapMonitor::tagStats(HeapMonitor::Tag::MQTT).allocs);
+  TEST_ASSERT_EQUAL_UINT32(48, HeapMonitor::tagStats(HeapMonitor::Tag::MQTT).bytes);
+  // Sin tag propio, el Scope del hilo principal no le afecta.
+  TEST_ASSERT_EQUAL_UINT32(48, HeapMonitor::tagStats(HeapMonitor::Tag::OTHER).bytes);
+}
+
+void test_new_goes_through_hooks() {
+  {
+    HeapMonitor::Scope config(HeapMonitor::Tag::CONFIG);
+    std::string text(200, 'x');
+    g_sink = &text[0];
+  }
+  g_sink = nullptr;
+
+  const HeapMonitor::TagStats stats = HeapMonitor::tagStats(HeapMonitor::Tag::CONFIG);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.allocs);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.frees);
+}
+
+void test_config_allocations_are_attributed() {
+  NvsHost::reset(kNvsFile);
+  Config::deinit();
+  Config::setString(Config::Key::WIFI_SSID, "invernadero-norte-con-nombre-largo");
+  (void)Config::getString(Config::Key::WIFI_SSID);
+
+  const HeapMonitor::TagStats config = HeapMonitor::tagStats(HeapMonitor::Tag::CONFIG);
+  TEST_ASSERT_TRUE(config.allocs > 0);
+  printf("[HEAP] Config set+get: %u reservas, %u bytes (other: %u)\n",
+         static_cast<unsigned>(config.allocs),
+         static_cast<unsigned>(config.bytes),
+         static_cast<unsigned>(HeapMonitor::tagStats(HeapMonitor::Tag::OTHER).allocs));
+  Config::deinit();
+}
+
+void test_trend_and_minimum() {
+  HeapCapsHost::setFree(120000, 90000);
+  HeapMonitor::Snapshot first = HeapMonitor::snapshot();
+  HeapMonitor::takeTrend(first);
+  TEST_ASSERT_EQUAL_UINT32(120000, first.minFreeBytes);
+  TEST_ASSERT_EQUAL_UINT8(25, first.fragmentationPct);
+
+  allocateAndFree(10);
+  allocateAndFree(10);
+  HeapCapsHost::setFree(100000, 40000);
+  const HeapMonitor::Snapshot second = HeapMonitor::snapshot();
+  const HeapMonitor::Trend trend = HeapMonitor::takeTrend(second);
+  TEST_ASSERT_EQUAL_INT32(-20000, trend.freeDelta);
+  TEST_ASSERT_EQUAL_INT32(-50000, trend.largestDelta);
+  TEST_ASSERT_EQUAL_UINT32(2, trend.allocs);
+  TEST_ASSERT_EQUAL_UINT8(60, second.fragmentationPct);
+
+  // El minimo historico no sube al recuperar memoria.
+  HeapCapsHost::setFree(130000, 130000);
+  const HeapMonitor::Snapshot third = HeapMonitor::snapshot();
+  TEST_ASSERT_EQUAL_UINT32(100000, third.minFreeBytes);
+  TEST_ASSERT_EQUAL_INT32(30000, HeapMonitor::takeTrend(third).freeDelta);
+}
+
+void test_host_heap_tracks_process_usage() {
+  const HeapMonitor::Snapshot before = HeapMonitor::snapshot();
+  void* block = std::malloc(32 * 1024);
+  g_sink = block;
+  const HeapMonitor::Snapshot during = HeapMonitor::snapshot();
+  std::free(block);
+  g_sink = nullptr;
+
+  TEST_ASSERT_TRUE(during.freeBytes + 32 * 1024 <= before.freeBytes + 64);
+  TEST_ASSERT_TRUE(during.minFreeBytes <= during.freeBytes);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fragmentation_pct);
+  RUN_TEST(test_untagged_allocations_count_as_other);
+  RUN_TEST(test_nested_scopes_restore_previous_tag);
+  RUN_TEST(test_free_outside_scope_shows_surviving_block);
+  RUN_TEST(test_realloc_counts_free_and_alloc);
+  RUN_TEST(test_scope_only_applies_to_its_task);
+  RUN_TEST(test_new_goes_through_hooks);
+  RUN_TEST(test_config_allocations_are_attributed);
+  RUN_TEST(test_trend_and_minimum);
+  RUN_TEST(test_host_heap_tracks_process_usage);
+  return UNITY_END();
+}
@@ -0,0 +1,75 @@
+#include <unity.h>
+
+#include <cstring>
+
+// Como -D LOG_LEVEL_SHT45=LOG_LEVEL_ERROR en build_flags.
+#define LOG_LEVEL_SHT45 LOG_LEVEL_ERROR
+
+#include "log.h"
+
+namespace {
+int g_evaluated = 0;
+
+int sideEffect() {
+  ++g_evaluated;
+  return 42;
+}
+
+const char* formatNext() {
+  static char line[LogRing::kLineLength];
+  LogRing::Entry entry;
+  line[0] = '\0';
+  if (LogRing::pop(entry)) {
+    LogRing::format(entry, line, sizeof(line));
+  }
+  return line;
+}
+}  // namespace
+
+static_assert(LOG_ENABLED(SHT45, ERROR), "ERROR activo en SHT45");
+static_assert(!LOG_ENABLED(SHT45, WARN), "WARN filtrado en SHT45");
+static_assert(LOG_ENABLED(WIFI, DEBUG), "el resto de modulos sigue en LOG_LEVEL");
+
+void setUp() {
+  g_evaluated = 0;
+  LogRing::begin();
+}
+
+void tearDown() {}
+
+void test_enabled_level_logs_with_module_tag() {
+  LOG_ERROR(SHT45, "Lectura fallida (%d)\n", sideEffect());
+  TEST_ASSERT_EQUAL_INT(1, g_evaluated);
+  TEST_ASSERT_EQUAL_STRING("[SHT45] Lectura fallida (42)\n", formatNext());
+
+  LOG_DEBUG(WIFI, "Reintento %d\n", 3);
+  TEST_ASSERT_EQUAL_STRING("[WIFI] Reintento 3\n", formatNext());
+}
+
+void test_disabled_level_does_not_evaluate_arguments() {
+  const uint32_t before = LogRing::stats().logged;
+  LOG_WARN(SHT45, "No se encontro SHT45 %d\n", sideEffect());
+  LOG_INFO(SHT45, "Sensor inicializado %d\n", sideEffect());
+  LOG_DEBUG(SHT45, "T=%d\n", sideEffect());
+  LOG_RAW(SHT45, DEBUG, "[SHT45] tabla %d\n", sideEffect());
+  TEST_ASSERT_EQUAL_INT(0, g_evaluated);
+  TEST_ASSERT_EQUAL_UINT32(before, LogRing::stats().logged);
+  TEST_ASSERT_EQUAL_STRING("", formatNext());
+}
+
+void test_macro_is_a_single_statement() {
+  // Sin llaves: el else debe seguir emparejado con el if de fuera.
+  if (sideEffect() == 0)
+    LOG_ERROR(SHT45, "nunca\n");
+  else
+    LOG_ERROR(SHT45, "rama else\n");
+  TEST_ASSERT_EQUAL_STRING("[SHT45] rama else\n", formatNext());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_enabled_level_logs_with_module_tag);
+  RUN_TEST(test_disabled_level_does_not_evaluate_arguments);
+  RUN_TEST(test_macro_is_a_single_statement);
+  return UNITY_END();
+}
@@ -0,0 +1,190 @@
+#include <unity.h>
+
+#include <esp_system_host.h>
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "log_ring.h"
+
+namespace {
+char g_line[LogRing::kLineLength];
+
+const char* formatNext() {
+  LogRing::Entry entry;
+  g_line[0] = '\0';
+  if (LogRing::pop(entry)) {
+    LogRing::format(entry, g_line, sizeof(g_line));
+  }
+  return g_line;
+}
+
+void drainAll() {
+  LogRing::Entry entry;
+  while (LogRing::pop(entry)) {
+  }
+}
+
+// Lo que hacia logWithDeviceId() antes, sin la escritura al UART.
+char g_formatted[256];
+void formatNow(const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(g_formatted, sizeof(g_formatted), fmt, args);
+  va_end(args);
+}
+}  // namespace
+
+void setUp() {
+  EspSystemHost::setResetReason(ESP_RST_POWERON);
+  LogRing::begin();
+}
+
+void tearDown() {}
+
+void test_formats_common_specifiers() {
+  LogRing::log("[MQTT] Reintento por %s en %lu ms\n", "timeout", static_cast<unsigned long>(4000000000u));
+  TEST_ASSERT_EQUAL_STRING("[MQTT] Reintento por timeout en 4000000000 ms\n", formatNext());
+
+  LogRing::log("[WIFI] motivo %ld, rssi %d, %u%%\n", static_cast<long>(-201), -67, 42u);
+  TEST_ASSERT_EQUAL_STRING("[WIFI] motivo -201, rssi -67, 42%\n", formatNext());
+
+  LogRing::log("vpd=%.2f hex=%04x big=%lld flag=%d\n", 1.2345, 0xbeefu, -5000000000LL, true);
+  TEST_ASSERT_EQUAL_STRING("vpd=1.23 hex=beef big=-5000000000 flag=1\n", formatNext());
+
+  LogRing::log("[%-6s|%5s]\n", "ab", "cd");
+  TEST_ASSERT_EQUAL_STRING("[ab    |   cd]\n", formatNext());
+}
+
+void test_string_is_copied_at_log_time() {
+  char buffer[16];
+  std::strcpy(buffer, "antes");
+  LogRing::log("[ESTADO] %s\n", buffer);
+  std::strcpy(buffer, "despues");
+  TEST_ASSERT_EQUAL_STRING("[ESTADO] antes\n", formatNext());
+}
+
+void test_long_arguments_are_truncated_not_misaligned() {
+  const char* topic = "lab/devices/lab_0123456789abcdef/sensor_registry/with/a/very/long/suffix";
+  LogRing::log("topic=%s bytes=%u\n", topic, 512u);
+
+  LogRing::Entry entry;
+  TEST_ASSERT_TRUE(LogRing::pop(entry));
+  TEST_ASSERT_TRUE(entry.flags & LogRing::kFlagTruncated);
+  LogRing::format(entry, g_line, sizeof(g_line));
+  TEST_ASSERT_EQUAL_INT(0, std::strncmp("topic=lab/devices/", g_line, 18));
+  TEST_ASSERT_NOT_NULL(std::strstr(g_line, " bytes=<?>\n"));
+  TEST_ASSERT_EQUAL_UINT32(1, LogRing::stats().truncated);
+}
+
+void test_overflow_keeps_newest_and_counts_lost() {
+  for (unsigned i = 0; i < LogRing::kCapacity + 8; ++i) {
+    LogRing::log("n=%u\n", i);
+  }
+  TEST_ASSERT_EQUAL_STRING("n=8\n", formatNext());
+  TEST_ASSERT_EQUAL_UINT32(8, LogRing::stats().lost);
+  drainAll();
+  TEST_ASSERT_EQUAL_UINT32(LogRing::kCapacity, LogRing::stats().drained);
+}
+
+void test_entries_survive_soft_reset_only() {
+  LogRing::log("[WIFI] Backoff maximo alcanzado, reiniciando...\n");
+  LogRing::log("[AWS] Mensaje %d\n", 2);
+  LogRing::log("[AWS] Mensaje %d\n", 3);
+  drainAll();
+
+  EspSystemHost::setResetReason(ESP_RST_PANIC);
+  LogRing::begin();
+  TEST_ASSERT_EQUAL_UINT32(3, LogRing::stats().previousBoot);
+  LogRing::log("[BOOT] nuevo\n");
+
+  LogRing::Entry entry;
+  bool previous = false;
+  TEST_ASSERT_TRUE(LogRing::pop(entry, &previous));
+  TEST_ASSERT_TRUE(previous);
+  LogRing::format(entry, g_line, sizeof(g_line));
+  TEST_ASSERT_EQUAL_STRING("[WIFI] Backoff maximo alcanzado, reiniciando...\n", g_line);
+  TEST_ASSERT_TRUE(LogRing::pop(entry, &previous));
+  TEST_ASSERT_TRUE(LogRing::pop(entry, &previous));
+  TEST_ASSERT_TRUE(previous);
+  TEST_ASSERT_TRUE(LogRing::pop(entry, &previous));
+  TEST_ASSERT_FALSE(previous);
+  LogRing::format(entry, g_line, sizeof(g_line));
+  TEST_ASSERT_EQUAL_STRING("[BOOT] nuevo\n", g_line);
+
+  // Un arranque en frio no hereda nada.
+  EspSystemHost::setResetReason(ESP_RST_POWERON);
+  LogRing::begin();
+  TEST_ASSERT_EQUAL_UINT32(0, LogRing::stats().previousBoot);
+  TEST_ASSERT_FALSE(LogRing::pop(entry));
+}
+
+void test_drain_writes_prefixed_lines() {
+  LogRing::setPrefix("lab_000001");
+  LogRing::log("[MQTT] Conectado\n");
+  LogRing::log("[MQTT] Desconectado\n");
+  TEST_ASSERT_EQUAL_UINT32(2, LogRing::drain(SIZE_MAX));
+  TEST_ASSERT_EQUAL_UINT32(0, LogRing::drain(SIZE_MAX));
+  LogRing::setPrefix(nullptr);
+}
+
+// Arranca log_drain: va la ultima, el hilo queda vaciando el anillo.
+void test_raw_goes_through_drain_from_its_task_only() {
+  LogRing::raw("[SCHED] %-12s runs=%lu\n", "sin_drain", 1UL);
+  TEST_ASSERT_EQUAL_UINT32(1, LogRing::stats().rawDirect);
+  TEST_ASSERT_EQUAL_UINT32(0, LogRing::stats().rawQueued);
+
+  LogRing::startDrain();
+  LogRing::raw("[SCHED] %-12s runs=%lu\n", "con_drain", 2UL);
+  TEST_ASSERT_EQUAL_UINT32(1, LogRing::stats().rawQueued);
+  TEST_ASSERT_EQUAL_UINT32(1, LogRing::stats().rawDirect);
+
+  std::thread other([] { LogRing::raw("[I2C] desde otra tarea\n"); });
+  other.join();
+  TEST_ASSERT_EQUAL_UINT32(1, LogRing::stats().rawQueued);
+  TEST_ASSERT_EQUAL_UINT32(2, LogRing::stats().rawDirect);
+}
+
+void test_log_cost_vs_vsnprintf() {
+  constexpr int kIterations = 200000;
+  const char* topic = "lab/devices/lab_000001/heartbeat";
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    LogRing::log("[AWS] Publicando sensor_registry -> topic=%s bytes=%u\n", topic, static_cast<unsigned>(i));
+    if ((i & 15) == 15) {
+      drainAll();
+    }
+  }
+  const double ringNs =
+      std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kIterations;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    formatNow("[AWS] Publicando sensor_registry -> topic=%s bytes=%u\n", topic, static_cast<unsigned>(i));
+  }
+  const double formatNs =
+      std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kIterations;
+
+  // A 115200 baudios cada byte tarda ~87 us en salir del UART.
+  const size_t lineBytes = std::strlen(g_formatted) + 13;
+  std::printf("[BENCH] log/ring %.0f ns, vsnprintf %.0f ns (host); linea de %u bytes = %.1f ms de UART\n",
+              ringNs, formatNs, static_cast<unsigned>(lineBytes), lineBytes * 10 * 1000.0 / 115200);
+  TEST_ASSERT_TRUE(ringNs > 0);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_formats_common_specifiers);
+  RUN_TEST(test_string_is_copied_at_log_time);
+  RUN_TEST(test_long_arguments_are_truncated_not_misaligned);
+  RUN_TEST(test_overflow_keeps_newest_and_counts_lost);
+  RUN_TEST(test_entries_survive_soft_reset_only);
+  RUN_TEST(test_drain_writes_prefixed_lines);
+  RUN_TEST(test_log_cost_vs_vsnprintf);
+  RUN_TEST(test_raw_goes_through_drain_from_its_task_only);
+  return UNITY_END();
+}
@@ -0,0 +1,136 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cstdio>
+
+#include "loop_profiler.h"
+
+namespace {
+LoopProfiler::SlotId g_aws = LoopProfiler::kInvalidSlot;
+LoopProfiler::SlotId g_telemetry = LoopProfiler::kInvalidSlot;
+LoopProfiler::SlotId g_display = LoopProfiler::kInvalidSlot;
+
+uint32_t bucketCount(LoopProfiler::SlotId slot, size_t bucket) {
+  LoopProfiler::SlotStats s;
+  LoopProfiler::stats(slot, s);
+  return s.buckets[bucket];
+}
+}  // namespace
+
+void setUp() { LoopProfiler::reset(); }
+
+void tearDown() {}
+
+void test_bucket_boundaries() {
+  TEST_ASSERT_EQUAL_UINT32(0, LoopProfiler::bucketFor(0));
+  TEST_ASSERT_EQUAL_UINT32(0, LoopProfiler::bucketFor(3));
+  TEST_ASSERT_EQUAL_UINT32(1, LoopProfiler::bucketFor(4));
+  TEST_ASSERT_EQUAL_UINT32(1, LoopProfiler::bucketFor(7));
+  TEST_ASSERT_EQUAL_UINT32(2, LoopProfiler::bucketFor(8));
+  TEST_ASSERT_EQUAL_UINT32(8, LoopProfiler::bucketFor(1000));
+  TEST_ASSERT_EQUAL_UINT32(14, LoopProfiler::bucketFor(65535));
+  TEST_ASSERT_EQUAL_UINT32(15, LoopProfiler::bucketFor(65536));
+  TEST_ASSERT_EQUAL_UINT32(15, LoopProfiler::bucketFor(5000000));
+  TEST_ASSERT_EQUAL_UINT32(15, LoopProfiler::bucketFor(0xFFFFFFFFu));
+
+  for (size_t bucket = 1; bucket < LoopProfiler::kBucketCount; ++bucket) {
+    const uint32_t floorUs = LoopProfiler::bucketFloorUs(bucket);
+    TEST_ASSERT_EQUAL_UINT32(bucket, LoopProfiler::bucketFor(floorUs));
+    TEST_ASSERT_EQUAL_UINT32(bucket - 1, LoopProfiler::bucketFor(floorUs - 1));
+  }
+}
+
+void test_record_builds_histogram_and_max() {
+  LoopProfiler::record(g_aws, 10);
+  LoopProfiler::record(g_aws, 12);
+  LoopProfiler::record(g_aws, 90000);
+
+  LoopProfiler::SlotStats s;
+  TEST_ASSERT_TRUE(LoopProfiler::stats(g_aws, s));
+  TEST_ASSERT_EQUAL_STRING("aws", s.name);
+  TEST_ASSERT_EQUAL_UINT32(3, s.calls);
+  TEST_ASSERT_EQUAL_UINT32(90000, s.maxUs);
+  TEST_ASSERT_EQUAL_UINT32(2, bucketCount(g_aws, 2));
+  TEST_ASSERT_EQUAL_UINT32(1, bucketCount(g_aws, 15));
+}
+
+void test_worst_samples_are_sorted_and_bounded() {
+  const uint32_t durations[] = {500, 90000, 20, 7000, 120000, 300, 45000};
+  for (uint32_t us : durations) {
+    LoopProfiler::record(us == 45000 ? g_display : g_telemetry, us);
+  }
+
+  LoopProfiler::Sample worst[LoopProfiler::kWorstCount + 2];
+  const size_t count = LoopProfiler::worst(worst, LoopProfiler::kWorstCount + 2);
+  TEST_ASSERT_EQUAL_UINT32(LoopProfiler::kWorstCount, count);
+  TEST_ASSERT_EQUAL_UINT32(120000, worst[0].us);
+  TEST_ASSERT_EQUAL_UINT32(90000, worst[1].us);
+  TEST_ASSERT_EQUAL_UINT32(45000, worst[2].us);
+  TEST_ASSERT_EQUAL_UINT32(7000, worst[3].us);
+  TEST_ASSERT_EQUAL_UINT8(g_display, worst[2].slot);
+}
+
+void test_window_reports_top_slots_and_restarts() {
+  LoopProfiler::record(g_aws, 300);
+  LoopProfiler::record(g_telemetry, 9000);
+  LoopProfiler::record(g_display, 1200);
+  LoopProfiler::record(g_aws, 2500);
+
+  LoopProfiler::Sample window[2];
+  TEST_ASSERT_EQUAL_UINT32(2, LoopProfiler::takeWindow(window, 2));
+  TEST_ASSERT_EQUAL_UINT8(g_telemetry, window[0].slot);
+  TEST_ASSERT_EQUAL_UINT32(9000, window[0].us);
+  TEST_ASSERT_EQUAL_UINT8(g_aws, window[1].slot);
+  TEST_ASSERT_EQUAL_UINT32(2500, window[1].us);
+
+  // Ventana nueva: solo lo registrado despues.
+  LoopProfiler::record(g_display, 50);
+  TEST_ASSERT_EQUAL_UINT32(1, LoopProfiler::takeWindow(window, 2));
+  TEST_ASSERT_EQUAL_UINT8(g_display, window[0].slot);
+}
+
+void test_scope_records_nested_handlers() {
+  {
+    LoopProfiler::Scope outer(g_aws);
+    LoopProfiler::Scope inner(g_telemetry);
+  }
+  LoopProfiler::Scope invalid(LoopProfiler::kInvalidSlot);
+
+  LoopProfiler::SlotStats s;
+  LoopProfiler::stats(g_aws, s);
+  TEST_ASSERT_EQUAL_UINT32(1, s.calls);
+  LoopProfiler::stats(g_telemetry, s);
+  TEST_ASSERT_EQUAL_UINT32(1, s.calls);
+}
+
+void test_scope_overhead() {
+  constexpr int kIterations = 200000;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    LoopProfiler::Scope scope(g_display);
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const double nsPerScope =
+      std::chrono::duration<double, std::nano>(elapsed).count() / kIterations;
+  printf("[BENCH] loop_prof/scope %.0f ns por handler (host, 2 lecturas de reloj)\n", nsPerScope);
+
+  LoopProfiler::SlotStats s;
+  LoopProfiler::stats(g_display, s);
+  TEST_ASSERT_EQUAL_UINT32(kIterations, s.calls);
+}
+
+int main(int, char**) {
+  g_aws = LoopProfiler::addSlot("aws");
+  g_telemetry = LoopProfiler::addSlot("telemetry");
+  g_display = LoopProfiler::addSlot("oled_loop");
+  LoopProfiler::begin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_bucket_boundaries);
+  RUN_TEST(test_record_builds_histogram_and_max);
+  RUN_TEST(test_worst_samples_are_sorted_and_bounded);
+  RUN_TEST(test_window_reports_top_slots_and_restarts);
+  RUN_TEST(test_scope_records_nested_handlers);
+  RUN_TEST(test_scope_overhead);
+  return UNITY_END();
+}
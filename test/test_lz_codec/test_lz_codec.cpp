@@ -0,0 +1,153 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "lz_codec.h"
+
+namespace {
+// Salida real de SensorRegistry::buildPayload y Sht45Sensor::buildTelemetryPayload
+// capturada por serial (el host no tiene String de Arduino).
+const char kRegistryPayload[] =
+    "{\"device_id\":\"lab_A1B2C3\",\"sensor_key\":\"ambient_1\",\"sensor_type\":\"sht45\","
+    "\"vendor\":\"adafruit\",\"model\":\"SHT45\",\"i2c_address\":\"0x44\",\"bus\":\"i2c0\","
+    "\"position\":\"canopy\",\"is_active\":true,\"measures\":[\"temperature_c\","
+    "\"humidity_rh\",\"vpd_kpa\"],\"unit_map\":{\"temperature_c\":\"C\",\"humidity_rh\":\"%\","
+    "\"vpd_kpa\":\"kPa\"},\"metadata\":{\"source\":\"firmware\"},"
+    "\"event_key\":\"lab_A1B2C3-sensor_registry-1767225600123-7\"}";
+
+std::string telemetryPayload(unsigned index) {
+  char buffer[320];
+  snprintf(buffer, sizeof(buffer),
+           "{\"device_id\":\"lab_A1B2C3\",\"sensor_key\":\"ambient_1\",\"temperature_c\":%u.%02u,"
+           "\"humidity_rh\":%u.%02u,\"vpd_kpa\":1.%02u,\"uptime_ms\":%u,\"time_synced\":true,"
+           "\"ts_ms\":%llu,\"event_key\":\"lab_A1B2C3-telemetry-%llu-%u\"}",
+           24 + index % 3, (index * 37) % 100, 60 + index % 9, (index * 53) % 100,
+           (index * 11) % 100, 123456 + index * 60000,
+           1767225600000ULL + index * 60000ULL, 1767225600000ULL + index * 60000ULL, index);
+  return buffer;
+}
+
+// Lote como el que produciria una cola de telemetria diferida.
+std::string telemetryBatch(unsigned count) {
+  std::string batch = "[";
+  for (unsigned i = 0; i < count; ++i) {
+    batch += (i > 0 ? "," : "") + telemetryPayload(i);
+  }
+  return batch + "]";
+}
+
+void roundTrip(const std::string& input, const LzCodec::Params& params, size_t* packedOut) {
+  std::vector<uint8_t> compressed(input.size() * 2);
+  const size_t packed = LzCodec::compress(reinterpret_cast<const uint8_t*>(input.data()),
+                                          input.size(), compressed.data(), compressed.size(),
+                                          params);
+  TEST_ASSERT_GREATER_THAN(0, packed);
+
+  std::vector<uint8_t> restored(input.size());
+  const size_t unpacked =
+      LzCodec::decompress(compressed.data(), packed, restored.data(), restored.size(), params);
+  TEST_ASSERT_EQUAL_UINT32(input.size(), unpacked);
+  TEST_ASSERT_EQUAL_MEMORY(input.data(), restored.data(), input.size());
+  if (packedOut) {
+    *packedOut = packed;
+  }
+}
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_round_trip_real_payloads() {
+  const std::string registry = kRegistryPayload;
+  size_t packed = 0;
+  roundTrip(registry, LzCodec::kDefaultParams, &packed);
+  // Un payload suelto tiene pocas repeticiones largas; el ahorro fuerte esta en lotes.
+  TEST_ASSERT_LESS_THAN(registry.size() * 9 / 10, packed);
+
+  roundTrip(telemetryPayload(1), LzCodec::kDefaultParams, nullptr);
+  const std::string batch = telemetryBatch(8);
+  roundTrip(batch, LzCodec::kDefaultParams, &packed);
+  TEST_ASSERT_LESS_THAN(batch.size() / 2, packed);
+}
+
+void test_round_trip_edge_cases() {
+  roundTrip("a", LzCodec::kDefaultParams, nullptr);
+  roundTrip(std::string(1000, 'x'), LzCodec::kDefaultParams, nullptr);
+
+  // Datos sin repeticion: crecen 1/8 y no caben en un buffer del tamano original.
+  std::string noise;
+  uint32_t x = 0x12345678u;
+  for (int i = 0; i < 200; ++i) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    noise.push_back(static_cast<char>(x));
+  }
+  std::vector<uint8_t> out(noise.size());
+  TEST_ASSERT_EQUAL_UINT32(0, LzCodec::compress(reinterpret_cast<const uint8_t*>(noise.data()),
+                                                noise.size(), out.data(), out.size()));
+  roundTrip(noise, LzCodec::kDefaultParams, nullptr);
+}
+
+void test_rejects_corrupt_input() {
+  // Tag 0 con offset 1 antes de emitir ningun byte.
+  const uint8_t bad[] = {0x00, 0x00};
+  uint8_t out[16];
+  TEST_ASSERT_EQUAL_UINT32(0, LzCodec::decompress(bad, sizeof(bad), out, sizeof(out)));
+
+  const std::string registry = kRegistryPayload;
+  std::vector<uint8_t> compressed(registry.size());
+  const size_t packed = LzCodec::compress(reinterpret_cast<const uint8_t*>(registry.data()),
+                                          registry.size(), compressed.data(), compressed.size());
+  std::vector<uint8_t> small(registry.size() / 2);
+  TEST_ASSERT_EQUAL_UINT32(
+      0, LzCodec::decompress(compressed.data(), packed, small.data(), small.size()));
+}
+
+// Ratio vs CPU por tamano de ventana. En host solo sirve para comparar
+// configuraciones; los tiempos en el C3 salen con -D MQTT_COMPRESSION_BENCHMARK=1.
+void test_benchmark_ratio_vs_cpu() {
+  struct Sample {
+    const char* name;
+    std::string payload;
+  };
+  const Sample samples[] = {
+      {"registry", kRegistryPayload},
+      {"telemetry", telemetryPayload(1)},
+      {"telemetry_x8", telemetryBatch(8)},
+  };
+  const LzCodec::Params configs[] = {{6, 3}, {7, 4}, {8, 4}, {9, 5}, {10, 5}};
+  constexpr int kIterations = 200;
+
+  for (const Sample& sample : samples) {
+    for (const LzCodec::Params& params : configs) {
+      std::vector<uint8_t> out(sample.payload.size() * 2);
+      size_t packed = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < kIterations; ++i) {
+        packed = LzCodec::compress(reinterpret_cast<const uint8_t*>(sample.payload.data()),
+                                   sample.payload.size(), out.data(), out.size(), params);
+      }
+      const auto elapsed = std::chrono::steady_clock::now() - start;
+      const double usPerRun =
+          std::chrono::duration<double, std::micro>(elapsed).count() / kIterations;
+      printf("[LZ] %-13s w=%2u l=%u %4zu -> %4zu bytes (%5.1f%%) %8.1f us\n", sample.name,
+             params.windowBits, params.lookaheadBits, sample.payload.size(), packed,
+             100.0 * packed / sample.payload.size(), usPerRun);
+      TEST_ASSERT_GREATER_THAN(0, packed);
+    }
+  }
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_real_payloads);
+  RUN_TEST(test_round_trip_edge_cases);
+  RUN_TEST(test_rejects_corrupt_input);
+  RUN_TEST(test_benchmark_ratio_vs_cpu);
+  return UNITY_END();
+}
@@ -0,0 +1,114 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cstdio>
+
+#include "metrics.h"
+
+namespace {
+char g_payload[512];
+
+const char* snapshot(uint32_t nowMs) {
+  g_payload[0] = '\0';
+  Metrics::writeSnapshot(g_payload, sizeof(g_payload), nowMs);
+  return g_payload;
+}
+}  // namespace
+
+void setUp() {
+  Metrics::reset(0);
+}
+
+void tearDown() {}
+
+void test_buckets_are_powers_of_two() {
+  TEST_ASSERT_EQUAL_UINT32(0, Metrics::bucketFor(0));
+  TEST_ASSERT_EQUAL_UINT32(1, Metrics::bucketFor(1));
+  TEST_ASSERT_EQUAL_UINT32(2, Metrics::bucketFor(2));
+  TEST_ASSERT_EQUAL_UINT32(2, Metrics::bucketFor(3));
+  TEST_ASSERT_EQUAL_UINT32(3, Metrics::bucketFor(4));
+  TEST_ASSERT_EQUAL_UINT32(10, Metrics::bucketFor(1023));
+  TEST_ASSERT_EQUAL_UINT32(11, Metrics::bucketFor(1024));
+  TEST_ASSERT_EQUAL_UINT32(11, Metrics::bucketFor(0xFFFFFFFFu));
+}
+
+void test_snapshot_has_only_what_changed() {
+  TEST_ASSERT_EQUAL_STRING("{\"seq\":0,\"dt\":1000}", snapshot(1000));
+
+  Metrics::increment(Metrics::Counter::PUBLISHES);
+  Metrics::increment(Metrics::Counter::PUBLISHES);
+  Metrics::increment(Metrics::Counter::BYTES_SENT, 420);
+  Metrics::set(Metrics::Gauge::WIFI_RSSI, -61);
+  Metrics::observe(Metrics::Histogram::LOOP_LAG_MS, 0);
+  Metrics::observe(Metrics::Histogram::LOOP_LAG_MS, 5);
+  Metrics::observe(Metrics::Histogram::LOOP_LAG_MS, 3);
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"seq\":0,\"dt\":60000,\"c\":{\"pub\":2,\"tx_bytes\":420},\"g\":{\"rssi\":-61},"
+      "\"h\":{\"lag_ms\":[3,8,5,1,0,1,1]}}",
+      snapshot(60000));
+  Metrics::commitSnapshot();
+
+  // Mismo gauge y sin cambios: nada que enviar salvo la cabecera.
+  Metrics::set(Metrics::Gauge::WIFI_RSSI, -61);
+  TEST_ASSERT_EQUAL_STRING("{\"seq\":1,\"dt\":60000}", snapshot(120000));
+  Metrics::commitSnapshot();
+
+  Metrics::increment(Metrics::Counter::PUBLISHES);
+  Metrics::set(Metrics::Gauge::WIFI_RSSI, -70);
+  Metrics::observe(Metrics::Histogram::LOOP_LAG_MS, 1);
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"seq\":2,\"dt\":60000,\"c\":{\"pub\":1},\"g\":{\"rssi\":-70},\"h\":{\"lag_ms\":[1,1,1,0,1]}}",
+      snapshot(180000));
+}
+
+void test_uncommitted_snapshot_is_merged_into_next() {
+  Metrics::increment(Metrics::Counter::SENSOR_ERRORS);
+  snapshot(60000);
+  // Publish fallido: sin commitSnapshot().
+  Metrics::increment(Metrics::Counter::SENSOR_ERRORS);
+  Metrics::increment(Metrics::Counter::MQTT_RECONNECTS);
+  TEST_ASSERT_EQUAL_STRING("{\"seq\":0,\"dt\":120000,\"c\":{\"mqtt_reconn\":1,\"sensor_err\":2}}",
+                           snapshot(120000));
+  Metrics::commitSnapshot();
+  TEST_ASSERT_EQUAL_STRING("{\"seq\":1,\"dt\":0}", snapshot(120000));
+}
+
+void test_histogram_max_is_per_window() {
+  Metrics::observe(Metrics::Histogram::PUBLISH_BYTES, 900);
+  snapshot(1000);
+  Metrics::commitSnapshot();
+  Metrics::observe(Metrics::Histogram::PUBLISH_BYTES, 100);
+  TEST_ASSERT_EQUAL_STRING("{\"seq\":1,\"dt\":1000,\"h\":{\"pub_bytes\":[1,100,100,0,0,0,0,0,0,0,1]}}",
+                           snapshot(2000));
+  TEST_ASSERT_EQUAL_UINT32(2, Metrics::stats(Metrics::Histogram::PUBLISH_BYTES).count);
+}
+
+void test_small_buffer_returns_zero() {
+  Metrics::increment(Metrics::Counter::PUBLISH_FAILURES, 7);
+  char small[16];
+  TEST_ASSERT_EQUAL_UINT32(0, Metrics::writeSnapshot(small, sizeof(small), 1000));
+}
+
+void test_update_cost() {
+  constexpr int kIterations = 1000000;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    Metrics::increment(Metrics::Counter::PUBLISHES);
+    Metrics::observe(Metrics::Histogram::LOOP_LAG_MS, static_cast<uint32_t>(i & 1023));
+  }
+  const double ns =
+      std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kIterations;
+  std::printf("[BENCH] metrics/increment+observe %.1f ns (host)\n", ns);
+  TEST_ASSERT_EQUAL_UINT32(kIterations, Metrics::value(Metrics::Counter::PUBLISHES));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_buckets_are_powers_of_two);
+  RUN_TEST(test_snapshot_has_only_what_changed);
+  RUN_TEST(test_uncommitted_snapshot_is_merged_into_next);
+  RUN_TEST(test_histogram_max_is_per_window);
+  RUN_TEST(test_small_buffer_returns_zero);
+  RUN_TEST(test_update_cost);
+  return UNITY_END();
+}
@@ -0,0 +1,201 @@
+#include <unity.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "i2c_bus.h"
+#include "oled_display.h"
+#include "u8g2_host.h"
+#include "wire_host.h"
+
+// Render de la OLED sobre el SSD1306 emulado: el panel debe acabar igual que
+// con un envio completo, pero moviendo solo los tiles que cambian. El bus
+// pasa por I2cBus real sobre Wire y FreeRTOS emulados.
+namespace {
+constexpr uint32_t kBlinkIntervalMs = 600;
+constexpr uint32_t kBusClockHz = 400000;
+constexpr int kToggles = 200;
+
+void bootDisplay() {
+  WireHost::reset();
+  I2cBus::begin();
+  U8g2Host::reset();
+  Display::begin();
+  Display::setBleActive(false);
+  Display::setConnectionStatus(false);
+  Display::forceRender();
+  U8g2Host::resetStats();
+  Display::resetStats();
+}
+
+// Tras un render parcial, el panel coincide con un reenvio completo.
+void assertPanelMatchesFullFrame() {
+  uint8_t partial[U8g2Host::kPanelBytes];
+  std::memcpy(partial, U8g2Host::panel(), sizeof(partial));
+  Display::forceRender();
+  TEST_ASSERT_EQUAL_MEMORY(U8g2Host::panel(), partial, sizeof(partial));
+}
+
+// 9 bits por byte (ACK incluido) a la velocidad del bus.
+unsigned long wireUs(uint64_t bytes) {
+  return static_cast<unsigned long>(bytes * 9 * 1000000ULL / kBusClockHz);
+}
+}  // namespace
+
+void setUp() { bootDisplay(); }
+
+void tearDown() {}
+
+void test_first_render_sends_full_frame() {
+  U8g2Host::reset();
+  Display::begin();
+  Display::resetStats();
+  U8g2Host::resetStats();
+  Display::forceRender();
+
+  const U8g2Host::Stats host = U8g2Host::stats();
+  // clearDisplay() de U8g2 al arrancar el panel y el frame completo.
+  TEST_ASSERT_EQUAL_UINT32(1, host.fullSends);
+  TEST_ASSERT_EQUAL_UINT32(256, host.tilesSent);
+  TEST_ASSERT_EQUAL_UINT32(1, Display::stats().fullFrames);
+  TEST_ASSERT_EQUAL_UINT32(host.i2cBytes, Display::stats().i2cBytes);
+}
+
+void test_unchanged_state_sends_nothing() {
+  Display::setConnectionStatus(false);
+  Display::loop();
+  Display::loop();
+
+  TEST_ASSERT_EQUAL_UINT64(0, U8g2Host::stats().i2cBytes);
+  TEST_ASSERT_EQUAL_UINT32(0, Display::stats().renders);
+}
+
+void test_fill_toggle_sends_only_disc_tiles() {
+  Display::setConnectionStatus(true);
+  Display::loop();
+
+  const U8g2Host::Stats host = U8g2Host::stats();
+  TEST_ASSERT_EQUAL_UINT32(0, host.fullSends);
+  TEST_ASSERT_TRUE(host.areaUpdates > 0);
+  // El disco (r=10 en 64,44) cae en 4x3 tiles.
+  TEST_ASSERT_TRUE(host.tilesSent <= 12);
+  TEST_ASSERT_EQUAL_UINT32(host.tilesSent, Display::stats().tilesSent);
+  TEST_ASSERT_EQUAL_UINT32(host.i2cBytes, Display::stats().i2cBytes);
+  assertPanelMatchesFullFrame();
+
+  Display::setConnectionStatus(false);
+  Display::loop();
+  assertPanelMatchesFullFrame();
+}
+
+void test_panel_matches_after_many_toggles() {
+  for (int i = 0; i < 50; ++i) {
+    Display::setConnectionStatus(i % 2 == 0);
+    Display::setBleActive(i % 7 == 3);
+    Display::loop();
+  }
+  assertPanelMatchesFullFrame();
+}
+
+void test_sensor_on_bus_defers_frame() {
+  I2cBus::configure(I2cBus::Client::SENSOR, 5, 6, 400000);
+  TEST_ASSERT_TRUE(I2cBus::acquire(I2cBus::Client::SENSOR, 0));
+  Display::setConnectionStatus(true);
+  Display::loop();
+  TEST_ASSERT_EQUAL_UINT64(0, U8g2Host::stats().i2cBytes);
+  TEST_ASSERT_EQUAL_UINT32(1, Display::stats().deferred);
+  TEST_ASSERT_EQUAL_UINT32(0, Display::stats().renders);
+
+  // El frame pendiente sale en cuanto el bus queda libre.
+  I2cBus::release(I2cBus::Client::SENSOR);
+  Display::loop();
+  TEST_ASSERT_EQUAL_UINT32(1, Display::stats().renders);
+  TEST_ASSERT_TRUE(U8g2Host::stats().tilesSent > 0);
+  assertPanelMatchesFullFrame();
+
+  const I2cBus::Stats bus = I2cBus::stats();
+  TEST_ASSERT_EQUAL_UINT32(1, bus.clients[static_cast<size_t>(I2cBus::Client::OLED)].timeouts);
+  TEST_ASSERT_EQUAL_UINT32(1, bus.clients[static_cast<size_t>(I2cBus::Client::SENSOR)].transactions);
+}
+
+void test_update_wait_drives_the_display_job() {
+  const uint32_t now = millis();
+  TEST_ASSERT_EQUAL_UINT32(Display::kNoUpdate, Display::msUntilUpdate(now));
+
+  Display::setConnectionStatus(true);
+  TEST_ASSERT_EQUAL_UINT32(0, Display::msUntilUpdate(now));
+  Display::loop();
+  TEST_ASSERT_EQUAL_UINT32(Display::kNoUpdate, Display::msUntilUpdate(now));
+
+  // Con BLE activo espera al siguiente parpadeo.
+  Display::setBleActive(true);
+  Display::loop();
+  const uint32_t waitMs = Display::msUntilUpdate(millis());
+  TEST_ASSERT_TRUE(waitMs > 0 && waitMs != Display::kNoUpdate);
+  TEST_ASSERT_EQUAL_UINT32(0, Display::msUntilUpdate(millis() + waitMs));
+}
+
+void test_bus_remaps_pins_between_clients() {
+  const uint32_t switchesBefore = I2cBus::stats().pinSwitches;
+  I2cBus::configure(I2cBus::Client::SENSOR, 8, 9, 400000);
+  TEST_ASSERT_TRUE(I2cBus::acquire(I2cBus::Client::SENSOR, 0));
+  TEST_ASSERT_EQUAL_INT(8, WireHost::config().sdaPin);
+  TEST_ASSERT_EQUAL_INT(9, WireHost::config().sclPin);
+  I2cBus::release(I2cBus::Client::SENSOR);
+
+  Display::setConnectionStatus(true);
+  Display::loop();
+  TEST_ASSERT_EQUAL_INT(5, WireHost::config().sdaPin);
+  TEST_ASSERT_EQUAL_INT(6, WireHost::config().sclPin);
+  TEST_ASSERT_EQUAL_UINT32(switchesBefore + 2, I2cBus::stats().pinSwitches);
+
+  // Mismo cliente otra vez: sin reiniciar el driver.
+  Display::setConnectionStatus(false);
+  Display::loop();
+  TEST_ASSERT_EQUAL_UINT32(switchesBefore + 2, I2cBus::stats().pinSwitches);
+}
+
+void test_blink_bytes_per_second() {
+  // Antes: cada render hacia sendBuffer() del frame completo.
+  Display::forceRender();
+  const Display::Stats full = Display::stats();
+  const uint32_t fullBytes = full.i2cBytes;
+  const uint32_t fullUs = full.lastRenderUs;
+  Display::resetStats();
+  U8g2Host::resetStats();
+
+  // Mismo cambio de pixels que el parpadeo BLE, sin esperar 600 ms reales.
+  for (int i = 0; i < kToggles; ++i) {
+    Display::setConnectionStatus(i % 2 == 0);
+    Display::loop();
+  }
+  const Display::Stats dirty = Display::stats();
+  TEST_ASSERT_EQUAL_UINT32(kToggles, dirty.renders);
+  TEST_ASSERT_EQUAL_UINT32(0, dirty.fullFrames);
+
+  const uint32_t dirtyBytes = dirty.i2cBytes / kToggles;
+  const unsigned long dirtyUs = static_cast<unsigned long>(dirty.totalRenderUs / kToggles);
+  printf("[BENCH] %-14s bytes/render=%-5lu bytes/s=%-5lu wire_us=%-6lu render_us=%lu\n",
+         "oled/full", static_cast<unsigned long>(fullBytes),
+         static_cast<unsigned long>(fullBytes * 1000 / kBlinkIntervalMs), wireUs(fullBytes),
+         static_cast<unsigned long>(fullUs));
+  printf("[BENCH] %-14s bytes/render=%-5lu bytes/s=%-5lu wire_us=%-6lu render_us=%lu\n",
+         "oled/dirty", static_cast<unsigned long>(dirtyBytes),
+         static_cast<unsigned long>(dirtyBytes * 1000 / kBlinkIntervalMs), wireUs(dirtyBytes),
+         dirtyUs);
+
+  TEST_ASSERT_TRUE(dirtyBytes * 5 < fullBytes);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_first_render_sends_full_frame);
+  RUN_TEST(test_unchanged_state_sends_nothing);
+  RUN_TEST(test_fill_toggle_sends_only_disc_tiles);
+  RUN_TEST(test_panel_matches_after_many_toggles);
+  RUN_TEST(test_sensor_on_bus_defers_frame);
+  RUN_TEST(test_update_wait_drives_the_display_job);
+  RUN_TEST(test_bus_remaps_pins_between_clients);
+  RUN_TEST(test_blink_bytes_per_second);
+  return UNITY_END();
+}
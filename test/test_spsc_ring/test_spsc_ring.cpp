@@ -0,0 +1,129 @@
+#include <unity.h>
+
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <thread>
+
+#include "spsc_ring.h"
+
+namespace {
+struct Notice {
+  char message[64];
+};
+
+void makeNotice(Notice& notice, const char* text) {
+  strncpy(notice.message, text, sizeof(notice.message) - 1);
+  notice.message[sizeof(notice.message) - 1] = '\0';
+}
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+// El caso del bug original: dos estados seguidos antes de que loop() drene.
+void test_keeps_order_of_consecutive_messages() {
+  SpscRing<Notice, 8> ring;
+  Notice notice;
+  makeNotice(notice, "wifi:conectando");
+  TEST_ASSERT_TRUE(ring.push(notice));
+  makeNotice(notice, "wifi:conectado");
+  TEST_ASSERT_TRUE(ring.push(notice));
+  TEST_ASSERT_EQUAL_UINT32(2, ring.size());
+
+  TEST_ASSERT_TRUE(ring.pop(notice));
+  TEST_ASSERT_EQUAL_STRING("wifi:conectando", notice.message);
+  TEST_ASSERT_TRUE(ring.pop(notice));
+  TEST_ASSERT_EQUAL_STRING("wifi:conectado", notice.message);
+  TEST_ASSERT_FALSE(ring.pop(notice));
+  TEST_ASSERT_TRUE(ring.empty());
+  TEST_ASSERT_EQUAL_UINT32(2, ring.popped());
+}
+
+void test_overflow_drops_newest_and_counts() {
+  SpscRing<uint32_t, 4> ring;
+  for (uint32_t i = 0; i < 6; ++i) {
+    ring.push(i);
+  }
+  TEST_ASSERT_EQUAL_UINT32(2, ring.dropped());
+  TEST_ASSERT_EQUAL_UINT32(4, ring.highWater());
+  uint32_t value = 0;
+  for (uint32_t expected = 0; expected < 4; ++expected) {
+    TEST_ASSERT_TRUE(ring.pop(value));
+    TEST_ASSERT_EQUAL_UINT32(expected, value);
+  }
+  TEST_ASSERT_TRUE(ring.push(99));
+  TEST_ASSERT_TRUE(ring.pop(value));
+  TEST_ASSERT_EQUAL_UINT32(99, value);
+}
+
+void test_indices_wrap_around() {
+  SpscRing<uint32_t, 2> ring;
+  uint32_t value = 0;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    TEST_ASSERT_TRUE(ring.push(i));
+    TEST_ASSERT_TRUE(ring.pop(value));
+    TEST_ASSERT_EQUAL_UINT32(i, value);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, ring.dropped());
+}
+
+// Productor y consumidor en hilos distintos: lo que se entrega llega en
+// orden y entregados + descartados == enviados. El productor espera a que
+// haya hueco salvo en uno de cada cuatro mensajes, que pueden desbordar.
+void test_two_threads_deliver_in_order() {
+  constexpr uint32_t kMessages = 500000;
+  static SpscRing<uint32_t, 8> ring;
+  std::atomic<uint32_t> accepted{0};
+  std::thread producer([&accepted]() {
+    for (uint32_t i = 0; i < kMessages; ++i) {
+      while (i % 4 != 0 && ring.size() == ring.capacity()) {
+        std::this_thread::yield();
+      }
+      if (ring.push(i)) {
+        accepted.store(accepted.load() + 1);
+      }
+    }
+  });
+
+  uint32_t received = 0;
+  uint32_t last = 0;
+  bool ordered = true;
+  bool producerDone = false;
+  while (!producerDone || !ring.empty()) {
+    uint32_t value = 0;
+    if (ring.pop(value)) {
+      ordered = ordered && (received == 0 || value > last);
+      last = value;
+      ++received;
+    } else if (accepted.load() + ring.dropped() == kMessages) {
+      producerDone = true;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  uint32_t value = 0;
+  while (ring.pop(value)) {
+    ordered = ordered && value > last;
+    last = value;
+    ++received;
+  }
+
+  printf("[SPSC] %lu enviados, %lu entregados, %lu descartados, ocupacion maxima %lu\n",
+         static_cast<unsigned long>(kMessages), static_cast<unsigned long>(received),
+         static_cast<unsigned long>(ring.dropped()),
+         static_cast<unsigned long>(ring.highWater()));
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_EQUAL_UINT32(accepted, received);
+  TEST_ASSERT_EQUAL_UINT32(kMessages, received + ring.dropped());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_keeps_order_of_consecutive_messages);
+  RUN_TEST(test_overflow_drops_newest_and_counts);
+  RUN_TEST(test_indices_wrap_around);
+  RUN_TEST(test_two_threads_deliver_in_order);
+  return UNITY_END();
+}
@@ -0,0 +1,92 @@
+#include <unity.h>
+
+#include <task_host.h>
+
+#include <cstdio>
+#include <string>
+
+#include "stack_monitor.h"
+
+namespace {
+const StackMonitor::TaskStats* find(const char* name) {
+  for (size_t i = 0; i < StackMonitor::taskCount(); ++i) {
+    if (std::string(StackMonitor::task(i).name) == name) {
+      return &StackMonitor::task(i);
+    }
+  }
+  return nullptr;
+}
+}  // namespace
+
+void setUp() {
+  TaskHost::clear();
+  StackMonitor::reset();
+}
+
+void tearDown() {}
+
+void test_samples_every_task() {
+  TaskHost::setTask("loopTask", 5200);
+  TaskHost::setTask("mqtt_task", 2100);
+  TaskHost::setTask("wifi", 1800);
+
+  StackMonitor::sample();
+
+  TEST_ASSERT_EQUAL_UINT32(3, StackMonitor::taskCount());
+  TEST_ASSERT_EQUAL_UINT32(5200, find("loopTask")->minFreeBytes);
+  TEST_ASSERT_EQUAL_UINT32(2100, find("mqtt_task")->minFreeBytes);
+  TEST_ASSERT_EQUAL_STRING("wifi", StackMonitor::tightest()->name);
+}
+
+void test_keeps_minimum_across_restarts() {
+  TaskHost::setTask("loopTask", 5200);
+  TaskHost::setTask("BTU_TASK", 900);
+  StackMonitor::sample();
+
+  // Tras liberar BLE la tarea desaparece; el minimo se conserva.
+  TaskHost::removeTask("BTU_TASK");
+  StackMonitor::sample();
+  TEST_ASSERT_FALSE(find("BTU_TASK")->alive);
+  TEST_ASSERT_EQUAL_UINT32(900, find("BTU_TASK")->minFreeBytes);
+
+  TaskHost::setTask("BTU_TASK", 1500);
+  StackMonitor::sample();
+  TEST_ASSERT_TRUE(find("BTU_TASK")->alive);
+  TEST_ASSERT_EQUAL_UINT32(900, find("BTU_TASK")->minFreeBytes);
+  TEST_ASSERT_EQUAL_UINT32(2, StackMonitor::taskCount());
+}
+
+void test_warns_once_below_threshold() {
+  TaskHost::setTask("loopTask", STACK_WARN_BYTES + 100);
+  StackMonitor::sample();
+  TEST_ASSERT_FALSE(find("loopTask")->warned);
+
+  TaskHost::setTask("loopTask", STACK_WARN_BYTES - 1);
+  StackMonitor::sample();
+  TEST_ASSERT_TRUE(find("loopTask")->warned);
+  TEST_ASSERT_EQUAL_UINT32(STACK_WARN_BYTES - 1, find("loopTask")->minFreeBytes);
+}
+
+void test_too_many_tasks_keeps_previous_data() {
+  TaskHost::setTask("loopTask", 4000);
+  StackMonitor::sample();
+
+  char name[16];
+  for (size_t i = 0; i < StackMonitor::kMaxTasks; ++i) {
+    std::snprintf(name, sizeof(name), "t%u", static_cast<unsigned>(i));
+    TaskHost::setTask(name, 3000);
+  }
+  StackMonitor::sample();
+
+  TEST_ASSERT_EQUAL_UINT32(1, StackMonitor::taskCount());
+  TEST_ASSERT_TRUE(find("loopTask")->alive);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_samples_every_task);
+  RUN_TEST(test_keeps_minimum_across_restarts);
+  RUN_TEST(test_warns_once_below_threshold);
+  RUN_TEST(test_too_many_tasks_keeps_previous_data);
+  return UNITY_END();
+}
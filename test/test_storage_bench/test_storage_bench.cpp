@@ -0,0 +1,234 @@
+#include <unity.h>
+
+#include <SPIFFS.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "Config.hpp"
+#include "aws_certs.h"
+#include "diag_counters.h"
+#include "nvs_host.h"
+#include "spiffs_host.h"
+
+// Cargas de almacenamiento del firmware sobre NVS/SPIFFS emulados. Cada
+// escenario imprime sus operaciones; los asserts fijan las mejoras ya
+// conseguidas para que una regresion se vea en pio test -e native.
+namespace {
+constexpr char kNvsFile[] = "test_storage_bench.nvs";
+constexpr char kSpiffsDir[] = "test_storage_bench.spiffs";
+constexpr uint32_t kOutageRetries = 600;
+
+void report(const char* scenario, const NvsHost::Stats& s) {
+  printf("[BENCH] %-26s opens=%-4lu reads=%-4lu writes=%-5lu commits=%-5lu bytes=%-6llu "
+         "entries=%-5lu erases=%lu\n",
+         scenario, static_cast<unsigned long>(s.opens), static_cast<unsigned long>(s.reads),
+         static_cast<unsigned long>(s.writes), static_cast<unsigned long>(s.commits),
+         static_cast<unsigned long long>(s.bytesWritten),
+         static_cast<unsigned long>(s.entriesWritten), static_cast<unsigned long>(s.eraseCycles));
+}
+
+void freshDevice() {
+  Config::deinit();
+  NvsHost::reset(kNvsFile);
+  Config::init();
+}
+
+void rebootDevice() {
+  Config::deinit();
+  NvsHost::reboot();
+  Config::init();
+}
+
+// Arranque anterior al esquema: exists() de cada default en cada boot.
+void seedPerKey() {
+  for (const Config::KeySpec& spec : Config::kSchema) {
+    if (!spec.seeded || Config::exists(spec.id)) {
+      continue;
+    }
+    if (spec.type == Config::Type::INT) {
+      Config::setInt(spec.id, spec.defaultInt);
+    } else {
+      Config::setString(spec.id, spec.defaultString);
+    }
+  }
+}
+
+void provisionPerKey() {
+  Config::setString(Config::Key::WIFI_SSID, "lab-net");
+  Config::setString(Config::Key::WIFI_PASSWORD, "secret-1");
+  Config::setString(Config::Key::DEVICE_PROVISION_TOKEN, "token-1");
+  Config::setString(Config::Key::DEVICE_ID, "lab_000001");
+  Config::setString(Config::Key::AWS_ENDPOINT, "a1.iot.us-east-1.amazonaws.com");
+  Config::setString(Config::Key::AWS_REGION, "us-east-1");
+  Config::setString(Config::Key::DEVICE_ENV, "prod");
+  Config::setString(Config::Key::AWS_THING, "thing-1");
+  Config::setInt(Config::Key::AWS_PORT, 8883);
+  Config::setString(Config::Key::DEVICE_USER, "user-1");
+}
+
+void stageProvisioning(Config::Transaction& tx) {
+  tx.setString(Config::Key::WIFI_SSID, "lab-net");
+  tx.setString(Config::Key::WIFI_PASSWORD, "secret-1");
+  tx.setString(Config::Key::DEVICE_PROVISION_TOKEN, "token-1");
+  tx.setString(Config::Key::DEVICE_ID, "lab_000001");
+  tx.setString(Config::Key::AWS_ENDPOINT, "a1.iot.us-east-1.amazonaws.com");
+  tx.setString(Config::Key::AWS_REGION, "us-east-1");
+  tx.setString(Config::Key::DEVICE_ENV, "prod");
+  tx.setString(Config::Key::AWS_THING, "thing-1");
+  tx.setInt(Config::Key::AWS_PORT, 8883);
+  tx.setString(Config::Key::DEVICE_USER, "user-1");
+}
+
+void putPem(const char* path, char fill, size_t length) {
+  std::string pem = "-----BEGIN CERTIFICATE-----\n";
+  pem.append(length, fill);
+  pem += "\n-----END CERTIFICATE-----\n";
+  SpiffsHost::putFile(path, pem.data(), pem.size());
+}
+}  // namespace
+
+void setUp() { freshDevice(); }
+void tearDown() {
+  Config::deinit();
+  remove(kNvsFile);
+  std::filesystem::remove_all(kSpiffsDir);
+}
+
+void test_boot_seeding() {
+  NvsHost::resetStats();
+  seedPerKey();
+  const NvsHost::Stats legacyFirst = NvsHost::stats();
+  rebootDevice();
+  NvsHost::resetStats();
+  seedPerKey();
+  const NvsHost::Stats legacyNext = NvsHost::stats();
+
+  freshDevice();
+  NvsHost::resetStats();
+  Config::seedDefaults("bench");
+  const NvsHost::Stats stampedFirst = NvsHost::stats();
+  rebootDevice();
+  NvsHost::resetStats();
+  Config::seedDefaults("bench");
+  const NvsHost::Stats stampedNext = NvsHost::stats();
+
+  report("seed/per-key first boot", legacyFirst);
+  report("seed/per-key next boot", legacyNext);
+  report("seed/stamped first boot", stampedFirst);
+  report("seed/stamped next boot", stampedNext);
+
+  TEST_ASSERT_EQUAL_UINT32(0, legacyNext.writes);
+  TEST_ASSERT_EQUAL_UINT32(0, stampedNext.writes);
+  // Con el sello vigente basta leer meta/schema.
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(1, stampedNext.opens);
+  TEST_ASSERT_LESS_THAN_UINT32(legacyNext.opens, stampedNext.opens);
+}
+
+void test_provisioning() {
+  Config::seedDefaults("bench");
+  NvsHost::resetStats();
+  provisionPerKey();
+  const NvsHost::Stats perKey = NvsHost::stats();
+
+  freshDevice();
+  Config::seedDefaults("bench");
+  NvsHost::resetStats();
+  Config::Transaction tx;
+  stageProvisioning(tx);
+  TEST_ASSERT_EQUAL(ESP_OK, tx.commit());
+  const NvsHost::Stats batched = NvsHost::stats();
+
+  report("provisioning/per-key", perKey);
+  report("provisioning/transaction", batched);
+
+  TEST_ASSERT_EQUAL_UINT32(10, perKey.commits);
+  TEST_ASSERT_LESS_THAN_UINT32(perKey.commits, batched.commits);
+}
+
+// Caida de la red: cada reintento de Wi-Fi y MQTT suma un contador.
+void test_outage_retry_storm() {
+  Config::seedDefaults("bench");
+  NvsHost::resetStats();
+  for (uint32_t i = 0; i < kOutageRetries; ++i) {
+    const Config::Key key =
+        (i % 2 == 0) ? Config::Key::DIAG_WIFI_RETRIES : Config::Key::DIAG_MQTT_RETRIES;
+    Config::setInt(key, Config::getInt(key) + 1);
+  }
+  const NvsHost::Stats perIncrement = NvsHost::stats();
+
+  freshDevice();
+  Config::seedDefaults("bench");
+  DiagCounters::begin();
+  NvsHost::resetStats();
+  for (uint32_t i = 0; i < kOutageRetries; ++i) {
+    DiagCounters::increment((i % 2 == 0) ? DiagCounters::Counter::WIFI_RETRIES
+                                         : DiagCounters::Counter::MQTT_RETRIES);
+  }
+  DiagCounters::flush();
+  const NvsHost::Stats coalesced = NvsHost::stats();
+
+  report("outage/per-increment", perIncrement);
+  report("outage/diag-counters", coalesced);
+
+  TEST_ASSERT_EQUAL_UINT32(kOutageRetries, perIncrement.commits);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(perIncrement.commits / 10, coalesced.commits);
+  TEST_ASSERT_LESS_THAN_UINT32(perIncrement.eraseCycles, coalesced.eraseCycles);
+  TEST_ASSERT_EQUAL_INT32(kOutageRetries / 2, Config::getInt(Config::Key::DIAG_WIFI_RETRIES));
+  TEST_ASSERT_EQUAL_INT32(kOutageRetries / 2, Config::getInt(Config::Key::DIAG_MQTT_RETRIES));
+}
+
+void test_certificate_load() {
+  SpiffsHost::reset(kSpiffsDir);
+  TEST_ASSERT_TRUE(SPIFFS.begin(false));
+  putPem("/certs/AmazonRootCA1.pem", 'A', 1100);
+  putPem("/certs/device.pem.crt", 'B', 1150);
+  putPem("/certs/private.pem.key", 'C', 1620);
+
+  Config::seedDefaults("bench");
+  AwsCerts::Bundle certs;
+  SpiffsHost::resetStats();
+  const AwsCerts::LoadResult result = AwsCerts::load(
+      SPIFFS, Config::getString(Config::Key::CERT_ROOT).c_str(),
+      Config::getString(Config::Key::CERT_DEVICE).c_str(),
+      Config::getString(Config::Key::CERT_PRIVATE).c_str(), certs);
+  const SpiffsHost::Stats s = SpiffsHost::stats();
+  printf("[BENCH] %-26s opens=%-4lu lookups=%-4lu read=%llu bytes\n", "certs/load",
+         static_cast<unsigned long>(s.opens), static_cast<unsigned long>(s.lookups),
+         static_cast<unsigned long long>(s.bytesRead));
+
+  TEST_ASSERT_EQUAL(static_cast<int>(AwsCerts::LoadResult::OK), static_cast<int>(result));
+  TEST_ASSERT_EQUAL_UINT32(3, s.opens);
+  TEST_ASSERT_EQUAL_UINT64(certs.rootCa.length() + certs.deviceCert.length() +
+                               certs.privateKey.length(),
+                           s.bytesRead);
+
+  SPIFFS.remove("/certs/device.pem.crt");
+  TEST_ASSERT_EQUAL(static_cast<int>(AwsCerts::LoadResult::NOT_FOUND),
+                    static_cast<int>(AwsCerts::load(SPIFFS, "/certs/AmazonRootCA1.pem",
+                                                    "/certs/device.pem.crt",
+                                                    "/certs/private.pem.key", certs)));
+  TEST_ASSERT_EQUAL_UINT32(0, certs.rootCa.length());
+
+  File empty = SPIFFS.open("/certs/device.pem.crt", "w");
+  empty.close();
+  TEST_ASSERT_EQUAL(static_cast<int>(AwsCerts::LoadResult::EMPTY),
+                    static_cast<int>(AwsCerts::load(SPIFFS, "/certs/AmazonRootCA1.pem",
+                                                    "/certs/device.pem.crt",
+                                                    "/certs/private.pem.key", certs)));
+
+  SpiffsHost::unformat();
+  TEST_ASSERT_FALSE(SPIFFS.begin(false));
+  TEST_ASSERT_TRUE(SPIFFS.begin(true));
+  TEST_ASSERT_FALSE(SPIFFS.exists("/certs/private.pem.key"));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_boot_seeding);
+  RUN_TEST(test_provisioning);
+  RUN_TEST(test_outage_retry_storm);
+  RUN_TEST(test_certificate_load);
+  return UNITY_END();
+}
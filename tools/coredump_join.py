@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""Junta los trozos de core dump publicados en <device>/coredump (src/core_dump.cpp).
+
+Cada mensaje lleva una cabecera de 16 bytes y los datos; el resultado es la
+imagen tal cual estaba en la particion coredump.
+
+Uso:
+    mosquitto_sub -t 'lab/devices/+/coredump' -F '%x' > trozos.txt
+    python tools/coredump_join.py trozos.txt            # un payload en hex por linea
+    python tools/coredump_join.py msg_0001.bin msg_0002.bin ...   # un mensaje por archivo
+    python tools/coredump_join.py -o dumps/ capturas/*.bin
+
+Los archivos binarios tambien pueden ser varios mensajes concatenados. Con la
+imagen completa:
+    espcoredump.py info_corefile --core-format raw --core coredump_<id>.bin firmware.elf
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+MAGIC = 0x4443
+HEADER = struct.Struct("<HHHHII")
+HEX_LINE = re.compile(r"^[0-9a-fA-F]+$")
+
+
+def messages_in(path):
+    """Payloads de un archivo: lineas hex o binario con uno o mas trozos."""
+    with open(path, "rb") as handle:
+        data = handle.read()
+    lines = data.decode("latin-1").split()
+    if lines and all(HEX_LINE.match(line) and len(line) % 2 == 0 for line in lines):
+        return [bytes.fromhex(line) for line in lines]
+    return [data]
+
+
+def chunks_in(payload):
+    """Trozos de un payload; varios si estan concatenados."""
+    pos = 0
+    while pos + HEADER.size <= len(payload):
+        magic, seq, count, length, dump_id, offset = HEADER.unpack_from(payload, pos)
+        if magic != MAGIC:
+            raise ValueError("cabecera sin magic en el byte %d" % pos)
+        data = payload[pos + HEADER.size:pos + HEADER.size + length]
+        if len(data) != length:
+            raise ValueError("trozo %d de %08x recortado" % (seq, dump_id))
+        yield dump_id, seq, count, offset, data
+        pos += HEADER.size + length
+
+
+def join(dumps, dump_id):
+    count, parts = dumps[dump_id]
+    missing = [seq for seq in range(count) if seq not in parts]
+    if missing:
+        return None, "faltan %d de %d trozos (primero %d)" % (len(missing), count, missing[0])
+    image = bytearray()
+    for seq in range(count):
+        offset, data = parts[seq]
+        if offset != len(image):
+            return None, "el trozo %d empieza en %d y se esperaba %d" % (seq, offset, len(image))
+        image += data
+    crc = zlib.crc32(bytes(image)) & 0xFFFFFFFF
+    if crc != dump_id:
+        return None, "CRC32 %08x no coincide" % crc
+    return bytes(image), None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("inputs", nargs="+", help="capturas: hex por linea o mensajes binarios")
+    parser.add_argument("-o", "--output-dir", default=".", help="donde escribir coredump_<id>.bin")
+    args = parser.parse_args()
+
+    # dump_id -> (count, {seq: (offset, data)}); los repetidos se quedan una vez.
+    dumps = {}
+    for path in args.inputs:
+        for payload in messages_in(path):
+            for dump_id, seq, count, offset, data in chunks_in(payload):
+                entry = dumps.setdefault(dump_id, (count, {}))
+                entry[1].setdefault(seq, (offset, data))
+
+    if not dumps:
+        print("no hay trozos en la entrada", file=sys.stderr)
+        return 1
+
+    status = 0
+    for dump_id in sorted(dumps):
+        image, error = join(dumps, dump_id)
+        if error:
+            print("%08x: %s" % (dump_id, error), file=sys.stderr)
+            status = 1
+            continue
+        path = os.path.join(args.output_dir, "coredump_%08x.bin" % dump_id)
+        with open(path, "wb") as handle:
+            handle.write(image)
+        print("%08x: %d bytes -> %s" % (dump_id, len(image), path))
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
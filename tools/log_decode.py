@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""Decodifica volcados del anillo de log binario (src/log_ring.cpp).
+
+Los formatos no estan en el volcado: cada entrada guarda la direccion de su
+cadena en flash, que se busca en el ELF del mismo firmware.
+
+Uso:
+    python tools/log_decode.py .pio/build/adafruit_qtpy_esp32c3/firmware.elf monitor.log
+    python tools/log_decode.py firmware.elf rtc.bin        # imagen binaria (p. ej. de la RTC)
+
+El volcado puede ser la captura del monitor serie con las lineas "[LOG] raw"
+o cualquier binario que contenga el anillo: se busca su cabecera.
+"""
+
+import argparse
+import hashlib
+import re
+import struct
+import sys
+
+MAGIC = 0x474F4C52
+HEADER = struct.Struct("<IHHHHI8s")
+ENTRY_HEADER = struct.Struct("<IIBBH")
+ARG_INT32, ARG_INT64, ARG_DOUBLE, ARG_STRING = 1, 2, 3, 4
+FLAG_TRUNCATED = 0x01
+RAW_LINE = re.compile(r"\[LOG\] raw ([0-9a-f]{4}) ([0-9a-f]+)")
+SPEC = re.compile(r"%([-+ #0-9.]*)(?:hh|h|ll|l|L|q|j|z|t)?([diouxXcsfFeEgGaAp%])")
+
+
+class Elf:
+    """Lo justo de un ELF32 little endian para leer cadenas por direccion."""
+
+    def __init__(self, path):
+        with open(path, "rb") as handle:
+            self.data = handle.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1:
+            raise ValueError("%s no es un ELF de 32 bits" % path)
+        self.sha256 = hashlib.sha256(self.data).hexdigest()
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for index in range(shnum):
+            fields = struct.unpack_from("<IIIIIIIIII", self.data, shoff + index * shentsize)
+            sh_type, sh_addr, sh_offset, sh_size = fields[1], fields[3], fields[4], fields[5]
+            if sh_type == 1 and sh_addr:  # SHT_PROGBITS cargada en memoria
+                self.sections.append((sh_addr, sh_offset, sh_size))
+
+    def string_at(self, address):
+        for sh_addr, sh_offset, sh_size in self.sections:
+            if sh_addr <= address < sh_addr + sh_size:
+                start = sh_offset + address - sh_addr
+                end = self.data.find(b"\0", start, sh_offset + sh_size)
+                if end < 0:
+                    end = sh_offset + sh_size
+                return self.data[start:end].decode("utf-8", "replace")
+        return None
+
+
+def read_dump(path):
+    with open(path, "rb") as handle:
+        data = handle.read()
+    chunks = {}
+    for match in RAW_LINE.finditer(data.decode("latin-1")):
+        chunks[int(match.group(1), 16)] = bytes.fromhex(match.group(2))
+    if not chunks:
+        return data
+    image = bytearray()
+    for offset in sorted(chunks):
+        image[offset:offset + len(chunks[offset])] = chunks[offset]
+    return bytes(image)
+
+
+def parse_args(blob):
+    """Lista de (tipo, valor) en el orden en que se guardaron."""
+    args = []
+    pos = 0
+    while pos < len(blob):
+        kind = blob[pos]
+        pos += 1
+        if kind == ARG_INT32 and pos + 4 <= len(blob):
+            args.append((kind, struct.unpack_from("<I", blob, pos)[0]))
+            pos += 4
+        elif kind == ARG_INT64 and pos + 8 <= len(blob):
+            args.append((kind, struct.unpack_from("<Q", blob, pos)[0]))
+            pos += 8
+        elif kind == ARG_DOUBLE and pos + 8 <= len(blob):
+            args.append((kind, struct.unpack_from("<d", blob, pos)[0]))
+            pos += 8
+        elif kind == ARG_STRING and blob.find(b"\0", pos) >= 0:
+            end = blob.find(b"\0", pos)
+            args.append((kind, blob[pos:end].decode("utf-8", "replace")))
+            pos = end + 1
+        else:
+            break
+    return args
+
+
+def to_signed(value, bits):
+    return value - (1 << bits) if value >> (bits - 1) else value
+
+
+def render(fmt, args):
+    """Mismo criterio que LogRing::format(): el tipo guardado manda."""
+    pending = list(args)
+
+    def one(match):
+        flags, conversion = match.group(1), match.group(2)
+        if conversion == "%":
+            return "%"
+        if not pending:
+            return "<?>"
+        kind, value = pending.pop(0)
+        if conversion == "s" and kind == ARG_STRING:
+            return ("%" + flags + "s") % value
+        if conversion in "fFeEgGaA" and kind == ARG_DOUBLE:
+            return ("%" + flags + conversion.replace("a", "e").replace("A", "E")) % value
+        if kind in (ARG_INT32, ARG_INT64):
+            bits = 64 if kind == ARG_INT64 else 32
+            if conversion == "p":
+                return "0x%x" % value
+            if conversion in "uxXo":
+                return ("%" + flags + ("d" if conversion == "u" else conversion)) % value
+            if conversion in "di":
+                return ("%" + flags + "d") % to_signed(value, bits)
+            if conversion == "c":
+                return chr(value & 0xFF)
+        return "<?>"
+
+    return SPEC.sub(one, fmt)
+
+
+def decode(elf, image):
+    start = image.find(struct.pack("<I", MAGIC))
+    if start < 0:
+        raise ValueError("no se encontro la cabecera del anillo en el volcado")
+    magic, version, entry_bytes, capacity, _, written, elf_sha = HEADER.unpack_from(image, start)
+    if version != 1 or entry_bytes != 64:
+        raise ValueError("version %d / entrada de %d bytes no soportada" % (version, entry_bytes))
+    sha = elf_sha.decode("ascii", "replace")
+    if not elf.sha256.startswith(sha):
+        print("# aviso: el volcado es del ELF %s... y el dado es %s..." % (sha, elf.sha256[:8]),
+              file=sys.stderr)
+
+    entries_at = start + HEADER.size
+    count = min(written, capacity)
+    for index in range(written - count, written):
+        offset = entries_at + (index % capacity) * entry_bytes
+        if offset + entry_bytes > len(image):
+            print("# volcado incompleto en la entrada %d" % index, file=sys.stderr)
+            break
+        address, ms, arg_bytes, flags, _ = ENTRY_HEADER.unpack_from(image, offset)
+        blob = image[offset + ENTRY_HEADER.size:offset + ENTRY_HEADER.size + min(arg_bytes, 52)]
+        fmt = elf.string_at(address)
+        if fmt is None:
+            line = "<formato 0x%08x no esta en el ELF> %r" % (address, [v for _, v in parse_args(blob)])
+        else:
+            line = render(fmt, parse_args(blob)).rstrip("\n")
+        if flags & FLAG_TRUNCATED:
+            line += " [recortada]"
+        yield "%10u ms  %s\n" % (ms, line)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="firmware.elf del mismo build que genero el volcado")
+    parser.add_argument("dump", help="captura serie con lineas '[LOG] raw' o imagen binaria")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    for line in decode(elf, read_dump(args.dump)):
+        sys.stdout.write(line)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
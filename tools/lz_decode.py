@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Decodifica payloads publicados en topics con sufijo /hs (src/lz_codec.cpp).
+
+Uso:
+    python tools/lz_decode.py payload.bin            # escribe el JSON en stdout
+    python tools/lz_decode.py -w 8 -l 4 < payload.bin
+    python tools/lz_decode.py --hex 'bf2a...'         # payload copiado del cliente MQTT
+"""
+
+import argparse
+import sys
+
+
+def decompress(data, window_bits=8, lookahead_bits=4):
+    out = bytearray()
+    total_bits = len(data) * 8
+    pos = 0
+
+    def take(count):
+        nonlocal pos
+        value = 0
+        for _ in range(count):
+            byte = data[pos // 8]
+            value = (value << 1) | ((byte >> (7 - pos % 8)) & 1)
+            pos += 1
+        return value
+
+    while pos < total_bits:
+        if take(1):
+            if total_bits - pos < 8:
+                break
+            out.append(take(8))
+            continue
+        # Tag 0 sin bits suficientes: relleno del ultimo byte.
+        if total_bits - pos < window_bits + lookahead_bits:
+            break
+        offset = take(window_bits) + 1
+        count = take(lookahead_bits) + 1
+        if offset > len(out):
+            raise ValueError("referencia fuera de la ventana en el bit %d" % pos)
+        for _ in range(count):
+            out.append(out[-offset])
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("path", nargs="?", help="archivo comprimido (stdin si se omite)")
+    parser.add_argument("-w", "--window-bits", type=int, default=8)
+    parser.add_argument("-l", "--lookahead-bits", type=int, default=4)
+    parser.add_argument("--hex", help="payload en hexadecimal")
+    args = parser.parse_args()
+
+    if args.hex:
+        data = bytes.fromhex(args.hex)
+    elif args.path:
+        with open(args.path, "rb") as handle:
+            data = handle.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    sys.stdout.buffer.write(decompress(data, args.window_bits, args.lookahead_bits))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())